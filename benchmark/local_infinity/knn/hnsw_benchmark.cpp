@@ -32,6 +32,7 @@ enum class ModeType : i8 {
     BUILD,
     QUERY,
     COMPRESS,
+    REORDER,
 };
 
 enum class BenchmarkType : i8 {
@@ -65,18 +66,47 @@ String BuildTypeToString(BuildType build_type) {
     }
 }
 
+enum class ReorderType : i8 {
+    NONE,
+    BFS,
+    RCM,
+};
+
+String ReorderTypeToString(ReorderType reorder_type) {
+    switch (reorder_type) {
+        case ReorderType::NONE:
+            return "none";
+        case ReorderType::BFS:
+            return "bfs";
+        case ReorderType::RCM:
+            return "rcm";
+    }
+}
+
 struct BenchmarkOption {
 public:
     BenchmarkOption() : app_("hnsw_benchmark") {}
 
-    static String IndexName(const BenchmarkType &benchmark_type, const BuildType &build_type, SizeT M, SizeT ef_construction) {
-        return fmt::format("hnsw_{}_{}_{}_{}", BenchmarkTypeToString(benchmark_type), BuildTypeToString(build_type), M, ef_construction);
+    static String IndexName(const BenchmarkType &benchmark_type,
+                            const BuildType &build_type,
+                            SizeT M,
+                            SizeT ef_construction,
+                            ReorderType reorder_type = ReorderType::NONE) {
+        String name = fmt::format("hnsw_{}_{}_{}_{}", BenchmarkTypeToString(benchmark_type), BuildTypeToString(build_type), M, ef_construction);
+        if (reorder_type != ReorderType::NONE) {
+            name += fmt::format("_{}", ReorderTypeToString(reorder_type));
+        }
+        return name;
     }
 
     void Parse(int argc, char *argv[]) {
-        Map<String, ModeType> mode_map = {{"build", ModeType::BUILD}, {"query", ModeType::QUERY}, {"compress", ModeType::COMPRESS}};
+        Map<String, ModeType> mode_map = {{"build", ModeType::BUILD},
+                                          {"query", ModeType::QUERY},
+                                          {"compress", ModeType::COMPRESS},
+                                          {"reorder", ModeType::REORDER}};
         Map<String, BenchmarkType> benchmark_type_map = {{"sift", BenchmarkType::SIFT}, {"gist", BenchmarkType::GIST}};
         Map<String, BuildType> build_type_map = {{"plain", BuildType::PLAIN}, {"lvq", BuildType::LVQ}, {"clvq", BuildType::CompressToLVQ}};
+        Map<String, ReorderType> reorder_type_map = {{"none", ReorderType::NONE}, {"bfs", ReorderType::BFS}, {"rcm", ReorderType::RCM}};
 
         app_.add_option("--mode", mode_type_, "mode")->required()->transform(CLI::CheckedTransformer(mode_map, CLI::ignore_case));
         app_.add_option("--benchmark_type", benchmark_type_, "benchmark type")
@@ -84,6 +114,10 @@ public:
             ->transform(CLI::CheckedTransformer(benchmark_type_map, CLI::ignore_case));
         app_.add_option("--build_type", build_type_, "build type")->required()->transform(CLI::CheckedTransformer(build_type_map, CLI::ignore_case));
         app_.add_option("--thread_n", thread_n_, "thread number")->required(false);
+        // the reordered index is saved by mode `reorder` to another file, which is searched by mode `query` with the same option
+        app_.add_option("--reorder_type", reorder_type_, "reorder type")
+            ->required(false)
+            ->transform(CLI::CheckedTransformer(reorder_type_map, CLI::ignore_case));
 
         app_.add_option("--chunk_size", chunk_size_, "chunk size")->required(false);
         app_.add_option("--max_chunk_num", max_chunk_num_, "max chunk size")->required(false);
@@ -91,6 +125,8 @@ public:
         app_.add_option("--ef_construction", ef_construction_, "ef construction")->required(false);
 
         app_.add_option("--ef", ef_, "ef")->required(false);
+        app_.add_option("--patience", patience_list_, "patience of early termination, 0 means off, several values are queried in turn")
+            ->required(false);
         app_.add_option("--test_n", test_n_, "test n")->required(false);
 
         try {
@@ -102,7 +138,7 @@ public:
     }
 
     void ParseInner() {
-        String index_name = IndexName(benchmark_type_, build_type_, M_, ef_construction_);
+        String index_name = IndexName(benchmark_type_, build_type_, M_, ef_construction_, reorder_type_);
         switch (benchmark_type_) {
             case BenchmarkType::SIFT: {
                 data_path_ = "test/data/benchmark/sift_1m/sift_base.fvecs";
@@ -124,6 +160,7 @@ public:
     ModeType mode_type_;
     BenchmarkType benchmark_type_;
     BuildType build_type_;
+    ReorderType reorder_type_ = ReorderType::NONE;
     SizeT thread_n_ = std::thread::hardware_concurrency();
 
     SizeT chunk_size_ = 8192;
@@ -132,6 +169,7 @@ public:
     SizeT ef_construction_ = 200;
 
     SizeT ef_ = 200;
+    Vector<SizeT> patience_list_ = {0};
     SizeT test_n_ = 1;
 
 public:
@@ -218,50 +256,54 @@ void Query(const BenchmarkOption &option) {
     if (gt_num != query_num) {
         UnrecoverableError("gt_num != query_num");
     }
-    KnnSearchOption search_option{.ef_ = option.ef_};
-
-    Vector<Vector<LabelT>> results(query_num, Vector<LabelT>(topk));
-
-    for (SizeT i = 0; i < option.test_n_; ++i) {
-        profiler.Begin();
-        Vector<std::thread> query_threads;
-        Atomic<i32> cur_i = 0;
-
-        for (SizeT i = 0; i < option.thread_n_; ++i) {
-            query_threads.emplace_back([&] {
-                SizeT i;
-                while ((i = cur_i.fetch_add(1)) < query_num) {
-                    const float *query = query_data.get() + i * query_dim;
-                    Vector<Pair<float, LabelT>> pairs = hnsw->KnnSearchSorted(query, topk, search_option);
-                    if (pairs.size() < SizeT(topk)) {
-                        UnrecoverableError("result_n != topk");
-                    }
-                    for (i32 j = 0; j < topk; ++j) {
-                        results[i][j] = pairs[j].second;
+
+    for (SizeT patience : option.patience_list_) {
+        KnnSearchOption search_option{.ef_ = option.ef_, .patience_ = patience};
+
+        Vector<Vector<LabelT>> results(query_num, Vector<LabelT>(topk));
+
+        for (SizeT i = 0; i < option.test_n_; ++i) {
+            profiler.Begin();
+            Vector<std::thread> query_threads;
+            Atomic<i32> cur_i = 0;
+
+            for (SizeT i = 0; i < option.thread_n_; ++i) {
+                query_threads.emplace_back([&] {
+                    SizeT i;
+                    while ((i = cur_i.fetch_add(1)) < query_num) {
+                        const float *query = query_data.get() + i * query_dim;
+                        Vector<Pair<float, LabelT>> pairs = hnsw->KnnSearchSorted(query, topk, search_option);
+                        if (pairs.size() < SizeT(topk)) {
+                            UnrecoverableError("result_n != topk");
+                        }
+                        for (i32 j = 0; j < topk; ++j) {
+                            results[i][j] = pairs[j].second;
+                        }
                     }
-                }
-            });
-        }
-        for (auto &thread : query_threads) {
-            thread.join();
-        }
-        profiler.End();
+                });
+            }
+            for (auto &thread : query_threads) {
+                thread.join();
+            }
+            profiler.End();
 
-        std::cout << fmt::format("Test {} / {}", i + 1, option.test_n_) << std::endl;
-        std::cout << fmt::format("Query time: {}", profiler.ElapsedToString(1000)) << std::endl;
-    }
+            std::cout << fmt::format("ef: {}, patience: {}, test {} / {}", option.ef_, patience, i + 1, option.test_n_) << std::endl;
+            std::cout << fmt::format("Query time: {}", profiler.ElapsedToString(1000)) << std::endl;
+            std::cout << fmt::format("QPS: {:.2f}", query_num / ((profiler.GetEnd() - profiler.GetBegin()) / 1e9)) << std::endl;
+        }
 
-    i32 correct = 0;
-    for (SizeT i = 0; i < query_num; ++i) {
-        HashSet<LabelT> gt_set(gt_data.get() + i * topk, gt_data.get() + (i + 1) * topk);
-        for (i32 j = 0; j < topk; ++j) {
-            if (gt_set.contains(results[i][j])) {
-                correct++;
+        i32 correct = 0;
+        for (SizeT i = 0; i < query_num; ++i) {
+            HashSet<LabelT> gt_set(gt_data.get() + i * topk, gt_data.get() + (i + 1) * topk);
+            for (i32 j = 0; j < topk; ++j) {
+                if (gt_set.contains(results[i][j])) {
+                    correct++;
+                }
             }
         }
+        float recall = float(correct) / (query_num * topk);
+        std::cout << fmt::format("ef: {}, patience: {}, recall: {}", option.ef_, patience, recall) << std::endl;
     }
-    float recall = float(correct) / (query_num * topk);
-    std::cout << "recall: " << recall << std::endl;
 }
 
 template <typename HnswT, typename HnswT2>
@@ -287,6 +329,33 @@ void Compress(const BenchmarkOption &option) {
     hnsw_lvq->Save(*index_file_lvq);
 }
 
+template <typename HnswT>
+void Reorder(const BenchmarkOption &option) {
+    if (option.reorder_type_ == ReorderType::NONE) {
+        UnrecoverableError("Reorder type is not set");
+    }
+    BaseProfiler profiler;
+
+    String index_name = BenchmarkOption::IndexName(option.benchmark_type_, option.build_type_, option.M_, option.ef_construction_);
+    Path index_path = option.index_dir_ / fmt::format("{}.bin", index_name);
+    auto [index_file, index_status] = VirtualStore::Open(index_path.string(), FileAccessMode::kRead);
+    if (!index_status.ok()) {
+        UnrecoverableError(index_status.message());
+    }
+    auto hnsw = HnswT::Load(*index_file);
+
+    profiler.Begin();
+    hnsw->Reorder(option.reorder_type_ == ReorderType::BFS ? HnswReorderType::kBFS : HnswReorderType::kRCM);
+    profiler.End();
+    std::cout << "Reorder time: " << profiler.ElapsedToString(1000) << std::endl;
+
+    auto [reorder_file, reorder_status] = VirtualStore::Open(option.index_save_path_.string(), FileAccessMode::kWrite);
+    if (!reorder_status.ok()) {
+        UnrecoverableError(reorder_status.message());
+    }
+    hnsw->Save(*reorder_file);
+}
+
 int main(int argc, char *argv[]) {
     BenchmarkOption option;
     option.Parse(argc, argv);
@@ -326,6 +395,20 @@ int main(int argc, char *argv[]) {
             Compress<Hnsw, HnswLVQ>(option);
             break;
         }
+        case ModeType::REORDER: {
+            switch (option.build_type_) {
+                case BuildType::PLAIN: {
+                    Reorder<Hnsw>(option);
+                    break;
+                }
+                case BuildType::LVQ:
+                case BuildType::CompressToLVQ: {
+                    Reorder<HnswLVQ>(option);
+                    break;
+                }
+            }
+            break;
+        }
     }
     return 0;
 }
@@ -0,0 +1,128 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <iostream>
+#include <random>
+
+import stl;
+import third_party;
+import profiler;
+import sparse_simd_funcs;
+import sparse_vector_distance;
+import simd_functions;
+
+using namespace infinity;
+
+// Inner product of sparse vectors with the shape of learned sparse embeddings: the scalar merge, the simd merge and the dense query.
+// Usage: sparse_ip_benchmark [doc_n] [doc_nnz] [query_nnz] [term_num]
+
+namespace {
+
+struct SparseMat {
+    Vector<SizeT> indptr_{0};
+    Vector<i32> indices_;
+    Vector<f32> data_;
+};
+
+SparseMat GenerateSparse(SizeT row_n, SizeT nnz, i32 term_num, std::mt19937 &rng) {
+    // frequent terms have small ids, as in a vocabulary sorted by frequency
+    std::exponential_distribution<f64> term_dist(8.0 / term_num);
+    std::uniform_real_distribution<f32> value_dist(0.0f, 1.0f);
+    SparseMat mat;
+    for (SizeT row = 0; row < row_n; ++row) {
+        Set<i32> terms;
+        while (terms.size() < nnz) {
+            terms.insert(std::min<i32>(term_dist(rng), term_num - 1));
+        }
+        for (i32 term : terms) {
+            mat.indices_.push_back(term);
+            mat.data_.push_back(value_dist(rng));
+        }
+        mat.indptr_.push_back(mat.indices_.size());
+    }
+    return mat;
+}
+
+template <typename Func>
+f64 Run(const String &name, const SparseMat &docs, const SparseMat &queries, Func &&func) {
+    BaseProfiler profiler(name);
+    f64 checksum = 0;
+    profiler.Begin();
+    for (SizeT q = 0; q + 1 < queries.indptr_.size(); ++q) {
+        checksum += func(q);
+    }
+    profiler.End();
+    const SizeT pair_n = (docs.indptr_.size() - 1) * (queries.indptr_.size() - 1);
+    std::cout << fmt::format("{:<12} time: {}, {:.1f} ns/pair, checksum: {:.4f}\n",
+                             name,
+                             profiler.ElapsedToString(1000),
+                             f64(profiler.Elapsed()) / pair_n,
+                             checksum);
+    return checksum;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    const SizeT doc_n = argc > 1 ? std::stoull(argv[1]) : 100000;
+    const SizeT doc_nnz = argc > 2 ? std::stoull(argv[2]) : 120;
+    const SizeT query_nnz = argc > 3 ? std::stoull(argv[3]) : 40;
+    const i32 term_num = argc > 4 ? std::stoi(argv[4]) : 30522;
+    const SizeT query_n = 20;
+
+    std::mt19937 rng(0);
+    SparseMat docs = GenerateSparse(doc_n, doc_nnz, term_num, rng);
+    SparseMat queries = GenerateSparse(query_n, query_nnz, term_num, rng);
+    std::cout << fmt::format("doc_n: {}, doc_nnz: {}, query_n: {}, query_nnz: {}, term_num: {}\n", doc_n, doc_nnz, query_n, query_nnz, term_num);
+
+    auto query_ptr = [&](SizeT q) { return Pair(queries.indptr_[q], queries.indptr_[q + 1] - queries.indptr_[q]); };
+    auto doc_ptr = [&](SizeT d) { return Pair(docs.indptr_[d], docs.indptr_[d + 1] - docs.indptr_[d]); };
+
+    const f64 expect = Run("scalar", docs, queries, [&](SizeT q) {
+        const auto [q_off, q_nnz] = query_ptr(q);
+        f64 sum = 0;
+        for (SizeT d = 0; d < doc_n; ++d) {
+            const auto [d_off, d_nnz] = doc_ptr(d);
+            sum += SparseIPF32I32_common(&queries.data_[q_off], &queries.indices_[q_off], q_nnz, &docs.data_[d_off], &docs.indices_[d_off], d_nnz);
+        }
+        return sum;
+    });
+    const auto simd_ip = GetSIMD_FUNCTIONS().SparseIPF32I32_func_ptr_;
+    const f64 simd = Run("simd merge", docs, queries, [&](SizeT q) {
+        const auto [q_off, q_nnz] = query_ptr(q);
+        f64 sum = 0;
+        for (SizeT d = 0; d < doc_n; ++d) {
+            const auto [d_off, d_nnz] = doc_ptr(d);
+            sum += simd_ip(&queries.data_[q_off], &queries.indices_[q_off], q_nnz, &docs.data_[d_off], &docs.indices_[d_off], d_nnz);
+        }
+        return sum;
+    });
+    SparseDenseQuery<f32, i32> dense_query;
+    const f64 dense = Run("dense query", docs, queries, [&](SizeT q) {
+        const auto [q_off, q_nnz] = query_ptr(q);
+        dense_query.Init(&queries.data_[q_off], &queries.indices_[q_off], q_nnz);
+        f64 sum = 0;
+        for (SizeT d = 0; d < doc_n; ++d) {
+            const auto [d_off, d_nnz] = doc_ptr(d);
+            sum += dense_query.IP(&docs.data_[d_off], &docs.indices_[d_off], d_nnz);
+        }
+        return sum;
+    });
+    if (std::abs(simd - expect) > 1e-3 * std::abs(expect) || std::abs(dense - expect) > 1e-3 * std::abs(expect)) {
+        std::cout << "checksum mismatch\n";
+        return 1;
+    }
+    return 0;
+}
@@ -158,6 +158,8 @@ export {
     constexpr f64 DISKANN_THRESHOLD_FOR_CACHING_IN_GB = 1.0;   //
     constexpr u32 DISKANN_NUM_NODES_TO_CACHE = 250000;         // cache node num
     constexpr u32 DISKANN_WARMUP_L = 20;
+    constexpr u32 DISKANN_SEARCH_SCRATCH_NUM = 8;     // concurrent searches of one loaded index
+    constexpr u32 DISKANN_BEAM_WIDTH = 4;             // nodes read from disk in one hop of beam search
     constexpr u32 DISKANN_NUM_KMEANS_REPS = 12;       // max iterations of lloyds kmeans
     constexpr u32 DISKANN_NUM_CENTERS = 256;          // number of centers for pq chunk
     constexpr f32 DISKANN_GRAPH_SLACK_FACTOR = 1.3f;  // In-mem index reserve factor
@@ -199,6 +201,9 @@ export {
 
     constexpr std::string_view DEFAULT_RESULT_CACHE = "off";
     constexpr SizeT DEFAULT_CACHE_RESULT_CAPACITY = 10000;
+    constexpr bool DEFAULT_LOCK_HNSW_UPPER_LAYERS = false;
+    constexpr i64 DEFAULT_HNSW_BUILD_THREAD_NUM = 0; // 0 means half of cpu_limit
+    constexpr bool DEFAULT_HNSW_SEGMENT_GROUP = false;
 
     // default persistence parameter
     constexpr std::string_view DEFAULT_PERSISTENCE_DIR = "/var/infinity/persistence"; // Empty means disabled
@@ -266,6 +271,9 @@ export {
     constexpr std::string_view MEMINDEX_MEMORY_QUOTA_OPTION_NAME = "memindex_memory_quota";
     constexpr std::string_view RESULT_CACHE_OPTION_NAME = "result_cache";
     constexpr std::string_view CACHE_RESULT_CAPACITY_OPTION_NAME = "cache_result_capacity";
+    constexpr std::string_view LOCK_HNSW_UPPER_LAYERS_OPTION_NAME = "lock_hnsw_upper_layers";
+    constexpr std::string_view HNSW_BUILD_THREAD_NUM_OPTION_NAME = "hnsw_build_thread_num";
+    constexpr std::string_view HNSW_SEGMENT_GROUP_OPTION_NAME = "hnsw_segment_group";
 
     constexpr std::string_view WAL_DIR_OPTION_NAME = "wal_dir";
     constexpr std::string_view WAL_COMPACT_THRESHOLD_OPTION_NAME = "wal_compact_threshold";
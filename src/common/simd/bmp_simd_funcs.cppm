@@ -0,0 +1,98 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+#include "simd_common_intrin_include.h"
+export module bmp_simd_funcs;
+import stl;
+
+namespace infinity {
+
+// upper_bounds[i] += weight * max_scores[i], the u8 block max scores of a term in every block
+export void BMPBlockMaxDense_common(const u8 *max_scores, SizeT n, f32 weight, f32 *upper_bounds) {
+    for (SizeT i = 0; i < n; ++i) {
+        upper_bounds[i] += weight * max_scores[i];
+    }
+}
+
+// upper_bounds[block_ids[i]] += weight * max_scores[i], the block ids of a term are distinct
+export void BMPBlockMaxSparse_common(const i32 *block_ids, const u8 *max_scores, SizeT n, f32 weight, f32 *upper_bounds) {
+    for (SizeT i = 0; i < n; ++i) {
+        upper_bounds[block_ids[i]] += weight * max_scores[i];
+    }
+}
+
+// res[offsets[i]] += weight * scores[i], the offsets of a term in a block are distinct
+export void BMPScatterAdd_common(const u8 *offsets, const f32 *scores, SizeT n, f32 weight, f32 *res) {
+    for (SizeT i = 0; i < n; ++i) {
+        res[offsets[i]] += weight * scores[i];
+    }
+}
+
+#if defined(__AVX2__)
+
+export void BMPBlockMaxDense_avx2(const u8 *max_scores, SizeT n, f32 weight, f32 *upper_bounds) {
+    const __m256 w = _mm256_set1_ps(weight);
+    SizeT i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i q = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(max_scores + i)));
+        const __m256 ub = _mm256_fmadd_ps(w, _mm256_cvtepi32_ps(q), _mm256_loadu_ps(upper_bounds + i));
+        _mm256_storeu_ps(upper_bounds + i, ub);
+    }
+    BMPBlockMaxDense_common(max_scores + i, n - i, weight, upper_bounds + i);
+}
+
+#endif // defined (__AVX2__)
+
+#if defined(__AVX512F__)
+
+export void BMPBlockMaxDense_avx512(const u8 *max_scores, SizeT n, f32 weight, f32 *upper_bounds) {
+    const __m512 w = _mm512_set1_ps(weight);
+    SizeT i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m512i q = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(max_scores + i)));
+        const __m512 ub = _mm512_fmadd_ps(w, _mm512_cvtepi32_ps(q), _mm512_loadu_ps(upper_bounds + i));
+        _mm512_storeu_ps(upper_bounds + i, ub);
+    }
+    BMPBlockMaxDense_common(max_scores + i, n - i, weight, upper_bounds + i);
+}
+
+// the indices of one step are distinct, so the scatter does not lose updates
+export void BMPBlockMaxSparse_avx512(const i32 *block_ids, const u8 *max_scores, SizeT n, f32 weight, f32 *upper_bounds) {
+    const __m512 w = _mm512_set1_ps(weight);
+    SizeT i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m512i ids = _mm512_loadu_si512(block_ids + i);
+        const __m512i q = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(max_scores + i)));
+        const __m512 ub = _mm512_fmadd_ps(w, _mm512_cvtepi32_ps(q), _mm512_i32gather_ps(ids, upper_bounds, 4));
+        _mm512_i32scatter_ps(upper_bounds, ids, ub, 4);
+    }
+    BMPBlockMaxSparse_common(block_ids + i, max_scores + i, n - i, weight, upper_bounds);
+}
+
+export void BMPScatterAdd_avx512(const u8 *offsets, const f32 *scores, SizeT n, f32 weight, f32 *res) {
+    const __m512 w = _mm512_set1_ps(weight);
+    SizeT i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m512i idx = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(offsets + i)));
+        const __m512 sum = _mm512_fmadd_ps(w, _mm512_loadu_ps(scores + i), _mm512_i32gather_ps(idx, res, 4));
+        _mm512_i32scatter_ps(res, idx, sum, 4);
+    }
+    BMPScatterAdd_common(offsets + i, scores + i, n - i, weight, res);
+}
+
+#endif // defined (__AVX512F__)
+
+} // namespace infinity
@@ -16,6 +16,7 @@ module;
 
 #include "simd_common_intrin_include.h"
 #include <cmath>
+#include <cstring>
 
 /*
 #if defined(__x86_64__) && (defined(__clang_major__) && (__clang_major__ > 10))
@@ -77,12 +78,21 @@ f32 CosineDistance_common(const f32 *x, const f32 *y, SizeT d) {
 }
 
 f32 HammingDistance_common(const u8 *x, const u8 *y, SizeT d) {
-    f32 result = 0;
-    for (SizeT i = 0; i < d; ++i) {
-        u8 xor_result = x[i] ^ y[i];
+    u64 result = 0;
+    SizeT pos = 0;
+    // 64 bits a time, which is one popcnt instruction
+    for (; pos + 8 <= d; pos += 8) {
+        u64 x_word;
+        u64 y_word;
+        std::memcpy(&x_word, x + pos, sizeof(u64));
+        std::memcpy(&y_word, y + pos, sizeof(u64));
+        result += __builtin_popcountll(x_word ^ y_word);
+    }
+    for (; pos < d; ++pos) {
+        u8 xor_result = x[pos] ^ y[pos];
         result += __builtin_popcount(xor_result);
     }
-    return result;
+    return static_cast<f32>(result);
 }
 
 #if defined(__AVX2__)
@@ -127,6 +137,162 @@ f32 HammingDistance_sse2(const u8 *x, const u8 *y, SizeT d) {
 
 #endif // defined (__SSE2__)
 
+// count the bytes in [begin, code_bytes)
+inline u32 RaBitQ4BitIPRange(const u8 *code, const u8 *planes, SizeT code_bytes, SizeT begin) {
+    u32 result = 0;
+    for (SizeT j = 0; j < 4; ++j) {
+        const u8 *plane = planes + j * code_bytes;
+        u32 cnt = 0;
+        SizeT pos = begin;
+        for (; pos + 8 <= code_bytes; pos += 8) {
+            u64 x, y;
+            std::memcpy(&x, code + pos, sizeof(u64));
+            std::memcpy(&y, plane + pos, sizeof(u64));
+            cnt += __builtin_popcountll(x & y);
+        }
+        for (; pos < code_bytes; ++pos) {
+            cnt += __builtin_popcount(code[pos] & plane[pos]);
+        }
+        result += cnt << j;
+    }
+    return result;
+}
+
+u32 RaBitQ4BitIP_common(const u8 *code, const u8 *planes, SizeT code_bytes) { return RaBitQ4BitIPRange(code, planes, code_bytes, 0); }
+
+void PQ4FastScan_common(const u8 *codes, const u8 *lut, SizeT subspace_num, u16 *result) {
+    std::fill_n(result, 32, 0);
+    for (SizeT j = 0; j < subspace_num; ++j) {
+        const u8 *table = lut + j * 16;
+        const u8 *code = codes + j * 16;
+        for (SizeT i = 0; i < 16; ++i) {
+            result[i] += table[code[i] & 0x0f];
+            result[i + 16] += table[code[i] >> 4];
+        }
+    }
+}
+
+#if defined(__AVX2__)
+
+u32 RaBitQ4BitIP_avx2(const u8 *code, const u8 *planes, SizeT code_bytes) {
+    u32 cnt[4] = {};
+    SizeT pos = 0;
+    for (; pos + 32 <= code_bytes; pos += 32) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(code + pos));
+        for (SizeT j = 0; j < 4; ++j) {
+            const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(planes + j * code_bytes + pos));
+            cnt[j] += popcount_avx2(_mm256_and_si256(x, y));
+        }
+    }
+    u32 result = cnt[0] + (cnt[1] << 1) + (cnt[2] << 2) + (cnt[3] << 3);
+    if (pos < code_bytes) {
+        result += RaBitQ4BitIPRange(code, planes, code_bytes, pos);
+    }
+    return result;
+}
+
+#endif // defined (__AVX2__)
+
+#if defined(__AVX512VPOPCNTDQ__)
+
+u32 RaBitQ4BitIP_avx512vpopcntdq(const u8 *code, const u8 *planes, SizeT code_bytes) {
+    __m512i cnt[4] = {_mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512()};
+    SizeT pos = 0;
+    for (; pos + 64 <= code_bytes; pos += 64) {
+        const __m512i x = _mm512_loadu_si512(code + pos);
+        for (SizeT j = 0; j < 4; ++j) {
+            const __m512i y = _mm512_loadu_si512(planes + j * code_bytes + pos);
+            cnt[j] = _mm512_add_epi64(cnt[j], _mm512_popcnt_epi64(_mm512_and_si512(x, y)));
+        }
+    }
+    u32 result = 0;
+    for (SizeT j = 0; j < 4; ++j) {
+        result += static_cast<u32>(_mm512_reduce_add_epi64(cnt[j])) << j;
+    }
+    if (pos < code_bytes) {
+        result += RaBitQ4BitIPRange(code, planes, code_bytes, pos);
+    }
+    return result;
+}
+
+f32 HammingDistance_avx512vpopcntdq(const u8 *x, const u8 *y, SizeT d) {
+    __m512i cnt = _mm512_setzero_si512();
+    SizeT pos = 0;
+    // 8 * 64 = 512
+    for (; pos + 64 <= d; pos += 64) {
+        const __m512i xor_result = _mm512_xor_si512(_mm512_loadu_si512(x + pos), _mm512_loadu_si512(y + pos));
+        cnt = _mm512_add_epi64(cnt, _mm512_popcnt_epi64(xor_result));
+    }
+    f32 result = static_cast<f32>(_mm512_reduce_add_epi64(cnt));
+    if (pos < d) {
+        result += HammingDistance_common(x + pos, y + pos, d - pos);
+    }
+    return result;
+}
+
+#endif // defined (__AVX512VPOPCNTDQ__)
+
+#if defined(__AVX2__)
+
+// two subspaces, one in every 128 bit lane, the lanes are added up by the caller
+inline void PQ4FastScanStep_avx2(const u8 *codes, const u8 *lut, __m256i *acc) {
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i table = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lut));
+    const __m256i code = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(codes));
+    const __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(code, low_mask));
+    const __m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(code, 4), low_mask));
+    acc[0] = _mm256_add_epi16(acc[0], _mm256_unpacklo_epi8(lo, zero)); // vectors 0 - 7
+    acc[1] = _mm256_add_epi16(acc[1], _mm256_unpackhi_epi8(lo, zero)); // vectors 8 - 15
+    acc[2] = _mm256_add_epi16(acc[2], _mm256_unpacklo_epi8(hi, zero)); // vectors 16 - 23
+    acc[3] = _mm256_add_epi16(acc[3], _mm256_unpackhi_epi8(hi, zero)); // vectors 24 - 31
+}
+
+void PQ4FastScan_avx2(const u8 *codes, const u8 *lut, SizeT subspace_num, u16 *result) {
+    __m256i acc[4] = {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256()};
+    for (SizeT j = 0; j < subspace_num; j += 2) {
+        PQ4FastScanStep_avx2(codes + j * 16, lut + j * 16, acc);
+    }
+    for (SizeT i = 0; i < 4; ++i) {
+        const __m128i sum = _mm_add_epi16(_mm256_castsi256_si128(acc[i]), _mm256_extracti128_si256(acc[i], 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(result + i * 8), sum);
+    }
+}
+
+#endif // defined (__AVX2__)
+
+#if defined(__AVX512BW__)
+
+void PQ4FastScan_avx512bw(const u8 *codes, const u8 *lut, SizeT subspace_num, u16 *result) {
+    const __m512i low_mask = _mm512_set1_epi8(0x0f);
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i acc[4] = {zero, zero, zero, zero};
+    SizeT j = 0;
+    for (; j + 4 <= subspace_num; j += 4) {
+        const __m512i table = _mm512_loadu_si512(lut + j * 16);
+        const __m512i code = _mm512_loadu_si512(codes + j * 16);
+        const __m512i lo = _mm512_shuffle_epi8(table, _mm512_and_si512(code, low_mask));
+        const __m512i hi = _mm512_shuffle_epi8(table, _mm512_and_si512(_mm512_srli_epi16(code, 4), low_mask));
+        acc[0] = _mm512_add_epi16(acc[0], _mm512_unpacklo_epi8(lo, zero));
+        acc[1] = _mm512_add_epi16(acc[1], _mm512_unpackhi_epi8(lo, zero));
+        acc[2] = _mm512_add_epi16(acc[2], _mm512_unpacklo_epi8(hi, zero));
+        acc[3] = _mm512_add_epi16(acc[3], _mm512_unpackhi_epi8(hi, zero));
+    }
+    __m256i acc256[4];
+    for (SizeT i = 0; i < 4; ++i) {
+        acc256[i] = _mm256_add_epi16(_mm512_castsi512_si256(acc[i]), _mm512_extracti64x4_epi64(acc[i], 1));
+    }
+    if (j < subspace_num) {
+        PQ4FastScanStep_avx2(codes + j * 16, lut + j * 16, acc256);
+    }
+    for (SizeT i = 0; i < 4; ++i) {
+        const __m128i sum = _mm_add_epi16(_mm256_castsi256_si128(acc256[i]), _mm256_extracti128_si256(acc256[i], 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(result + i * 8), sum);
+    }
+}
+
+#endif // defined (__AVX512BW__)
+
 #if defined(__AVX2__)
 inline f32 L2Distance_avx2_128(const f32 *vector1, const f32 *vector2, SizeT) {
     __m256 diff_1 = _mm256_sub_ps(_mm256_loadu_ps(vector1), _mm256_loadu_ps(vector2));
@@ -301,4 +467,282 @@ f32 CosineDistance_avx2(const f32 *vector1, const f32 *vector2, SizeT dimension)
 }
 #endif
 
+// half precision, fp16 and bf16 elements are passed as their raw u16 bits and computed in f32
+
+namespace {
+
+inline f32 F16ToF32(const u16 h) {
+    const u32 sign = u32(h & 0x8000u) << 16;
+    const u32 exp = (h >> 10) & 0x1fu;
+    const u32 mant = h & 0x3ffu;
+    if (exp == 0) {
+        // zero or subnormal
+        const f32 v = std::ldexp(static_cast<f32>(mant), -24);
+        return sign ? -v : v;
+    }
+    u32 bits = sign | (mant << 13);
+    if (exp == 0x1fu) {
+        bits |= 0x7f800000u;
+    } else {
+        bits |= (exp + 112) << 23;
+    }
+    f32 res;
+    std::memcpy(&res, &bits, sizeof(res));
+    return res;
+}
+
+inline f32 BF16ToF32(const u16 h) {
+    const u32 bits = u32(h) << 16;
+    f32 res;
+    std::memcpy(&res, &bits, sizeof(res));
+    return res;
+}
+
+struct F32Elem {
+    using T = f32;
+    static f32 ToF32(const f32 *p) { return *p; }
+#if defined(__AVX2__)
+    static __m256 Load8(const f32 *p) { return _mm256_loadu_ps(p); }
+#endif
+#if defined(__AVX512F__)
+    static __m512 Load16(const f32 *p) { return _mm512_loadu_ps(p); }
+#endif
+};
+
+struct F16Elem {
+    using T = u16;
+    static f32 ToF32(const u16 *p) { return F16ToF32(*p); }
+#if defined(__AVX2__) && defined(__F16C__)
+    static __m256 Load8(const u16 *p) { return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))); }
+#endif
+#if defined(__AVX512F__)
+    static __m512 Load16(const u16 *p) { return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))); }
+#endif
+};
+
+struct BF16Elem {
+    using T = u16;
+    static f32 ToF32(const u16 *p) { return BF16ToF32(*p); }
+#if defined(__AVX2__)
+    static __m256 Load8(const u16 *p) {
+        const __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(v, 16));
+    }
+#endif
+#if defined(__AVX512F__)
+    static __m512 Load16(const u16 *p) {
+        const __m512i v = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+        return _mm512_castsi512_ps(_mm512_slli_epi32(v, 16));
+    }
+#endif
+};
+
+template <typename E1, typename E2>
+f32 HalfL2Common(const typename E1::T *x, const typename E2::T *y, SizeT d) {
+    f32 res = 0.0f;
+    for (SizeT i = 0; i < d; ++i) {
+        const f32 tmp = E1::ToF32(x + i) - E2::ToF32(y + i);
+        res += tmp * tmp;
+    }
+    return res;
+}
+
+template <typename E1, typename E2>
+f32 HalfIPCommon(const typename E1::T *x, const typename E2::T *y, SizeT d) {
+    f32 res = 0.0f;
+    for (SizeT i = 0; i < d; ++i) {
+        res += E1::ToF32(x + i) * E2::ToF32(y + i);
+    }
+    return res;
+}
+
+struct CosSums {
+    f32 dot_ = 0.0f;
+    f32 sqr_x_ = 0.0f;
+    f32 sqr_y_ = 0.0f;
+
+    f32 Result() const { return dot_ ? dot_ / std::sqrt(sqr_x_ * sqr_y_) : 0.0f; }
+};
+
+template <typename E1, typename E2>
+void HalfCosAccumulate(const typename E1::T *x, const typename E2::T *y, SizeT d, CosSums &sums) {
+    for (SizeT i = 0; i < d; ++i) {
+        const f32 fx = E1::ToF32(x + i);
+        const f32 fy = E2::ToF32(y + i);
+        sums.dot_ += fx * fy;
+        sums.sqr_x_ += fx * fx;
+        sums.sqr_y_ += fy * fy;
+    }
+}
+
+template <typename E1, typename E2>
+f32 HalfCosCommon(const typename E1::T *x, const typename E2::T *y, SizeT d) {
+    CosSums sums;
+    HalfCosAccumulate<E1, E2>(x, y, d, sums);
+    return sums.Result();
+}
+
+#if defined(__AVX2__)
+template <typename E1, typename E2>
+f32 HalfL2AVX2(const typename E1::T *x, const typename E2::T *y, SizeT d) {
+    __m256 sum = _mm256_setzero_ps();
+    SizeT i = 0;
+    for (; i + 8 <= d; i += 8) {
+        const __m256 diff = _mm256_sub_ps(E1::Load8(x + i), E2::Load8(y + i));
+        sum = _mm256_fmadd_ps(diff, diff, sum);
+    }
+    f32 res = hsum256_ps_avx(sum);
+    if (i < d) {
+        res += HalfL2Common<E1, E2>(x + i, y + i, d - i);
+    }
+    return res;
+}
+
+template <typename E1, typename E2>
+f32 HalfIPAVX2(const typename E1::T *x, const typename E2::T *y, SizeT d) {
+    __m256 sum = _mm256_setzero_ps();
+    SizeT i = 0;
+    for (; i + 8 <= d; i += 8) {
+        sum = _mm256_fmadd_ps(E1::Load8(x + i), E2::Load8(y + i), sum);
+    }
+    f32 res = hsum256_ps_avx(sum);
+    if (i < d) {
+        res += HalfIPCommon<E1, E2>(x + i, y + i, d - i);
+    }
+    return res;
+}
+
+template <typename E1, typename E2>
+f32 HalfCosAVX2(const typename E1::T *x, const typename E2::T *y, SizeT d) {
+    __m256 dot = _mm256_setzero_ps();
+    __m256 sqr_x = _mm256_setzero_ps();
+    __m256 sqr_y = _mm256_setzero_ps();
+    SizeT i = 0;
+    for (; i + 8 <= d; i += 8) {
+        const __m256 vx = E1::Load8(x + i);
+        const __m256 vy = E2::Load8(y + i);
+        dot = _mm256_fmadd_ps(vx, vy, dot);
+        sqr_x = _mm256_fmadd_ps(vx, vx, sqr_x);
+        sqr_y = _mm256_fmadd_ps(vy, vy, sqr_y);
+    }
+    CosSums sums{hsum256_ps_avx(dot), hsum256_ps_avx(sqr_x), hsum256_ps_avx(sqr_y)};
+    HalfCosAccumulate<E1, E2>(x + i, y + i, d - i, sums);
+    return sums.Result();
+}
+#endif
+
+#if defined(__AVX512F__)
+template <typename E1, typename E2>
+f32 HalfL2AVX512(const typename E1::T *x, const typename E2::T *y, SizeT d) {
+    __m512 sum = _mm512_setzero_ps();
+    SizeT i = 0;
+    for (; i + 16 <= d; i += 16) {
+        const __m512 diff = _mm512_sub_ps(E1::Load16(x + i), E2::Load16(y + i));
+        sum = _mm512_fmadd_ps(diff, diff, sum);
+    }
+    f32 res = _mm512_reduce_add_ps(sum);
+    if (i < d) {
+        res += HalfL2Common<E1, E2>(x + i, y + i, d - i);
+    }
+    return res;
+}
+
+template <typename E1, typename E2>
+f32 HalfIPAVX512(const typename E1::T *x, const typename E2::T *y, SizeT d) {
+    __m512 sum = _mm512_setzero_ps();
+    SizeT i = 0;
+    for (; i + 16 <= d; i += 16) {
+        sum = _mm512_fmadd_ps(E1::Load16(x + i), E2::Load16(y + i), sum);
+    }
+    f32 res = _mm512_reduce_add_ps(sum);
+    if (i < d) {
+        res += HalfIPCommon<E1, E2>(x + i, y + i, d - i);
+    }
+    return res;
+}
+
+template <typename E1, typename E2>
+f32 HalfCosAVX512(const typename E1::T *x, const typename E2::T *y, SizeT d) {
+    __m512 dot = _mm512_setzero_ps();
+    __m512 sqr_x = _mm512_setzero_ps();
+    __m512 sqr_y = _mm512_setzero_ps();
+    SizeT i = 0;
+    for (; i + 16 <= d; i += 16) {
+        const __m512 vx = E1::Load16(x + i);
+        const __m512 vy = E2::Load16(y + i);
+        dot = _mm512_fmadd_ps(vx, vy, dot);
+        sqr_x = _mm512_fmadd_ps(vx, vx, sqr_x);
+        sqr_y = _mm512_fmadd_ps(vy, vy, sqr_y);
+    }
+    CosSums sums{_mm512_reduce_add_ps(dot), _mm512_reduce_add_ps(sqr_x), _mm512_reduce_add_ps(sqr_y)};
+    HalfCosAccumulate<E1, E2>(x + i, y + i, d - i, sums);
+    return sums.Result();
+}
+#endif
+
+} // namespace
+
+f32 F16L2Distance_common(const u16 *x, const u16 *y, SizeT d) { return HalfL2Common<F16Elem, F16Elem>(x, y, d); }
+f32 F16IPDistance_common(const u16 *x, const u16 *y, SizeT d) { return HalfIPCommon<F16Elem, F16Elem>(x, y, d); }
+f32 F16CosineDistance_common(const u16 *x, const u16 *y, SizeT d) { return HalfCosCommon<F16Elem, F16Elem>(x, y, d); }
+f32 BF16L2Distance_common(const u16 *x, const u16 *y, SizeT d) { return HalfL2Common<BF16Elem, BF16Elem>(x, y, d); }
+f32 BF16IPDistance_common(const u16 *x, const u16 *y, SizeT d) { return HalfIPCommon<BF16Elem, BF16Elem>(x, y, d); }
+f32 BF16CosineDistance_common(const u16 *x, const u16 *y, SizeT d) { return HalfCosCommon<BF16Elem, BF16Elem>(x, y, d); }
+f32 F32F16L2Distance_common(const f32 *x, const u16 *y, SizeT d) { return HalfL2Common<F32Elem, F16Elem>(x, y, d); }
+f32 F32F16IPDistance_common(const f32 *x, const u16 *y, SizeT d) { return HalfIPCommon<F32Elem, F16Elem>(x, y, d); }
+f32 F32F16CosineDistance_common(const f32 *x, const u16 *y, SizeT d) { return HalfCosCommon<F32Elem, F16Elem>(x, y, d); }
+f32 F32BF16L2Distance_common(const f32 *x, const u16 *y, SizeT d) { return HalfL2Common<F32Elem, BF16Elem>(x, y, d); }
+f32 F32BF16IPDistance_common(const f32 *x, const u16 *y, SizeT d) { return HalfIPCommon<F32Elem, BF16Elem>(x, y, d); }
+f32 F32BF16CosineDistance_common(const f32 *x, const u16 *y, SizeT d) { return HalfCosCommon<F32Elem, BF16Elem>(x, y, d); }
+
+#if defined(__AVX2__) && defined(__F16C__)
+f32 F16L2Distance_f16c(const u16 *x, const u16 *y, SizeT d) { return HalfL2AVX2<F16Elem, F16Elem>(x, y, d); }
+f32 F16IPDistance_f16c(const u16 *x, const u16 *y, SizeT d) { return HalfIPAVX2<F16Elem, F16Elem>(x, y, d); }
+f32 F16CosineDistance_f16c(const u16 *x, const u16 *y, SizeT d) { return HalfCosAVX2<F16Elem, F16Elem>(x, y, d); }
+f32 F32F16L2Distance_f16c(const f32 *x, const u16 *y, SizeT d) { return HalfL2AVX2<F32Elem, F16Elem>(x, y, d); }
+f32 F32F16IPDistance_f16c(const f32 *x, const u16 *y, SizeT d) { return HalfIPAVX2<F32Elem, F16Elem>(x, y, d); }
+f32 F32F16CosineDistance_f16c(const f32 *x, const u16 *y, SizeT d) { return HalfCosAVX2<F32Elem, F16Elem>(x, y, d); }
+#endif
+
+#if defined(__AVX2__)
+f32 BF16L2Distance_avx2(const u16 *x, const u16 *y, SizeT d) { return HalfL2AVX2<BF16Elem, BF16Elem>(x, y, d); }
+f32 BF16IPDistance_avx2(const u16 *x, const u16 *y, SizeT d) { return HalfIPAVX2<BF16Elem, BF16Elem>(x, y, d); }
+f32 BF16CosineDistance_avx2(const u16 *x, const u16 *y, SizeT d) { return HalfCosAVX2<BF16Elem, BF16Elem>(x, y, d); }
+f32 F32BF16L2Distance_avx2(const f32 *x, const u16 *y, SizeT d) { return HalfL2AVX2<F32Elem, BF16Elem>(x, y, d); }
+f32 F32BF16IPDistance_avx2(const f32 *x, const u16 *y, SizeT d) { return HalfIPAVX2<F32Elem, BF16Elem>(x, y, d); }
+f32 F32BF16CosineDistance_avx2(const f32 *x, const u16 *y, SizeT d) { return HalfCosAVX2<F32Elem, BF16Elem>(x, y, d); }
+#endif
+
+#if defined(__AVX512F__)
+f32 F16L2Distance_avx512(const u16 *x, const u16 *y, SizeT d) { return HalfL2AVX512<F16Elem, F16Elem>(x, y, d); }
+f32 F16IPDistance_avx512(const u16 *x, const u16 *y, SizeT d) { return HalfIPAVX512<F16Elem, F16Elem>(x, y, d); }
+f32 F16CosineDistance_avx512(const u16 *x, const u16 *y, SizeT d) { return HalfCosAVX512<F16Elem, F16Elem>(x, y, d); }
+f32 BF16L2Distance_avx512(const u16 *x, const u16 *y, SizeT d) { return HalfL2AVX512<BF16Elem, BF16Elem>(x, y, d); }
+f32 BF16IPDistance_avx512(const u16 *x, const u16 *y, SizeT d) { return HalfIPAVX512<BF16Elem, BF16Elem>(x, y, d); }
+f32 BF16CosineDistance_avx512(const u16 *x, const u16 *y, SizeT d) { return HalfCosAVX512<BF16Elem, BF16Elem>(x, y, d); }
+f32 F32F16L2Distance_avx512(const f32 *x, const u16 *y, SizeT d) { return HalfL2AVX512<F32Elem, F16Elem>(x, y, d); }
+f32 F32F16IPDistance_avx512(const f32 *x, const u16 *y, SizeT d) { return HalfIPAVX512<F32Elem, F16Elem>(x, y, d); }
+f32 F32F16CosineDistance_avx512(const f32 *x, const u16 *y, SizeT d) { return HalfCosAVX512<F32Elem, F16Elem>(x, y, d); }
+f32 F32BF16L2Distance_avx512(const f32 *x, const u16 *y, SizeT d) { return HalfL2AVX512<F32Elem, BF16Elem>(x, y, d); }
+f32 F32BF16IPDistance_avx512(const f32 *x, const u16 *y, SizeT d) { return HalfIPAVX512<F32Elem, BF16Elem>(x, y, d); }
+f32 F32BF16CosineDistance_avx512(const f32 *x, const u16 *y, SizeT d) { return HalfCosAVX512<F32Elem, BF16Elem>(x, y, d); }
+#endif
+
+#if defined(__AVX512BF16__)
+f32 BF16IPDistance_avx512bf16(const u16 *x, const u16 *y, SizeT d) {
+    __m512 sum = _mm512_setzero_ps();
+    SizeT i = 0;
+    for (; i + 32 <= d; i += 32) {
+        const auto vx = (__m512bh)_mm512_loadu_si512(x + i);
+        const auto vy = (__m512bh)_mm512_loadu_si512(y + i);
+        sum = _mm512_dpbf16_ps(sum, vx, vy);
+    }
+    f32 res = _mm512_reduce_add_ps(sum);
+    if (i < d) {
+        res += HalfIPCommon<BF16Elem, BF16Elem>(x + i, y + i, d - i);
+    }
+    return res;
+}
+#endif
+
 } // namespace infinity
@@ -28,6 +28,13 @@ export f32 CosineDistance_common(const f32 *x, const f32 *y, SizeT d);
 
 export f32 HammingDistance_common(const u8 *x, const u8 *y, SizeT d);
 
+// sum of (popcount(code & plane_j) << j) over the 4 bit planes of a quantized query, code and every plane have `code_bytes` bytes
+export u32 RaBitQ4BitIP_common(const u8 *code, const u8 *planes, SizeT code_bytes);
+
+// u16 sums of the u8 table entries of the 4 bit codes of a block of 32 vectors, `lut` has 16 entries per subspace.
+// For every subspace the block has 16 bytes, vector i is in the low half of byte i and vector i + 16 in the high half.
+export void PQ4FastScan_common(const u8 *codes, const u8 *lut, SizeT subspace_num, u16 *result);
+
 #if defined(__AVX2__)
 export f32 L2Distance_avx2(const f32 *vector1, const f32 *vector2, SizeT dimension);
 
@@ -36,10 +43,77 @@ export f32 IPDistance_avx2(const f32 *vector1, const f32 *vector2, SizeT dimensi
 export f32 CosineDistance_avx2(const f32 *vector1, const f32 *vector2, SizeT dimension);
 
 export f32 HammingDistance_avx2(const u8 *vector1, const u8 *vector2, SizeT dimension);
+
+export u32 RaBitQ4BitIP_avx2(const u8 *code, const u8 *planes, SizeT code_bytes);
+
+// `subspace_num` is even
+export void PQ4FastScan_avx2(const u8 *codes, const u8 *lut, SizeT subspace_num, u16 *result);
+#endif
+
+#if defined(__AVX512VPOPCNTDQ__)
+export u32 RaBitQ4BitIP_avx512vpopcntdq(const u8 *code, const u8 *planes, SizeT code_bytes);
+
+export f32 HammingDistance_avx512vpopcntdq(const u8 *vector1, const u8 *vector2, SizeT dimension);
+#endif
+
+#if defined(__AVX512BW__)
+// `subspace_num` is even
+export void PQ4FastScan_avx512bw(const u8 *codes, const u8 *lut, SizeT subspace_num, u16 *result);
 #endif
 
 #if defined(__SSE2__)
 export f32 HammingDistance_sse2(const u8 *vector1, const u8 *vector2, SizeT dimesion);
 #endif
 
+// half precision, the u16 arguments are raw fp16 / bf16 bits, f32 arguments are queries
+export f32 F16L2Distance_common(const u16 *x, const u16 *y, SizeT d);
+export f32 F16IPDistance_common(const u16 *x, const u16 *y, SizeT d);
+export f32 F16CosineDistance_common(const u16 *x, const u16 *y, SizeT d);
+export f32 BF16L2Distance_common(const u16 *x, const u16 *y, SizeT d);
+export f32 BF16IPDistance_common(const u16 *x, const u16 *y, SizeT d);
+export f32 BF16CosineDistance_common(const u16 *x, const u16 *y, SizeT d);
+export f32 F32F16L2Distance_common(const f32 *x, const u16 *y, SizeT d);
+export f32 F32F16IPDistance_common(const f32 *x, const u16 *y, SizeT d);
+export f32 F32F16CosineDistance_common(const f32 *x, const u16 *y, SizeT d);
+export f32 F32BF16L2Distance_common(const f32 *x, const u16 *y, SizeT d);
+export f32 F32BF16IPDistance_common(const f32 *x, const u16 *y, SizeT d);
+export f32 F32BF16CosineDistance_common(const f32 *x, const u16 *y, SizeT d);
+
+#if defined(__AVX2__) && defined(__F16C__)
+export f32 F16L2Distance_f16c(const u16 *x, const u16 *y, SizeT d);
+export f32 F16IPDistance_f16c(const u16 *x, const u16 *y, SizeT d);
+export f32 F16CosineDistance_f16c(const u16 *x, const u16 *y, SizeT d);
+export f32 F32F16L2Distance_f16c(const f32 *x, const u16 *y, SizeT d);
+export f32 F32F16IPDistance_f16c(const f32 *x, const u16 *y, SizeT d);
+export f32 F32F16CosineDistance_f16c(const f32 *x, const u16 *y, SizeT d);
+#endif
+
+#if defined(__AVX2__)
+export f32 BF16L2Distance_avx2(const u16 *x, const u16 *y, SizeT d);
+export f32 BF16IPDistance_avx2(const u16 *x, const u16 *y, SizeT d);
+export f32 BF16CosineDistance_avx2(const u16 *x, const u16 *y, SizeT d);
+export f32 F32BF16L2Distance_avx2(const f32 *x, const u16 *y, SizeT d);
+export f32 F32BF16IPDistance_avx2(const f32 *x, const u16 *y, SizeT d);
+export f32 F32BF16CosineDistance_avx2(const f32 *x, const u16 *y, SizeT d);
+#endif
+
+#if defined(__AVX512F__)
+export f32 F16L2Distance_avx512(const u16 *x, const u16 *y, SizeT d);
+export f32 F16IPDistance_avx512(const u16 *x, const u16 *y, SizeT d);
+export f32 F16CosineDistance_avx512(const u16 *x, const u16 *y, SizeT d);
+export f32 BF16L2Distance_avx512(const u16 *x, const u16 *y, SizeT d);
+export f32 BF16IPDistance_avx512(const u16 *x, const u16 *y, SizeT d);
+export f32 BF16CosineDistance_avx512(const u16 *x, const u16 *y, SizeT d);
+export f32 F32F16L2Distance_avx512(const f32 *x, const u16 *y, SizeT d);
+export f32 F32F16IPDistance_avx512(const f32 *x, const u16 *y, SizeT d);
+export f32 F32F16CosineDistance_avx512(const f32 *x, const u16 *y, SizeT d);
+export f32 F32BF16L2Distance_avx512(const f32 *x, const u16 *y, SizeT d);
+export f32 F32BF16IPDistance_avx512(const f32 *x, const u16 *y, SizeT d);
+export f32 F32BF16CosineDistance_avx512(const f32 *x, const u16 *y, SizeT d);
+#endif
+
+#if defined(__AVX512BF16__)
+export f32 BF16IPDistance_avx512bf16(const u16 *x, const u16 *y, SizeT d);
+#endif
+
 } // namespace infinity
@@ -62,30 +62,23 @@ export u32 *filter_scores_output_ids_avx2(u32 *output_id_ptr, const f32 threshol
     return output_id_ptr;
 }
 
+// MaxSim of 32 query tokens over the rows of the transposed query token - centroid score table picked by centroid_ids.
+// The max starts from 0, so a token scores 0 if no row is picked or all its scores are negative.
 export template <u32 FIXED_QUERY_TOKEN_NUM, u32 BEGIN_OFFSET>
-inline f32 GetMaxSim32Width(const f32 *centroid_distances, const u32 doclen) {
+inline f32 GetCentroidInteraction32Width(const f32 *centroids_scores_transposed, const u32 *centroid_ids, const u32 centroid_num) {
     static_assert(BEGIN_OFFSET % 32 == 0);
     static_assert(FIXED_QUERY_TOKEN_NUM > 0 && FIXED_QUERY_TOKEN_NUM % 32 == 0);
     static_assert(BEGIN_OFFSET < FIXED_QUERY_TOKEN_NUM);
-    centroid_distances += BEGIN_OFFSET;
-    __m256 max0 = _mm256_load_ps(centroid_distances);
-    __m256 max1 = _mm256_load_ps(centroid_distances + 8);
-    __m256 max2 = _mm256_load_ps(centroid_distances + 16);
-    __m256 max3 = _mm256_load_ps(centroid_distances + 24);
-    for (u32 i = 1; i < doclen; ++i) {
-        centroid_distances += FIXED_QUERY_TOKEN_NUM;
-        __m256 current0 = _mm256_load_ps(centroid_distances);
-        __m256 current1 = _mm256_load_ps(centroid_distances + 8);
-        __m256 current2 = _mm256_load_ps(centroid_distances + 16);
-        __m256 current3 = _mm256_load_ps(centroid_distances + 24);
-        auto cmp0 = _mm256_cmp_ps(current0, max0, _CMP_GT_OS);
-        auto cmp1 = _mm256_cmp_ps(current1, max1, _CMP_GT_OS);
-        auto cmp2 = _mm256_cmp_ps(current2, max2, _CMP_GT_OS);
-        auto cmp3 = _mm256_cmp_ps(current3, max3, _CMP_GT_OS);
-        max0 = _mm256_blendv_ps(max0, current0, cmp0);
-        max1 = _mm256_blendv_ps(max1, current1, cmp1);
-        max2 = _mm256_blendv_ps(max2, current2, cmp2);
-        max3 = _mm256_blendv_ps(max3, current3, cmp3);
+    __m256 max0 = _mm256_setzero_ps();
+    __m256 max1 = _mm256_setzero_ps();
+    __m256 max2 = _mm256_setzero_ps();
+    __m256 max3 = _mm256_setzero_ps();
+    for (u32 i = 0; i < centroid_num; ++i) {
+        const f32 *row = centroids_scores_transposed + static_cast<SizeT>(centroid_ids[i]) * FIXED_QUERY_TOKEN_NUM + BEGIN_OFFSET;
+        max0 = _mm256_max_ps(max0, _mm256_loadu_ps(row));
+        max1 = _mm256_max_ps(max1, _mm256_loadu_ps(row + 8));
+        max2 = _mm256_max_ps(max2, _mm256_loadu_ps(row + 16));
+        max3 = _mm256_max_ps(max3, _mm256_loadu_ps(row + 24));
     }
     __m256 half_sum_1 = _mm256_add_ps(max0, max1);
     __m256 half_sum_2 = _mm256_add_ps(max2, max3);
@@ -1216,4 +1216,48 @@ export float F32IPSSEResidual(const float *pVect1, const float *pVect2, SizeT qt
 
 #endif
 
+//------------------------------//------------------------------//------------------------------
+
+// PQ asymmetric distance: sum of lut[i * 256 + codes[i]] over all subspaces.
+// lut holds the query-to-centroid distances of every subspace, 256 entries per subspace.
+export float PQ8ADCBF(const float *lut, const uint8_t *codes, SizeT subspace_num) {
+    float res = 0;
+    for (SizeT i = 0; i < subspace_num; ++i) {
+        res += lut[(i << 8) + codes[i]];
+    }
+    return res;
+}
+
+#if defined(__AVX512F__)
+
+export float PQ8ADCAVX512(const float *lut, const uint8_t *codes, SizeT subspace_num) {
+    const __m512i offset = _mm512_setr_epi32(0, 256, 512, 768, 1024, 1280, 1536, 1792, 2048, 2304, 2560, 2816, 3072, 3328, 3584, 3840);
+    __m512 sum = _mm512_setzero_ps();
+    SizeT i = 0;
+    for (; i + 16 <= subspace_num; i += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(codes + i));
+        __m512i idx = _mm512_add_epi32(_mm512_cvtepu8_epi32(c), offset);
+        sum = _mm512_add_ps(sum, _mm512_i32gather_ps(idx, lut + (i << 8), 4));
+    }
+    return _mm512_reduce_add_ps(sum) + PQ8ADCBF(lut + (i << 8), codes + i, subspace_num - i);
+}
+
+#endif
+
+#if defined(__AVX2__)
+
+export float PQ8ADCAVX2(const float *lut, const uint8_t *codes, SizeT subspace_num) {
+    const __m256i offset = _mm256_setr_epi32(0, 256, 512, 768, 1024, 1280, 1536, 1792);
+    __m256 sum = _mm256_setzero_ps();
+    SizeT i = 0;
+    for (; i + 8 <= subspace_num; i += 8) {
+        __m128i c = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(codes + i));
+        __m256i idx = _mm256_add_epi32(_mm256_cvtepu8_epi32(c), offset);
+        sum = _mm256_add_ps(sum, _mm256_i32gather_ps(lut + (i << 8), idx, 4));
+    }
+    return hsum256_ps_avx(sum) + PQ8ADCBF(lut + (i << 8), codes + i, subspace_num - i);
+}
+
+#endif
+
 } // namespace infinity
@@ -26,6 +26,22 @@ export struct SIMD_FUNCTIONS {
     F32DistanceFuncType IPDistance_func_ptr_ = GetIPDistanceFuncPtr();
     F32DistanceFuncType CosineDistance_func_ptr_ = GetCosineDistanceFuncPtr();
     U8HammingDistanceFuncType HammingDistance_func_ptr_ = GetHammingDistanceFuncPtr();
+    RaBitQ4BitIPFuncType RaBitQ4BitIP_func_ptr_ = GetRaBitQ4BitIPFuncPtr();
+    PQ4FastScanFuncType PQ4FastScan_func_ptr_ = GetPQ4FastScanFuncPtr();
+
+    // half precision distance functions
+    F16DistanceFuncType F16L2Distance_func_ptr_ = GetF16L2DistanceFuncPtr();
+    F16DistanceFuncType F16IPDistance_func_ptr_ = GetF16IPDistanceFuncPtr();
+    F16DistanceFuncType F16CosineDistance_func_ptr_ = GetF16CosineDistanceFuncPtr();
+    BF16DistanceFuncType BF16L2Distance_func_ptr_ = GetBF16L2DistanceFuncPtr();
+    BF16DistanceFuncType BF16IPDistance_func_ptr_ = GetBF16IPDistanceFuncPtr();
+    BF16DistanceFuncType BF16CosineDistance_func_ptr_ = GetBF16CosineDistanceFuncPtr();
+    F32F16DistanceFuncType F32F16L2Distance_func_ptr_ = GetF32F16L2DistanceFuncPtr();
+    F32F16DistanceFuncType F32F16IPDistance_func_ptr_ = GetF32F16IPDistanceFuncPtr();
+    F32F16DistanceFuncType F32F16CosineDistance_func_ptr_ = GetF32F16CosineDistanceFuncPtr();
+    F32BF16DistanceFuncType F32BF16L2Distance_func_ptr_ = GetF32BF16L2DistanceFuncPtr();
+    F32BF16DistanceFuncType F32BF16IPDistance_func_ptr_ = GetF32BF16IPDistanceFuncPtr();
+    F32BF16DistanceFuncType F32BF16CosineDistance_func_ptr_ = GetF32BF16CosineDistanceFuncPtr();
 
     // HNSW F32
     F32DistanceFuncType HNSW_F32L2_ptr_ = Get_HNSW_F32L2_ptr();
@@ -57,6 +73,9 @@ export struct SIMD_FUNCTIONS {
     U8DistanceFuncType HNSW_U8IP_64_ptr_ = Get_HNSW_U8IP_64_ptr();
     U8CosDistanceFuncType HNSW_U8Cos_ptr_ = Get_HNSW_U8Cos_ptr();
 
+    // HNSW PQ
+    PQ8ADCFuncType HNSW_PQ8ADC_ptr_ = Get_HNSW_PQ8ADC_ptr();
+
     // MaxSim IP
     MaxSimF32BitIPFuncType MaxSimF32BitIP_func_ptr_ = GetMaxSimF32BitIPFuncPtr();
     MaxSimI32BitIPFuncType MaxSimI32BitIP_func_ptr_ = GetMaxSimI32BitIPFuncPtr();
@@ -67,6 +86,16 @@ export struct SIMD_FUNCTIONS {
 
     // K-means
     SearchTop1WithDisF32U32FuncType SearchTop1WithDisF32U32_func_ptr_ = GetSearchTop1WithDisF32U32FuncPtr();
+
+    // BMP
+    BMPBlockMaxDenseFuncType BMPBlockMaxDense_func_ptr_ = GetBMPBlockMaxDenseFuncPtr();
+    BMPBlockMaxSparseFuncType BMPBlockMaxSparse_func_ptr_ = GetBMPBlockMaxSparseFuncPtr();
+    BMPScatterAddFuncType BMPScatterAdd_func_ptr_ = GetBMPScatterAddFuncPtr();
+
+    // Sparse
+    SparseIPF32I32FuncType SparseIPF32I32_func_ptr_ = GetSparseIPF32I32FuncPtr();
+    SparseBitIPI32FuncType SparseBitIPI32_func_ptr_ = GetSparseBitIPI32FuncPtr();
+    SparseDenseIPF32I32FuncType SparseDenseIPF32I32_func_ptr_ = GetSparseDenseIPF32I32FuncPtr();
 };
 
 export const SIMD_FUNCTIONS &GetSIMD_FUNCTIONS() {
@@ -21,6 +21,8 @@ import hnsw_simd_func;
 import maxsim_simd_funcs;
 import emvb_simd_funcs;
 import search_top_1_sgemm;
+import bmp_simd_funcs;
+import sparse_simd_funcs;
 
 namespace infinity {
 
@@ -66,16 +68,224 @@ F32DistanceFuncType GetCosineDistanceFuncPtr() {
     return &CosineDistance_common;
 }
 
+F16DistanceFuncType GetF16L2DistanceFuncPtr() {
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &F16L2Distance_avx512;
+    }
+#endif
+#if defined(__AVX2__) && defined(__F16C__)
+    if (IsAVX2Supported() && IsF16CSupported()) {
+        return &F16L2Distance_f16c;
+    }
+#endif
+    return &F16L2Distance_common;
+}
+
+F16DistanceFuncType GetF16IPDistanceFuncPtr() {
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &F16IPDistance_avx512;
+    }
+#endif
+#if defined(__AVX2__) && defined(__F16C__)
+    if (IsAVX2Supported() && IsF16CSupported()) {
+        return &F16IPDistance_f16c;
+    }
+#endif
+    return &F16IPDistance_common;
+}
+
+F16DistanceFuncType GetF16CosineDistanceFuncPtr() {
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &F16CosineDistance_avx512;
+    }
+#endif
+#if defined(__AVX2__) && defined(__F16C__)
+    if (IsAVX2Supported() && IsF16CSupported()) {
+        return &F16CosineDistance_f16c;
+    }
+#endif
+    return &F16CosineDistance_common;
+}
+
+BF16DistanceFuncType GetBF16L2DistanceFuncPtr() {
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &BF16L2Distance_avx512;
+    }
+#endif
+#if defined(__AVX2__)
+    if (IsAVX2Supported()) {
+        return &BF16L2Distance_avx2;
+    }
+#endif
+    return &BF16L2Distance_common;
+}
+
+BF16DistanceFuncType GetBF16IPDistanceFuncPtr() {
+#if defined(__AVX512BF16__)
+    if (IsAVX512BF16Supported()) {
+        return &BF16IPDistance_avx512bf16;
+    }
+#endif
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &BF16IPDistance_avx512;
+    }
+#endif
+#if defined(__AVX2__)
+    if (IsAVX2Supported()) {
+        return &BF16IPDistance_avx2;
+    }
+#endif
+    return &BF16IPDistance_common;
+}
+
+BF16DistanceFuncType GetBF16CosineDistanceFuncPtr() {
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &BF16CosineDistance_avx512;
+    }
+#endif
+#if defined(__AVX2__)
+    if (IsAVX2Supported()) {
+        return &BF16CosineDistance_avx2;
+    }
+#endif
+    return &BF16CosineDistance_common;
+}
+
+F32F16DistanceFuncType GetF32F16L2DistanceFuncPtr() {
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &F32F16L2Distance_avx512;
+    }
+#endif
+#if defined(__AVX2__) && defined(__F16C__)
+    if (IsAVX2Supported() && IsF16CSupported()) {
+        return &F32F16L2Distance_f16c;
+    }
+#endif
+    return &F32F16L2Distance_common;
+}
+
+F32F16DistanceFuncType GetF32F16IPDistanceFuncPtr() {
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &F32F16IPDistance_avx512;
+    }
+#endif
+#if defined(__AVX2__) && defined(__F16C__)
+    if (IsAVX2Supported() && IsF16CSupported()) {
+        return &F32F16IPDistance_f16c;
+    }
+#endif
+    return &F32F16IPDistance_common;
+}
+
+F32F16DistanceFuncType GetF32F16CosineDistanceFuncPtr() {
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &F32F16CosineDistance_avx512;
+    }
+#endif
+#if defined(__AVX2__) && defined(__F16C__)
+    if (IsAVX2Supported() && IsF16CSupported()) {
+        return &F32F16CosineDistance_f16c;
+    }
+#endif
+    return &F32F16CosineDistance_common;
+}
+
+F32BF16DistanceFuncType GetF32BF16L2DistanceFuncPtr() {
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &F32BF16L2Distance_avx512;
+    }
+#endif
+#if defined(__AVX2__)
+    if (IsAVX2Supported()) {
+        return &F32BF16L2Distance_avx2;
+    }
+#endif
+    return &F32BF16L2Distance_common;
+}
+
+F32BF16DistanceFuncType GetF32BF16IPDistanceFuncPtr() {
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &F32BF16IPDistance_avx512;
+    }
+#endif
+#if defined(__AVX2__)
+    if (IsAVX2Supported()) {
+        return &F32BF16IPDistance_avx2;
+    }
+#endif
+    return &F32BF16IPDistance_common;
+}
+
+F32BF16DistanceFuncType GetF32BF16CosineDistanceFuncPtr() {
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &F32BF16CosineDistance_avx512;
+    }
+#endif
+#if defined(__AVX2__)
+    if (IsAVX2Supported()) {
+        return &F32BF16CosineDistance_avx2;
+    }
+#endif
+    return &F32BF16CosineDistance_common;
+}
+
 U8HammingDistanceFuncType GetHammingDistanceFuncPtr() {
-#ifdef __AVX2__
-    return &HammingDistance_avx2;
+#if defined(__AVX512VPOPCNTDQ__)
+    if (IsAVX512VPOPCNTDQSupported()) {
+        return &HammingDistance_avx512vpopcntdq;
+    }
 #endif
-#ifdef __SSE2__
+#if defined(__AVX2__)
+    if (IsAVX2Supported()) {
+        return &HammingDistance_avx2;
+    }
+#endif
+#if defined(__SSE2__)
     return &HammingDistance_sse2;
 #endif
     return &HammingDistance_common;
 }
 
+RaBitQ4BitIPFuncType GetRaBitQ4BitIPFuncPtr() {
+#if defined(__AVX512VPOPCNTDQ__)
+    if (IsAVX512VPOPCNTDQSupported()) {
+        return &RaBitQ4BitIP_avx512vpopcntdq;
+    }
+#endif
+#if defined(__AVX2__)
+    if (IsAVX2Supported()) {
+        return &RaBitQ4BitIP_avx2;
+    }
+#endif
+    return &RaBitQ4BitIP_common;
+}
+
+PQ4FastScanFuncType GetPQ4FastScanFuncPtr() {
+#if defined(__AVX512BW__)
+    if (IsAVX512BWSupported()) {
+        return &PQ4FastScan_avx512bw;
+    }
+#endif
+#if defined(__AVX2__)
+    if (IsAVX2Supported()) {
+        return &PQ4FastScan_avx2;
+    }
+#endif
+    return &PQ4FastScan_common;
+}
+
 F32DistanceFuncType Get_HNSW_F32L2_16_ptr() {
 #if defined(__AVX512F__)
     if (IsAVX512Supported()) {
@@ -532,6 +742,20 @@ U8CosDistanceFuncType Get_HNSW_U8Cos_ptr() {
     return &U8CosBF;
 }
 
+PQ8ADCFuncType Get_HNSW_PQ8ADC_ptr() {
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &PQ8ADCAVX512;
+    }
+#endif
+#if defined(__AVX2__)
+    if (IsAVX2Supported()) {
+        return &PQ8ADCAVX2;
+    }
+#endif
+    return &PQ8ADCBF;
+}
+
 MaxSimF32BitIPFuncType GetMaxSimF32BitIPFuncPtr() {
 #if defined(__AVX512F__)
     if (IsAVX512Supported()) {
@@ -597,4 +821,63 @@ SearchTop1WithDisF32U32FuncType GetSearchTop1WithDisF32U32FuncPtr() {
     return &search_top_1_simple_with_dis<f32, f32, u32, f32>;
 }
 
+BMPBlockMaxDenseFuncType GetBMPBlockMaxDenseFuncPtr() {
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &BMPBlockMaxDense_avx512;
+    }
+#endif
+#if defined(__AVX2__)
+    if (IsAVX2Supported()) {
+        return &BMPBlockMaxDense_avx2;
+    }
+#endif
+    return &BMPBlockMaxDense_common;
+}
+
+BMPBlockMaxSparseFuncType GetBMPBlockMaxSparseFuncPtr() {
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &BMPBlockMaxSparse_avx512;
+    }
+#endif
+    return &BMPBlockMaxSparse_common;
+}
+
+BMPScatterAddFuncType GetBMPScatterAddFuncPtr() {
+#if defined(__AVX512F__)
+    if (IsAVX512Supported()) {
+        return &BMPScatterAdd_avx512;
+    }
+#endif
+    return &BMPScatterAdd_common;
+}
+
+SparseIPF32I32FuncType GetSparseIPF32I32FuncPtr() {
+#if defined(__AVX2__)
+    if (IsAVX2Supported()) {
+        return &SparseIPF32I32_avx2;
+    }
+#endif
+    return &SparseIPF32I32_common;
+}
+
+SparseBitIPI32FuncType GetSparseBitIPI32FuncPtr() {
+#if defined(__AVX2__)
+    if (IsAVX2Supported()) {
+        return &SparseBitIPI32_avx2;
+    }
+#endif
+    return &SparseBitIPI32_common;
+}
+
+SparseDenseIPF32I32FuncType GetSparseDenseIPF32I32FuncPtr() {
+#if defined(__AVX2__)
+    if (IsAVX2Supported()) {
+        return &SparseDenseIPF32I32_avx2;
+    }
+#endif
+    return &SparseDenseIPF32I32_common;
+}
+
 } // namespace infinity
@@ -26,27 +26,65 @@ export using infinity::IsSSE2Supported;
 export using infinity::IsAVX2Supported;
 export using infinity::IsAVX512Supported;
 export using infinity::IsAVX512BWSupported;
+export using infinity::IsAVX512VPOPCNTDQSupported;
+export using infinity::IsAVX512BF16Supported;
 
 export using F32DistanceFuncType = f32(*)(const f32 *, const f32 *, SizeT);
 export using I8DistanceFuncType = i32(*)(const i8 *, const i8 *, SizeT);
 export using I8CosDistanceFuncType = f32(*)(const i8 *, const i8 *, SizeT);
 export using U8DistanceFuncType = i32(*)(const u8 *, const u8 *, SizeT);
+// half precision elements are passed as raw u16 bits
+export using F16DistanceFuncType = f32(*)(const u16 *, const u16 *, SizeT);
+export using BF16DistanceFuncType = f32(*)(const u16 *, const u16 *, SizeT);
+export using F32F16DistanceFuncType = f32(*)(const f32 *, const u16 *, SizeT);
+export using F32BF16DistanceFuncType = f32(*)(const f32 *, const u16 *, SizeT);
 //dimension in hamming distance is in bytes
 export using U8HammingDistanceFuncType = f32(*)(const u8 *, const u8 *, SizeT);
+// code and each of the 4 query bit planes are in bytes
+export using RaBitQ4BitIPFuncType = u32(*)(const u8 *, const u8 *, SizeT);
+// a block of 32 vectors with 4 bit codes, the u8 tables and the u16 sums of the vectors
+export using PQ4FastScanFuncType = void(*)(const u8 *, const u8 *, SizeT, u16 *);
 export using U8CosDistanceFuncType = f32(*)(const u8 *, const u8 *, SizeT);
 export using MaxSimF32BitIPFuncType = f32(*)(const f32 *, const u8 *, SizeT);
 export using MaxSimI32BitIPFuncType = i32(*)(const i32 *, const u8 *, SizeT);
 export using MaxSimI64BitIPFuncType = i64(*)(const i64 *, const u8 *, SizeT);
 export using FilterScoresOutputIdsFuncType = u32 * (*)(u32 *, f32, const f32 *, u32);
 export using SearchTop1WithDisF32U32FuncType = void(*)(u32, u32, const f32 *, u32, const f32 *, u32 *, f32 *);
+export using PQ8ADCFuncType = f32(*)(const f32 *, const u8 *, SizeT);
+// u8 block max scores (and block ids) of a term, the weight of the term and the f32 upper bounds of the blocks
+export using BMPBlockMaxDenseFuncType = void(*)(const u8 *, SizeT, f32, f32 *);
+export using BMPBlockMaxSparseFuncType = void(*)(const i32 *, const u8 *, SizeT, f32, f32 *);
+// block offsets and scores of a term in a block, the weight of the term and the f32 scores of the block
+export using BMPScatterAddFuncType = void(*)(const u8 *, const f32 *, SizeT, f32, f32 *);
+// sorted indices of two sparse vectors
+export using SparseIPF32I32FuncType = f32(*)(const f32 *, const i32 *, SizeT, const f32 *, const i32 *, SizeT);
+export using SparseBitIPI32FuncType = SizeT(*)(const i32 *, SizeT, const i32 *, SizeT);
+// the query scattered to a dense array and its size, then a sparse vector
+export using SparseDenseIPF32I32FuncType = f32(*)(const f32 *, SizeT, const f32 *, const i32 *, SizeT);
 
 // F32 distance functions
 export F32DistanceFuncType GetL2DistanceFuncPtr();
 export F32DistanceFuncType GetIPDistanceFuncPtr();
 export F32DistanceFuncType GetCosineDistanceFuncPtr();
 
+// half precision distance functions
+export F16DistanceFuncType GetF16L2DistanceFuncPtr();
+export F16DistanceFuncType GetF16IPDistanceFuncPtr();
+export F16DistanceFuncType GetF16CosineDistanceFuncPtr();
+export BF16DistanceFuncType GetBF16L2DistanceFuncPtr();
+export BF16DistanceFuncType GetBF16IPDistanceFuncPtr();
+export BF16DistanceFuncType GetBF16CosineDistanceFuncPtr();
+export F32F16DistanceFuncType GetF32F16L2DistanceFuncPtr();
+export F32F16DistanceFuncType GetF32F16IPDistanceFuncPtr();
+export F32F16DistanceFuncType GetF32F16CosineDistanceFuncPtr();
+export F32BF16DistanceFuncType GetF32BF16L2DistanceFuncPtr();
+export F32BF16DistanceFuncType GetF32BF16IPDistanceFuncPtr();
+export F32BF16DistanceFuncType GetF32BF16CosineDistanceFuncPtr();
+
 // u32 distance functions
 export U8HammingDistanceFuncType GetHammingDistanceFuncPtr();
+export RaBitQ4BitIPFuncType GetRaBitQ4BitIPFuncPtr();
+export PQ4FastScanFuncType GetPQ4FastScanFuncPtr();
 
 // HNSW F32
 export F32DistanceFuncType Get_HNSW_F32L2_ptr();
@@ -75,6 +113,8 @@ export U8DistanceFuncType Get_HNSW_U8IP_16_ptr();
 export U8DistanceFuncType Get_HNSW_U8IP_32_ptr();
 export U8DistanceFuncType Get_HNSW_U8IP_64_ptr();
 export U8CosDistanceFuncType Get_HNSW_U8Cos_ptr();
+// HNSW PQ
+export PQ8ADCFuncType Get_HNSW_PQ8ADC_ptr();
 // MaxSim IP
 export MaxSimF32BitIPFuncType GetMaxSimF32BitIPFuncPtr();
 export MaxSimI32BitIPFuncType GetMaxSimI32BitIPFuncPtr();
@@ -83,5 +123,13 @@ export MaxSimI64BitIPFuncType GetMaxSimI64BitIPFuncPtr();
 export FilterScoresOutputIdsFuncType GetFilterScoresOutputIdsFuncPtr();
 // K-means
 export SearchTop1WithDisF32U32FuncType GetSearchTop1WithDisF32U32FuncPtr();
+// BMP
+export BMPBlockMaxDenseFuncType GetBMPBlockMaxDenseFuncPtr();
+export BMPBlockMaxSparseFuncType GetBMPBlockMaxSparseFuncPtr();
+export BMPScatterAddFuncType GetBMPScatterAddFuncPtr();
+// Sparse
+export SparseIPF32I32FuncType GetSparseIPF32I32FuncPtr();
+export SparseBitIPI32FuncType GetSparseBitIPI32FuncPtr();
+export SparseDenseIPF32I32FuncType GetSparseDenseIPF32I32FuncPtr();
 
 } // namespace infinity
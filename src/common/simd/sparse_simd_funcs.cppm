@@ -0,0 +1,133 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+#include "simd_common_intrin_include.h"
+export module sparse_simd_funcs;
+import stl;
+import simd_common_tools;
+
+namespace infinity {
+
+// inner product of two sparse vectors, the indices of each vector are sorted and distinct
+export f32 SparseIPF32I32_common(const f32 *data1, const i32 *index1, SizeT nnz1, const f32 *data2, const i32 *index2, SizeT nnz2) {
+    f32 distance{};
+    SizeT i = 0, j = 0;
+    while (i < nnz1 && j < nnz2) {
+        if (index1[i] == index2[j]) {
+            distance += data1[i] * data2[j];
+            ++i;
+            ++j;
+        } else if (index1[i] < index2[j]) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+    return distance;
+}
+
+// number of the common indices
+export SizeT SparseBitIPI32_common(const i32 *index1, SizeT nnz1, const i32 *index2, SizeT nnz2) {
+    SizeT distance{};
+    SizeT i = 0, j = 0;
+    while (i < nnz1 && j < nnz2) {
+        if (index1[i] == index2[j]) {
+            ++distance;
+            ++i;
+            ++j;
+        } else if (index1[i] < index2[j]) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+    return distance;
+}
+
+// inner product of a sparse vector and a query scattered to `dense`, the indices from `dense_size` on are 0 in the query
+export f32 SparseDenseIPF32I32_common(const f32 *dense, SizeT dense_size, const f32 *data, const i32 *index, SizeT nnz) {
+    f32 distance{};
+    for (SizeT k = 0; k < nnz; ++k) {
+        if (static_cast<SizeT>(index[k]) >= dense_size) {
+            break;
+        }
+        distance += data[k] * dense[index[k]];
+    }
+    return distance;
+}
+
+#if defined(__AVX2__)
+
+// Blocks of 8 indices of the two vectors are compared all against all by rotating one of them 8 times, the block with the smaller
+// last index moves on. A common index is in exactly one pair of blocks which are compared.
+export f32 SparseIPF32I32_avx2(const f32 *data1, const i32 *index1, SizeT nnz1, const f32 *data2, const i32 *index2, SizeT nnz2) {
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    __m256 acc = _mm256_setzero_ps();
+    SizeT i = 0, j = 0;
+    while (i + 8 <= nnz1 && j + 8 <= nnz2) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(index1 + i));
+        const __m256 da = _mm256_loadu_ps(data1 + i);
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(index2 + j));
+        __m256 db = _mm256_loadu_ps(data2 + j);
+        for (u32 r = 0; r < 8; ++r) {
+            const __m256 eq = _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b));
+            acc = _mm256_add_ps(acc, _mm256_and_ps(eq, _mm256_mul_ps(da, db)));
+            b = _mm256_permutevar8x32_epi32(b, rotate);
+            db = _mm256_permutevar8x32_ps(db, rotate);
+        }
+        const i32 a_max = index1[i + 7];
+        const i32 b_max = index2[j + 7];
+        i += a_max <= b_max ? 8 : 0;
+        j += b_max <= a_max ? 8 : 0;
+    }
+    return hsum256_ps_avx(acc) + SparseIPF32I32_common(data1 + i, index1 + i, nnz1 - i, data2 + j, index2 + j, nnz2 - j);
+}
+
+export SizeT SparseBitIPI32_avx2(const i32 *index1, SizeT nnz1, const i32 *index2, SizeT nnz2) {
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    SizeT distance = 0;
+    SizeT i = 0, j = 0;
+    while (i + 8 <= nnz1 && j + 8 <= nnz2) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(index1 + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(index2 + j));
+        __m256i eq = _mm256_cmpeq_epi32(a, b);
+        for (u32 r = 1; r < 8; ++r) {
+            b = _mm256_permutevar8x32_epi32(b, rotate);
+            eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(a, b));
+        }
+        distance += _mm_popcnt_u32(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+        const i32 a_max = index1[i + 7];
+        const i32 b_max = index2[j + 7];
+        i += a_max <= b_max ? 8 : 0;
+        j += b_max <= a_max ? 8 : 0;
+    }
+    return distance + SparseBitIPI32_common(index1 + i, nnz1 - i, index2 + j, nnz2 - j);
+}
+
+export f32 SparseDenseIPF32I32_avx2(const f32 *dense, SizeT dense_size, const f32 *data, const i32 *index, SizeT nnz) {
+    __m256 acc = _mm256_setzero_ps();
+    SizeT k = 0;
+    // the indices are sorted, the last one of a block bounds the gather
+    for (; k + 8 <= nnz && static_cast<SizeT>(index[k + 7]) < dense_size; k += 8) {
+        const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(index + k));
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(data + k), _mm256_i32gather_ps(dense, idx, 4), acc);
+    }
+    return hsum256_ps_avx(acc) + SparseDenseIPF32I32_common(dense, dense_size, data + k, index + k, nnz - k);
+}
+
+#endif // defined (__AVX2__)
+
+} // namespace infinity
@@ -408,19 +408,26 @@ SizeT PhysicalExport::ExportToFVECS(QueryContext *query_context, ExportOperatorS
     }
 
     EmbeddingInfo *embedding_type_info = static_cast<EmbeddingInfo *>(data_type->type_info().get());
-    switch (embedding_type_info->Type()) {
-        case EmbeddingDataType::kElemFloat: {
-            // Supported
+    const EmbeddingDataType elem_type = embedding_type_info->Type();
+    switch (elem_type) {
+        case EmbeddingDataType::kElemFloat:
+        case EmbeddingDataType::kElemFloat16:
+        case EmbeddingDataType::kElemBFloat16: {
+            // Supported, half precision is written as float
             break;
         }
         default: {
-            Status status = Status::NotSupport(fmt::format("Type: {}, only float element type embedding is supported now",
-                                                           EmbeddingType::EmbeddingDataType2String(embedding_type_info->Type())));
+            Status status = Status::NotSupport(fmt::format("Type: {}, only float, float16 and bfloat16 element type embedding is supported now",
+                                                           EmbeddingType::EmbeddingDataType2String(elem_type)));
             RecoverableError(status);
         }
     }
 
     i32 dimension = embedding_type_info->Dimension();
+    UniquePtr<FloatT[]> f32_buffer;
+    if (elem_type != EmbeddingDataType::kElemFloat) {
+        f32_buffer = MakeUniqueForOverwrite<FloatT[]>(dimension);
+    }
 
     String parent_path = VirtualStore::GetParentPath(file_path_);
     if (!parent_path.empty()) {
@@ -482,7 +489,28 @@ SizeT PhysicalExport::ExportToFVECS(QueryContext *query_context, ExportOperatorS
                 }
 
                 file_handle->Append(&dimension, sizeof(dimension));
-                file_handle->Append(embedding.data(), embedding.size_bytes());
+                switch (elem_type) {
+                    case EmbeddingDataType::kElemFloat16: {
+                        const auto *src = reinterpret_cast<const Float16T *>(embedding.data());
+                        for (i32 i = 0; i < dimension; ++i) {
+                            f32_buffer[i] = static_cast<FloatT>(src[i]);
+                        }
+                        file_handle->Append(f32_buffer.get(), sizeof(FloatT) * dimension);
+                        break;
+                    }
+                    case EmbeddingDataType::kElemBFloat16: {
+                        const auto *src = reinterpret_cast<const BFloat16T *>(embedding.data());
+                        for (i32 i = 0; i < dimension; ++i) {
+                            f32_buffer[i] = static_cast<FloatT>(src[i]);
+                        }
+                        file_handle->Append(f32_buffer.get(), sizeof(FloatT) * dimension);
+                        break;
+                    }
+                    default: {
+                        file_handle->Append(embedding.data(), embedding.size_bytes());
+                        break;
+                    }
+                }
 
                 ++row_count;
                 if (limit_ != 0 && row_count == limit_) {
@@ -142,8 +142,10 @@ void PhysicalImport::ImportFVECS(QueryContext *query_context, ImportOperatorStat
         RecoverableError(status);
     }
     auto embedding_info = static_cast<EmbeddingInfo *>(column_type->type_info().get());
-    if (embedding_info->Type() != EmbeddingDataType::kElemFloat) {
-        Status status = Status::ImportFileFormatError("FVECS file must have only one embedding column with float element.");
+    const EmbeddingDataType elem_type = embedding_info->Type();
+    if (elem_type != EmbeddingDataType::kElemFloat && elem_type != EmbeddingDataType::kElemFloat16 &&
+        elem_type != EmbeddingDataType::kElemBFloat16) {
+        Status status = Status::ImportFileFormatError("FVECS file must have only one embedding column with float, float16 or bfloat16 element.");
         RecoverableError(status);
     }
 
@@ -194,6 +196,11 @@ void PhysicalImport::ImportFVECS(QueryContext *query_context, ImportOperatorStat
         BufferHandle buffer_handle = block_entry->GetColumnBlockEntry(0)->buffer()->Load();
         SizeT row_idx = 0;
         auto buf_ptr = static_cast<ptr_t>(buffer_handle.GetDataMut());
+        // half precision columns are converted from the f32 vectors in the file
+        UniquePtr<FloatT[]> f32_buffer;
+        if (elem_type != EmbeddingDataType::kElemFloat) {
+            f32_buffer = MakeUniqueForOverwrite<FloatT[]>(dimension);
+        }
         while (true) {
             i32 dim;
             auto [nbytes, status_read] = file_handle->Read(&dim, sizeof(dimension));
@@ -205,8 +212,29 @@ void PhysicalImport::ImportFVECS(QueryContext *query_context, ImportOperatorStat
                     Status::ImportFileFormatError(fmt::format("Dimension in file ({}) doesn't match with table definition ({}).", dim, dimension));
                 RecoverableError(status_error);
             }
-            ptr_t dst_ptr = buf_ptr + block_entry->row_count() * sizeof(FloatT) * dimension;
-            file_handle->Read(dst_ptr, sizeof(FloatT) * dimension);
+            ptr_t dst_ptr = buf_ptr + block_entry->row_count() * embedding_info->Size();
+            switch (elem_type) {
+                case EmbeddingDataType::kElemFloat16: {
+                    file_handle->Read(f32_buffer.get(), sizeof(FloatT) * dimension);
+                    auto *dst = reinterpret_cast<Float16T *>(dst_ptr);
+                    for (i32 i = 0; i < dimension; ++i) {
+                        dst[i] = static_cast<Float16T>(f32_buffer[i]);
+                    }
+                    break;
+                }
+                case EmbeddingDataType::kElemBFloat16: {
+                    file_handle->Read(f32_buffer.get(), sizeof(FloatT) * dimension);
+                    auto *dst = reinterpret_cast<BFloat16T *>(dst_ptr);
+                    for (i32 i = 0; i < dimension; ++i) {
+                        dst[i] = static_cast<BFloat16T>(f32_buffer[i]);
+                    }
+                    break;
+                }
+                default: {
+                    file_handle->Read(dst_ptr, sizeof(FloatT) * dimension);
+                    break;
+                }
+            }
             block_entry->IncreaseRowCount(1);
             ++row_idx;
 
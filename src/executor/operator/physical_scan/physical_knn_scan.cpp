@@ -14,6 +14,7 @@
 
 module;
 
+#include <chrono>
 #include <cstdlib>
 #include <memory>
 #include <string>
@@ -53,6 +54,7 @@ import data_block;
 import roaring_bitmap;
 import column_vector;
 import index_hnsw;
+import index_ivf;
 import status;
 import create_index_info;
 import knn_expr;
@@ -61,9 +63,17 @@ import segment_entry;
 import abstract_hnsw;
 import physical_match_tensor_scan;
 import hnsw_alg;
+import vec_store_type;
+import rabitq_quantizer;
 import ivf_index_data_in_mem;
 import ivf_index_data;
 import ivf_index_search;
+import hnsw_segment_group;
+import table_index_entry;
+import index_diskann;
+import diskann_index_in_chunk;
+import knn_query_coalescer;
+import knn_flat_gemm;
 
 namespace infinity {
 
@@ -356,6 +366,13 @@ SizeT PhysicalKnnScan::GetColumnID() const {
     return column_expr->binding().column_idx;
 }
 
+// whether the snapshot of the query sees the same rows of the segment as the group graph
+bool HnswSegmentGroupPartVisible(const HnswSegmentGroupPart &part, const BlockIndex *block_index) {
+    const auto &segment_index_hashmap = block_index->segment_block_index_;
+    auto iter = segment_index_hashmap.find(part.segment_id_);
+    return iter != segment_index_hashmap.end() && iter->second.segment_offset_ == part.row_count_;
+}
+
 void PhysicalKnnScan::PlanWithIndex(QueryContext *query_context) { // TODO: return base entry vector
     InitBlockParallelOption();                                     // PlanWithIndex() will be called in physical planner
     Txn *txn = query_context->GetTxn();
@@ -369,6 +386,7 @@ void PhysicalKnnScan::PlanWithIndex(QueryContext *query_context) { // TODO: retu
 
     TableEntry *table_entry = base_table_ref_->table_entry_ptr_;
     Map<u32, SharedPtr<SegmentIndexEntry>> index_entry_map;
+    TableIndexEntry *knn_index_entry = nullptr;
 
     if (knn_expression_->ignore_index_) {
         LOG_TRACE("Not use index"); // No index need to check
@@ -392,7 +410,8 @@ void PhysicalKnnScan::PlanWithIndex(QueryContext *query_context) { // TODO: retu
                 }
                 // check index type
                 if (auto index_type = table_index_entry->index_base()->index_type_;
-                    index_type != IndexType::kIVF and index_type != IndexType::kHnsw) {
+                    index_type != IndexType::kIVF and index_type != IndexType::kHnsw and
+                    index_type != IndexType::kDiskAnn) {
                     LOG_TRACE(fmt::format("KnnScan: PlanWithIndex(): Skipping non-knn index."));
                     continue;
                 }
@@ -402,6 +421,7 @@ void PhysicalKnnScan::PlanWithIndex(QueryContext *query_context) { // TODO: retu
                     auto guard = table_index_entry->GetSegmentIndexesGuard();
                     index_entry_map = guard.index_by_segment_;
                 }
+                knn_index_entry = table_index_entry;
             }
         } else {
             LOG_TRACE(fmt::format("Use index: {}", knn_expression_->using_index_));
@@ -428,7 +448,8 @@ void PhysicalKnnScan::PlanWithIndex(QueryContext *query_context) { // TODO: retu
                 RecoverableError(std::move(error_status));
             }
             // check index type
-            if (auto index_type = table_index_entry->index_base()->index_type_; index_type != IndexType::kIVF and index_type != IndexType::kHnsw) {
+            if (auto index_type = table_index_entry->index_base()->index_type_; index_type != IndexType::kIVF and index_type != IndexType::kHnsw and
+                    index_type != IndexType::kDiskAnn) {
                 LOG_ERROR("Invalid index type");
                 Status error_status = Status::InvalidIndexType("invalid index");
                 RecoverableError(std::move(error_status));
@@ -439,12 +460,30 @@ void PhysicalKnnScan::PlanWithIndex(QueryContext *query_context) { // TODO: retu
                 auto guard = table_index_entry->GetSegmentIndexesGuard();
                 index_entry_map = guard.index_by_segment_;
             }
+            knn_index_entry = table_index_entry;
         }
     }
 
     // Generate task set: index segment and no index block
     BlockIndex *block_index = base_table_ref_->block_index_.get();
+    // the segments merged into the hnsw segment group are searched in one task, unless they changed since the group was built
+    HashSet<SegmentID> group_segments;
+    if (knn_index_entry != nullptr && knn_index_entry->index_base()->index_type_ == IndexType::kHnsw) {
+        if (auto group = knn_index_entry->GetHnswSegmentGroup(); group.get() != nullptr) {
+            for (const auto &part : group->parts()) {
+                if (HnswSegmentGroupPartVisible(part, block_index)) {
+                    group_segments.insert(part.segment_id_);
+                }
+            }
+            if (!group_segments.empty()) {
+                hnsw_segment_group_ = std::move(group);
+            }
+        }
+    }
     for (const auto &[segment_id, segment_info] : block_index->segment_block_index_) {
+        if (group_segments.contains(segment_id)) {
+            continue;
+        }
         if (auto iter = index_entry_map.find(segment_id); iter != index_entry_map.end()) {
             index_entries_->emplace_back(iter->second.get());
         } else {
@@ -456,7 +495,7 @@ void PhysicalKnnScan::PlanWithIndex(QueryContext *query_context) { // TODO: retu
         }
     }
     block_column_entries_size_ = block_column_entries_->size();
-    index_entries_size_ = index_entries_->size();
+    index_entries_size_ = index_entries_->size() + (hnsw_segment_group_.get() != nullptr);
     LOG_TRACE(fmt::format("KnnScan: brute force task: {}, index task: {}", block_column_entries_size_, index_entries_size_));
 }
 
@@ -476,6 +515,296 @@ void MultiVectorSearchOneLine(MergeKnn<QueryDataType, C, DistanceDataType> *merg
                               SegmentOffset segment_offset,
                               BlockOffset block_offset);
 
+// recompute the exact distances of the candidates returned by an index from the column data
+template <LogicalType t, typename ColumnDataType, typename QueryDataType, template <typename, typename> typename C, typename DistanceDataType>
+void RerankIndexResult(MergeKnn<QueryDataType, C, DistanceDataType> *merge_heap,
+                       KnnDistance1<QueryDataType, DistanceDataType> *dist_func,
+                       const QueryDataType *query,
+                       const SizeT query_id,
+                       const u32 embedding_dim,
+                       UniquePtr<QueryDataType[]> &buffer_ptr_for_cast,
+                       BlockIndex *block_index,
+                       BufferManager *buffer_mgr,
+                       const SizeT knn_column_id,
+                       const SegmentID segment_id,
+                       const SegmentOffset *l_ptr,
+                       const SizeT result_n) {
+    Vector<SizeT> idxes(result_n);
+    std::iota(idxes.begin(), idxes.end(), 0);
+    std::sort(idxes.begin(), idxes.end(), [&](SizeT i, SizeT j) { return l_ptr[i] < l_ptr[j]; }); // sort by segment offset
+    BlockID prev_block_id = -1;
+    ColumnVector column_vector;
+    for (SizeT idx : idxes) {
+        SegmentOffset segment_offset = l_ptr[idx];
+        BlockID block_id = segment_offset / DEFAULT_BLOCK_CAPACITY;
+        BlockOffset block_offset = segment_offset % DEFAULT_BLOCK_CAPACITY;
+        if (block_id != prev_block_id) {
+            prev_block_id = block_id;
+            BlockEntry *block_entry = block_index->GetBlockEntry(segment_id, block_id);
+            column_vector = block_entry->GetConstColumnVector(buffer_mgr, knn_column_id);
+        }
+        if constexpr (t == LogicalType::kEmbedding) {
+            const auto *data = reinterpret_cast<const ColumnDataType *>(column_vector.data());
+            data += block_offset * embedding_dim;
+            const QueryDataType *target_ptr = nullptr;
+            if constexpr (std::is_same_v<ColumnDataType, QueryDataType>) {
+                target_ptr = data;
+            } else {
+                if (!buffer_ptr_for_cast) {
+                    buffer_ptr_for_cast = MakeUniqueForOverwrite<QueryDataType[]>(embedding_dim);
+                }
+                for (u32 i = 0; i < embedding_dim; ++i) {
+                    buffer_ptr_for_cast[i] = static_cast<QueryDataType>(data[i]);
+                }
+                target_ptr = buffer_ptr_for_cast.get();
+            }
+            const DistanceDataType dist = dist_func->dist_func_(query, target_ptr, embedding_dim);
+            const RowID row_id(segment_id, segment_offset);
+            merge_heap->Search(query_id, &dist, &row_id, 1);
+        } else if constexpr (t == LogicalType::kMultiVector) {
+            MultiVectorSearchOneLine<ColumnDataType, QueryDataType, C, DistanceDataType>(merge_heap,
+                                                                                         dist_func,
+                                                                                         query,
+                                                                                         embedding_dim,
+                                                                                         buffer_ptr_for_cast,
+                                                                                         column_vector,
+                                                                                         segment_id,
+                                                                                         segment_offset,
+                                                                                         block_offset);
+        } else {
+            static_assert(false, "Unexpected logical type");
+        }
+    }
+}
+
+// the elements of a vector in the hnsw index, bit vectors are searched on their packed bytes
+u32 HnswVectorDimension(const KnnScanSharedData *knn_scan_shared_data) {
+    const u32 dim = knn_scan_shared_data->dimension_;
+    return knn_scan_shared_data->query_elem_type_ == EmbeddingDataType::kElemBit ? dim / 8 : dim;
+}
+
+// the k-th distance which the other tasks have found for the query, in the distance of the hnsw index which is negated for the inner product
+template <typename QueryDataType, template <typename, typename> typename C, typename DistanceDataType>
+f32 HnswSharedDistanceBound(const MergeKnn<QueryDataType, C, DistanceDataType> *merge_heap,
+                            const KnnDistanceType knn_distance_type,
+                            const u64 query_idx) {
+    const auto bound = merge_heap->GetSharedBound(query_idx);
+    if (!bound.has_value()) {
+        return std::numeric_limits<f32>::max();
+    }
+    switch (knn_distance_type) {
+        case KnnDistanceType::kCosine:
+        case KnnDistanceType::kInnerProduct: {
+            return -bound.value();
+        }
+        default: {
+            return bound.value();
+        }
+    }
+}
+
+// The single query searches of concurrent requests on the same hnsw index with the same options are searched as one batch, which shares
+// the traversal of the upper layers. An index being built is keyed by the visible rows of the request too.
+template <typename HnswIndex>
+auto CoalescedHnswSearch(const HnswIndex *hnsw_index,
+                         const typename HnswIndex::QueryVecType query,
+                         const SizeT topk,
+                         const bool with_lock,
+                         const SegmentOffset max_segment_offset,
+                         const KnnSearchOption &option,
+                         const u64 window_us) {
+    using QueryVecType = typename HnswIndex::QueryVecType;
+    using Result = decltype(hnsw_index->template KnnSearch<false>(query, topk, option));
+    // index, whether it is being built, visible rows, top k, ef, patience
+    using Key = Tuple<const void *, bool, SegmentOffset, SizeT, SizeT, SizeT>;
+    static KnnQueryCoalescer<Key, QueryVecType, Result> coalescer;
+    KnnSearchOption batch_option = option;
+    // the bound of a query does not hold for the others
+    batch_option.distance_bound_ = KnnSearchOption().distance_bound_;
+    const Key key(hnsw_index, with_lock, with_lock ? max_segment_offset : 0, topk, option.ef_, option.patience_);
+    return coalescer.Submit(key, query, std::chrono::microseconds(window_us), [&](const Vector<QueryVecType> &queries) {
+        if (!with_lock) {
+            return hnsw_index->template KnnSearchBatch<false>(queries.data(), queries.size(), topk, batch_option);
+        }
+        AppendFilter filter(max_segment_offset);
+        return hnsw_index->template KnnSearchBatch<AppendFilter, true>(queries.data(), queries.size(), topk, filter, batch_option);
+    });
+}
+
+template <LogicalType t, typename ColumnDataType, typename QueryDataType, template <typename, typename> typename C, typename DistanceDataType>
+void SearchHnswSegmentGroup(const HnswSegmentGroup &group,
+                            const CommonQueryFilter *common_query_filter,
+                            const KnnScanSharedData *knn_scan_shared_data,
+                            MergeKnn<QueryDataType, C, DistanceDataType> *merge_heap,
+                            KnnDistance1<QueryDataType, DistanceDataType> *dist_func,
+                            UniquePtr<QueryDataType[]> &buffer_ptr_for_cast,
+                            BlockIndex *block_index,
+                            BufferManager *buffer_mgr,
+                            const SizeT knn_column_id) {
+    if constexpr (t != LogicalType::kEmbedding ||
+                  !((IsAnyOf<ColumnDataType, u8, i8, f32> && std::is_same_v<ColumnDataType, QueryDataType>) ||
+                    IsAnyOf<ColumnDataType, Float16T, BFloat16T>)) {
+        UnrecoverableError("Invalid data type for hnsw segment group");
+    } else {
+        // the labels of the parts which are not visible or filtered out are not selected
+        bool all_parts_visible = true;
+        SizeT selected_n = 0;
+        for (const auto &part : group.parts()) {
+            all_parts_visible = all_parts_visible && HnswSegmentGroupPartVisible(part, block_index);
+        }
+        UniquePtr<BitmaskFilter<SegmentOffset>> group_filter;
+        if (!all_parts_visible || !common_query_filter->AlwaysTrue()) {
+            group_filter = MakeUnique<BitmaskFilter<SegmentOffset>>(group.row_count());
+            for (const auto &part : group.parts()) {
+                if (!HnswSegmentGroupPartVisible(part, block_index)) {
+                    continue;
+                }
+                if (common_query_filter->AlwaysTrue()) {
+                    group_filter->SetRange(part.base_offset_, part.base_offset_ + part.row_count_);
+                    selected_n += part.row_count_;
+                } else if (auto it = common_query_filter->filter_result_.find(part.segment_id_); it != common_query_filter->filter_result_.end()) {
+                    group_filter->Set(it->second, part.base_offset_);
+                    selected_n += it->second.CountTrue();
+                }
+            }
+            if (selected_n == 0) {
+                return;
+            }
+        }
+
+        const u32 embedding_dim = HnswVectorDimension(knn_scan_shared_data);
+        UniquePtr<ColumnDataType[]> query_for_cast;
+        std::visit(
+            [&](auto &&hnsw_index) {
+                using T = std::decay_t<decltype(hnsw_index)>;
+                if constexpr (std::is_same_v<T, std::nullptr_t>) {
+                    UnrecoverableError("Invalid index type");
+                } else if constexpr (!std::is_same_v<ColumnDataType, typename std::remove_pointer_t<T>::DataType>) {
+                    UnrecoverableError("Invalid data type");
+                } else {
+                    using VecStoreT = typename std::remove_pointer_t<T>::VecStoreT;
+                    bool rerank = false;
+                    KnnSearchOption search_option;
+                    search_option.column_logical_type_ = t;
+                    if (group_filter) {
+                        search_option.filter_pass_n_ = selected_n;
+                        search_option.predicate_aware_ = selected_n < kHnswPredicateAwareSelectivity * group.row_count();
+                    }
+                    for (const auto &opt_param : knn_scan_shared_data->opt_params_) {
+                        if (opt_param.param_name_ == "ef") {
+                            search_option.ef_ = std::stoull(opt_param.param_value_);
+                        } else if (opt_param.param_name_ == "rerank") {
+                            rerank = true;
+                        } else if (opt_param.param_name_ == "predicate_aware") {
+                            search_option.predicate_aware_ = group_filter && opt_param.param_value_ != "false";
+                        } else if (opt_param.param_name_ == "patience") {
+                            search_option.patience_ = std::stoull(opt_param.param_value_);
+                        }
+                    }
+                    if constexpr (RerankRequired<VecStoreT>) {
+                        rerank = true;
+                        if (search_option.ef_ == 0) {
+                            search_option.ef_ = knn_scan_shared_data->topk_ * kRaBitQRerankFactor;
+                        }
+                    }
+                    if (t == LogicalType::kEmbedding && hnsw_index->dim() < embedding_dim) {
+                        // the graph only has the first dimensions, the candidates are reranked with the full vectors
+                        rerank = true;
+                        if (search_option.ef_ == 0) {
+                            search_option.ef_ = knn_scan_shared_data->topk_ * kHnswTruncatedRerankFactor;
+                        }
+                    }
+
+                    for (u64 query_idx = 0; query_idx < knn_scan_shared_data->query_count_; ++query_idx) {
+                        const auto *query = static_cast<const QueryDataType *>(knn_scan_shared_data->query_embedding_) + query_idx * embedding_dim;
+                        const ColumnDataType *index_query = nullptr;
+                        if constexpr (std::is_same_v<ColumnDataType, QueryDataType>) {
+                            index_query = query;
+                        } else {
+                            if (!query_for_cast) {
+                                query_for_cast = MakeUniqueForOverwrite<ColumnDataType[]>(embedding_dim);
+                            }
+                            for (u32 i = 0; i < embedding_dim; ++i) {
+                                query_for_cast[i] = static_cast<ColumnDataType>(query[i]);
+                            }
+                            index_query = query_for_cast.get();
+                        }
+
+                        if (!rerank) {
+                            // the approximate distances of the reranked candidates are not comparable with the bound
+                            search_option.distance_bound_ = HnswSharedDistanceBound(merge_heap, knn_scan_shared_data->knn_distance_type_, query_idx);
+                        }
+
+                        // the rows of the segments sealed later may be being inserted into the graph, they are locked and filtered out
+                        SizeT result_n = 0;
+                        UniquePtr<DistanceDataType[]> d_ptr = nullptr;
+                        UniquePtr<SegmentOffset[]> l_ptr = nullptr;
+                        if (group_filter) {
+                            std::tie(result_n, d_ptr, l_ptr) = hnsw_index->template KnnSearch<BitmaskFilter<SegmentOffset>, true>(index_query,
+                                                                                                                                  knn_scan_shared_data->topk_,
+                                                                                                                                  *group_filter,
+                                                                                                                                  search_option);
+                        } else {
+                            AppendFilter filter(group.row_count());
+                            std::tie(result_n, d_ptr, l_ptr) =
+                                hnsw_index->template KnnSearch<AppendFilter, true>(index_query, knn_scan_shared_data->topk_, filter, search_option);
+                        }
+
+                        if (rerank) {
+                            // the labels of a part are contiguous after sorting, they are reranked with the rows of its segment
+                            std::sort(l_ptr.get(), l_ptr.get() + result_n);
+                            for (SizeT i = 0; i < result_n;) {
+                                const auto &part = group.GetPart(l_ptr[i]);
+                                SizeT j = i;
+                                for (; j < result_n && l_ptr[j] - part.base_offset_ < part.row_count_; ++j) {
+                                    l_ptr[j] -= part.base_offset_;
+                                }
+                                RerankIndexResult<t, ColumnDataType, QueryDataType, C, DistanceDataType>(merge_heap,
+                                                                                                        dist_func,
+                                                                                                        query,
+                                                                                                        query_idx,
+                                                                                                        embedding_dim,
+                                                                                                        buffer_ptr_for_cast,
+                                                                                                        block_index,
+                                                                                                        buffer_mgr,
+                                                                                                        knn_column_id,
+                                                                                                        part.segment_id_,
+                                                                                                        l_ptr.get() + i,
+                                                                                                        j - i);
+                                i = j;
+                            }
+                            continue;
+                        }
+                        switch (knn_scan_shared_data->knn_distance_type_) {
+                            case KnnDistanceType::kInvalid: {
+                                String error_message = "Invalid distance type";
+                                UnrecoverableError(error_message);
+                            }
+                            case KnnDistanceType::kL2:
+                            case KnnDistanceType::kHamming: {
+                                break;
+                            }
+                            case KnnDistanceType::kCosine:
+                            case KnnDistanceType::kInnerProduct: {
+                                for (SizeT i = 0; i < result_n; ++i) {
+                                    d_ptr[i] = -d_ptr[i];
+                                }
+                                break;
+                            }
+                        }
+                        auto row_ids = MakeUniqueForOverwrite<RowID[]>(result_n);
+                        for (SizeT i = 0; i < result_n; ++i) {
+                            const auto &part = group.GetPart(l_ptr[i]);
+                            row_ids[i] = RowID{part.segment_id_, l_ptr[i] - part.base_offset_};
+                        }
+                        merge_heap->Search(query_idx, d_ptr.get(), row_ids.get(), result_n);
+                    }
+                }
+            },
+            group.get());
+    }
+}
+
 template <LogicalType t, typename ColumnDataType, typename QueryDataType, template <typename, typename> typename C, typename DistanceDataType>
 void PhysicalKnnScan::ExecuteInternalByColumnDataTypeAndQueryDataType(QueryContext *query_context, KnnScanOperatorState *knn_scan_operator_state) {
     // knn expr output data type is always f32
@@ -510,7 +839,8 @@ void PhysicalKnnScan::ExecuteInternalByColumnDataTypeAndQueryDataType(QueryConte
         UnrecoverableError(err);
     }
 
-    const SizeT index_task_n = knn_scan_shared_data->index_entries_->size();
+    const SizeT group_task_n = knn_scan_shared_data->hnsw_segment_group_.get() != nullptr;
+    const SizeT index_task_n = knn_scan_shared_data->index_entries_->size() + group_task_n;
     const SizeT brute_task_n = knn_scan_shared_data->block_column_entries_->size();
     BlockIndex *block_index = knn_scan_shared_data->table_ref_->block_index_.get();
     BufferManager *buffer_mgr = query_context->storage()->buffer_manager();
@@ -522,6 +852,13 @@ void PhysicalKnnScan::ExecuteInternalByColumnDataTypeAndQueryDataType(QueryConte
         block_column_idx < brute_task_n) {
         LOG_TRACE(fmt::format("KnnScan: {} brute force {}/{}", knn_scan_function_data->task_id_, block_column_idx + 1, brute_task_n));
         // brute force
+        // the float vectors are quantized for the int8 gemm of many queries only on request, the scan is approximate then
+        bool gemm_quantize = false;
+        for (const auto &opt_param : knn_scan_shared_data->opt_params_) {
+            if (opt_param.param_name_ == "gemm_quantize") {
+                gemm_quantize = opt_param.param_value_ != "false";
+            }
+        }
         // TODO: now will try to finish all block scan job in the task
         do {
             BlockColumnEntry *block_column_entry = knn_scan_shared_data->block_column_entries_->at(block_column_idx);
@@ -546,14 +883,27 @@ void PhysicalKnnScan::ExecuteInternalByColumnDataTypeAndQueryDataType(QueryConte
                                                                                                     segment_id,
                                                                                                     block_id,
                                                                                                     row_count,
-                                                                                                    bitmask);
+                                                                                                    bitmask,
+                                                                                                    gemm_quantize);
             }
             block_column_idx = knn_scan_shared_data->current_block_idx_++;
         } while (block_column_idx < brute_task_n);
-    } else if (u64 index_idx = knn_scan_shared_data->current_index_idx_++; index_idx < index_task_n) {
+    } else if (u64 index_idx = knn_scan_shared_data->current_index_idx_++; index_idx < group_task_n) {
+        // the largest task goes first
+        LOG_TRACE(fmt::format("KnnScan: {} hnsw segment group {}/{}", knn_scan_function_data->task_id_, index_idx + 1, index_task_n));
+        SearchHnswSegmentGroup<t, ColumnDataType, QueryDataType, C, DistanceDataType>(*knn_scan_shared_data->hnsw_segment_group_,
+                                                                                     common_query_filter_.get(),
+                                                                                     knn_scan_shared_data,
+                                                                                     merge_heap,
+                                                                                     dist_func,
+                                                                                     buffer_ptr_for_cast,
+                                                                                     block_index,
+                                                                                     buffer_mgr,
+                                                                                     knn_column_id);
+    } else if (index_idx < index_task_n) {
         LOG_TRACE(fmt::format("KnnScan: {} index {}/{}", knn_scan_function_data->task_id_, index_idx + 1, index_task_n));
         // with index
-        SegmentIndexEntry *segment_index_entry = knn_scan_shared_data->index_entries_->at(index_idx);
+        SegmentIndexEntry *segment_index_entry = knn_scan_shared_data->index_entries_->at(index_idx - group_task_n);
 
         auto segment_id = segment_index_entry->segment_id();
         SegmentOffset segment_row_count = 0;
@@ -588,7 +938,18 @@ void PhysicalKnnScan::ExecuteInternalByColumnDataTypeAndQueryDataType(QueryConte
             switch (segment_index_entry->table_index_entry()->index_base()->index_type_) {
                 case IndexType::kIVF: {
                     const SegmentOffset max_segment_offset = block_index->GetSegmentOffset(segment_id);
-                    const auto ivf_search_params = IVF_Search_Params::Make(knn_scan_function_data);
+                    auto ivf_search_params = IVF_Search_Params::Make(knn_scan_function_data);
+                    const auto &ivf_storage_option = static_cast<const IndexIVF *>(segment_index_entry->table_index_entry()->index_base())->ivf_option_.storage_option_;
+                    if (ivf_storage_option.type_ == IndexIVFStorageOption::Type::kRaBitQ) {
+                        // 1 bit codes only give candidates, always rerank them
+                        ivf_search_params.rerank_ = true;
+                        ivf_search_params.topk_ *= kRaBitQRerankFactor;
+                    } else if (ivf_storage_option.type_ == IndexIVFStorageOption::Type::kProductQuantization &&
+                               ivf_storage_option.product_quantization_subspace_bits_ <= 4) {
+                        // the fast scan of 4 bit codes sums quantized tables
+                        ivf_search_params.rerank_ = true;
+                        ivf_search_params.topk_ *= kPQFastScanRerankFactor;
+                    }
                     auto ivf_result_handler =
                         GetIVFSearchHandler<t, C, DistanceDataType>(ivf_search_params, use_bitmask, bitmask, max_segment_offset);
                     ivf_result_handler->Begin();
@@ -603,116 +964,228 @@ void PhysicalKnnScan::ExecuteInternalByColumnDataTypeAndQueryDataType(QueryConte
                     if (memory_ivf_index) {
                         ivf_result_handler->Search(memory_ivf_index.get());
                     }
-                    auto [result_n, d_ptr, offset_ptr] = ivf_result_handler->EndWithoutSort();
-                    auto row_ids = MakeUniqueForOverwrite<RowID[]>(result_n);
-                    for (SizeT i = 0; i < result_n; ++i) {
-                        row_ids[i] = RowID{segment_id, offset_ptr[i]};
+                    auto [result_ns, d_ptr, offset_ptr] = ivf_result_handler->EndWithoutSort();
+                    for (u64 query_idx = 0; query_idx < result_ns.size(); ++query_idx) {
+                        const SizeT result_n = result_ns[query_idx];
+                        const SizeT result_begin = query_idx * ivf_search_params.topk_;
+                        if (ivf_search_params.rerank_) {
+                            RerankIndexResult<t, ColumnDataType, QueryDataType, C, DistanceDataType>(merge_heap,
+                                                                                                    dist_func,
+                                                                                                    knn_query_ptr + query_idx * embedding_dim,
+                                                                                                    query_idx,
+                                                                                                    embedding_dim,
+                                                                                                    buffer_ptr_for_cast,
+                                                                                                    block_index,
+                                                                                                    buffer_mgr,
+                                                                                                    knn_column_id,
+                                                                                                    segment_id,
+                                                                                                    offset_ptr.get() + result_begin,
+                                                                                                    result_n);
+                            continue;
+                        }
+                        auto row_ids = MakeUniqueForOverwrite<RowID[]>(result_n);
+                        for (SizeT i = 0; i < result_n; ++i) {
+                            row_ids[i] = RowID{segment_id, offset_ptr[result_begin + i]};
+                        }
+                        merge_heap->Search(query_idx, d_ptr.get() + result_begin, row_ids.get(), result_n);
                     }
-                    merge_heap->Search(0, d_ptr.get(), row_ids.get(), result_n);
                     break;
                 }
                 case IndexType::kHnsw: {
-                    if constexpr (!(IsAnyOf<ColumnDataType, u8, i8, f32> && std::is_same_v<ColumnDataType, QueryDataType>)) {
+                    if constexpr (!((IsAnyOf<ColumnDataType, u8, i8, f32> && std::is_same_v<ColumnDataType, QueryDataType>) ||
+                                    IsAnyOf<ColumnDataType, Float16T, BFloat16T>)) {
                         UnrecoverableError("Invalid data type");
                     } else {
-                        auto hnsw_search = [&](auto *hnsw_index, bool with_lock) {
+                        const u32 hnsw_dim = HnswVectorDimension(knn_scan_shared_data);
+                        // half precision indexes are searched with the query rounded to the column element type
+                        UniquePtr<ColumnDataType[]> query_for_cast;
+                        // flattened once and shared by all the queries and the chunks of the segment
+                        UniquePtr<BitmaskFilter<SegmentOffset>> bitmask_filter;
+                        if (use_bitmask) {
+                            bitmask_filter = MakeUnique<BitmaskFilter<SegmentOffset>>(bitmask);
+                        }
+                        // the index has the rows [row_begin, row_end) of the segment
+                        auto hnsw_search = [&](auto *hnsw_index, bool with_lock, SegmentOffset row_begin, SegmentOffset row_end) {
+                            using VecStoreT = typename std::remove_pointer_t<decltype(hnsw_index)>::VecStoreT;
                             bool rerank = false;
+                            u64 coalesce_window_us = 0;
                             KnnSearchOption search_option;
                             search_option.column_logical_type_ = t;
+                            // a filter restrictive on the rows of the index walks only the matching vertices, unless it is set explicitly
+                            if (use_bitmask) {
+                                search_option.filter_pass_n_ = bitmask.CountTrue(row_begin, row_end);
+                                search_option.predicate_aware_ =
+                                    search_option.filter_pass_n_ < kHnswPredicateAwareSelectivity * (row_end - row_begin);
+                            }
                             for (const auto &opt_param : knn_scan_shared_data->opt_params_) {
                                 if (opt_param.param_name_ == "ef") {
                                     u64 ef = std::stoull(opt_param.param_value_);
                                     search_option.ef_ = ef;
                                 } else if (opt_param.param_name_ == "rerank") {
                                     rerank = true;
+                                } else if (opt_param.param_name_ == "predicate_aware") {
+                                    search_option.predicate_aware_ = use_bitmask && opt_param.param_value_ != "false";
+                                } else if (opt_param.param_name_ == "patience") {
+                                    search_option.patience_ = std::stoull(opt_param.param_value_);
+                                } else if (opt_param.param_name_ == "coalesce_window") {
+                                    // microseconds to wait for the concurrent single queries on the same index
+                                    coalesce_window_us = std::stoull(opt_param.param_value_);
+                                }
+                            }
+                            if constexpr (RerankRequired<VecStoreT>) {
+                                // 1 bit codes only give candidates, always rerank them
+                                rerank = true;
+                                if (search_option.ef_ == 0) {
+                                    search_option.ef_ = knn_scan_shared_data->topk_ * kRaBitQRerankFactor;
+                                }
+                            }
+                            if (t == LogicalType::kEmbedding && hnsw_index->dim() < hnsw_dim) {
+                                // the graph only has the first dimensions, the candidates are reranked with the full vectors
+                                rerank = true;
+                                if (search_option.ef_ == 0) {
+                                    search_option.ef_ = knn_scan_shared_data->topk_ * kHnswTruncatedRerankFactor;
                                 }
                             }
 
-                            i64 result_n = -1;
-                            for (u64 query_idx = 0; query_idx < knn_scan_shared_data->query_count_; ++query_idx) {
-                                const auto *query = static_cast<const QueryDataType *>(knn_scan_shared_data->query_embedding_) +
-                                                    query_idx * knn_scan_shared_data->dimension_;
+                            const u64 query_count = knn_scan_shared_data->query_count_;
+                            auto get_query = [&](u64 query_idx) {
+                                return static_cast<const QueryDataType *>(knn_scan_shared_data->query_embedding_) + query_idx * hnsw_dim;
+                            };
+
+                            // the query vectors of a request are searched together, so that they share the traversal of the upper layers.
+                            // One option holds for the whole batch, so the batch does not use the shared bound of each query, the merge heap
+                            // drops the results that miss the top k.
+                            Vector<Tuple<SizeT, UniquePtr<DistanceDataType[]>, UniquePtr<SegmentOffset[]>>> batch_results;
+                            if (t == LogicalType::kEmbedding && query_count > 1) {
+                                Vector<const ColumnDataType *> index_queries(query_count);
+                                UniquePtr<ColumnDataType[]> queries_for_cast;
+                                if constexpr (!std::is_same_v<ColumnDataType, QueryDataType>) {
+                                    queries_for_cast = MakeUniqueForOverwrite<ColumnDataType[]>(query_count * hnsw_dim);
+                                }
+                                for (u64 query_idx = 0; query_idx < query_count; ++query_idx) {
+                                    if constexpr (std::is_same_v<ColumnDataType, QueryDataType>) {
+                                        index_queries[query_idx] = get_query(query_idx);
+                                    } else {
+                                        const QueryDataType *query = get_query(query_idx);
+                                        ColumnDataType *cast_query = queries_for_cast.get() + query_idx * hnsw_dim;
+                                        for (u32 i = 0; i < hnsw_dim; ++i) {
+                                            cast_query[i] = static_cast<ColumnDataType>(query[i]);
+                                        }
+                                        index_queries[query_idx] = cast_query;
+                                    }
+                                }
+                                if (use_bitmask) {
+                                    const auto &filter = *bitmask_filter;
+                                    if (with_lock) {
+                                        batch_results = hnsw_index->template KnnSearchBatch<BitmaskFilter<SegmentOffset>, true>(index_queries.data(),
+                                                                                                                               query_count,
+                                                                                                                               knn_scan_shared_data->topk_,
+                                                                                                                               filter,
+                                                                                                                               search_option);
+                                    } else {
+                                        batch_results = hnsw_index->template KnnSearchBatch<BitmaskFilter<SegmentOffset>, false>(index_queries.data(),
+                                                                                                                                query_count,
+                                                                                                                                knn_scan_shared_data->topk_,
+                                                                                                                                filter,
+                                                                                                                                search_option);
+                                    }
+                                } else {
+                                    SegmentOffset max_segment_offset = block_index->GetSegmentOffset(segment_id);
+                                    if (!with_lock) {
+                                        batch_results = hnsw_index->template KnnSearchBatch<false>(index_queries.data(),
+                                                                                                   query_count,
+                                                                                                   knn_scan_shared_data->topk_,
+                                                                                                   search_option);
+                                    } else {
+                                        AppendFilter filter(max_segment_offset);
+                                        batch_results = hnsw_index->template KnnSearchBatch<AppendFilter, true>(index_queries.data(),
+                                                                                                               query_count,
+                                                                                                               knn_scan_shared_data->topk_,
+                                                                                                               filter,
+                                                                                                               search_option);
+                                    }
+                                }
+                            }
+
+                            for (u64 query_idx = 0; query_idx < query_count; ++query_idx) {
+                                const auto *query = get_query(query_idx);
+                                const ColumnDataType *index_query = nullptr;
+                                if constexpr (std::is_same_v<ColumnDataType, QueryDataType>) {
+                                    index_query = query;
+                                } else if (batch_results.empty()) {
+                                    if (!query_for_cast) {
+                                        query_for_cast = MakeUniqueForOverwrite<ColumnDataType[]>(hnsw_dim);
+                                    }
+                                    for (u32 i = 0; i < hnsw_dim; ++i) {
+                                        query_for_cast[i] = static_cast<ColumnDataType>(query[i]);
+                                    }
+                                    index_query = query_for_cast.get();
+                                }
 
                                 SizeT result_n1 = 0;
                                 UniquePtr<DistanceDataType[]> d_ptr = nullptr;
                                 UniquePtr<SegmentOffset[]> l_ptr = nullptr;
-                                if (use_bitmask) {
-                                    BitmaskFilter<SegmentOffset> filter(bitmask);
+                                if (!rerank) {
+                                    search_option.distance_bound_ =
+                                        HnswSharedDistanceBound(merge_heap, knn_scan_shared_data->knn_distance_type_, query_idx);
+                                }
+                                if (!batch_results.empty()) {
+                                    std::tie(result_n1, d_ptr, l_ptr) = std::move(batch_results[query_idx]);
+                                } else if (use_bitmask) {
+                                    const auto &filter = *bitmask_filter;
                                     if (with_lock) {
                                         std::tie(result_n1, d_ptr, l_ptr) =
-                                            hnsw_index->template KnnSearch<BitmaskFilter<SegmentOffset>, true>(query,
+                                            hnsw_index->template KnnSearch<BitmaskFilter<SegmentOffset>, true>(index_query,
                                                                                                                knn_scan_shared_data->topk_,
                                                                                                                filter,
                                                                                                                search_option);
                                     } else {
                                         std::tie(result_n1, d_ptr, l_ptr) =
-                                            hnsw_index->template KnnSearch<BitmaskFilter<SegmentOffset>, false>(query,
+                                            hnsw_index->template KnnSearch<BitmaskFilter<SegmentOffset>, false>(index_query,
                                                                                                                 knn_scan_shared_data->topk_,
                                                                                                                 filter,
                                                                                                                 search_option);
                                     }
+                                } else if (t == LogicalType::kEmbedding && query_count == 1 && coalesce_window_us > 0) {
+                                    SegmentOffset max_segment_offset = block_index->GetSegmentOffset(segment_id);
+                                    std::tie(result_n1, d_ptr, l_ptr) = CoalescedHnswSearch(hnsw_index,
+                                                                                           index_query,
+                                                                                           knn_scan_shared_data->topk_,
+                                                                                           with_lock,
+                                                                                           max_segment_offset,
+                                                                                           search_option,
+                                                                                           coalesce_window_us);
                                 } else {
                                     SegmentOffset max_segment_offset = block_index->GetSegmentOffset(segment_id);
                                     if (!with_lock) {
                                         std::tie(result_n1, d_ptr, l_ptr) =
-                                            hnsw_index->template KnnSearch<false>(query, knn_scan_shared_data->topk_, search_option);
+                                            hnsw_index->template KnnSearch<false>(index_query, knn_scan_shared_data->topk_, search_option);
                                     } else {
                                         AppendFilter filter(max_segment_offset);
                                         std::tie(result_n1, d_ptr, l_ptr) =
-                                            hnsw_index->template KnnSearch<AppendFilter, true>(query,
+                                            hnsw_index->template KnnSearch<AppendFilter, true>(index_query,
                                                                                                knn_scan_shared_data->topk_,
                                                                                                filter,
                                                                                                search_option);
                                     }
                                 }
 
-                                if (result_n < 0) {
-                                    result_n = result_n1;
-                                } else if (result_n != (i64)result_n1) {
-                                    String error_message = "KnnScan: result_n mismatch";
-                                    UnrecoverableError(error_message);
-                                }
+                                // the queries may get different numbers of results when some vertices are filtered out
+                                const i64 result_n = result_n1;
 
                                 if (rerank) {
-                                    Vector<SizeT> idxes(result_n);
-                                    std::iota(idxes.begin(), idxes.end(), 0);
-                                    std::sort(idxes.begin(), idxes.end(), [&](SizeT i, SizeT j) {
-                                        return l_ptr[i] < l_ptr[j];
-                                    }); // sort by segment offset
-                                    BlockID prev_block_id = -1;
-                                    ColumnVector column_vector;
-                                    for (SizeT idx : idxes) {
-                                        SegmentOffset segment_offset = l_ptr[idx];
-                                        BlockID block_id = segment_offset / DEFAULT_BLOCK_CAPACITY;
-                                        BlockOffset block_offset = segment_offset % DEFAULT_BLOCK_CAPACITY;
-                                        if (block_id != prev_block_id) {
-                                            prev_block_id = block_id;
-                                            BlockEntry *block_entry = block_index->GetBlockEntry(segment_id, block_id);
-                                            column_vector = block_entry->GetConstColumnVector(buffer_mgr, knn_column_id);
-                                        }
-                                        if constexpr (t == LogicalType::kEmbedding) {
-                                            const auto *data = reinterpret_cast<const ColumnDataType *>(column_vector.data());
-                                            data += block_offset * knn_scan_shared_data->dimension_;
-                                            merge_heap->Search(query,
-                                                               data,
-                                                               knn_scan_shared_data->dimension_,
-                                                               dist_func->dist_func_,
-                                                               segment_id,
-                                                               segment_offset);
-                                        } else if constexpr (t == LogicalType::kMultiVector) {
-                                            MultiVectorSearchOneLine<ColumnDataType, QueryDataType, C, DistanceDataType>(merge_heap,
-                                                                                                                         dist_func,
-                                                                                                                         query,
-                                                                                                                         embedding_dim,
-                                                                                                                         buffer_ptr_for_cast,
-                                                                                                                         column_vector,
-                                                                                                                         segment_id,
-                                                                                                                         segment_offset,
-                                                                                                                         block_offset);
-                                        } else {
-                                            static_assert(false, "Unexpected logical type");
-                                        }
-                                    }
+                                    RerankIndexResult<t, ColumnDataType, QueryDataType, C, DistanceDataType>(merge_heap,
+                                                                                                            dist_func,
+                                                                                                            query,
+                                                                                                            query_idx,
+                                                                                                            hnsw_dim,
+                                                                                                            buffer_ptr_for_cast,
+                                                                                                            block_index,
+                                                                                                            buffer_mgr,
+                                                                                                            knn_column_id,
+                                                                                                            segment_id,
+                                                                                                            l_ptr.get(),
+                                                                                                            result_n);
                                 } else {
                                     switch (knn_scan_shared_data->knn_distance_type_) {
                                         case KnnDistanceType::kInvalid: {
@@ -738,11 +1211,14 @@ void PhysicalKnnScan::ExecuteInternalByColumnDataTypeAndQueryDataType(QueryConte
                                         row_ids[i] = RowID{segment_id, l_ptr[i]};
                                     }
 
-                                    merge_heap->Search(0, d_ptr.get(), row_ids.get(), result_n);
+                                    merge_heap->Search(query_idx, d_ptr.get(), row_ids.get(), result_n);
                                 }
                             }
                         };
-                        auto abstract_hnsw_search = [&](const AbstractHnsw &abstract_hnsw, bool with_lock) {
+                        auto abstract_hnsw_search = [&](const AbstractHnsw &abstract_hnsw,
+                                                        bool with_lock,
+                                                        SegmentOffset row_begin,
+                                                        SegmentOffset row_end) {
                             std::visit(
                                 [&](auto &&arg) {
                                     using T = std::decay_t<decltype(arg)>;
@@ -751,7 +1227,7 @@ void PhysicalKnnScan::ExecuteInternalByColumnDataTypeAndQueryDataType(QueryConte
                                     } else if constexpr (!std::is_same_v<ColumnDataType, typename std::remove_pointer_t<T>::DataType>) {
                                         UnrecoverableError("Invalid data type");
                                     } else {
-                                        hnsw_search(arg, with_lock);
+                                        hnsw_search(arg, with_lock, row_begin, row_end);
                                     }
                                 },
                                 abstract_hnsw);
@@ -762,12 +1238,90 @@ void PhysicalKnnScan::ExecuteInternalByColumnDataTypeAndQueryDataType(QueryConte
                             if (chunk_index_entry->CheckVisible(txn)) {
                                 BufferHandle index_handle = chunk_index_entry->GetIndex();
                                 const auto *abstract_hnsw = reinterpret_cast<const AbstractHnsw *>(index_handle.GetData());
-                                abstract_hnsw_search(*abstract_hnsw, false);
+                                const SegmentOffset row_begin = chunk_index_entry->base_rowid_.segment_offset_;
+                                abstract_hnsw_search(*abstract_hnsw, false, row_begin, row_begin + chunk_index_entry->GetRowCount());
                             }
                         }
                         if (memory_hnsw_index.get() != nullptr) {
                             const AbstractHnsw &abstract_hnsw = memory_hnsw_index->get();
-                            abstract_hnsw_search(abstract_hnsw, true);
+                            // the in memory index grows up to the end of the segment
+                            abstract_hnsw_search(abstract_hnsw, true, memory_hnsw_index->GetBeginRowID().segment_offset_, segment_row_count);
+                        }
+                    }
+                    break;
+                }
+                case IndexType::kDiskAnn: {
+                    if constexpr (!(t == LogicalType::kEmbedding && std::is_same_v<ColumnDataType, f32> && std::is_same_v<QueryDataType, f32>)) {
+                        RecoverableError(Status::NotSupport("DiskAnn index only supports float embedding"));
+                    } else {
+                        const auto *index_diskann = static_cast<const IndexDiskAnn *>(segment_index_entry->table_index_entry()->index_base());
+                        SizeT search_list_size = index_diskann->L_;
+                        SizeT beam_width = DISKANN_BEAM_WIDTH;
+                        for (const auto &opt_param : knn_scan_shared_data->opt_params_) {
+                            if (opt_param.param_name_ == "l") {
+                                search_list_size = std::stoull(opt_param.param_value_);
+                            } else if (opt_param.param_name_ == "beam_width") {
+                                beam_width = std::stoull(opt_param.param_value_);
+                            }
+                        }
+                        const SizeT topk = knn_scan_shared_data->topk_ * (use_bitmask ? kDiskAnnFilterFetchFactor : 1);
+                        const u64 query_count = knn_scan_shared_data->query_count_;
+                        // the candidates of all the chunks, filtered and reranked with the exact distances
+                        auto offsets = MakeUniqueForOverwrite<SegmentOffset[]>(topk);
+                        SegmentOffset covered_end = 0;
+                        const auto chunk_index_entries = segment_index_entry->GetDiskAnnIndexSnapshot();
+                        for (auto &chunk_index_entry : chunk_index_entries) {
+                            if (!chunk_index_entry->CheckVisible(txn)) {
+                                continue;
+                            }
+                            BufferHandle index_handle = chunk_index_entry->GetIndex();
+                            const auto *diskann_chunk = static_cast<const DiskAnnIndexInChunk *>(index_handle.GetData());
+                            covered_end = std::max<SegmentOffset>(covered_end, diskann_chunk->start_segment_offset() + diskann_chunk->row_count());
+                            for (u64 query_idx = 0; query_idx < query_count; ++query_idx) {
+                                const QueryDataType *query = knn_query_ptr + query_idx * embedding_dim;
+                                const SizeT result_n = diskann_chunk->SearchIndex(query, topk, search_list_size, beam_width, offsets.get());
+                                SizeT pass_n = 0;
+                                for (SizeT i = 0; i < result_n; ++i) {
+                                    if (offsets[i] < segment_row_count && (!use_bitmask || bitmask.IsTrue(offsets[i]))) {
+                                        offsets[pass_n++] = offsets[i];
+                                    }
+                                }
+                                RerankIndexResult<t, ColumnDataType, QueryDataType, C, DistanceDataType>(merge_heap,
+                                                                                                        dist_func,
+                                                                                                        query,
+                                                                                                        query_idx,
+                                                                                                        embedding_dim,
+                                                                                                        buffer_ptr_for_cast,
+                                                                                                        block_index,
+                                                                                                        buffer_mgr,
+                                                                                                        knn_column_id,
+                                                                                                        segment_id,
+                                                                                                        offsets.get(),
+                                                                                                        pass_n);
+                            }
+                        }
+                        // the rows appended after the build, or the whole segment if it is too small for a graph
+                        Vector<SegmentOffset> uncovered_offsets;
+                        for (SegmentOffset offset = covered_end; offset < segment_row_count; ++offset) {
+                            if (!use_bitmask || bitmask.IsTrue(offset)) {
+                                uncovered_offsets.push_back(offset);
+                            }
+                        }
+                        if (!uncovered_offsets.empty()) {
+                            for (u64 query_idx = 0; query_idx < query_count; ++query_idx) {
+                                RerankIndexResult<t, ColumnDataType, QueryDataType, C, DistanceDataType>(merge_heap,
+                                                                                                        dist_func,
+                                                                                                        knn_query_ptr + query_idx * embedding_dim,
+                                                                                                        query_idx,
+                                                                                                        embedding_dim,
+                                                                                                        buffer_ptr_for_cast,
+                                                                                                        block_index,
+                                                                                                        buffer_mgr,
+                                                                                                        knn_column_id,
+                                                                                                        segment_id,
+                                                                                                        uncovered_offsets.data(),
+                                                                                                        uncovered_offsets.size());
+                            }
                         }
                     }
                     break;
@@ -809,7 +1363,26 @@ struct BruteForceBlockScan<LogicalType::kEmbedding, ColumnDataType, QueryDataTyp
                         const SegmentID segment_id,
                         const BlockID block_id,
                         const BlockOffset row_count,
-                        const Bitmask &bitmask) {
+                        const Bitmask &bitmask,
+                        const bool gemm_quantize) {
+        auto embedding_info = static_cast<EmbeddingInfo *>(column_vector.data_type()->type_info().get());
+        const bool use_gemm = merge_heap->query_count() >= kKnnFlatGemmMinQueryCount && embedding_info->Type() != EmbeddingDataType::kElemBit &&
+                              dist_func->dist_type_ != KnnDistanceType::kHamming && (IsAnyOf<ColumnDataType, u8, i8> || gemm_quantize);
+        if constexpr (IsAnyOf<ColumnDataType, Float16T, BFloat16T>) {
+            if (!use_gemm) {
+                // half precision data are computed directly, without casting the block to f32
+                const auto half_dist_func = std::is_same_v<ColumnDataType, Float16T> ? dist_func->f16_dist_func_ : dist_func->bf16_dist_func_;
+                const auto *half_data = reinterpret_cast<const u16 *>(column_vector.data());
+                if constexpr (C<DistanceDataType, RowID>::IsMax) {
+                    if (dist_func->dist_type_ == KnnDistanceType::kL2) {
+                        merge_heap->SearchPartial(knn_query_ptr, half_data, embedding_dim, half_dist_func, row_count, segment_id, block_id, bitmask);
+                        return;
+                    }
+                }
+                merge_heap->Search(knn_query_ptr, half_data, embedding_dim, half_dist_func, row_count, segment_id, block_id, bitmask);
+                return;
+            }
+        }
         auto data = reinterpret_cast<const ColumnDataType *>(column_vector.data());
         const QueryDataType *target_ptr = nullptr;
         if constexpr (std::is_same_v<ColumnDataType, QueryDataType>) {
@@ -824,11 +1397,79 @@ struct BruteForceBlockScan<LogicalType::kEmbedding, ColumnDataType, QueryDataTyp
             }
             target_ptr = buffer_ptr_for_cast.get();
         }
-        auto embedding_info = static_cast<EmbeddingInfo *>(column_vector.data_type()->type_info().get());
+        if (use_gemm) {
+            GemmSearch(merge_heap, dist_func, knn_query_ptr, embedding_dim, target_ptr, segment_id, block_id, row_count, bitmask);
+            return;
+        }
         if (embedding_info->Type() == EmbeddingDataType::kElemBit) {
             merge_heap->Search(knn_query_ptr, target_ptr, embedding_dim / 8, dist_func->dist_func_, row_count, segment_id, block_id, bitmask);
+            return;
+        }
+        if constexpr (C<DistanceDataType, RowID>::IsMax) {
+            // the squared L2 only grows over the dimensions, a row stops once it is worse than the k-th distance of the scan
+            if (dist_func->dist_type_ == KnnDistanceType::kL2) {
+                merge_heap->SearchPartial(knn_query_ptr, target_ptr, embedding_dim, dist_func->dist_func_, row_count, segment_id, block_id, bitmask);
+                return;
+            }
+        }
+        merge_heap->Search(knn_query_ptr, target_ptr, embedding_dim, dist_func->dist_func_, row_count, segment_id, block_id, bitmask);
+    }
+
+    // The queries share one int8 GEMM over the block, see `KnnFlatGemm`. The distances of u8 / i8 vectors are exact, the float vectors
+    // are ranked by their quantized distances and the best candidates of each query are reranked with the exact distances.
+    static void GemmSearch(MergeKnn<QueryDataType, C, DistanceDataType> *merge_heap,
+                           KnnDistance1<QueryDataType, DistanceDataType> *dist_func,
+                           const QueryDataType *queries,
+                           const u32 embedding_dim,
+                           const QueryDataType *rows,
+                           const SegmentID segment_id,
+                           const BlockID block_id,
+                           const BlockOffset row_count,
+                           const Bitmask &bitmask) {
+        const SizeT query_n = merge_heap->query_count();
+        const SegmentOffset segment_offset_start = block_id * DEFAULT_BLOCK_CAPACITY;
+        Vector<BlockOffset> selected;
+        selected.reserve(row_count);
+        for (BlockOffset i = 0; i < row_count; ++i) {
+            if (bitmask.IsTrue(i)) {
+                selected.push_back(i);
+            }
+        }
+        if (selected.empty()) {
+            return;
+        }
+        KnnFlatGemm gemm(dist_func->dist_type_, embedding_dim);
+        const auto scores = MakeUniqueForOverwrite<f32[]>(query_n * row_count);
+        Vector<DistanceDataType> dists(selected.size());
+        Vector<RowID> row_ids(selected.size());
+        if constexpr (IsAnyOf<QueryDataType, u8, i8>) {
+            gemm.Distances(queries, query_n, rows, row_count, scores.get());
+            for (SizeT i = 0; i < selected.size(); ++i) {
+                row_ids[i] = RowID(segment_id, segment_offset_start + selected[i]);
+            }
+            for (SizeT q = 0; q < query_n; ++q) {
+                for (SizeT i = 0; i < selected.size(); ++i) {
+                    dists[i] = scores[q * row_count + selected[i]];
+                }
+                merge_heap->Search(q, dists.data(), row_ids.data(), selected.size());
+            }
         } else {
-            merge_heap->Search(knn_query_ptr, target_ptr, embedding_dim, dist_func->dist_func_, row_count, segment_id, block_id, bitmask);
+            gemm.RankScores(queries, query_n, rows, row_count, scores.get());
+            const SizeT candidate_n = std::min<SizeT>(selected.size(), merge_heap->topk() * kKnnFlatGemmRerankFactor);
+            Vector<BlockOffset> candidates;
+            for (SizeT q = 0; q < query_n; ++q) {
+                const f32 *query_scores = scores.get() + q * row_count;
+                candidates = selected;
+                std::nth_element(candidates.begin(), candidates.begin() + (candidate_n - 1), candidates.end(), [&](BlockOffset a, BlockOffset b) {
+                    return query_scores[a] < query_scores[b];
+                });
+                const QueryDataType *query = queries + q * embedding_dim;
+                for (SizeT i = 0; i < candidate_n; ++i) {
+                    dists[i] = dist_func->dist_func_(query, rows + static_cast<SizeT>(candidates[i]) * embedding_dim, embedding_dim);
+                    row_ids[i] = RowID(segment_id, segment_offset_start + candidates[i]);
+                }
+                merge_heap->Search(q, dists.data(), row_ids.data(), candidate_n);
+            }
         }
     }
 };
@@ -844,7 +1485,8 @@ struct BruteForceBlockScan<LogicalType::kMultiVector, ColumnDataType, QueryDataT
                         const SegmentID segment_id,
                         const BlockID block_id,
                         const BlockOffset row_count,
-                        const Bitmask &bitmask) {
+                        const Bitmask &bitmask,
+                        const bool) {
         for (BlockOffset row_id = 0; row_id < row_count; ++row_id) {
             if (bitmask.IsTrue(row_id)) {
                 SegmentOffset segment_offset = block_id * DEFAULT_BLOCK_CAPACITY + row_id;
@@ -874,7 +1516,7 @@ void MultiVectorSearchOneLine(MergeKnn<QueryDataType, C, DistanceDataType> *merg
                               const BlockOffset block_offset) {
     using Compare = C<DistanceDataType, RowID>;
     const QueryDataType *target_ptr = nullptr;
-    if constexpr (!std::is_same_v<ColumnDataType, QueryDataType>) {
+    if constexpr (!std::is_same_v<ColumnDataType, QueryDataType> && !IsAnyOf<ColumnDataType, Float16T, BFloat16T>) {
         if (!buffer_ptr_for_cast) {
             buffer_ptr_for_cast = MakeUniqueForOverwrite<QueryDataType[]>(embedding_dim);
         }
@@ -884,14 +1526,20 @@ void MultiVectorSearchOneLine(MergeKnn<QueryDataType, C, DistanceDataType> *merg
     auto result_dist = Compare::InitialValue();
     auto raw_data_ptr = reinterpret_cast<const ColumnDataType *>(data_span.data());
     for (u32 i = 0; i < embedding_num; ++i) {
-        if constexpr (!std::is_same_v<ColumnDataType, QueryDataType>) {
-            for (u32 j = 0; j < embedding_dim; ++j) {
-                buffer_ptr_for_cast[j] = static_cast<QueryDataType>(raw_data_ptr[j]);
-            }
+        DistanceDataType new_dist{};
+        if constexpr (IsAnyOf<ColumnDataType, Float16T, BFloat16T>) {
+            const auto half_dist_func = std::is_same_v<ColumnDataType, Float16T> ? dist_func->f16_dist_func_ : dist_func->bf16_dist_func_;
+            new_dist = half_dist_func(knn_query_ptr, reinterpret_cast<const u16 *>(raw_data_ptr), embedding_dim);
         } else {
-            target_ptr = raw_data_ptr;
+            if constexpr (!std::is_same_v<ColumnDataType, QueryDataType>) {
+                for (u32 j = 0; j < embedding_dim; ++j) {
+                    buffer_ptr_for_cast[j] = static_cast<QueryDataType>(raw_data_ptr[j]);
+                }
+            } else {
+                target_ptr = raw_data_ptr;
+            }
+            new_dist = dist_func->dist_func_(knn_query_ptr, target_ptr, embedding_dim);
         }
-        const auto new_dist = dist_func->dist_func_(knn_query_ptr, target_ptr, embedding_dim);
         static_assert(std::is_same_v<decltype(result_dist), std::decay_t<decltype(new_dist)>>);
         result_dist = Compare::Compare(result_dist, new_dist) ? new_dist : result_dist;
         raw_data_ptr += embedding_dim;
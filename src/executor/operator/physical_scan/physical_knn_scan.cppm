@@ -34,6 +34,8 @@ import physical_filter_scan_base;
 
 namespace infinity {
 
+class HnswSegmentGroup;
+
 export class PhysicalKnnScan final : public PhysicalFilterScanBase {
 public:
     explicit PhysicalKnnScan(u64 id,
@@ -96,9 +98,10 @@ public:
 
     Vector<Pair<u32, u32>> block_parallel_options_;
     u32 block_column_entries_size_ = 0; // need this value because block_column_entries_ will be moved into KnnScanSharedData
-    u32 index_entries_size_ = 0;
+    u32 index_entries_size_ = 0; // including the hnsw segment group
     UniquePtr<Vector<BlockColumnEntry *>> block_column_entries_{};
     UniquePtr<Vector<SegmentIndexEntry *>> index_entries_{};
+    SharedPtr<HnswSegmentGroup> hnsw_segment_group_{};
 
 private:
     void InitBlockParallelOption();
@@ -440,6 +440,7 @@ void PhysicalMatchSparseScan::ExecuteInnerT(DistFunc *dist_func,
 
         for (SizeT query_id = 0; query_id < query_n; ++query_id) {
             auto query_sparse = get_ele(query_vector, query_id);
+            dist_func->BeginQuery(query_sparse);
             for (BlockOffset i = 0; i < row_cnt; ++i) {
                 if (!bitmask.IsTrue(i)) {
                     continue;
@@ -447,7 +448,7 @@ void PhysicalMatchSparseScan::ExecuteInnerT(DistFunc *dist_func,
 
                 auto sparse = get_ele(column_vector, i);
 
-                ResultType d = dist_func->Calculate(query_sparse, sparse);
+                ResultType d = dist_func->CalculateQuery(sparse);
                 RowID row_id(segment_id, block_id * DEFAULT_BLOCK_CAPACITY + i);
 
                 merge_heap->Search(query_id, &d, &row_id, 1);
@@ -15,6 +15,7 @@
 module;
 
 #include <bit>
+#include <future>
 #include <cstdlib>
 #include <memory>
 #include <string>
@@ -69,6 +70,7 @@ import buffer_manager;
 import buffer_handle;
 import match_tensor_scan_function_data;
 import mlas_matrix_multiply;
+import maxsim_batch;
 import physical_fusion;
 import filter_value_type_classification;
 import logical_match_tensor_scan;
@@ -76,6 +78,7 @@ import simd_functions;
 import knn_expression;
 import search_options;
 import result_cache_manager;
+import infinity_context;
 
 namespace infinity {
 
@@ -389,28 +392,46 @@ void PhysicalMatchTensorScan::ExecuteInner(QueryContext *query_context, MatchTen
                                     }},
                            result);
             }
-            // 2. chunk index
+            // 2. chunk index, the chunks are searched in parallel
+            Vector<BufferHandle> index_handles;
             for (const auto &chunk_index_entry : std::get<Vector<SharedPtr<ChunkIndexEntry>>>(emvb_snapshot)) {
                 if (chunk_index_entry->CheckVisible(txn)) {
-                    const BufferHandle index_handle = chunk_index_entry->GetIndex();
-                    const auto *emvb_index = static_cast<const EMVBIndex *>(index_handle.GetData());
-                    // TODO: fix the parameters
-                    const auto [result_num, score_ptr, row_id_ptr] =
-                        emvb_index->SearchWithBitmask(reinterpret_cast<const f32 *>(calc_match_tensor_expr_->query_embedding_.ptr),
-                                                      calc_match_tensor_expr_->num_of_embedding_in_query_tensor_,
-                                                      topn_,
-                                                      segment_bitmask,
-                                                      segment_entry,
-                                                      block_index,
-                                                      begin_ts,
-                                                      index_options_->emvb_centroid_nprobe_,
-                                                      index_options_->emvb_threshold_first_,
-                                                      index_options_->emvb_n_doc_to_score_,
-                                                      index_options_->emvb_n_doc_out_second_stage_,
-                                                      index_options_->emvb_threshold_final_);
-                    for (u32 i = 0; i < result_num; ++i) {
-                        function_data.result_handler_->AddResult(0, score_ptr[i], RowID(segment_id, row_id_ptr[i]));
-                    }
+                    index_handles.push_back(chunk_index_entry->GetIndex());
+                }
+            }
+            Vector<Tuple<u32, UniquePtr<f32[]>, UniquePtr<u32[]>>> chunk_results(index_handles.size());
+            auto search_chunk = [&](const SizeT chunk_i) {
+                const auto *emvb_index = static_cast<const EMVBIndex *>(index_handles[chunk_i].GetData());
+                // TODO: fix the parameters
+                chunk_results[chunk_i] = emvb_index->SearchWithBitmask(reinterpret_cast<const f32 *>(calc_match_tensor_expr_->query_embedding_.ptr),
+                                                                       calc_match_tensor_expr_->num_of_embedding_in_query_tensor_,
+                                                                       topn_,
+                                                                       segment_bitmask,
+                                                                       segment_entry,
+                                                                       block_index,
+                                                                       begin_ts,
+                                                                       index_options_->emvb_centroid_nprobe_,
+                                                                       index_options_->emvb_threshold_first_,
+                                                                       index_options_->emvb_n_doc_to_score_,
+                                                                       index_options_->emvb_n_doc_out_second_stage_,
+                                                                       index_options_->emvb_threshold_final_);
+            };
+            if (index_handles.size() > 1) {
+                auto &thread_pool = InfinityContext::instance().GetKnnSearchThreadPool();
+                Vector<std::future<void>> futs;
+                futs.reserve(index_handles.size());
+                for (SizeT chunk_i = 0; chunk_i < index_handles.size(); ++chunk_i) {
+                    futs.emplace_back(thread_pool.push([&search_chunk, chunk_i](int) { search_chunk(chunk_i); }));
+                }
+                for (auto &fut : futs) {
+                    fut.get();
+                }
+            } else if (index_handles.size() == 1) {
+                search_chunk(0);
+            }
+            for (const auto &[result_num, score_ptr, row_id_ptr] : chunk_results) {
+                for (u32 i = 0; i < result_num; ++i) {
+                    function_data.result_handler_->AddResult(0, score_ptr[i], RowID(segment_id, row_id_ptr[i]));
                 }
             }
         }
@@ -502,7 +523,6 @@ struct MaxSimOp {
 };
 
 // TensorElemT: bit, QueryElemT: bit (unaligned)
-// TODO: hamming distance?
 template <>
 struct MaxSimOp<bool, bool> {
     static float Score(const char *raw_query_tensor_ptr,
@@ -510,51 +530,22 @@ struct MaxSimOp<bool, bool> {
                        const u32 query_embedding_num,
                        const u32 target_embedding_num,
                        const u32 basic_embedding_dimension) {
-        const auto unit_embedding_bytes = basic_embedding_dimension / 8;
-        if (unit_embedding_bytes % 4 == 0) {
-            if (reinterpret_cast<uintptr_t>(raw_query_tensor_ptr) % alignof(u32) == 0 &&
-                reinterpret_cast<uintptr_t>(raw_target_tensor_ptr) % alignof(u32) == 0) {
-                const auto u32_cnt = unit_embedding_bytes / 4;
-                const auto query_tensor_u32_ptr = reinterpret_cast<const u32 *>(raw_query_tensor_ptr);
-                const auto target_tensor_u32_ptr = reinterpret_cast<const u32 *>(raw_target_tensor_ptr);
-                u32 maxsim_score = 0;
-                for (u32 query_i = 0; query_i < query_embedding_num; ++query_i) {
-                    const auto query_ptr = query_tensor_u32_ptr + query_i * u32_cnt;
-                    auto min_score_i = std::numeric_limits<u32>::max();
-                    for (u32 target_j = 0; target_j < target_embedding_num; ++target_j) {
-                        const auto target_ptr = target_tensor_u32_ptr + target_j * u32_cnt;
-                        u32 score_ij = 0;
-                        for (u32 k = 0; k < u32_cnt; ++k) {
-                            score_ij += std::popcount(query_ptr[k] ^ target_ptr[k]);
-                        }
-                        min_score_i = std::min(min_score_i, score_ij);
-                    }
-                    maxsim_score += min_score_i;
-                }
-                // hamming distance, higher score means more different
-                return -static_cast<float>(maxsim_score);
-            }
-            // memory allocated by new char[] should be aligned to any basic type
-            LOG_ERROR("MaxSimOp<bool, bool> Score: input tensor is not aligned to int");
-        }
+        const auto hamming_func_ptr = GetSIMD_FUNCTIONS().HammingDistance_func_ptr_;
         const auto query_tensor_ptr = reinterpret_cast<const u8 *>(raw_query_tensor_ptr);
         const auto target_tensor_ptr = reinterpret_cast<const u8 *>(raw_target_tensor_ptr);
-        u32 maxsim_score = 0;
+        const auto unit_embedding_bytes = basic_embedding_dimension / 8;
+        float maxsim_score = 0.0f;
         for (u32 query_i = 0; query_i < query_embedding_num; ++query_i) {
             const auto query_ptr = query_tensor_ptr + query_i * unit_embedding_bytes;
-            auto min_score_i = std::numeric_limits<u32>::max();
+            auto min_score_i = std::numeric_limits<float>::max();
             for (u32 target_j = 0; target_j < target_embedding_num; ++target_j) {
                 const auto target_ptr = target_tensor_ptr + target_j * unit_embedding_bytes;
-                u32 score_ij = 0;
-                for (u32 k = 0; k < unit_embedding_bytes; ++k) {
-                    score_ij += std::popcount(static_cast<u32>(query_ptr[k] ^ target_ptr[k]));
-                }
-                min_score_i = std::min(min_score_i, score_ij);
+                min_score_i = std::min(min_score_i, hamming_func_ptr(query_ptr, target_ptr, unit_embedding_bytes));
             }
             maxsim_score += min_score_i;
         }
         // hamming distance, higher score means more different
-        return -static_cast<float>(maxsim_score);
+        return -maxsim_score;
     }
 };
 
@@ -763,6 +754,12 @@ struct CalcutateScoreOfTensorRow {
         const auto [raw_data, embedding_num] = column_vector.GetTensorRaw(block_offset);
         return Op::Score(query_tensor_ptr, raw_data.data(), query_embedding_num, embedding_num, basic_embedding_dimension);
     }
+
+    template <typename Batch>
+    static void AddToBatch(ColumnVector &column_vector, const u32 block_offset, Batch &batch, const u32 slot) {
+        const auto [raw_data, embedding_num] = column_vector.GetTensorRaw(block_offset);
+        batch.Add(raw_data.data(), embedding_num, slot);
+    }
 };
 
 template <typename Op>
@@ -780,6 +777,14 @@ struct CalcutateScoreOfTensorArrayRow {
         }
         return maxsim_score;
     }
+
+    template <typename Batch>
+    static void AddToBatch(ColumnVector &column_vector, const u32 block_offset, Batch &batch, const u32 slot) {
+        Vector<Pair<Span<const char>, SizeT>> tensor_array = column_vector.GetTensorArrayRaw(block_offset);
+        for (const auto &[raw_data, embedding_num] : tensor_array) {
+            batch.Add(raw_data.data(), embedding_num, slot);
+        }
+    }
 };
 
 template <typename CalcutateScoreOfRowOp>
@@ -805,6 +810,45 @@ void ExecuteScanOnColumn(ColumnVector &column_vector,
     }
 }
 
+template <typename CalcutateScoreOfRowOp, typename Batch>
+void ExecuteBatchedScanOnColumn(ColumnVector &column_vector,
+                                const SegmentID segment_id,
+                                const BlockID block_id,
+                                const u32 start_block_offset,
+                                const u32 row_count,
+                                const Bitmask &bitmask,
+                                const MatchTensorExpression &match_tensor_expr,
+                                MatchTensorScanFunctionData &function_data) {
+    Batch batch(match_tensor_expr.query_embedding_.ptr,
+                match_tensor_expr.num_of_embedding_in_query_tensor_,
+                match_tensor_expr.tensor_basic_embedding_dimension_);
+    const u32 segment_offset_start = block_id * DEFAULT_BLOCK_CAPACITY;
+    const u32 end_block_offset = start_block_offset + row_count;
+    Vector<u32> batch_block_offsets;
+    Vector<float> batch_scores;
+    auto score_batch = [&] {
+        batch_scores.assign(batch_block_offsets.size(), std::numeric_limits<float>::lowest());
+        batch.Score(batch_scores.data());
+        for (SizeT k = 0; k < batch_block_offsets.size(); ++k) {
+            function_data.result_handler_->AddResult(0, batch_scores[k], RowID(segment_id, segment_offset_start + batch_block_offsets[k]));
+        }
+        batch.Clear();
+        batch_block_offsets.clear();
+    };
+    for (u32 i = start_block_offset; i < end_block_offset; ++i) {
+        if (bitmask.IsTrue(i)) {
+            CalcutateScoreOfRowOp::AddToBatch(column_vector, i, batch, batch_block_offsets.size());
+            batch_block_offsets.push_back(i);
+            if (batch.embedding_num() >= kMaxSimBatchEmbeddingNum) {
+                score_batch();
+            }
+        }
+    }
+    if (!batch_block_offsets.empty()) {
+        score_batch();
+    }
+}
+
 struct TensorScanParameterPack {
     ColumnVector &column_vector_;
     const SegmentID segment_id_;
@@ -830,6 +874,17 @@ template <template <typename> typename CalcutateScoreOfRow, typename ColumnElemT
 void CalculateScoreOnColumnVectorT(TensorScanParameterPack &parameter_pack) {
     switch (parameter_pack.match_tensor_expr_.search_method_) {
         case MatchTensorSearchMethod::kMaxSim: {
+            if constexpr (MaxSimBatch<ColumnElemT, QueryElemT>::kBatched) {
+                return ExecuteBatchedScanOnColumn<CalcutateScoreOfRow<MaxSimOp<ColumnElemT, QueryElemT>>, MaxSimBatch<ColumnElemT, QueryElemT>>(
+                    parameter_pack.column_vector_,
+                    parameter_pack.segment_id_,
+                    parameter_pack.block_id_,
+                    parameter_pack.start_block_offset_,
+                    parameter_pack.row_count_,
+                    parameter_pack.bitmask_,
+                    parameter_pack.match_tensor_expr_,
+                    parameter_pack.function_data_);
+            }
             return ExecuteScanOnColumn<CalcutateScoreOfRow<MaxSimOp<ColumnElemT, QueryElemT>>>(parameter_pack.column_vector_,
                                                                                                parameter_pack.segment_id_,
                                                                                                parameter_pack.block_id_,
@@ -972,6 +1027,44 @@ void GetRerankerScore(Vector<MatchTensorRerankDoc> &rerank_docs,
     }
 }
 
+template <typename CalcutateScoreOfRowOp, typename Batch>
+void GetBatchedRerankerScore(Vector<MatchTensorRerankDoc> &rerank_docs,
+                             BufferManager *buffer_mgr,
+                             const ColumnID column_id,
+                             const BlockIndex *block_index,
+                             const char *query_tensor_ptr,
+                             const u32 query_embedding_num,
+                             const u32 basic_embedding_dimension) {
+    Batch batch(query_tensor_ptr, query_embedding_num, basic_embedding_dimension);
+    Vector<float> batch_scores;
+    SizeT batch_start = 0;
+    auto score_batch = [&](const SizeT batch_end) {
+        batch_scores.assign(batch_end - batch_start, std::numeric_limits<float>::lowest());
+        batch.Score(batch_scores.data());
+        for (SizeT k = batch_start; k < batch_end; ++k) {
+            rerank_docs[k].score_ = batch_scores[k - batch_start];
+        }
+        batch.Clear();
+        batch_start = batch_end;
+    };
+    for (SizeT doc_i = 0; doc_i < rerank_docs.size(); ++doc_i) {
+        const RowID row_id = rerank_docs[doc_i].row_id_;
+        const SegmentID segment_id = row_id.segment_id_;
+        const SegmentOffset segment_offset = row_id.segment_offset_;
+        const BlockID block_id = segment_offset / DEFAULT_BLOCK_CAPACITY;
+        const BlockOffset block_offset = segment_offset % DEFAULT_BLOCK_CAPACITY;
+        BlockEntry *block_entry = block_index->segment_block_index_.at(segment_id).block_map_.at(block_id);
+        auto column_vec = block_entry->GetConstColumnVector(buffer_mgr, column_id);
+        CalcutateScoreOfRowOp::AddToBatch(column_vec, block_offset, batch, doc_i - batch_start);
+        if (batch.embedding_num() >= kMaxSimBatchEmbeddingNum) {
+            score_batch(doc_i + 1);
+        }
+    }
+    if (batch_start < rerank_docs.size()) {
+        score_batch(rerank_docs.size());
+    }
+}
+
 template <template <typename> typename CalcutateScoreOfRow, typename ColumnElemT, typename QueryElemT>
 void RerankerScoreT(RerankerParameterPack &parameter_pack) {
     const char *query_tensor_ptr = parameter_pack.match_tensor_expr_.query_embedding_.ptr;
@@ -979,6 +1072,16 @@ void RerankerScoreT(RerankerParameterPack &parameter_pack) {
     const u32 basic_embedding_dimension = parameter_pack.match_tensor_expr_.tensor_basic_embedding_dimension_;
     switch (parameter_pack.match_tensor_expr_.search_method_) {
         case MatchTensorSearchMethod::kMaxSim: {
+            if constexpr (MaxSimBatch<ColumnElemT, QueryElemT>::kBatched) {
+                return GetBatchedRerankerScore<CalcutateScoreOfRow<MaxSimOp<ColumnElemT, QueryElemT>>, MaxSimBatch<ColumnElemT, QueryElemT>>(
+                    parameter_pack.rerank_docs_,
+                    parameter_pack.buffer_mgr_,
+                    parameter_pack.column_id_,
+                    parameter_pack.block_index_,
+                    query_tensor_ptr,
+                    query_embedding_num,
+                    basic_embedding_dimension);
+            }
             return GetRerankerScore<CalcutateScoreOfRow<MaxSimOp<ColumnElemT, QueryElemT>>>(parameter_pack.rerank_docs_,
                                                                                             parameter_pack.buffer_mgr_,
                                                                                             parameter_pack.column_id_,
@@ -14,43 +14,96 @@
 
 module;
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <xmmintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+#include <simde/x86/sse.h>
+#endif
+
 export module knn_filter;
 
 import stl;
-import hnsw_common;
 import roaring_bitmap;
 
 import segment_entry;
 
 namespace infinity {
 
+// The visible and selected rows of a segment snapshot, flattened from `Bitmask` once so that a check is a single load.
 export template <typename LabelType>
-class BitmaskFilter final : public FilterBase<LabelType> {
+class BitmaskFilter {
 public:
-    explicit BitmaskFilter(const Bitmask &bitmask) : bitmask_(bitmask) {}
+    explicit BitmaskFilter(const Bitmask &bitmask) : count_(bitmask.count()), words_((count_ + 63) / 64, 0) {
+        if (bitmask.IsAllTrue()) {
+            std::fill(words_.begin(), words_.end(), ~u64(0));
+            return;
+        }
+        bitmask.RoaringBitmapApplyFunc([&](u32 row_index) {
+            words_[row_index >> 6] |= u64(1) << (row_index & 63);
+            return true;
+        });
+    }
+
+    // no row is selected until `SetRange` or `Set`, used for a label space made of several segments
+    explicit BitmaskFilter(SizeT count) : count_(count), words_((count_ + 63) / 64, 0) {}
+
+    void SetRange(SizeT begin, SizeT end) {
+        for (; begin < end && (begin & 63) != 0; ++begin) {
+            words_[begin >> 6] |= u64(1) << (begin & 63);
+        }
+        for (; begin + 64 <= end; begin += 64) {
+            words_[begin >> 6] = ~u64(0);
+        }
+        for (; begin < end; ++begin) {
+            words_[begin >> 6] |= u64(1) << (begin & 63);
+        }
+    }
+
+    // selects the rows of `bitmask` shifted by `offset`
+    void Set(const Bitmask &bitmask, SizeT offset) {
+        if (bitmask.IsAllTrue()) {
+            SetRange(offset, offset + bitmask.count());
+            return;
+        }
+        bitmask.RoaringBitmapApplyFunc([&](u32 row_index) {
+            SizeT label = offset + row_index;
+            words_[label >> 6] |= u64(1) << (label & 63);
+            return true;
+        });
+    }
+
+    bool operator()(const LabelType &label) const { return label < count_ && ((words_[label >> 6] >> (label & 63)) & 1); }
+
+    void Prefetch(const LabelType &label) const {
+        if (label < count_) {
+            _mm_prefetch(reinterpret_cast<const char *>(words_.data() + (label >> 6)), _MM_HINT_T0);
+        }
+    }
 
-    bool operator()(const LabelType &label) const final { return bitmask_.IsTrue(label); }
+    SizeT count() const { return count_; }
+    const u64 *words() const { return words_.data(); }
 
 private:
-    const Bitmask &bitmask_;
+    SizeT count_ = 0;
+    Vector<u64> words_;
 };
 
-export class AppendFilter final : public FilterBase<SegmentOffset> {
+export class AppendFilter {
 public:
     AppendFilter(SegmentOffset max_segment_offset) : max_segment_offset_(max_segment_offset) {}
 
-    bool operator()(const SegmentOffset &segment_offset) const final { return segment_offset < max_segment_offset_; }
+    bool operator()(const SegmentOffset &segment_offset) const { return segment_offset < max_segment_offset_; }
 
 private:
     const SegmentOffset max_segment_offset_;
 };
 
-export class DeleteFilter final : public FilterBase<SegmentOffset> {
+export class DeleteFilter {
 public:
     explicit DeleteFilter(const SegmentEntry *segment, TxnTimeStamp query_ts, SegmentOffset max_segment_offset)
         : segment_(segment), query_ts_(query_ts), max_segment_offset_(max_segment_offset) {}
 
-    bool operator()(const SegmentOffset &segment_offset) const final {
+    bool operator()(const SegmentOffset &segment_offset) const {
         bool check_append = max_segment_offset_ == 0;
         return segment_offset <= max_segment_offset_ && segment_->CheckRowVisible(segment_offset, query_ts_, check_append);
     }
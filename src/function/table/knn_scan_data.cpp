@@ -41,14 +41,20 @@ void KnnDistance1<f32, f32>::InitKnnDistance1(KnnDistanceType dist_type) {
     switch (dist_type) {
         case KnnDistanceType::kL2: {
             dist_func_ = GetSIMD_FUNCTIONS().L2Distance_func_ptr_;
+            f16_dist_func_ = GetSIMD_FUNCTIONS().F32F16L2Distance_func_ptr_;
+            bf16_dist_func_ = GetSIMD_FUNCTIONS().F32BF16L2Distance_func_ptr_;
             break;
         }
         case KnnDistanceType::kCosine: {
             dist_func_ = GetSIMD_FUNCTIONS().CosineDistance_func_ptr_;
+            f16_dist_func_ = GetSIMD_FUNCTIONS().F32F16CosineDistance_func_ptr_;
+            bf16_dist_func_ = GetSIMD_FUNCTIONS().F32BF16CosineDistance_func_ptr_;
             break;
         }
         case KnnDistanceType::kInnerProduct: {
             dist_func_ = GetSIMD_FUNCTIONS().IPDistance_func_ptr_;
+            f16_dist_func_ = GetSIMD_FUNCTIONS().F32F16IPDistance_func_ptr_;
+            bf16_dist_func_ = GetSIMD_FUNCTIONS().F32BF16IPDistance_func_ptr_;
             break;
         }
         default: {
@@ -191,6 +197,7 @@ void KnnScanFunctionData::Init() {
             auto merge_knn_max = MakeUnique<MergeKnn<QueryDataType, CompareMax, DistDataType>>(knn_scan_shared_data_->query_count_,
                                                                                                knn_scan_shared_data_->topk_,
                                                                                                knn_threshold);
+            merge_knn_max->SetSharedBound(&knn_scan_shared_data_->shared_bound_);
             merge_knn_max->Begin();
             merge_knn_base_ = std::move(merge_knn_max);
             break;
@@ -201,6 +208,7 @@ void KnnScanFunctionData::Init() {
             auto merge_knn_min = MakeUnique<MergeKnn<QueryDataType, CompareMin, DistDataType>>(knn_scan_shared_data_->query_count_,
                                                                                                knn_scan_shared_data_->topk_,
                                                                                                knn_threshold);
+            merge_knn_min->SetSharedBound(&knn_scan_shared_data_->shared_bound_);
             merge_knn_min->Begin();
             merge_knn_base_ = std::move(merge_knn_min);
             break;
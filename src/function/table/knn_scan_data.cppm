@@ -36,6 +36,8 @@ import internal_types;
 
 namespace infinity {
 
+class HnswSegmentGroup;
+
 export class KnnScanSharedData {
 public:
     KnnScanSharedData(SharedPtr<BaseTableRef> table_ref,
@@ -50,13 +52,16 @@ public:
                       KnnDistanceType knn_distance_type)
         : table_ref_(table_ref), block_column_entries_(std::move(block_column_entries)), index_entries_(std::move(index_entries)),
           opt_params_(std::move(opt_params)), topk_(topk), dimension_(dimension), query_count_(query_embedding_count),
-          query_embedding_(query_embedding), query_elem_type_(elem_type), knn_distance_type_(knn_distance_type) {}
+          query_embedding_(query_embedding), query_elem_type_(elem_type), knn_distance_type_(knn_distance_type),
+          shared_bound_(query_embedding_count) {}
 
 public:
     const SharedPtr<BaseTableRef> table_ref_{};
 
     const UniquePtr<Vector<BlockColumnEntry *>> block_column_entries_{};
     const UniquePtr<Vector<SegmentIndexEntry *>> index_entries_{};
+    // searched as one more index task, its segments are not in the other tasks
+    SharedPtr<HnswSegmentGroup> hnsw_segment_group_{};
 
     const Vector<InitParameter> opt_params_{};
     const i64 topk_;
@@ -68,6 +73,9 @@ public:
 
     atomic_u64 current_block_idx_{0};
     atomic_u64 current_index_idx_{0};
+
+    // the k-th distances of the tasks, the blocks and indexes searched later skip the results worse than them
+    KnnSharedBound shared_bound_;
 };
 
 //-------------------------------------------------------------------
@@ -106,8 +114,12 @@ public:
 
 public:
     using DistFunc = DistType (*)(const QueryDataType *, const QueryDataType *, SizeT);
+    // fp16 / bf16 data are passed as their raw u16 bits, only set for f32 query
+    using HalfDistFunc = DistType (*)(const QueryDataType *, const u16 *, SizeT);
 
     DistFunc dist_func_{};
+    HalfDistFunc f16_dist_func_{};
+    HalfDistFunc bf16_dist_func_{};
 };
 
 template <>
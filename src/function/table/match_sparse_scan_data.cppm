@@ -60,11 +60,29 @@ public:
         return dist_func_(data, index, nnz, data2, index2, nnz2);
     }
 
+    // the documents of a block scan are scored against one query with a dense copy of it
+    void BeginQuery(const SparseVecRef<DataType, IndexType> &query) {
+        query_ = query;
+        use_dense_query_ = dense_query_.Init(query.data_, query.indices_, query.nnz_);
+    }
+
+    ResultType CalculateQuery(const SparseVecRef<DataType, IndexType> &vec) {
+        if (use_dense_query_) {
+            return dense_query_.IP(vec.data_, vec.indices_, vec.nnz_);
+        }
+        return Calculate(query_, vec);
+    }
+
 public:
     using DistFunc =
         ResultType (*)(const DataType *data, const IndexType *index, SizeT nnz, const DataType *data2, const IndexType *index2, SizeT nnz2);
 
     DistFunc dist_func_{};
+
+private:
+    SparseVecRef<DataType, IndexType> query_{0, nullptr, nullptr};
+    SparseDenseQuery<DataType, IndexType, ResultType> dense_query_;
+    bool use_dense_query_ = false;
 };
 
 export template <typename IndexType, typename ResultType = IndexType>
@@ -91,10 +109,17 @@ public:
 
     ResultType Calculate(const IndexType *index1, SizeT nnz1, const IndexType *index2, SizeT nnz2) { return dist_func_(index1, nnz1, index2, nnz2); }
 
+    void BeginQuery(const SparseVecRef<DataT, IndexType> &query) { query_ = query; }
+
+    ResultType CalculateQuery(const SparseVecRef<DataT, IndexType> &vec) { return Calculate(query_, vec); }
+
 public:
     using DistFunc = ResultType (*)(const IndexType *raw1, SizeT nnz1, const IndexType *raw2, SizeT nnz2);
 
     DistFunc dist_func_{};
+
+private:
+    SparseVecRef<DataT, IndexType> query_{0, nullptr, nullptr};
 };
 
 export class MatchSparseScanFunctionData : public TableFunctionData {
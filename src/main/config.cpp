@@ -454,6 +454,33 @@ Status Config::Init(const SharedPtr<String> &config_path, DefaultConfig *default
             UnrecoverableError(status.message());
         }
 
+        // Lock hnsw upper layers
+        bool lock_hnsw_upper_layers = DEFAULT_LOCK_HNSW_UPPER_LAYERS;
+        auto lock_hnsw_upper_layers_option = MakeUnique<BooleanOption>(LOCK_HNSW_UPPER_LAYERS_OPTION_NAME, lock_hnsw_upper_layers);
+        status = global_options_.AddOption(std::move(lock_hnsw_upper_layers_option));
+        if (!status.ok()) {
+            fmt::print("Fatal: {}", status.message());
+            UnrecoverableError(status.message());
+        }
+
+        // Hnsw build thread num
+        i64 hnsw_build_thread_num = DEFAULT_HNSW_BUILD_THREAD_NUM;
+        auto hnsw_build_thread_num_option = MakeUnique<IntegerOption>(HNSW_BUILD_THREAD_NUM_OPTION_NAME, hnsw_build_thread_num, 16384, 0);
+        status = global_options_.AddOption(std::move(hnsw_build_thread_num_option));
+        if (!status.ok()) {
+            fmt::print("Fatal: {}", status.message());
+            UnrecoverableError(status.message());
+        }
+
+        // Hnsw segment group
+        bool hnsw_segment_group = DEFAULT_HNSW_SEGMENT_GROUP;
+        auto hnsw_segment_group_option = MakeUnique<BooleanOption>(HNSW_SEGMENT_GROUP_OPTION_NAME, hnsw_segment_group);
+        status = global_options_.AddOption(std::move(hnsw_segment_group_option));
+        if (!status.ok()) {
+            fmt::print("Fatal: {}", status.message());
+            UnrecoverableError(status.message());
+        }
+
         // Temp Dir
         String temp_dir = "/var/infinity/tmp";
         if (default_config != nullptr) {
@@ -1735,6 +1762,43 @@ Status Config::Init(const SharedPtr<String> &config_path, DefaultConfig *default
                             global_options_.AddOption(std::move(cache_result_num_option));
                             break;
                         }
+                        case GlobalOptionIndex::kLockHnswUpperLayers: {
+                            bool lock_hnsw_upper_layers = DEFAULT_LOCK_HNSW_UPPER_LAYERS;
+                            if (elem.second.is_boolean()) {
+                                lock_hnsw_upper_layers = elem.second.value_or(lock_hnsw_upper_layers);
+                            } else {
+                                return Status::InvalidConfig("'lock_hnsw_upper_layers' field isn't boolean.");
+                            }
+                            auto lock_hnsw_upper_layers_option = MakeUnique<BooleanOption>(LOCK_HNSW_UPPER_LAYERS_OPTION_NAME, lock_hnsw_upper_layers);
+                            global_options_.AddOption(std::move(lock_hnsw_upper_layers_option));
+                            break;
+                        }
+                        case GlobalOptionIndex::kHnswBuildThreadNum: {
+                            i64 hnsw_build_thread_num = DEFAULT_HNSW_BUILD_THREAD_NUM;
+                            if (elem.second.is_integer()) {
+                                hnsw_build_thread_num = elem.second.value_or(hnsw_build_thread_num);
+                            } else {
+                                return Status::InvalidConfig("'hnsw_build_thread_num' field isn't integer.");
+                            }
+                            auto hnsw_build_thread_num_option =
+                                MakeUnique<IntegerOption>(HNSW_BUILD_THREAD_NUM_OPTION_NAME, hnsw_build_thread_num, 16384, 0);
+                            if (!hnsw_build_thread_num_option->Validate()) {
+                                return Status::InvalidConfig(fmt::format("Invalid hnsw build thread num: {}", hnsw_build_thread_num));
+                            }
+                            global_options_.AddOption(std::move(hnsw_build_thread_num_option));
+                            break;
+                        }
+                        case GlobalOptionIndex::kHnswSegmentGroup: {
+                            bool hnsw_segment_group = DEFAULT_HNSW_SEGMENT_GROUP;
+                            if (elem.second.is_boolean()) {
+                                hnsw_segment_group = elem.second.value_or(hnsw_segment_group);
+                            } else {
+                                return Status::InvalidConfig("'hnsw_segment_group' field isn't boolean.");
+                            }
+                            auto hnsw_segment_group_option = MakeUnique<BooleanOption>(HNSW_SEGMENT_GROUP_OPTION_NAME, hnsw_segment_group);
+                            global_options_.AddOption(std::move(hnsw_segment_group_option));
+                            break;
+                        }
                         default: {
                             return Status::InvalidConfig(fmt::format("Unrecognized config parameter: {} in 'buffer' field", var_name));
                         }
@@ -1800,6 +1864,35 @@ Status Config::Init(const SharedPtr<String> &config_path, DefaultConfig *default
                     }
                 }
 
+                if (global_options_.GetOptionByIndex(GlobalOptionIndex::kLockHnswUpperLayers) == nullptr) {
+                    bool lock_hnsw_upper_layers = DEFAULT_LOCK_HNSW_UPPER_LAYERS;
+                    UniquePtr<BooleanOption> lock_hnsw_upper_layers_option =
+                        MakeUnique<BooleanOption>(LOCK_HNSW_UPPER_LAYERS_OPTION_NAME, lock_hnsw_upper_layers);
+                    Status status = global_options_.AddOption(std::move(lock_hnsw_upper_layers_option));
+                    if (!status.ok()) {
+                        UnrecoverableError(status.message());
+                    }
+                }
+
+                if (global_options_.GetOptionByIndex(GlobalOptionIndex::kHnswBuildThreadNum) == nullptr) {
+                    i64 hnsw_build_thread_num = DEFAULT_HNSW_BUILD_THREAD_NUM;
+                    UniquePtr<IntegerOption> hnsw_build_thread_num_option =
+                        MakeUnique<IntegerOption>(HNSW_BUILD_THREAD_NUM_OPTION_NAME, hnsw_build_thread_num, 16384, 0);
+                    Status status = global_options_.AddOption(std::move(hnsw_build_thread_num_option));
+                    if (!status.ok()) {
+                        UnrecoverableError(status.message());
+                    }
+                }
+
+                if (global_options_.GetOptionByIndex(GlobalOptionIndex::kHnswSegmentGroup) == nullptr) {
+                    bool hnsw_segment_group = DEFAULT_HNSW_SEGMENT_GROUP;
+                    UniquePtr<BooleanOption> hnsw_segment_group_option = MakeUnique<BooleanOption>(HNSW_SEGMENT_GROUP_OPTION_NAME, hnsw_segment_group);
+                    Status status = global_options_.AddOption(std::move(hnsw_segment_group_option));
+                    if (!status.ok()) {
+                        UnrecoverableError(status.message());
+                    }
+                }
+
             } else {
                 return Status::InvalidConfig("No 'buffer' section in configure file.");
             }
@@ -2402,6 +2495,21 @@ void Config::SetCacheResult(const String &mode) {
     result_cache_option->value_ = mode;
 }
 
+bool Config::LockHnswUpperLayers() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return global_options_.GetBoolValue(GlobalOptionIndex::kLockHnswUpperLayers);
+}
+
+i64 Config::HnswBuildThreadNum() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return global_options_.GetIntegerValue(GlobalOptionIndex::kHnswBuildThreadNum);
+}
+
+bool Config::HnswSegmentGroup() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return global_options_.GetBoolValue(GlobalOptionIndex::kHnswSegmentGroup);
+}
+
 // WAL
 String Config::WALDir() {
     std::lock_guard<std::mutex> guard(mutex_);
@@ -2538,6 +2646,9 @@ void Config::PrintAll() {
     fmt::print(" - buffer_manager_size: {}\n", Utility::FormatByteSize(BufferManagerSize()));
     fmt::print(" - temp_dir: {}\n", TempDir());
     fmt::print(" - memindex_memory_quota: {}\n", Utility::FormatByteSize(MemIndexMemoryQuota()));
+    fmt::print(" - lock_hnsw_upper_layers: {}\n", LockHnswUpperLayers());
+    fmt::print(" - hnsw_build_thread_num: {}\n", HnswBuildThreadNum());
+    fmt::print(" - hnsw_segment_group: {}\n", HnswSegmentGroup());
 
     // WAL
     fmt::print(" - wal_dir: {}\n", WALDir());
@@ -119,6 +119,10 @@ public:
     i64 CacheResultNum();
     void SetCacheResult(const String &mode);
 
+    bool LockHnswUpperLayers();
+    i64 HnswBuildThreadNum();
+    bool HnswSegmentGroup();
+
     // WAL
     String WALDir();
 
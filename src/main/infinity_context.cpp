@@ -491,7 +491,13 @@ void InfinityContext::SetIndexThreadPool(SizeT thread_num) {
     LOG_TRACE(fmt::format("Set index thread pool size to {}", thread_num));
     inverting_thread_pool_.resize(thread_num);
     commiting_thread_pool_.resize(thread_num);
-    hnsw_build_thread_pool_.resize(thread_num);
+    SizeT hnsw_build_thread_num = thread_num;
+    if (config_ != nullptr && config_->HnswBuildThreadNum() > 0) {
+        hnsw_build_thread_num = config_->HnswBuildThreadNum();
+    }
+    LOG_TRACE(fmt::format("Set hnsw build thread pool size to {}", hnsw_build_thread_num));
+    hnsw_build_thread_pool_.resize(hnsw_build_thread_num);
+    knn_search_thread_pool_.resize(thread_num);
 }
 
 void InfinityContext::RestoreIndexThreadPoolToDefault() {
@@ -499,6 +505,7 @@ void InfinityContext::RestoreIndexThreadPoolToDefault() {
     inverting_thread_pool_.resize(4);
     commiting_thread_pool_.resize(2);
     hnsw_build_thread_pool_.resize(4);
+    knn_search_thread_pool_.resize(4);
 }
 
 void InfinityContext::AddThriftServerFn(std::function<void()> start_func, std::function<void()> stop_func) {
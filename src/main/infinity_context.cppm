@@ -51,6 +51,7 @@ public:
     [[nodiscard]] inline ThreadPool &GetFulltextInvertingThreadPool() { return inverting_thread_pool_; }
     [[nodiscard]] inline ThreadPool &GetFulltextCommitingThreadPool() { return commiting_thread_pool_; }
     [[nodiscard]] inline ThreadPool &GetHnswBuildThreadPool() { return hnsw_build_thread_pool_; }
+    [[nodiscard]] inline ThreadPool &GetKnnSearchThreadPool() { return knn_search_thread_pool_; }
 
     NodeRole GetServerRole() const;
 
@@ -96,6 +97,9 @@ private:
     // For hnsw index
     ThreadPool hnsw_build_thread_pool_{4};
 
+    // For the parts of one ivf query searched in parallel
+    ThreadPool knn_search_thread_pool_{4};
+
     mutable std::mutex mutex_;
 
     std::function<void()> start_servers_func_{};
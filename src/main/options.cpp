@@ -74,6 +74,9 @@ GlobalOptions::GlobalOptions() {
 
     name2index_[String(RESULT_CACHE_OPTION_NAME)] = GlobalOptionIndex::kResultCache;
     name2index_[String(CACHE_RESULT_CAPACITY_OPTION_NAME)] = GlobalOptionIndex::kCacheResultCapacity;
+    name2index_[String(LOCK_HNSW_UPPER_LAYERS_OPTION_NAME)] = GlobalOptionIndex::kLockHnswUpperLayers;
+    name2index_[String(HNSW_BUILD_THREAD_NUM_OPTION_NAME)] = GlobalOptionIndex::kHnswBuildThreadNum;
+    name2index_[String(HNSW_SEGMENT_GROUP_OPTION_NAME)] = GlobalOptionIndex::kHnswSegmentGroup;
 
     name2index_[String(WAL_DIR_OPTION_NAME)] = GlobalOptionIndex::kWALDir;
     name2index_[String(WAL_COMPACT_THRESHOLD_OPTION_NAME)] = GlobalOptionIndex::kWALCompactThreshold;
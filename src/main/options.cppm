@@ -160,8 +160,11 @@ export enum class GlobalOptionIndex : i8 {
     kObjectStorageAccessKey = 44,
     kObjectStorageSecretKey = 45,
     kObjectStorageHttps = 46,
+    kLockHnswUpperLayers = 47,
+    kHnswBuildThreadNum = 48,
+    kHnswSegmentGroup = 49,
 
-    kInvalid = 47,
+    kInvalid = 50,
 };
 
 export struct GlobalOptions {
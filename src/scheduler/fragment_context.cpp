@@ -708,6 +708,7 @@ SizeT InitKnnScanFragmentContext(PhysicalKnnScan *knn_scan_operator, FragmentCon
                                               knn_scan_operator->real_knn_query_embedding_ptr_,
                                               knn_scan_operator->real_knn_query_elem_type_,
                                               knn_expr->distance_type_);
+            serial_materialize_fragment_ctx->knn_scan_shared_data_->hnsw_segment_group_ = std::move(knn_scan_operator->hnsw_segment_group_);
             break;
         }
         case FragmentType::kParallelMaterialize: {
@@ -723,6 +724,7 @@ SizeT InitKnnScanFragmentContext(PhysicalKnnScan *knn_scan_operator, FragmentCon
                                               knn_scan_operator->real_knn_query_embedding_ptr_,
                                               knn_scan_operator->real_knn_query_elem_type_,
                                               knn_expr->distance_type_);
+            parallel_materialize_fragment_ctx->knn_scan_shared_data_->hnsw_segment_group_ = std::move(knn_scan_operator->hnsw_segment_group_);
             break;
         }
         default: {
@@ -0,0 +1,92 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+module diskann_index_file_worker;
+
+import stl;
+import index_file_worker;
+import file_worker;
+import index_base;
+import index_diskann;
+import diskann_index_in_chunk;
+import infinity_exception;
+import logical_type;
+import embedding_info;
+import internal_types;
+import column_def;
+import file_worker_type;
+import utility;
+import third_party;
+
+namespace infinity {
+
+DiskAnnIndexFileWorker::~DiskAnnIndexFileWorker() {
+    if (data_ != nullptr) {
+        FreeInMemory();
+        data_ = nullptr;
+    }
+}
+
+void DiskAnnIndexFileWorker::AllocateInMemory() {
+    if (data_) {
+        const auto error_message = "Data is already allocated.";
+        UnrecoverableError(error_message);
+    }
+    if (index_base_->index_type_ != IndexType::kDiskAnn) {
+        const auto error_message = "Index type is mismatched";
+        UnrecoverableError(error_message);
+    }
+    if (column_def_->type()->type() != LogicalType::kEmbedding || GetEmbeddingInfo()->Type() != EmbeddingDataType::kElemFloat) {
+        const auto error_message = "DiskAnn Index should be created on Float Embedding column now.";
+        UnrecoverableError(error_message);
+    }
+    const auto *index_diskann = static_cast<const IndexDiskAnn *>(index_base_.get());
+    data_ = static_cast<void *>(new DiskAnnIndexInChunk(start_segment_offset_, index_diskann, GetEmbeddingInfo()->Dimension(), WorkDir()));
+}
+
+void DiskAnnIndexFileWorker::FreeInMemory() {
+    if (!data_) {
+        String error_message = "Data is not allocated.";
+        UnrecoverableError(error_message);
+    }
+    auto index = static_cast<DiskAnnIndexInChunk *>(data_);
+    delete index;
+    data_ = nullptr;
+}
+
+bool DiskAnnIndexFileWorker::WriteToFileImpl(bool to_spill, bool &prepare_success, const FileWorkerSaveCtx &ctx) {
+    auto *index = static_cast<DiskAnnIndexInChunk *>(data_);
+    index->SaveIndexInner(*file_handle_);
+    prepare_success = true;
+    return true;
+}
+
+void DiskAnnIndexFileWorker::ReadFromFileImpl(SizeT file_size) {
+    if (data_) {
+        const auto error_message = "Data is already allocated.";
+        UnrecoverableError(error_message);
+    }
+    const auto *index_diskann = static_cast<const IndexDiskAnn *>(index_base_.get());
+    auto *index = new DiskAnnIndexInChunk(start_segment_offset_, index_diskann, GetEmbeddingInfo()->Dimension(), WorkDir());
+    data_ = static_cast<void *>(index);
+    index->ReadIndexInner(*file_handle_);
+}
+
+const EmbeddingInfo *DiskAnnIndexFileWorker::GetEmbeddingInfo() const { return static_cast<EmbeddingInfo *>(column_def_->type()->type_info().get()); }
+
+String DiskAnnIndexFileWorker::WorkDir() const { return Path(*temp_dir_) / "diskann" / StringTransform(GetFilePath(), "/", "_"); }
+
+} // namespace infinity
@@ -34,6 +34,7 @@ export enum class FileWorkerType {
     kIndexFile,
     kEMVBIndexFile,
     kBMPIndexFile,
+    kDiskAnnIndexFile,
     kInvalid,
 };
 
@@ -72,6 +73,9 @@ export String FileWorkerType2Str(FileWorkerType type) {
         case FileWorkerType::kBMPIndexFile: {
             return "BMP index";
         }
+        case FileWorkerType::kDiskAnnIndexFile: {
+            return "DiskAnn index";
+        }
         case FileWorkerType::kInvalid: {
             String error_message = "Invalid file worker type";
             UnrecoverableError(error_message);
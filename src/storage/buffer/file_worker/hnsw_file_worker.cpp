@@ -36,6 +36,8 @@ import abstract_hnsw;
 import virtual_store;
 import persistence_manager;
 import local_file_handle;
+import infinity_context;
+import config;
 
 namespace infinity {
 
@@ -99,6 +101,15 @@ void HnswFileWorker::FreeInMemory() {
         *p);
     delete p;
     data_ = nullptr;
+    ReleaseFileMemory();
+}
+
+void HnswFileWorker::ReleaseFileMemory() {
+    if (!mmap_path_.empty()) {
+        VirtualStore::MunmapFile(mmap_path_);
+        mmap_path_.clear();
+    }
+    file_buffer_.reset();
 }
 
 bool HnswFileWorker::WriteToFileImpl(bool to_spill, bool &prepare_success, const FileWorkerSaveCtx &ctx) {
@@ -113,10 +124,13 @@ bool HnswFileWorker::WriteToFileImpl(bool to_spill, bool &prepare_success, const
             if constexpr (std::is_same_v<T, std::nullptr_t>) {
                 UnrecoverableError("Invalid index type.");
             } else {
-                index->Save(*file_handle_);
+                // the file may be overwritten in place, so the index must not be a view of it
+                index->Materialize();
+                index->SaveToPtr(*file_handle_);
             }
         },
         *hnsw_index);
+    ReleaseFileMemory();
     prepare_success = true;
     return true;
 }
@@ -125,6 +139,21 @@ void HnswFileWorker::ReadFromFileImpl(SizeT file_size) {
     if (data_ != nullptr) {
         UnrecoverableError("Data is already allocated.");
     }
+    const char *file_ptr = nullptr;
+    if (file_size >= sizeof(kHnswFileMagic)) {
+        i64 offset = file_handle_->Tell();
+        u64 magic = 0;
+        file_handle_->Read(&magic, sizeof(magic));
+        file_handle_->Seek(offset);
+        if (magic == kHnswFileMagic) {
+            file_ptr = MapFile(offset, file_size);
+        }
+    }
+    bool lock_upper_layers = false;
+    if (Config *config = InfinityContext::instance().config(); config != nullptr) {
+        lock_upper_layers = config->LockHnswUpperLayers();
+    }
+
     data_ = static_cast<void *>(new AbstractHnsw(HnswIndexInMem::InitAbstractIndex(index_base_.get(), column_def_.get())));
     auto *hnsw_index = reinterpret_cast<AbstractHnsw *>(data_);
     std::visit(
@@ -134,10 +163,42 @@ void HnswFileWorker::ReadFromFileImpl(SizeT file_size) {
                 UnrecoverableError("Invalid index type.");
             } else {
                 using IndexT = std::decay_t<decltype(*index)>;
-                index = IndexT::Load(*file_handle_).release();
+                if (file_ptr != nullptr) {
+                    index = IndexT::LoadFromPtr(file_ptr, file_size, lock_upper_layers).release();
+                } else {
+                    // file saved before the mappable layout
+                    index = IndexT::Load(*file_handle_).release();
+                }
             }
         },
         *hnsw_index);
 }
 
+const char *HnswFileWorker::MapFile(i64 offset, SizeT file_size) {
+    String path = file_handle_->Path();
+    if (Path(path).is_absolute()) {
+        u8 *data_ptr = nullptr;
+        SizeT data_len = 0;
+        if (VirtualStore::MmapFile(path, data_ptr, data_len) == 0) {
+            const char *ptr = reinterpret_cast<const char *>(data_ptr) + offset;
+            // an index packed in an object file may be placed at an unaligned offset
+            if (offset + file_size <= data_len && reinterpret_cast<SizeT>(ptr) % kHnswFileAlign == 0) {
+                mmap_path_ = std::move(path);
+                return ptr;
+            }
+            VirtualStore::MunmapFile(path);
+        }
+    }
+    file_buffer_ = MakeUniqueForOverwrite<char[]>(file_size + kHnswFileAlign);
+    char *ptr = file_buffer_.get() + (kHnswFileAlign - reinterpret_cast<SizeT>(file_buffer_.get()) % kHnswFileAlign) % kHnswFileAlign;
+    auto [read_n, status] = file_handle_->Read(ptr, file_size);
+    if (!status.ok()) {
+        UnrecoverableError(status.message());
+    }
+    if (read_n != file_size) {
+        UnrecoverableError(fmt::format("Read hnsw file {} failed, expect {} bytes, read {} bytes.", file_handle_->Path(), file_size, read_n));
+    }
+    return ptr;
+}
+
 } // namespace infinity
\ No newline at end of file
@@ -56,8 +56,18 @@ protected:
 
     void ReadFromFileImpl(SizeT file_size) override;
 
+private:
+    // memory of the hnsw file at `offset` of the opened file, aligned to `kHnswFileAlign`
+    const char *MapFile(i64 offset, SizeT file_size);
+
+    void ReleaseFileMemory();
+
 private:
     SizeT index_size_{};
+
+    // memory of the file which the loaded index is a view of
+    String mmap_path_{};
+    UniquePtr<char[]> file_buffer_{};
 };
 
 } // namespace infinity
\ No newline at end of file
@@ -190,6 +190,20 @@ struct RoaringBitmap {
         return roaring_.cardinality();
     }
 
+    // the number of true in [start, end)
+    [[nodiscard]] inline u32 CountTrue(const u32 start, u32 end) const {
+        end = std::min(end, count_);
+        if (start >= end) {
+            return 0;
+        }
+        if constexpr (init_all_true) {
+            if (all_true_flag_.value) {
+                return end - start;
+            }
+        }
+        return roaring_.rank(end - 1) - (start > 0 ? roaring_.rank(start - 1) : 0);
+    }
+
     [[nodiscard]] inline u32 CountFalse() const {
         if constexpr (init_all_true) {
             if (all_true_flag_.value) {
@@ -51,6 +51,9 @@ String MetricTypeToString(MetricType metric_type) {
         case MetricType::kMetricL2: {
             return "l2";
         }
+        case MetricType::kMetricHamming: {
+            return "hamming";
+        }
         case MetricType::kInvalid: {
             return "Invalid";
         }
@@ -64,6 +67,8 @@ MetricType StringToMetricType(const String &str) {
         return MetricType::kMetricInnerProduct;
     } else if (str == "l2") {
         return MetricType::kMetricL2;
+    } else if (str == "hamming") {
+        return MetricType::kMetricHamming;
     } else {
         return MetricType::kInvalid;
     }
@@ -129,11 +134,29 @@ SharedPtr<IndexBase> IndexBase::ReadAdv(const char *&ptr, int32_t maxbytes) {
         }
         case IndexType::kHnsw: {
             MetricType metric_type = ReadBufAdv<MetricType>(ptr);
-            HnswEncodeType encode_type = ReadBufAdv<HnswEncodeType>(ptr);
+            i32 encode_type_value = static_cast<i32>(ReadBufAdv<HnswEncodeType>(ptr));
+            const bool has_optional_params = (encode_type_value & IndexHnsw::kOptionalParamsFlag) != 0;
+            HnswEncodeType encode_type = static_cast<HnswEncodeType>(encode_type_value & ~IndexHnsw::kOptionalParamsFlag);
             SizeT M = ReadBufAdv<SizeT>(ptr);
             SizeT ef_construction = ReadBufAdv<SizeT>(ptr);
             SizeT block_size = ReadBufAdv<SizeT>(ptr);
-            res = MakeShared<IndexHnsw>(index_name, index_comment, file_name, column_names, metric_type, encode_type, M, ef_construction, block_size);
+            SizeT pq_subspace_num = 0;
+            SizeT truncate_dim = 0;
+            if (has_optional_params) {
+                pq_subspace_num = ReadBufAdv<SizeT>(ptr);
+                truncate_dim = ReadBufAdv<SizeT>(ptr);
+            }
+            res = MakeShared<IndexHnsw>(index_name,
+                                        index_comment,
+                                        file_name,
+                                        column_names,
+                                        metric_type,
+                                        encode_type,
+                                        M,
+                                        ef_construction,
+                                        block_size,
+                                        pq_subspace_num,
+                                        truncate_dim);
             break;
         }
         case IndexType::kDiskAnn: {
@@ -240,6 +263,14 @@ SharedPtr<IndexBase> IndexBase::Deserialize(const nlohmann::json &index_def_json
             SizeT block_size = index_def_json["block_size"];
             MetricType metric_type = StringToMetricType(index_def_json["metric_type"]);
             HnswEncodeType encode_type = StringToHnswEncodeType(index_def_json["encode_type"]);
+            SizeT pq_subspace_num = 0;
+            if (index_def_json.contains("pq_subspace_num")) {
+                pq_subspace_num = index_def_json["pq_subspace_num"];
+            }
+            SizeT truncate_dim = 0;
+            if (index_def_json.contains("truncate_dim")) {
+                truncate_dim = index_def_json["truncate_dim"];
+            }
             res = MakeShared<IndexHnsw>(index_name,
                                         index_comment,
                                         file_name,
@@ -248,7 +279,9 @@ SharedPtr<IndexBase> IndexBase::Deserialize(const nlohmann::json &index_def_json
                                         encode_type,
                                         M,
                                         ef_construction,
-                                        block_size);
+                                        block_size,
+                                        pq_subspace_num,
+                                        truncate_dim);
             break;
         }
         case IndexType::kDiskAnn: {
@@ -28,6 +28,8 @@ export enum class MetricType {
     kMetricCosine,
     kMetricInnerProduct,
     kMetricL2,
+    // bit vectors only
+    kMetricHamming,
     kInvalid,
 };
 
@@ -42,6 +42,10 @@ HnswEncodeType StringToHnswEncodeType(const String &str) {
         return HnswEncodeType::kPlain;
     } else if (str == "lvq") {
         return HnswEncodeType::kLVQ;
+    } else if (str == "pq") {
+        return HnswEncodeType::kPQ;
+    } else if (str == "rabitq") {
+        return HnswEncodeType::kRaBitQ;
     } else {
         return HnswEncodeType::kInvalid;
     }
@@ -53,6 +57,10 @@ String HnswEncodeTypeToString(HnswEncodeType encode_type) {
             return "plain";
         case HnswEncodeType::kLVQ:
             return "lvq";
+        case HnswEncodeType::kPQ:
+            return "pq";
+        case HnswEncodeType::kRaBitQ:
+            return "rabitq";
         default:
             return "invalid";
     }
@@ -68,6 +76,8 @@ SharedPtr<IndexBase> IndexHnsw::Make(SharedPtr<String> index_name,
     SizeT block_size = HNSW_BLOCK_SIZE;
     MetricType metric_type = MetricType::kInvalid;
     HnswEncodeType encode_type = HnswEncodeType::kPlain;
+    SizeT pq_subspace_num = 0; // 0: the pq store picks the smallest subspace dimension of at least 4 which divides the dimension
+    SizeT truncate_dim = 0;
     for (const auto *param : index_param_list) {
         if (param->param_name_ == "m") {
             M = std::stoi(param->param_value_);
@@ -79,6 +89,10 @@ SharedPtr<IndexBase> IndexHnsw::Make(SharedPtr<String> index_name,
             encode_type = StringToHnswEncodeType(param->param_value_);
         } else if (param->param_name_ == "block_size") {
             block_size = std::stoi(param->param_value_);
+        } else if (param->param_name_ == "pq_subspace_num") {
+            pq_subspace_num = std::stoi(param->param_value_);
+        } else if (param->param_name_ == "truncate_dim") {
+            truncate_dim = std::stoi(param->param_value_);
         } else {
             Status status = Status::InvalidIndexParam(param->param_name_);
             RecoverableError(status);
@@ -95,6 +109,11 @@ SharedPtr<IndexBase> IndexHnsw::Make(SharedPtr<String> index_name,
         RecoverableError(status);
     }
 
+    if (pq_subspace_num != 0 && encode_type != HnswEncodeType::kPQ) {
+        Status status = Status::InvalidIndexParam("pq_subspace_num");
+        RecoverableError(status);
+    }
+
     return MakeShared<IndexHnsw>(index_name,
                                  index_comment,
                                  file_name,
@@ -103,7 +122,9 @@ SharedPtr<IndexBase> IndexHnsw::Make(SharedPtr<String> index_name,
                                  encode_type,
                                  M,
                                  ef_construction,
-                                 block_size);
+                                 block_size,
+                                 pq_subspace_num,
+                                 truncate_dim);
 }
 
 bool IndexHnsw::operator==(const IndexHnsw &other) const {
@@ -111,7 +132,8 @@ bool IndexHnsw::operator==(const IndexHnsw &other) const {
         return false;
     }
     return metric_type_ == other.metric_type_ && encode_type_ == other.encode_type_ && M_ == other.M_ && ef_construction_ == other.ef_construction_ &&
-           block_size_ == other.block_size_;
+           block_size_ == other.block_size_ && pq_subspace_num_ == other.pq_subspace_num_ &&
+           truncate_dim_ == other.truncate_dim_;
 }
 
 bool IndexHnsw::operator!=(const IndexHnsw &other) const { return !(*this == other); }
@@ -123,16 +145,29 @@ i32 IndexHnsw::GetSizeInBytes() const {
     size += sizeof(M_);
     size += sizeof(ef_construction_);
     size += sizeof(block_size_);
+    if (HasOptionalParams()) {
+        size += sizeof(pq_subspace_num_);
+        size += sizeof(truncate_dim_);
+    }
     return size;
 }
 
 void IndexHnsw::WriteAdv(char *&ptr) const {
     IndexBase::WriteAdv(ptr);
     WriteBufAdv(ptr, metric_type_);
-    WriteBufAdv(ptr, encode_type_);
+    const bool has_optional_params = HasOptionalParams();
+    i32 encode_type = static_cast<i32>(encode_type_);
+    if (has_optional_params) {
+        encode_type |= kOptionalParamsFlag;
+    }
+    WriteBufAdv(ptr, static_cast<HnswEncodeType>(encode_type));
     WriteBufAdv(ptr, M_);
     WriteBufAdv(ptr, ef_construction_);
     WriteBufAdv(ptr, block_size_);
+    if (has_optional_params) {
+        WriteBufAdv(ptr, pq_subspace_num_);
+        WriteBufAdv(ptr, truncate_dim_);
+    }
 }
 
 String IndexHnsw::ToString() const {
@@ -145,6 +180,12 @@ String IndexHnsw::BuildOtherParamsString() const {
     std::stringstream ss;
     ss << "metric = " << MetricTypeToString(metric_type_) << ", encode_type = " << HnswEncodeTypeToString(encode_type_) << ", M = " << M_
        << ", ef_construction = " << ef_construction_;
+    if (encode_type_ == HnswEncodeType::kPQ) {
+        ss << ", pq_subspace_num = " << pq_subspace_num_;
+    }
+    if (truncate_dim_ != 0) {
+        ss << ", truncate_dim = " << truncate_dim_;
+    }
     return ss.str();
 }
 
@@ -155,9 +196,18 @@ nlohmann::json IndexHnsw::Serialize() const {
     res["M"] = M_;
     res["ef_construction"] = ef_construction_;
     res["block_size"] = block_size_;
+    res["pq_subspace_num"] = pq_subspace_num_;
+    res["truncate_dim"] = truncate_dim_;
     return res;
 }
 
+SizeT IndexHnsw::IndexDimension(const EmbeddingInfo *embedding_info) const {
+    if (embedding_info->Type() == EmbeddingDataType::kElemBit) {
+        return embedding_info->Dimension() / 8;
+    }
+    return truncate_dim_ == 0 ? embedding_info->Dimension() : truncate_dim_;
+}
+
 void IndexHnsw::ValidateColumnDataType(const SharedPtr<BaseTableRef> &base_table_ref,
                                        const String &column_name,
                                        const Vector<InitParameter *> &index_param_list) {
@@ -180,6 +230,28 @@ void IndexHnsw::ValidateColumnDataType(const SharedPtr<BaseTableRef> &base_table
     }
     const auto embedding_info = dynamic_cast<const EmbeddingInfo *>(data_type_ptr->type_info().get());
     const EmbeddingDataType embedding_data_type = embedding_info->Type();
+    SizeT index_dim = embedding_info->Dimension();
+    MetricType metric_type = MetricType::kInvalid;
+    for (const auto *param : index_param_list) {
+        if (param->param_name_ == "metric") {
+            metric_type = StringToMetricType(param->param_value_);
+        }
+        if (param->param_name_ == "truncate_dim") {
+            // the prefix of a row is the truncated vector only if the rows are single vectors of whole elements
+            if (data_type_ptr->type() != LogicalType::kEmbedding || embedding_data_type == EmbeddingDataType::kElemBit) {
+                RecoverableError(Status::InvalidIndexDefinition(
+                    fmt::format("Attempt to create HNSW index with truncate_dim on column: {}, data type: {}. now only support non-bit embedding column.",
+                                column_name,
+                                data_type_ptr->ToString())));
+            }
+            const SizeT truncate_dim = std::stoi(param->param_value_);
+            if (truncate_dim == 0 || truncate_dim >= embedding_info->Dimension()) {
+                RecoverableError(Status::InvalidIndexDefinition(
+                    fmt::format("truncate_dim: {} should be less than the dimension of column: {}.", truncate_dim, column_name)));
+            }
+            index_dim = truncate_dim;
+        }
+    }
     for (const auto *param : index_param_list) {
         if (param->param_name_ == "encode" && StringToHnswEncodeType(param->param_value_) == HnswEncodeType::kLVQ) {
             // TODO: now only support float?
@@ -190,18 +262,58 @@ void IndexHnsw::ValidateColumnDataType(const SharedPtr<BaseTableRef> &base_table
                                 data_type_ptr->ToString())));
             }
         }
+        if (param->param_name_ == "encode" && StringToHnswEncodeType(param->param_value_) == HnswEncodeType::kPQ) {
+            if (embedding_data_type != EmbeddingDataType::kElemFloat) {
+                RecoverableError(Status::InvalidIndexDefinition(
+                    fmt::format("Attempt to create HNSW index with PQ encoding on column: {}, data type: {}. now only support float element type.",
+                                column_name,
+                                data_type_ptr->ToString())));
+            }
+        }
+        if (param->param_name_ == "encode" && StringToHnswEncodeType(param->param_value_) == HnswEncodeType::kRaBitQ) {
+            if (embedding_data_type != EmbeddingDataType::kElemFloat) {
+                RecoverableError(Status::InvalidIndexDefinition(fmt::format(
+                    "Attempt to create HNSW index with RaBitQ encoding on column: {}, data type: {}. now only support float element type.",
+                    column_name,
+                    data_type_ptr->ToString())));
+            }
+        }
+        if (param->param_name_ == "pq_subspace_num") {
+            const SizeT pq_subspace_num = std::stoi(param->param_value_);
+            if (pq_subspace_num == 0 || index_dim % pq_subspace_num != 0) {
+                RecoverableError(Status::InvalidIndexDefinition(fmt::format("pq_subspace_num: {} should be a divisor of the dimension of index on column: {}.",
+                                                                            pq_subspace_num,
+                                                                            column_name)));
+            }
+        }
     }
-    // TODO: now only support float, int8, uint8?
     switch (embedding_data_type) {
         case EmbeddingDataType::kElemFloat:
+        case EmbeddingDataType::kElemFloat16:
+        case EmbeddingDataType::kElemBFloat16:
         case EmbeddingDataType::kElemInt8:
         case EmbeddingDataType::kElemUInt8: {
-            // supported
+            if (metric_type == MetricType::kMetricHamming) {
+                RecoverableError(Status::InvalidIndexDefinition(
+                    fmt::format("Attempt to create HNSW index with hamming metric on column: {}, data type: {}. now only support bit element type.",
+                                column_name,
+                                data_type_ptr->ToString())));
+            }
+            break;
+        }
+        case EmbeddingDataType::kElemBit: {
+            // the packed bits are compared by hamming distance, and not encoded further
+            if (metric_type != MetricType::kMetricHamming) {
+                RecoverableError(Status::InvalidIndexDefinition(
+                    fmt::format("Attempt to create HNSW index on column: {}, data type: {}. bit element type only supports hamming metric.",
+                                column_name,
+                                data_type_ptr->ToString())));
+            }
             break;
         }
         default: {
             RecoverableError(Status::InvalidIndexDefinition(
-                fmt::format("Attempt to create HNSW index on column: {}, data type: {}. now only support float, int8, uint8 element type.",
+                fmt::format("Attempt to create HNSW index on column: {}, data type: {}. now only support float, float16, bfloat16, int8, uint8, bit element type.",
                             column_name,
                             data_type_ptr->ToString())));
         }
@@ -14,6 +14,10 @@
 
 module;
 
+namespace infinity {
+class EmbeddingInfo;
+}
+
 export module index_hnsw;
 
 import stl;
@@ -30,6 +34,8 @@ namespace infinity {
 export enum class HnswEncodeType {
     kPlain,
     kLVQ,
+    kPQ,
+    kRaBitQ,
     kInvalid,
 };
 
@@ -53,9 +59,12 @@ public:
               HnswEncodeType encode_type,
               SizeT M,
               SizeT ef_construction,
-              SizeT block_size)
+              SizeT block_size,
+              SizeT pq_subspace_num = 0,
+              SizeT truncate_dim = 0)
         : IndexBase(IndexType::kHnsw, index_name, index_comment, file_name, std::move(column_names)), metric_type_(metric_type),
-          encode_type_(encode_type), M_(M), ef_construction_(ef_construction), block_size_(block_size) {}
+          encode_type_(encode_type), M_(M), ef_construction_(ef_construction), block_size_(block_size), pq_subspace_num_(pq_subspace_num),
+          truncate_dim_(truncate_dim) {}
 
     ~IndexHnsw() final = default;
 
@@ -74,6 +83,15 @@ public:
 
     virtual nlohmann::json Serialize() const override;
 
+    // the dimension of the vectors in the graph, the bytes of the packed bits for bit vectors
+    SizeT IndexDimension(const EmbeddingInfo *embedding_info) const;
+
+    // Set on the encode type of the binary format when pq_subspace_num and truncate_dim follow block_size.
+    // Records written before these parameters have no flag, and an index without them is still written in that layout.
+    static constexpr i32 kOptionalParamsFlag = 1 << 16;
+
+    bool HasOptionalParams() const { return pq_subspace_num_ != 0 || truncate_dim_ != 0; }
+
 public:
     static void
     ValidateColumnDataType(const SharedPtr<BaseTableRef> &base_table_ref, const String &column_name, const Vector<InitParameter *> &index_param_list);
@@ -84,6 +102,10 @@ public:
     const SizeT M_{};
     const SizeT ef_construction_{};
     const SizeT block_size_{};
+    // only used by pq encoding, 0 means decided by the dimension
+    const SizeT pq_subspace_num_{};
+    // the graph is built on the first truncate_dim dimensions and the candidates are reranked with the full vectors, 0 means not truncated
+    const SizeT truncate_dim_{};
 };
 
 } // namespace infinity
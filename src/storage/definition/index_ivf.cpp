@@ -127,9 +127,11 @@ SharedPtr<IndexIVF> IndexIVF::Make(SharedPtr<String> index_name,
                 ivf_option.storage_option_.type_ = IndexIVFStorageOption::Type::kScalarQuantization;
             } else if (nh.mapped() == "product_quantization") {
                 ivf_option.storage_option_.type_ = IndexIVFStorageOption::Type::kProductQuantization;
+            } else if (nh.mapped() == "rabitq") {
+                ivf_option.storage_option_.type_ = IndexIVFStorageOption::Type::kRaBitQ;
             } else {
                 RecoverableError(Status::InvalidIndexDefinition(
-                    std::format("Unrecognized storage_type '{}', valid choices: 'plain', 'scalar_quantization', 'product_quantization'",
+                    std::format("Unrecognized storage_type '{}', valid choices: 'plain', 'scalar_quantization', 'product_quantization', 'rabitq'",
                                 nh.mapped())));
             }
         }
@@ -153,6 +155,9 @@ SharedPtr<IndexIVF> IndexIVF::Make(SharedPtr<String> index_name,
                 ivf_option.storage_option_.product_quantization_subspace_bits_ = GetIntegerFromNodeHandler<u32, 4, 16>(nh2);
                 break;
             }
+            case IndexIVFStorageOption::Type::kRaBitQ: {
+                break;
+            }
         }
     }
     if (!params_map.empty()) {
@@ -253,7 +258,8 @@ void CheckIndexIVFStorageOption(IndexIVFStorageOption &storage_option, const Dat
             break;
         }
         case IndexIVFStorageOption::Type::kScalarQuantization:
-        case IndexIVFStorageOption::Type::kProductQuantization: {
+        case IndexIVFStorageOption::Type::kProductQuantization:
+        case IndexIVFStorageOption::Type::kRaBitQ: {
             // only allowed on float32, float16, bfloat16, float64 embedding
             switch (embedding_data_type) {
                 case EmbeddingDataType::kElemFloat:
@@ -270,8 +276,8 @@ void CheckIndexIVFStorageOption(IndexIVFStorageOption &storage_option, const Dat
                 case EmbeddingDataType::kElemUInt8:
                 case EmbeddingDataType::kElemInvalid: {
                     RecoverableError(Status::InvalidIndexDefinition(
-                        std::format("Attempt to use scalar quantization on embedding column with type: {}.", column_data_type->ToString()) +
-                        " Can only use scalar quantization on float32, float16, bfloat16, float64 embedding."));
+                        std::format("Attempt to use quantized storage on embedding column with type: {}.", column_data_type->ToString()) +
+                        " Can only use quantized storage on float32, float16, bfloat16, float64 embedding."));
                 }
             }
             if (storage_option.type_ == IndexIVFStorageOption::Type::kScalarQuantization) {
@@ -297,7 +303,7 @@ void CheckIndexIVFStorageOption(IndexIVFStorageOption &storage_option, const Dat
                         Status::InvalidIndexDefinition(std::format("product_quantization_subspace_bits can only be in range [4, 16], now it is {}.",
                                                                    product_quantization_subspace_bits)));
                 }
-            } else {
+            } else if (storage_option.type_ != IndexIVFStorageOption::Type::kRaBitQ) {
                 UnrecoverableError("Unexpected case");
             }
             break;
@@ -330,7 +336,7 @@ void IndexIVF::ValidateColumnDataType(const SharedPtr<BaseTableRef> &base_table_
         RecoverableError(Status::InvalidIndexDefinition(
             std::format("Attempt to create IVF index on column: {}, data type: {}.", column_name, data_type->ToString())));
     } else {
-        if (ivf_option_.metric_ == MetricType::kInvalid) {
+        if (ivf_option_.metric_ == MetricType::kInvalid || ivf_option_.metric_ == MetricType::kMetricHamming) {
             RecoverableError(Status::InvalidIndexDefinition("Invalid metric type"));
         }
         CheckIndexIVFCentroidOption(ivf_option_.centroid_option_);
@@ -382,6 +388,10 @@ String IndexIVFStorageOption::ToString() const {
                                product_quantization_subspace_bits_);
             break;
         }
+        case Type::kRaBitQ: {
+            oss << "Type: RaBitQ";
+            break;
+        }
     }
     oss << ']';
     return std::move(oss).str();
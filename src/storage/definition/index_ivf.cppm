@@ -39,6 +39,7 @@ export struct IndexIVFStorageOption {
         kPlain,               // for floating-point, i8, u8
         kScalarQuantization,  // for floating-point, quantization for every dimension
         kProductQuantization, // for floating-point, centroid tag for several subspaces
+        kRaBitQ,              // for floating-point, 1 bit for every dimension of the residual, results are reranked
     };
     Type type_ = Type::kPlain;
     // kPlain
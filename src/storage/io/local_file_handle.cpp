@@ -142,6 +142,15 @@ Status LocalFileHandle::Seek(u64 nbytes) {
     return Status::OK();
 }
 
+i64 LocalFileHandle::Tell() {
+    off_t offset = lseek(fd_, 0, SEEK_CUR);
+    if (offset == (off_t)-1) {
+        String error_message = fmt::format("Can't tell file: {}: {}", path_, strerror(errno));
+        UnrecoverableError(error_message);
+    }
+    return offset;
+}
+
 i64 LocalFileHandle::FileSize() {
     struct stat s {};
     if (fstat(fd_, &s) == -1) {
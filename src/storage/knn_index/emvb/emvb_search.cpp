@@ -88,11 +88,12 @@ auto EMVBSearch<FIXED_QUERY_TOKEN_NUM>::find_candidate_docs(const f32 *centroids
             closest_centroids_ids.insert(closest_centroids_ids.end(), idx_result.get(), idx_result.get() + result_cnt);
         }
     }
-    std::unordered_set<u32> remove_dup_cid;
+    std::vector<bool> centroid_visited(n_centroids_);
     std::vector<bool> doc_visited(n_docs_);
     std::vector<u32> candidate_docs;
     for (const auto &cid : closest_centroids_ids) {
-        if (const auto [_, success] = remove_dup_cid.insert(cid); success) {
+        if (!centroid_visited[cid]) {
+            centroid_visited[cid] = true;
             const auto [docid_shared, size] = centroids_to_docid_[cid].GetData();
             const auto docid_ptr = docid_shared.get();
             for (u32 i = 0; i < size; ++i) {
@@ -114,8 +115,8 @@ auto EMVBSearch<FIXED_QUERY_TOKEN_NUM>::find_candidate_docs(const f32 *centroids
 template <u32 FIXED_QUERY_TOKEN_NUM>
 auto EMVBSearch<FIXED_QUERY_TOKEN_NUM>::compute_hit_frequency(std::vector<u32> candidate_documents,
                                                               const u32 n_doc_to_score,
-                                                              auto centroid_q_token_sim) const {
-    static_assert(std::is_same_v<typename decltype(centroid_q_token_sim)::value_type, std::bitset<FIXED_QUERY_TOKEN_NUM>>);
+                                                              const auto &centroid_q_token_sim) const {
+    static_assert(std::is_same_v<typename std::decay_t<decltype(centroid_q_token_sim)>::value_type, std::bitset<FIXED_QUERY_TOKEN_NUM>>);
     if (n_doc_to_score >= candidate_documents.size()) [[unlikely]] {
         // too few documents
         std::pair<u32, std::unique_ptr<u32[]>> result(candidate_documents.size(), nullptr);
@@ -141,81 +142,99 @@ auto EMVBSearch<FIXED_QUERY_TOKEN_NUM>::compute_hit_frequency(std::vector<u32> c
 }
 
 template <u32 FIXED_QUERY_TOKEN_NUM>
-auto EMVBSearch<FIXED_QUERY_TOKEN_NUM>::compute_ip_of_vectors_in_doc_with_centroids(const u32 doc_id, const f32 *centroids_scores_transposed) const {
+void EMVBSearch<FIXED_QUERY_TOKEN_NUM>::compute_ip_of_vectors_in_doc_with_centroids(const u32 doc_id,
+                                                                                    const f32 *centroids_scores_transposed,
+                                                                                    f32 *centroid_distances) const {
     const auto doclen = doc_lens_[doc_id];
     const auto doc_offset = doc_offsets_[doc_id];
-    auto centroid_distances = Get256AlignedF32Array(doclen * FIXED_QUERY_TOKEN_NUM);
-    auto dst_start = centroid_distances.get();
+    auto dst_start = centroid_distances;
     for (u32 j = 0; j < doclen; ++j) {
         const auto centroid_id = centroid_id_assignments_[doc_offset + j];
-        const auto src_start = centroids_scores_transposed + centroid_id * FIXED_QUERY_TOKEN_NUM;
+        const auto src_start = centroids_scores_transposed + static_cast<SizeT>(centroid_id) * FIXED_QUERY_TOKEN_NUM;
         std::copy_n(src_start, FIXED_QUERY_TOKEN_NUM, dst_start);
         dst_start += FIXED_QUERY_TOKEN_NUM;
     }
-    return centroid_distances;
 }
 
 #if defined(__AVX2__)
 template <u32 FIXED_QUERY_TOKEN_NUM, typename IndexSequence>
-struct GetMaxSimSumUp;
+struct GetCentroidInteractionSumUp;
 
 template <u32 FIXED_QUERY_TOKEN_NUM, std::size_t... I>
-struct GetMaxSimSumUp<FIXED_QUERY_TOKEN_NUM, std::index_sequence<I...>> {
-    static f32 Get(const f32 *centroid_distances, const u32 doclen) {
-        return (GetMaxSim32Width<FIXED_QUERY_TOKEN_NUM, I * 32>(centroid_distances, doclen) + ...);
+struct GetCentroidInteractionSumUp<FIXED_QUERY_TOKEN_NUM, std::index_sequence<I...>> {
+    static f32 Get(const f32 *centroids_scores_transposed, const u32 *centroid_ids, const u32 centroid_num) {
+        return (GetCentroidInteraction32Width<FIXED_QUERY_TOKEN_NUM, I * 32>(centroids_scores_transposed, centroid_ids, centroid_num) + ...);
     }
 };
 
 template <u32 FIXED_QUERY_TOKEN_NUM>
     requires((FIXED_QUERY_TOKEN_NUM % 32 == 0) && (FIXED_QUERY_TOKEN_NUM > 0))
-struct GetMaxSimScoreOfDoc {
-    static f32 Get(const f32 *centroid_distances, const u32 doclen) {
-        return GetMaxSimSumUp<FIXED_QUERY_TOKEN_NUM, std::make_index_sequence<FIXED_QUERY_TOKEN_NUM / 32>>::Get(centroid_distances, doclen);
+struct GetCentroidInteractionScoreOfDoc {
+    static f32 Get(const f32 *centroids_scores_transposed, const u32 *centroid_ids, const u32 centroid_num) {
+        return GetCentroidInteractionSumUp<FIXED_QUERY_TOKEN_NUM, std::make_index_sequence<FIXED_QUERY_TOKEN_NUM / 32>>::Get(centroids_scores_transposed,
+                                                                                                                           centroid_ids,
+                                                                                                                           centroid_num);
     }
 };
 #endif
 
 template <u32 FIXED_QUERY_TOKEN_NUM>
-inline f32 SimpleGetMaxSimScoreOfDoc(const f32 *centroid_distances, const u32 doclen) {
-    std::array<f32, FIXED_QUERY_TOKEN_NUM> maxs;
-    std::copy_n(centroid_distances, FIXED_QUERY_TOKEN_NUM, maxs.begin());
-    for (u32 i = 1; i < doclen; ++i) {
-        centroid_distances += FIXED_QUERY_TOKEN_NUM;
+inline f32 SimpleGetCentroidInteractionScoreOfDoc(const f32 *centroids_scores_transposed, const u32 *centroid_ids, const u32 centroid_num) {
+    std::array<f32, FIXED_QUERY_TOKEN_NUM> maxs = {};
+    for (u32 i = 0; i < centroid_num; ++i) {
+        const f32 *row = centroids_scores_transposed + static_cast<SizeT>(centroid_ids[i]) * FIXED_QUERY_TOKEN_NUM;
         for (u32 j = 0; j < FIXED_QUERY_TOKEN_NUM; ++j) {
-            maxs[j] = std::max(maxs[j], centroid_distances[j]);
+            maxs[j] = std::max(maxs[j], row[j]);
         }
     }
     return std::reduce(maxs.begin(), maxs.end());
 }
 
+// PLAID style centroid interaction: the score of a document is the MaxSim over the centroids of its embeddings, looked up in the
+// query token - centroid score table, nothing of the residuals is decoded.
+// The centroids which pass the first threshold for no query token are pruned before the lookup. The max of a token starts from 0,
+// so with a threshold of 0 the pruned centroids would not change the score anyway.
 template <u32 FIXED_QUERY_TOKEN_NUM>
 auto EMVBSearch<FIXED_QUERY_TOKEN_NUM>::second_stage_filtering(auto selected_cnt_and_docs,
                                                                const u32 out_second_stage,
-                                                               auto query_token_centroids_scores) const {
-    static_assert(std::is_same_v<decltype(query_token_centroids_scores), UniquePtrF32Aligned>);
+                                                               const f32 *centroids_scores_transposed,
+                                                               const auto &centroid_q_token_sim) const {
     const auto &[selected_cnt, selected_docs] = selected_cnt_and_docs;
-    auto centroids_scores_transposed = std::make_unique_for_overwrite<f32[]>(FIXED_QUERY_TOKEN_NUM * n_centroids_);
-    TransposeMatrix(query_token_centroids_scores.get(), centroids_scores_transposed.get(), FIXED_QUERY_TOKEN_NUM, n_centroids_);
-    // release memory no longer needed
-    query_token_centroids_scores.reset();
-    using ResultHandler = EMVBReservoirResultHandler<f32, std::pair<u32, UniquePtrF32Aligned>>;
+    using ResultHandler = EMVBReservoirResultHandler<f32, u32>;
     ResultHandler result_handler(out_second_stage);
+    std::vector<u32> kept_centroid_ids;
+    auto prune_centroids = [&](const u32 doc_id) {
+        const auto doclen = doc_lens_[doc_id];
+        const auto doc_offset = doc_offsets_[doc_id];
+        if (kept_centroid_ids.size() < doclen) {
+            kept_centroid_ids.resize(doclen);
+        }
+        u32 kept_num = 0;
+        for (u32 j = 0; j < doclen; ++j) {
+            const auto centroid_id = centroid_id_assignments_[doc_offset + j];
+            kept_centroid_ids[kept_num] = centroid_id;
+            kept_num += centroid_q_token_sim[centroid_id].any();
+        }
+        return kept_num;
+    };
 #if defined(__AVX2__)
     if (IsAVX2Supported()) {
         for (u32 i = 0; i < selected_cnt; ++i) {
             const auto doc_id = selected_docs[i];
-            auto centroid_scores = compute_ip_of_vectors_in_doc_with_centroids(doc_id, centroids_scores_transposed.get());
-            const auto score = GetMaxSimScoreOfDoc<FIXED_QUERY_TOKEN_NUM>::Get(centroid_scores.get(), doc_lens_[doc_id]);
-            result_handler.Add(score, std::make_pair(doc_id, std::move(centroid_scores)));
+            const u32 kept_num = prune_centroids(doc_id);
+            const auto score =
+                GetCentroidInteractionScoreOfDoc<FIXED_QUERY_TOKEN_NUM>::Get(centroids_scores_transposed, kept_centroid_ids.data(), kept_num);
+            result_handler.Add(score, doc_id);
         }
     } else
 #endif
     {
         for (u32 i = 0; i < selected_cnt; ++i) {
             const auto doc_id = selected_docs[i];
-            auto centroid_scores = compute_ip_of_vectors_in_doc_with_centroids(doc_id, centroids_scores_transposed.get());
-            const auto score = SimpleGetMaxSimScoreOfDoc<FIXED_QUERY_TOKEN_NUM>(centroid_scores.get(), doc_lens_[doc_id]);
-            result_handler.Add(score, std::make_pair(doc_id, std::move(centroid_scores)));
+            const u32 kept_num = prune_centroids(doc_id);
+            const auto score =
+                SimpleGetCentroidInteractionScoreOfDoc<FIXED_QUERY_TOKEN_NUM>(centroids_scores_transposed, kept_centroid_ids.data(), kept_num);
+            result_handler.Add(score, doc_id);
         }
     }
     result_handler.EndWithoutSort();
@@ -265,20 +284,26 @@ struct ReuseableBuffer256Aligned {
 
 template <u32 FIXED_QUERY_TOKEN_NUM>
 auto EMVBSearch<FIXED_QUERY_TOKEN_NUM>::compute_topk_documents_selected(const f32 *query_ptr,
-                                                                        auto selected_docs_centroid_scores,
+                                                                        auto selected_docs,
+                                                                        const f32 *centroids_scores_transposed,
                                                                         const u32 k,
                                                                         const f32 th) const {
     const auto residual_pq_ip_table = product_quantizer_->GetIPDistanceTable(query_ptr, FIXED_QUERY_TOKEN_NUM);
     using ResultHandler = EMVBReservoirResultHandler<f32, u32>;
     ResultHandler result_handler(k);
-    auto &[selected_num, docs_centroid_scores_ptr] = selected_docs_centroid_scores;
+    auto &[selected_num, selected_doc_ids] = selected_docs;
     ReuseableBuffer<u32> embedding_id_buffer;
+    ReuseableBuffer256Aligned<f32> centroid_distances_buffer;
     ReuseableBuffer256Aligned<f32> distances_buffer;
     ReuseableBuffer256Aligned<f32> residual_distances_buffer;
     for (u32 selected_i = 0; selected_i < selected_num; ++selected_i) {
-        const auto &[doc_id, centroid_distances] = docs_centroid_scores_ptr[selected_i];
+        const auto doc_id = selected_doc_ids[selected_i];
         const auto doclen = doc_lens_[doc_id];
         const auto doc_offset = doc_offsets_[doc_id];
+        // only the documents left after the centroid interaction get their embedding - centroid scores
+        centroid_distances_buffer.Resize(doclen * FIXED_QUERY_TOKEN_NUM);
+        const auto centroid_distances = centroid_distances_buffer.GetPtr();
+        compute_ip_of_vectors_in_doc_with_centroids(doc_id, centroids_scores_transposed, centroid_distances);
         distances_buffer.Resize(doclen);
         const auto distances_ptr = distances_buffer.GetPtr();
         embedding_id_buffer.Resize(doclen + 8);
@@ -327,6 +352,14 @@ auto EMVBSearch<FIXED_QUERY_TOKEN_NUM>::compute_topk_documents_selected(const f3
     return std::make_tuple(result_handler.GetSize(), result_handler.GetDistancePtr(), result_handler.GetIdPtr());
 }
 
+template <u32 FIXED_QUERY_TOKEN_NUM>
+auto EMVBSearch<FIXED_QUERY_TOKEN_NUM>::transpose_centroids_scores(auto query_token_centroids_scores) const {
+    static_assert(std::is_same_v<decltype(query_token_centroids_scores), UniquePtrF32Aligned>);
+    auto centroids_scores_transposed = std::make_unique_for_overwrite<f32[]>(FIXED_QUERY_TOKEN_NUM * n_centroids_);
+    TransposeMatrix(query_token_centroids_scores.get(), centroids_scores_transposed.get(), FIXED_QUERY_TOKEN_NUM, n_centroids_);
+    return centroids_scores_transposed;
+}
+
 template <u32 FIXED_QUERY_TOKEN_NUM>
 EMVBSearch<FIXED_QUERY_TOKEN_NUM>::EMVBSearch(const u32 embedding_dimension,
                                               const u32 n_docs,
@@ -361,10 +394,11 @@ std::tuple<u32, std::unique_ptr<f32[]>, std::unique_ptr<u32[]>> EMVBSearch<FIXED
     const u32 real_nprobe = std::min(n_centroids_, nprobe);
     assert(real_nprobe > 0);
     auto [candidate_docs, centroid_q_token_sim] = find_candidate_docs(query_token_centroids_scores.get(), real_nprobe, thresh);
-    auto selected_cnt_and_docs = compute_hit_frequency(std::move(candidate_docs), n_doc_to_score, std::move(centroid_q_token_sim));
-    auto selected_docs_centroid_scores =
-        second_stage_filtering(std::move(selected_cnt_and_docs), out_second_stage, std::move(query_token_centroids_scores));
-    auto query_res = compute_topk_documents_selected(query_ptr, std::move(selected_docs_centroid_scores), k, thresh_query);
+    auto selected_cnt_and_docs = compute_hit_frequency(std::move(candidate_docs), n_doc_to_score, centroid_q_token_sim);
+    const auto centroids_scores_transposed = transpose_centroids_scores(std::move(query_token_centroids_scores));
+    auto selected_docs =
+        second_stage_filtering(std::move(selected_cnt_and_docs), out_second_stage, centroids_scores_transposed.get(), centroid_q_token_sim);
+    auto query_res = compute_topk_documents_selected(query_ptr, std::move(selected_docs), centroids_scores_transposed.get(), k, thresh_query);
     static_assert(std::is_same_v<decltype(query_res), std::tuple<u32, std::unique_ptr<f32[]>, std::unique_ptr<u32[]>>>);
     return query_res;
 }
@@ -410,10 +444,11 @@ Tuple<u32, UniquePtr<f32[]>, UniquePtr<u32[]>> EMVBSearch<FIXED_QUERY_TOKEN_NUM>
         // no delete
         candidate_docs_filtered = std::move(candidate_docs);
     }
-    auto selected_cnt_and_docs = compute_hit_frequency(std::move(candidate_docs_filtered), n_doc_to_score, std::move(centroid_q_token_sim));
-    auto selected_docs_centroid_scores =
-        second_stage_filtering(std::move(selected_cnt_and_docs), out_second_stage, std::move(query_token_centroids_scores));
-    auto query_res = compute_topk_documents_selected(query_ptr, std::move(selected_docs_centroid_scores), k, thresh_query);
+    auto selected_cnt_and_docs = compute_hit_frequency(std::move(candidate_docs_filtered), n_doc_to_score, centroid_q_token_sim);
+    const auto centroids_scores_transposed = transpose_centroids_scores(std::move(query_token_centroids_scores));
+    auto selected_docs =
+        second_stage_filtering(std::move(selected_cnt_and_docs), out_second_stage, centroids_scores_transposed.get(), centroid_q_token_sim);
+    auto query_res = compute_topk_documents_selected(query_ptr, std::move(selected_docs), centroids_scores_transposed.get(), k, thresh_query);
     static_assert(std::is_same_v<decltype(query_res), std::tuple<u32, std::unique_ptr<f32[]>, std::unique_ptr<u32[]>>>);
     // consider start_segment_offset
     auto &[doc_num, scores, doc_ids] = query_res;
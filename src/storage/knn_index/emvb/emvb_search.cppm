@@ -80,13 +80,18 @@ public:
 private:
     auto find_candidate_docs(const f32 *centroids_scores, u32 nprobe, f32 th) const;
 
-    auto compute_hit_frequency(Vector<u32> candidate_documents, u32 n_doc_to_score, auto centroid_q_token_sim) const;
+    auto compute_hit_frequency(Vector<u32> candidate_documents, u32 n_doc_to_score, const auto &centroid_q_token_sim) const;
 
-    auto second_stage_filtering(auto selected_cnt_and_docs, u32 out_second_stage, auto query_token_centroids_scores) const;
+    auto transpose_centroids_scores(auto query_token_centroids_scores) const;
 
-    auto compute_ip_of_vectors_in_doc_with_centroids(u32 doc_id, const f32 *centroids_scores_transposed) const;
+    auto second_stage_filtering(auto selected_cnt_and_docs,
+                                u32 out_second_stage,
+                                const f32 *centroids_scores_transposed,
+                                const auto &centroid_q_token_sim) const;
 
-    auto compute_topk_documents_selected(const f32 *query_ptr, auto selected_docs_centroid_scores, u32 k, f32 th) const;
+    void compute_ip_of_vectors_in_doc_with_centroids(u32 doc_id, const f32 *centroids_scores_transposed, f32 *centroid_distances) const;
+
+    auto compute_topk_documents_selected(const f32 *query_ptr, auto selected_docs, const f32 *centroids_scores_transposed, u32 k, f32 th) const;
 };
 
 } // namespace infinity
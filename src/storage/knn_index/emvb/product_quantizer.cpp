@@ -121,7 +121,8 @@ void PQ<SUBSPACE_CENTROID_TAG, SUBSPACE_NUM>::Train(const f32 *embedding_data, c
                                                             part_train_data.get(),
                                                             subspace_centroids_[i],
                                                             subspace_centroid_num_,
-                                                            iter_cnt);
+                                                            iter_cnt,
+                                                            KMeansOption{.kmeans_plus_plus_ = true});
         if (centroid_cnt_result != subspace_centroid_num_) {
             const auto error_info = fmt::format("KMeans failed to find {} centroids for subspace", subspace_centroid_num_);
             UnrecoverableError(error_info);
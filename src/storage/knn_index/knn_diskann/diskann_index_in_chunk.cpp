@@ -0,0 +1,296 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+#include <chrono>
+
+module diskann_index_in_chunk;
+
+import stl;
+import internal_types;
+import index_base;
+import index_diskann;
+import pq_flash_index;
+import diskann_index_data;
+import diskann_dist_func;
+import default_values;
+import local_file_handle;
+import virtual_store;
+import segment_entry;
+import segment_iter;
+import column_def;
+import buffer_manager;
+import infinity_exception;
+import status;
+import logger;
+import third_party;
+
+namespace infinity {
+
+namespace {
+
+// same as the clamp in `DiskAnnIndexData::BuildIndex`
+u32 ClampPqChunks(SizeT num_pq_chunks, u32 dimension) {
+    return std::min({std::max<u32>(num_pq_chunks, 1u), dimension, static_cast<u32>(DISKANN_MAX_PQ_CHUNKS)});
+}
+
+template <MetricType metric>
+void BuildDiskAnnFiles(u32 dimension,
+                       u32 row_count,
+                       u32 R,
+                       u32 L,
+                       u32 num_pq_chunks,
+                       const String &work_dir,
+                       const String &data_path,
+                       const String &graph_path,
+                       const String &pq_compressed_path,
+                       const String &pq_pivot_path) {
+    Vector<SizeT> labels(row_count);
+    std::iota(labels.begin(), labels.end(), 0);
+    auto index_data = DiskAnnIndexData<f32, SizeT, metric>::Make(dimension, row_count, R, L, num_pq_chunks, 1 /*num_parts*/);
+    index_data->BuildIndex(dimension,
+                           row_count,
+                           labels,
+                           Path(data_path),
+                           Path(work_dir) / "mem_index.bin",
+                           Path(graph_path),
+                           Path(pq_compressed_path),
+                           Path(work_dir),
+                           Path(pq_pivot_path));
+}
+
+void CopyFileContent(LocalFileHandle &src, LocalFileHandle &dst, u64 size) {
+    constexpr u64 kCopyBufferSize = 1 << 20;
+    auto buffer = MakeUniqueForOverwrite<char[]>(kCopyBufferSize);
+    while (size > 0) {
+        const u64 copy_size = std::min(size, kCopyBufferSize);
+        auto [read_size, status] = src.Read(buffer.get(), copy_size);
+        if (!status.ok() || read_size != copy_size) {
+            UnrecoverableError(fmt::format("Failed to read {} bytes from {}", copy_size, src.Path()));
+        }
+        dst.Append(buffer.get(), copy_size);
+        size -= copy_size;
+    }
+}
+
+} // namespace
+
+DiskAnnIndexInChunk::DiskAnnIndexInChunk(SegmentOffset start_segment_offset, const IndexDiskAnn *index_diskann, u32 dimension, String work_dir)
+    : start_segment_offset_(start_segment_offset), metric_(index_diskann->metric_type_), dimension_(dimension), R_(index_diskann->R_),
+      L_(index_diskann->L_), num_pq_chunks_(ClampPqChunks(index_diskann->num_pq_chunks_, dimension)), work_dir_(std::move(work_dir)) {}
+
+DiskAnnIndexInChunk::~DiskAnnIndexInChunk() {
+    flash_index_.reset();
+    if (VirtualStore::Exists(work_dir_)) {
+        VirtualStore::RemoveDirectory(work_dir_);
+    }
+}
+
+bool DiskAnnIndexInChunk::CanBuild(u32 row_count) { return row_count > DISKANN_NUM_CENTERS; }
+
+void DiskAnnIndexInChunk::BuildDiskAnnIndex(RowID base_rowid,
+                                            u32 row_count,
+                                            const SegmentEntry *segment_entry,
+                                            const ColumnDef *column_def,
+                                            BufferManager *buffer_mgr) {
+    if (base_rowid.segment_offset_ != start_segment_offset_) {
+        UnrecoverableError(fmt::format("DiskAnnIndexInChunk::BuildDiskAnnIndex: can not build chunk of {} rows from offset {}.",
+                                       row_count,
+                                       base_rowid.segment_offset_));
+    }
+    CheckBuild(row_count);
+
+    // the vamana build reads the vectors from a raw file
+    const String data_path = Path(work_dir_) / "data.bin";
+    {
+        auto [data_file_handle, status] = VirtualStore::Open(data_path, FileAccessMode::kWrite);
+        if (!status.ok()) {
+            UnrecoverableError(status.message());
+        }
+        const SegmentOffset end_offset = start_segment_offset_ + row_count;
+        CappedOneColumnIterator<f32, false /*check ts*/> iter(segment_entry, buffer_mgr, column_def->id(), MAX_TIMESTAMP, end_offset);
+        SegmentOffset next_offset = start_segment_offset_;
+        while (auto ret = iter.Next()) {
+            const auto &[vec, offset] = *ret;
+            if (offset < start_segment_offset_) {
+                continue;
+            }
+            if (offset != next_offset) {
+                UnrecoverableError(fmt::format("DiskAnnIndexInChunk::BuildDiskAnnIndex: expect row {}, got {}.", next_offset, offset));
+            }
+            data_file_handle->Append(vec, sizeof(f32) * dimension_);
+            ++next_offset;
+        }
+        if (next_offset != end_offset) {
+            UnrecoverableError(
+                fmt::format("DiskAnnIndexInChunk::BuildDiskAnnIndex: expect {} rows, got {}.", row_count, next_offset - start_segment_offset_));
+        }
+    }
+    BuildFromDataFile(data_path, row_count);
+}
+
+void DiskAnnIndexInChunk::BuildDiskAnnIndex(const f32 *vectors, u32 row_count) {
+    CheckBuild(row_count);
+    const String data_path = Path(work_dir_) / "data.bin";
+    {
+        auto [data_file_handle, status] = VirtualStore::Open(data_path, FileAccessMode::kWrite);
+        if (!status.ok()) {
+            UnrecoverableError(status.message());
+        }
+        data_file_handle->Append(vectors, sizeof(f32) * dimension_ * row_count);
+    }
+    BuildFromDataFile(data_path, row_count);
+}
+
+void DiskAnnIndexInChunk::CheckBuild(u32 row_count) {
+    if (flash_index_.get() != nullptr) {
+        UnrecoverableError("DiskAnnIndexInChunk::BuildDiskAnnIndex: index is already built.");
+    }
+    if (!CanBuild(row_count)) {
+        UnrecoverableError(fmt::format("DiskAnnIndexInChunk::BuildDiskAnnIndex: can not build chunk of {} rows.", row_count));
+    }
+    if (!VirtualStore::Exists(work_dir_)) {
+        VirtualStore::MakeDirectory(work_dir_);
+    }
+}
+
+void DiskAnnIndexInChunk::BuildFromDataFile(const String &data_path, u32 row_count) {
+    const auto time_0 = std::chrono::high_resolution_clock::now();
+    switch (metric_) {
+        case MetricType::kMetricL2: {
+            BuildDiskAnnFiles<MetricType::kMetricL2>(dimension_,
+                                                     row_count,
+                                                     R_,
+                                                     L_,
+                                                     num_pq_chunks_,
+                                                     work_dir_,
+                                                     data_path,
+                                                     GraphPath(),
+                                                     PqCompressedPath(),
+                                                     PqPivotPath());
+            break;
+        }
+        case MetricType::kMetricCosine: {
+            BuildDiskAnnFiles<MetricType::kMetricCosine>(dimension_,
+                                                         row_count,
+                                                         R_,
+                                                         L_,
+                                                         num_pq_chunks_,
+                                                         work_dir_,
+                                                         data_path,
+                                                         GraphPath(),
+                                                         PqCompressedPath(),
+                                                         PqPivotPath());
+            break;
+        }
+        default: {
+            Status status = Status::NotSupport("DiskAnn index only supports l2 and cosine metric");
+            RecoverableError(status);
+        }
+    }
+    // only the graph and the pq files are kept
+    VirtualStore::DeleteFile(data_path);
+    VirtualStore::DeleteFile(Path(work_dir_) / "train_data.bin");
+    VirtualStore::DeleteFile(Path(work_dir_) / "train_ids.bin");
+
+    row_count_ = row_count;
+    LoadFlashIndex(PqPivotPath(), 0, PqCompressedPath(), 0, GraphPath(), 0);
+    const auto time_1 = std::chrono::high_resolution_clock::now();
+    LOG_INFO(fmt::format("DiskAnnIndexInChunk::BuildDiskAnnIndex: built {} rows in {} ms.",
+                         row_count,
+                         std::chrono::duration_cast<std::chrono::milliseconds>(time_1 - time_0).count()));
+}
+
+void DiskAnnIndexInChunk::SaveIndexInner(LocalFileHandle &file_handle) const {
+    file_handle.Append(&row_count_, sizeof(row_count_));
+    if (row_count_ == 0) {
+        return;
+    }
+    for (const String &path : {PqPivotPath(), PqCompressedPath(), GraphPath()}) {
+        const u64 file_size = VirtualStore::GetFileSize(path);
+        file_handle.Append(&file_size, sizeof(file_size));
+        auto [src_handle, status] = VirtualStore::Open(path, FileAccessMode::kRead);
+        if (!status.ok()) {
+            UnrecoverableError(status.message());
+        }
+        CopyFileContent(*src_handle, file_handle, file_size);
+    }
+}
+
+void DiskAnnIndexInChunk::ReadIndexInner(LocalFileHandle &file_handle) {
+    file_handle.Read(&row_count_, sizeof(row_count_));
+    if (row_count_ == 0) {
+        return;
+    }
+    // the pq pivots, the pq codes and the graph are read in place, each from its offset of the chunk file
+    u64 offsets[3];
+    for (u64 &offset : offsets) {
+        u64 file_size = 0;
+        file_handle.Read(&file_size, sizeof(file_size));
+        offset = file_handle.Tell();
+        file_handle.Seek(offset + file_size);
+    }
+    const String path = file_handle.Path();
+    LoadFlashIndex(path, offsets[0], path, offsets[1], path, offsets[2]);
+}
+
+SizeT DiskAnnIndexInChunk::SearchIndex(const f32 *query, SizeT topk, SizeT search_list_size, SizeT beam_width, SegmentOffset *offsets) const {
+    if (flash_index_.get() == nullptr || topk == 0) {
+        return 0;
+    }
+    // the sector reads of one hop must fit in the sector scratch of a search
+    const SizeT max_node_len = std::ceil(R_ * DISKANN_GRAPH_SLACK_FACTOR) * sizeof(SizeT) + sizeof(u32) + dimension_ * sizeof(f32);
+    const SizeT sectors_per_node = (max_node_len + DISKANN_SECTOR_LEN - 1) / DISKANN_SECTOR_LEN;
+    beam_width = std::clamp<SizeT>(beam_width, 1, std::max<SizeT>(DISKANN_MAX_N_SECTOR_READS / sectors_per_node, 1));
+    const SizeT l_search = std::max(search_list_size, topk);
+    auto indices = MakeUniqueForOverwrite<u64[]>(topk);
+    const SizeT result_n = flash_index_->CachedBeamSearch(query, topk, l_search, indices.get(), nullptr, beam_width);
+    for (SizeT i = 0; i < result_n; ++i) {
+        offsets[i] = start_segment_offset_ + indices[i];
+    }
+    return result_n;
+}
+
+void DiskAnnIndexInChunk::LoadFlashIndex(const String &pq_pivot_path,
+                                         u64 pq_pivot_offset,
+                                         const String &pq_compressed_path,
+                                         u64 pq_compressed_offset,
+                                         const String &graph_path,
+                                         u64 graph_offset) {
+    const DiskAnnMetricType metric = metric_ == MetricType::kMetricCosine ? DiskAnnMetricType::Cosine : DiskAnnMetricType::L2;
+    flash_index_ = PqFlashIndex<f32, SizeT>::Make(metric, dimension_, row_count_, num_pq_chunks_);
+    flash_index_->Load(pq_pivot_path,
+                       pq_pivot_offset,
+                       pq_compressed_path,
+                       pq_compressed_offset,
+                       graph_path,
+                       graph_offset,
+                       DISKANN_SEARCH_SCRATCH_NUM);
+    // the nodes near the entry point are visited by every search, keep them in memory
+    const u64 num_nodes_to_cache = std::min<u64>(DISKANN_NUM_NODES_TO_CACHE, row_count_ / 10);
+    if (num_nodes_to_cache > 0) {
+        Vector<SizeT> node_list;
+        flash_index_->CacheBfsLevels(num_nodes_to_cache, node_list);
+        flash_index_->LoadCacheList(node_list);
+    }
+}
+
+String DiskAnnIndexInChunk::PqPivotPath() const { return Path(work_dir_) / "pq_pivot.bin"; }
+
+String DiskAnnIndexInChunk::PqCompressedPath() const { return Path(work_dir_) / "pqCompressed_data.bin"; }
+
+String DiskAnnIndexInChunk::GraphPath() const { return Path(work_dir_) / "index.bin"; }
+
+} // namespace infinity
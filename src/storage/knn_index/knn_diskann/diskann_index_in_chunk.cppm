@@ -0,0 +1,95 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+export module diskann_index_in_chunk;
+
+import stl;
+import internal_types;
+import pq_flash_index;
+import index_base;
+
+namespace infinity {
+
+// the beam search ranks by the full vectors but ignores the filter, fetch more candidates for the rows filtered out later
+export constexpr SizeT kDiskAnnFilterFetchFactor = 4;
+
+class LocalFileHandle;
+class IndexDiskAnn;
+struct SegmentEntry;
+class ColumnDef;
+class BufferManager;
+
+// The diskann index of a chunk: a vamana graph built when the chunk is dumped, laid out on disk with the full vectors,
+// and the pq codes of the vectors kept in memory. A search reads the graph sectors of each hop in one batch, see `AlignedFileReader`.
+// The chunk file holds the pq pivots, the pq codes and the graph. A loaded chunk reads the graph with positional reads at its offset of
+// the chunk file, `work_dir` only holds the files of a build until the chunk is saved.
+// The node id of a row is its offset from the start of the chunk.
+export class DiskAnnIndexInChunk {
+public:
+    DiskAnnIndexInChunk(SegmentOffset start_segment_offset, const IndexDiskAnn *index_diskann, u32 dimension, String work_dir);
+
+    ~DiskAnnIndexInChunk();
+
+    DiskAnnIndexInChunk(const DiskAnnIndexInChunk &) = delete;
+    DiskAnnIndexInChunk &operator=(const DiskAnnIndexInChunk &) = delete;
+
+    // the graph needs more rows than the centers of a pq chunk
+    static bool CanBuild(u32 row_count);
+
+    void BuildDiskAnnIndex(RowID base_rowid, u32 row_count, const SegmentEntry *segment_entry, const ColumnDef *column_def, BufferManager *buffer_mgr);
+
+    // build from `row_count` vectors laid out one after another
+    void BuildDiskAnnIndex(const f32 *vectors, u32 row_count);
+
+    void SaveIndexInner(LocalFileHandle &file_handle) const;
+
+    void ReadIndexInner(LocalFileHandle &file_handle);
+
+    // beam search of one f32 query, results are sorted by the distance of the full vectors, returns the number of results
+    SizeT SearchIndex(const f32 *query, SizeT topk, SizeT search_list_size, SizeT beam_width, SegmentOffset *offsets) const;
+
+    u32 row_count() const { return row_count_; }
+
+    SegmentOffset start_segment_offset() const { return start_segment_offset_; }
+
+private:
+    void CheckBuild(u32 row_count);
+
+    void BuildFromDataFile(const String &data_path, u32 row_count);
+
+    void LoadFlashIndex(const String &pq_pivot_path,
+                        u64 pq_pivot_offset,
+                        const String &pq_compressed_path,
+                        u64 pq_compressed_offset,
+                        const String &graph_path,
+                        u64 graph_offset);
+
+    String PqPivotPath() const;
+    String PqCompressedPath() const;
+    String GraphPath() const;
+
+    const SegmentOffset start_segment_offset_ = 0;
+    const MetricType metric_ = MetricType::kInvalid;
+    const u32 dimension_ = 0;
+    const u32 R_ = 0;
+    const u32 L_ = 0;
+    const u32 num_pq_chunks_ = 0;
+    u32 row_count_ = 0;
+    const String work_dir_;
+    UniquePtr<PqFlashIndex<f32, SizeT>> flash_index_;
+};
+
+} // namespace infinity
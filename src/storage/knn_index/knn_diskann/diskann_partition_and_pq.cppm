@@ -432,7 +432,8 @@ private:
 public:
     FixedChunkPQTable(u64 ndims, u64 n_chunks) : ndims_(ndims), n_chunks_(n_chunks) {}
     ~FixedChunkPQTable() = default;
-    void LoadPqCentroidBin(const std::string &pq_table_file, SizeT num_chunks) {
+    // the table starts at `base_offset` of the file
+    void LoadPqCentroidBin(const std::string &pq_table_file, SizeT num_chunks, u64 base_offset = 0) {
         // read meta data
         UniquePtr<SizeT[]> file_offset_data = MakeUnique<SizeT[]>(4); // offset of pq_table_file
         auto [pq_table_handle, status] = VirtualStore::Open(pq_table_file, FileAccessMode::kRead);
@@ -440,7 +441,11 @@ public:
             UnrecoverableError(status.message());
         }
         LOG_DEBUG(fmt::format("read meta data"));
+        pq_table_handle->Seek(base_offset);
         pq_table_handle->Read(file_offset_data.get(), 4 * sizeof(SizeT));
+        for (SizeT i = 0; i < 4; ++i) {
+            file_offset_data[i] += base_offset;
+        }
 
         // read table data
         u64 num_centers = (file_offset_data[1] - file_offset_data[0]) / (ndims_ * sizeof(f32)); // rows of table
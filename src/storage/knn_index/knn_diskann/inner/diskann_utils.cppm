@@ -16,7 +16,17 @@ module;
 
 #include <boost/dynamic_bitset.hpp>
 #include <cassert>
+#include <cerrno>
 #include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define DISKANN_USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
 
 import stl;
 import third_party;
@@ -64,44 +74,252 @@ export struct AlignedRead {
     }
 };
 
-// reader of disk index, async = false for now
+#ifdef DISKANN_USE_IO_URING
+// A minimal io_uring ring driven by raw syscalls, used to submit all sector reads of one beam search hop at once.
+// Each search thread owns a ring, see `AlignedFileReader::Read`.
+export class IoUringRing {
+public:
+    explicit IoUringRing(u32 entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ring_fd_ < 0) {
+            return;
+        }
+        sq_entries_ = params.sq_entries;
+        sq_map_size_ = params.sq_off.array + params.sq_entries * sizeof(u32);
+        cq_map_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) {
+            sq_map_size_ = cq_map_size_ = std::max(sq_map_size_, cq_map_size_);
+        }
+        sq_ptr_ = mmap(nullptr, sq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+        if (sq_ptr_ == MAP_FAILED) {
+            Destroy();
+            return;
+        }
+        if (single_mmap) {
+            cq_ptr_ = sq_ptr_;
+        } else {
+            cq_ptr_ = mmap(nullptr, cq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+            if (cq_ptr_ == MAP_FAILED) {
+                Destroy();
+                return;
+            }
+        }
+        sqes_map_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqes = mmap(nullptr, sqes_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            Destroy();
+            return;
+        }
+        sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+        char *sq = static_cast<char *>(sq_ptr_);
+        sq_tail_ = reinterpret_cast<u32 *>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<u32 *>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<u32 *>(sq + params.sq_off.array);
+        char *cq = static_cast<char *>(cq_ptr_);
+        cq_head_ = reinterpret_cast<u32 *>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<u32 *>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<u32 *>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    }
+
+    ~IoUringRing() { Destroy(); }
+
+    IoUringRing(const IoUringRing &) = delete;
+    IoUringRing &operator=(const IoUringRing &) = delete;
+
+    bool ok() const { return sqes_ != nullptr; }
+
+    // Read all requests, `done[i]` is set for the requests fully read.
+    // Returns false if the ring is broken, the requests not done must then be read synchronously.
+    bool Read(int fd, const Vector<AlignedRead> &read_reqs, Vector<bool> &done) {
+        for (SizeT batch_begin = 0; batch_begin < read_reqs.size(); batch_begin += sq_entries_) {
+            const SizeT batch_end = std::min(read_reqs.size(), batch_begin + sq_entries_);
+            const u32 batch_size = batch_end - batch_begin;
+            u32 tail = *sq_tail_;
+            for (SizeT i = batch_begin; i < batch_end; ++i, ++tail) {
+                const u32 idx = tail & sq_mask_;
+                io_uring_sqe *sqe = &sqes_[idx];
+                std::memset(sqe, 0, sizeof(*sqe));
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = fd;
+                sqe->off = read_reqs[i].offset;
+                sqe->addr = reinterpret_cast<u64>(read_reqs[i].buf);
+                sqe->len = read_reqs[i].len;
+                sqe->user_data = i;
+                sq_array_[idx] = idx;
+            }
+            __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+            u32 submitted = 0;
+            while (submitted < batch_size) {
+                int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, batch_size - submitted, 0, 0, nullptr, 0));
+                if (ret < 0) {
+                    if (errno == EINTR || errno == EAGAIN) {
+                        continue;
+                    }
+                    Destroy();
+                    return false;
+                }
+                submitted += ret;
+            }
+
+            u32 completed = 0;
+            while (completed < batch_size) {
+                u32 head = *cq_head_;
+                if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+                    int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+                    if (ret < 0 && errno != EINTR && errno != EAGAIN) {
+                        Destroy();
+                        return false;
+                    }
+                    continue;
+                }
+                const io_uring_cqe *cqe = &cqes_[head & cq_mask_];
+                const SizeT req_idx = cqe->user_data;
+                // a failed or short read is retried synchronously
+                done[req_idx] = cqe->res >= 0 && static_cast<u64>(cqe->res) == read_reqs[req_idx].len;
+                __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+                ++completed;
+            }
+        }
+        return true;
+    }
+
+private:
+    void Destroy() {
+        if (sqes_ != nullptr) {
+            munmap(sqes_, sqes_map_size_);
+            sqes_ = nullptr;
+        }
+        if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) {
+            munmap(cq_ptr_, cq_map_size_);
+        }
+        cq_ptr_ = MAP_FAILED;
+        if (sq_ptr_ != MAP_FAILED) {
+            munmap(sq_ptr_, sq_map_size_);
+            sq_ptr_ = MAP_FAILED;
+        }
+        if (ring_fd_ >= 0) {
+            close(ring_fd_);
+            ring_fd_ = -1;
+        }
+    }
+
+    int ring_fd_ = -1;
+    u32 sq_entries_ = 0;
+    SizeT sq_map_size_ = 0;
+    SizeT cq_map_size_ = 0;
+    SizeT sqes_map_size_ = 0;
+    void *sq_ptr_ = MAP_FAILED;
+    void *cq_ptr_ = MAP_FAILED;
+    io_uring_sqe *sqes_ = nullptr;
+    u32 *sq_tail_ = nullptr;
+    u32 sq_mask_ = 0;
+    u32 *sq_array_ = nullptr;
+    u32 *cq_head_ = nullptr;
+    u32 *cq_tail_ = nullptr;
+    u32 cq_mask_ = 0;
+    io_uring_cqe *cqes_ = nullptr;
+};
+#else
+// io_uring is not available, every read is synchronous
+export class IoUringRing {
+public:
+    explicit IoUringRing(u32) {}
+
+    bool ok() const { return false; }
+
+    bool Read(int, const Vector<AlignedRead> &, Vector<bool> &) { return false; }
+};
+#endif
+
+// reader of disk index, reads are positional so that concurrent searches can share the reader
+// The offsets of the reads are from `base_offset_`, where the disk index starts in its file.
 export class AlignedFileReader {
     using This = AlignedFileReader;
 
 private:
     u64 file_sz_;
+    u64 base_offset_ = 0;
     UniquePtr<LocalFileHandle> file_desc_;
 
 public:
     AlignedFileReader() : file_sz_(0), file_desc_(nullptr) {}
 
-    AlignedFileReader(This &&other) : file_sz_(other.file_sz_), file_desc_(std::move(other.file_desc_)) {}
+    AlignedFileReader(This &&other) : file_sz_(other.file_sz_), base_offset_(other.base_offset_), file_desc_(std::move(other.file_desc_)) {}
 
     ~AlignedFileReader() = default;
 
     static UniquePtr<This> Make() { return MakeUnique<This>(); }
 
+    // async = true submits all requests at once through the io_uring ring of the calling thread,
+    // and falls back to synchronous reads if io_uring is not available
     void Read(std::vector<AlignedRead> &read_reqs, bool async = false) {
-        if (async) {
-            Status status = Status::NotSupport("DiskAnn(): Async read not supported yet");
-            RecoverableError(status);
+        if (async && read_reqs.size() > 1) {
+            thread_local IoUringRing ring(DISKANN_MAX_N_SECTOR_READS);
+            Read(read_reqs, ring);
+            return;
         }
+        const int fd = file_desc_->FileDescriptor();
+        for (const AlignedRead &read_req : read_reqs) {
+            ReadSync(fd, read_req);
+        }
+    }
 
-        for (SizeT reqs = 0; reqs < read_reqs.size(); reqs++) {
-            file_desc_->Seek(read_reqs[reqs].offset);
-            file_desc_->Read(read_reqs[reqs].buf, read_reqs[reqs].len);
+    // read through `ring`, the requests it fails to read, or all of them if its setup failed, are read by pread
+    void Read(std::vector<AlignedRead> &read_reqs, IoUringRing &ring) {
+        const int fd = file_desc_->FileDescriptor();
+        Vector<bool> done(read_reqs.size(), false);
+        if (ring.ok()) {
+            std::vector<AlignedRead> file_reqs;
+            if (base_offset_ > 0) {
+                file_reqs = read_reqs;
+                for (AlignedRead &read_req : file_reqs) {
+                    read_req.offset += base_offset_;
+                }
+            }
+            if (!ring.Read(fd, base_offset_ > 0 ? file_reqs : read_reqs, done)) {
+                LOG_WARN("DiskAnn(): io_uring read failed, fall back to synchronous reads");
+            }
+        }
+        for (SizeT i = 0; i < read_reqs.size(); ++i) {
+            if (!done[i]) {
+                ReadSync(fd, read_reqs[i]);
+            }
         }
     }
 
-    void Open(const std::string &file_path) {
+    void Open(const std::string &file_path, u64 base_offset = 0) {
         auto [data_file_handle, status] = VirtualStore::Open(file_path, FileAccessMode::kRead);
         if (!status.ok()) {
             UnrecoverableError(status.message());
         }
+        file_sz_ = data_file_handle->FileSize();
+        base_offset_ = base_offset;
         file_desc_ = std::move(data_file_handle);
     }
 
     void Close() { file_desc_.reset(); }
+
+private:
+    void ReadSync(int fd, const AlignedRead &read_req) const {
+        u64 read_len = 0;
+        char *buf = static_cast<char *>(read_req.buf);
+        while (read_len < read_req.len) {
+            ssize_t ret = pread(fd, buf + read_len, read_req.len - read_len, base_offset_ + read_req.offset + read_len);
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ret <= 0) {
+                UnrecoverableError(fmt::format("DiskAnn(): read {} bytes at offset {} failed", read_req.len, read_req.offset));
+            }
+            read_len += ret;
+        }
+    }
 };
 
 export inline void AllocAligned(void **ptr, SizeT size, SizeT align) {
@@ -377,7 +595,7 @@ public:
         SizeT coord_alloc_size = RoundUp(sizeof(DataType) * aligned_dim, 256);
 
         AllocAligned((void **)&coord_scratch_, coord_alloc_size, 256);
-        AllocAligned((void **)&sector_scratch_, DISKANN_MAX_N_SECTOR_READS * DISKANN_SECTOR_LEN, 256);
+        AllocAligned((void **)&sector_scratch_, DISKANN_MAX_N_SECTOR_READS * DISKANN_SECTOR_LEN, DISKANN_SECTOR_LEN);
         AllocAligned((void **)&this->aligned_query_T_, sizeof(DataType) * aligned_dim, 8 * sizeof(DataType));
 
         this->pq_scratch_ = new PQScratch<DataType>(DISKANN_MAX_GRAPH_DEGREE, aligned_dim);
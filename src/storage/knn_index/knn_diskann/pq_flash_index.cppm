@@ -81,19 +81,30 @@ public:
         std::string pq_table_bin = index_prefix + "/pq_pivot.bin";
         std::string pq_compressed_vectors = index_prefix + "/pqCompressed_data.bin";
         std::string disk_index_file = index_prefix + "/index.bin";
+        return Load(pq_table_bin, 0, pq_compressed_vectors, 0, disk_index_file, 0, num_threads);
+    }
+
+    // each part starts at its offset of its file, the parts may be in one file
+    int Load(const std::string &pq_table_file,
+             u64 pq_table_offset,
+             const std::string &pq_compressed_file,
+             u64 pq_compressed_offset,
+             const std::string &disk_index_file,
+             u64 disk_index_offset,
+             u32 num_threads = 1) {
         this->disk_index_file_ = disk_index_file;
 
         // 1. load pq compressed vector
-        LoadPqCompressedVec(pq_compressed_vectors);
+        LoadPqCompressedVec(pq_compressed_file, pq_compressed_offset);
 
         // 2. load PQ table
-        pq_table_->LoadPqCentroidBin(pq_table_bin, n_chunks_);
+        pq_table_->LoadPqCentroidBin(pq_table_file, n_chunks_, pq_table_offset);
 
         // 3. load disk index meta data
-        LoadDiskIndexMetaData(disk_index_file);
+        LoadDiskIndexMetaData(disk_index_file, disk_index_offset);
 
         // 4. open reader for the disk index file
-        reader_->Open(disk_index_file);
+        reader_->Open(disk_index_file, disk_index_offset);
         this->max_nthreads_ = num_threads;
         this->SetupThreadData(num_threads);
 
@@ -257,7 +268,8 @@ public:
     }
 
     // Fourth step
-    void CachedBeamSearch(const VectorDataType *query1,
+    // returns the number of results, which is less than k_search if the search expanded less than k_search nodes
+    u64 CachedBeamSearch(const VectorDataType *query1,
                           const u64 k_search,
                           const u64 l_search,
                           u64 *indices,
@@ -369,7 +381,7 @@ public:
         u32 num_ios = 0;
 
         Vector<SizeT> frontier; // expanding nodes not found in cache in one iteration, needs to read from disk
-        frontier.push_back(2 * beam_width);
+        frontier.reserve(2 * beam_width);
         Vector<Pair<SizeT, char *>> frontier_nhoods; // store ptr in sector_scratch of frontier nodes' nhoods info read from disk
         frontier_nhoods.reserve(2 * beam_width);
         Vector<AlignedRead> frontier_read_reqs;
@@ -422,7 +434,7 @@ public:
                     }
                     num_ios++;
                 }
-                reader_->Read(frontier_read_reqs);
+                reader_->Read(frontier_read_reqs, true /*async*/); // all reads of one hop are in flight together
             }
 
             // 3. process cached nodes' nhoods
@@ -509,7 +521,8 @@ public:
         LOG_DEBUG(fmt::format("Beam search hops {}: {} nodes expanded, {} cmps,  {} ios", hops, full_retset.size(), cmps, num_ios));
         // copy the top k results to the output buffer
         std::sort(full_retset.begin(), full_retset.end());
-        for (u64 i = 0; i < k_search; i++) {
+        const u64 result_n = std::min<u64>(k_search, full_retset.size());
+        for (u64 i = 0; i < result_n; i++) {
             indices[i] = full_retset[i].id;
             auto key = indices[i];
             // filter
@@ -525,19 +538,21 @@ public:
                 }
             }
         }
-
-        // delete[] data;
+        return result_n;
     }
 
+    u64 num_points() const { return num_points_; }
+
 private:
     // read pq compressed vectors from disk to this->data_
-    void LoadPqCompressedVec(std::string pq_compressed_vectors_path) {
+    void LoadPqCompressedVec(const std::string &pq_compressed_vectors_path, u64 offset) {
         this->data_ = MakeUnique<u8[]>(this->num_points_ * this->n_chunks_);
         auto read_buf = MakeUnique<u32[]>(this->num_points_ * this->n_chunks_ * sizeof(u32));
         auto [pq_data_handle, status] = VirtualStore::Open(pq_compressed_vectors_path, FileAccessMode::kRead);
         if (!status.ok()) {
             UnrecoverableError(status.message());
         }
+        pq_data_handle->Seek(offset);
 
         pq_data_handle->Read(read_buf.get(), this->num_points_ * this->n_chunks_ * sizeof(u32));
         for (u64 i = 0; i < this->num_points_ * this->n_chunks_; i++) {
@@ -602,7 +617,7 @@ private:
             read_reqs.push_back(read);
         }
 
-        reader_->Read(read_reqs);
+        reader_->Read(read_reqs, true /*async*/);
         // reader reads all sectors of node in disk index, so it needs to extract node data
         for (u32 i = 0; i < read_reqs.size(); i++) {
             char *node_buf = OffsetToNode((char *)read_reqs[i].buf, node_ids[i]);
@@ -640,11 +655,12 @@ private:
     // locate the offset of the neighbor data from the start sector buffer(i.e. skip the vector data)
     inline u32 *OffsetToNodeNhood(char *node_buf) { return (u32 *)(node_buf + disk_bytes_per_point_); }
 
-    void LoadDiskIndexMetaData(const std::string &disk_index_file) {
+    void LoadDiskIndexMetaData(const std::string &disk_index_file, u64 offset) {
         auto [index_file_handle, status] = VirtualStore::Open(disk_index_file, FileAccessMode::kRead);
         if (!status.ok()) {
             UnrecoverableError(status.message());
         }
+        index_file_handle->Seek(offset);
 
         u64 disk_nnodes, disk_ndims;
         index_file_handle->Read(&disk_nnodes, sizeof(u64));
@@ -0,0 +1,203 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+#include <cmath>
+
+export module knn_flat_gemm;
+
+import stl;
+import knn_expr;
+import mlas_matrix_multiply;
+import infinity_exception;
+
+namespace infinity {
+
+// a block scan with at least this many queries computes the distances of the block by one GEMM. It is exact for u8 / i8 vectors, the
+// float vectors are only quantized with the knn option "gemm_quantize", since the scan is no longer exact then
+export constexpr SizeT kKnnFlatGemmMinQueryCount = 8;
+// candidates per result of the quantized GEMM of float vectors, which are reranked with the exact distances
+export constexpr SizeT kKnnFlatGemmRerankFactor = 4;
+
+// The distances of a batch of queries to a block of rows by one 8 bit GEMM, with both matrices as u8 so that the product is exact on
+// every CPU.
+// The u8 / i8 vectors are multiplied exactly. The float vectors are quantized to i8 on the fly, with one scale for each dimension of the
+// rows of the block and one for each query, and only rank the rows for an exact rerank.
+export class KnnFlatGemm {
+public:
+    KnnFlatGemm(const KnnDistanceType dist_type, const SizeT dim) : dist_type_(dist_type), dim_(dim) {
+        if (dist_type != KnnDistanceType::kL2 && dist_type != KnnDistanceType::kInnerProduct && dist_type != KnnDistanceType::kCosine) {
+            UnrecoverableError("KnnFlatGemm: unsupported distance type");
+        }
+    }
+
+    // distances[q * row_n + r], in the distance of the knn scan
+    template <typename ElemType>
+        requires std::is_same_v<ElemType, u8> || std::is_same_v<ElemType, i8>
+    void Distances(const ElemType *queries, const SizeT query_n, const ElemType *rows, const SizeT row_n, f32 *distances) {
+        constexpr bool is_signed = std::is_same_v<ElemType, i8>;
+        // both matrices are u8, i8 is shifted by the zero point 128
+        const u8 *a = reinterpret_cast<const u8 *>(rows);
+        if constexpr (is_signed) {
+            a_.resize(row_n * dim_);
+            for (SizeT i = 0; i < row_n * dim_; ++i) {
+                a_[i] = static_cast<u8>(rows[i]) ^ 0x80;
+            }
+            a = a_.data();
+        }
+        const u8 *b = Transpose(queries, query_n);
+        constexpr u8 zero_point = is_signed ? 128 : 0;
+        products_.resize(row_n * query_n);
+        u8_matrixA_multiply_matrixB_output_to_C(a, zero_point, b, zero_point, row_n, query_n, dim_, products_.data());
+
+        Vector<i32> row_norms;
+        Vector<i32> query_norms;
+        if (dist_type_ != KnnDistanceType::kInnerProduct) {
+            row_norms = Norms(rows, row_n);
+            query_norms = Norms(queries, query_n);
+        }
+        for (SizeT q = 0; q < query_n; ++q) {
+            for (SizeT r = 0; r < row_n; ++r) {
+                const i32 ip = products_[r * query_n + q];
+                f32 &dist = distances[q * row_n + r];
+                switch (dist_type_) {
+                    case KnnDistanceType::kL2: {
+                        dist = static_cast<f32>(row_norms[r] + query_norms[q] - 2 * ip);
+                        break;
+                    }
+                    case KnnDistanceType::kInnerProduct: {
+                        dist = static_cast<f32>(ip);
+                        break;
+                    }
+                    default: {
+                        const f32 norm = std::sqrt(static_cast<f32>(row_norms[r]) * static_cast<f32>(query_norms[q]));
+                        dist = norm > 0 ? ip / norm : 0;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    // scores[q * row_n + r], smaller is better, of the quantized vectors
+    void RankScores(const f32 *queries, const SizeT query_n, const f32 *rows, const SizeT row_n, f32 *scores) {
+        // rows, with one scale for each dimension so that a dimension of large values does not take the precision of the others, and
+        // their exact norms
+        Vector<f32> dim_scales(dim_, 0);
+        for (SizeT r = 0; r < row_n; ++r) {
+            for (SizeT k = 0; k < dim_; ++k) {
+                dim_scales[k] = std::max(dim_scales[k], std::abs(rows[r * dim_ + k]));
+            }
+        }
+        Vector<f32> dim_inv_scales(dim_);
+        for (SizeT k = 0; k < dim_; ++k) {
+            dim_scales[k] /= 127;
+            dim_inv_scales[k] = dim_scales[k] > 0 ? 1 / dim_scales[k] : 0;
+        }
+        a_.resize(row_n * dim_);
+        Vector<f32> row_norms(row_n, 0);
+        for (SizeT r = 0; r < row_n; ++r) {
+            const f32 *row = rows + r * dim_;
+            for (SizeT k = 0; k < dim_; ++k) {
+                a_[r * dim_ + k] = static_cast<u8>(Quantize(row[k] * dim_inv_scales[k]) + 128);
+                row_norms[r] += row[k] * row[k];
+            }
+        }
+        // queries, with the scales of the dimensions folded in and one scale each, transposed to the matrix B
+        Vector<f32> query_scales(query_n);
+        Vector<f32> scaled_query(dim_);
+        b_.resize(dim_ * query_n);
+        for (SizeT q = 0; q < query_n; ++q) {
+            const f32 *query = queries + q * dim_;
+            for (SizeT k = 0; k < dim_; ++k) {
+                scaled_query[k] = query[k] * dim_scales[k];
+            }
+            query_scales[q] = MaxAbs(scaled_query.data(), dim_) / 127;
+            const f32 inv_scale = query_scales[q] > 0 ? 1 / query_scales[q] : 0;
+            for (SizeT k = 0; k < dim_; ++k) {
+                b_[k * query_n + q] = static_cast<u8>(Quantize(scaled_query[k] * inv_scale) + 128);
+            }
+        }
+        products_.resize(row_n * query_n);
+        u8_matrixA_multiply_matrixB_output_to_C(a_.data(), 128, b_.data(), 128, row_n, query_n, dim_, products_.data());
+
+        for (SizeT q = 0; q < query_n; ++q) {
+            const f32 scale = query_scales[q];
+            for (SizeT r = 0; r < row_n; ++r) {
+                const f32 ip = products_[r * query_n + q] * scale;
+                f32 &score = scores[q * row_n + r];
+                switch (dist_type_) {
+                    case KnnDistanceType::kL2: {
+                        // the norm of the query is the same for all the rows
+                        score = row_norms[r] - 2 * ip;
+                        break;
+                    }
+                    case KnnDistanceType::kInnerProduct: {
+                        score = -ip;
+                        break;
+                    }
+                    default: {
+                        score = row_norms[r] > 0 ? -ip / std::sqrt(row_norms[r]) : 0;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    static i8 Quantize(const f32 x) { return static_cast<i8>(std::clamp<f32>(std::round(x), -127, 127)); }
+
+    static f32 MaxAbs(const f32 *x, const SizeT n) {
+        f32 res = 0;
+        for (SizeT i = 0; i < n; ++i) {
+            res = std::max(res, std::abs(x[i]));
+        }
+        return res;
+    }
+
+    template <typename ElemType>
+    Vector<i32> Norms(const ElemType *vectors, const SizeT n) const {
+        Vector<i32> norms(n, 0);
+        for (SizeT i = 0; i < n; ++i) {
+            for (SizeT k = 0; k < dim_; ++k) {
+                const i32 x = vectors[i * dim_ + k];
+                norms[i] += x * x;
+            }
+        }
+        return norms;
+    }
+
+    // the queries as the u8 matrix B, i8 is shifted by the zero point 128
+    template <typename ElemType>
+    const u8 *Transpose(const ElemType *queries, const SizeT query_n) {
+        constexpr u8 shift = std::is_same_v<ElemType, i8> ? 0x80 : 0;
+        b_.resize(dim_ * query_n);
+        for (SizeT q = 0; q < query_n; ++q) {
+            for (SizeT k = 0; k < dim_; ++k) {
+                b_[k * query_n + q] = static_cast<u8>(queries[q * dim_ + k]) ^ shift;
+            }
+        }
+        return b_.data();
+    }
+
+    const KnnDistanceType dist_type_;
+    const SizeT dim_;
+    Vector<u8> a_;
+    Vector<u8> b_;
+    Vector<i32> products_;
+};
+
+} // namespace infinity
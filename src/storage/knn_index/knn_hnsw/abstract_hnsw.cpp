@@ -61,15 +61,19 @@ HnswIndexInMem::HnswIndexInMem(RowID begin_row_id,
                                const ColumnDef *column_def,
                                SegmentIndexEntry *segment_index_entry,
                                bool trace)
-    : begin_row_id_(begin_row_id), hnsw_(InitAbstractIndex(index_base, column_def)), segment_index_entry_(segment_index_entry), trace_(trace),
-      own_memory_(true) {
+    : begin_row_id_(begin_row_id), hnsw_(InitAbstractIndex(index_base, column_def, true /*build_in_mem*/)), segment_index_entry_(segment_index_entry),
+      trace_(trace), own_memory_(true) {
     const auto *index_hnsw = static_cast<const IndexHnsw *>(index_base);
+    if (index_hnsw->encode_type_ == HnswEncodeType::kPQ || index_hnsw->encode_type_ == HnswEncodeType::kRaBitQ) {
+        dump_encode_type_ = index_hnsw->encode_type_;
+    }
+    pq_subspace_num_ = index_hnsw->pq_subspace_num_;
     const auto *embedding_info = static_cast<const EmbeddingInfo *>(column_def->type()->type_info().get());
 
     SizeT chunk_size = index_hnsw->block_size_;
     SizeT max_chunk_num = (DEFAULT_SEGMENT_CAPACITY - 1) / chunk_size + 1;
 
-    SizeT dim = embedding_info->Dimension();
+    SizeT dim = index_hnsw->IndexDimension(embedding_info);
     SizeT M = index_hnsw->M_;
     SizeT ef_construction = index_hnsw->ef_construction_;
     std::visit(
@@ -83,19 +87,32 @@ HnswIndexInMem::HnswIndexInMem(RowID begin_row_id,
         hnsw_);
 }
 
-AbstractHnsw HnswIndexInMem::InitAbstractIndex(const IndexBase *index_base, const ColumnDef *column_def) {
+AbstractHnsw HnswIndexInMem::InitAbstractIndex(const IndexBase *index_base, const ColumnDef *column_def, bool build_in_mem) {
     const auto *index_hnsw = static_cast<const IndexHnsw *>(index_base);
     const auto *embedding_info = static_cast<const EmbeddingInfo *>(column_def->type()->type_info().get());
 
     switch (embedding_info->Type()) {
         case EmbeddingDataType::kElemFloat: {
-            return InitAbstractIndex<float>(index_hnsw);
+            return InitAbstractIndex<float>(index_hnsw, build_in_mem);
         }
         case EmbeddingDataType::kElemUInt8: {
-            return InitAbstractIndex<u8>(index_hnsw);
+            return InitAbstractIndex<u8>(index_hnsw, build_in_mem);
         }
         case EmbeddingDataType::kElemInt8: {
-            return InitAbstractIndex<i8>(index_hnsw);
+            return InitAbstractIndex<i8>(index_hnsw, build_in_mem);
+        }
+        case EmbeddingDataType::kElemFloat16: {
+            return InitAbstractIndex<Float16T>(index_hnsw, build_in_mem);
+        }
+        case EmbeddingDataType::kElemBFloat16: {
+            return InitAbstractIndex<BFloat16T>(index_hnsw, build_in_mem);
+        }
+        case EmbeddingDataType::kElemBit: {
+            if (index_hnsw->encode_type_ != HnswEncodeType::kPlain || index_hnsw->metric_type_ != MetricType::kMetricHamming) {
+                return nullptr;
+            }
+            using HnswIndex = KnnHnsw<PlainHammingVecStoreType<u8>, SegmentOffset>;
+            return static_cast<HnswIndex *>(nullptr);
         }
         default: {
             return nullptr;
@@ -153,12 +170,12 @@ void HnswIndexInMem::InsertVecs(SizeT block_offset,
                 switch (const auto &column_data_type = block_column_entry->column_type(); column_data_type->type()) {
                     case LogicalType::kEmbedding: {
                         MemIndexInserterIter<DataType> iter(block_offset, block_column_entry, buffer_manager, row_offset, row_count);
-                        InsertVecs(index, std::move(iter), config, mem_usage);
+                        InsertVecsParallel(index, std::move(iter), config, mem_usage);
                         break;
                     }
                     case LogicalType::kMultiVector: {
                         MemIndexInserterIter<MultiVectorRef<DataType>> iter(block_offset, block_column_entry, buffer_manager, row_offset, row_count);
-                        InsertVecs(index, std::move(iter), config, mem_usage);
+                        InsertVecsParallel(index, std::move(iter), config, mem_usage);
                         break;
                     }
                     default: {
@@ -191,10 +208,10 @@ void HnswIndexInMem::InsertVecs(const SegmentEntry *segment_entry,
                     case LogicalType::kEmbedding: {
                         if (check_ts) {
                             OneColumnIterator<DataType> iter(segment_entry, buffer_mgr, column_id, begin_ts);
-                            InsertVecs(index, std::move(iter), config, mem_usage);
+                            InsertVecsParallel(index, std::move(iter), config, mem_usage);
                         } else {
                             OneColumnIterator<DataType, false> iter(segment_entry, buffer_mgr, column_id, begin_ts);
-                            InsertVecs(index, std::move(iter), config, mem_usage);
+                            InsertVecsParallel(index, std::move(iter), config, mem_usage);
                         }
                         break;
                     }
@@ -202,10 +219,10 @@ void HnswIndexInMem::InsertVecs(const SegmentEntry *segment_entry,
                         const auto ele_size = column_data_type->type_info()->Size();
                         if (check_ts) {
                             OneColumnIterator<MultiVectorRef<DataType>> iter(segment_entry, buffer_mgr, column_id, begin_ts, ele_size);
-                            InsertVecs(index, std::move(iter), config, mem_usage);
+                            InsertVecsParallel(index, std::move(iter), config, mem_usage);
                         } else {
                             OneColumnIterator<MultiVectorRef<DataType>, false> iter(segment_entry, buffer_mgr, column_id, begin_ts, ele_size);
-                            InsertVecs(index, std::move(iter), config, mem_usage);
+                            InsertVecsParallel(index, std::move(iter), config, mem_usage);
                         }
                         break;
                     }
@@ -225,6 +242,15 @@ SharedPtr<ChunkIndexEntry> HnswIndexInMem::Dump(SegmentIndexEntry *segment_index
     SizeT index_size = 0;
     SizeT dump_size = 0;
     trace_ = false;
+    std::visit(
+        [&](auto &&index) {
+            using T = std::decay_t<decltype(index)>;
+            if constexpr (!std::is_same_v<T, std::nullptr_t>) {
+                dump_size = index->mem_usage();
+            }
+        },
+        hnsw_);
+    CompressOnDump();
     std::visit(
         [&](auto &&index) {
             using T = std::decay_t<decltype(index)>;
@@ -233,7 +259,6 @@ SharedPtr<ChunkIndexEntry> HnswIndexInMem::Dump(SegmentIndexEntry *segment_index
             } else {
                 row_count = index->GetVecNum();
                 index_size = index->GetSizeInBytes();
-                dump_size = index->mem_usage();
             }
         },
         hnsw_);
@@ -250,6 +275,40 @@ SharedPtr<ChunkIndexEntry> HnswIndexInMem::Dump(SegmentIndexEntry *segment_index
     return new_chunk_indey_entry;
 }
 
+void HnswIndexInMem::CompressOnDump() {
+    if (dump_encode_type_ == HnswEncodeType::kPlain) {
+        return;
+    }
+    std::visit(
+        [&](auto &&index) {
+            using T = std::decay_t<decltype(index)>;
+            if constexpr (!std::is_same_v<T, std::nullptr_t>) {
+                using IndexT = std::decay_t<decltype(*index)>;
+                using VecStoreT = typename IndexT::VecStoreT;
+                if constexpr (std::is_same_v<typename IndexT::DataType, float>) {
+                    if constexpr (PQCompressible<VecStoreT>) {
+                        if (dump_encode_type_ == HnswEncodeType::kPQ) {
+                            auto *p = std::move(*index).CompressToPQ(pq_subspace_num_).release();
+                            delete index;
+                            hnsw_ = p;
+                            return;
+                        }
+                    }
+                    if constexpr (RaBitQCompressible<VecStoreT>) {
+                        if (dump_encode_type_ == HnswEncodeType::kRaBitQ) {
+                            auto *p = std::move(*index).CompressToRaBitQ().release();
+                            delete index;
+                            hnsw_ = p;
+                            return;
+                        }
+                    }
+                }
+            }
+        },
+        hnsw_);
+    dump_encode_type_ = HnswEncodeType::kPlain;
+}
+
 TableIndexEntry *HnswIndexInMem::table_index_entry() const { return segment_index_entry_->table_index_entry(); }
 
 MemIndexTracerInfo HnswIndexInMem::GetInfo() const {
@@ -59,9 +59,22 @@ export using AbstractHnsw = std::variant<KnnHnsw<PlainCosVecStoreType<float>, Se
                                          KnnHnsw<PlainCosVecStoreType<i8>, SegmentOffset> *,
                                          KnnHnsw<PlainIPVecStoreType<i8>, SegmentOffset> *,
                                          KnnHnsw<PlainL2VecStoreType<i8>, SegmentOffset> *,
+                                         KnnHnsw<PlainCosVecStoreType<Float16T>, SegmentOffset> *,
+                                         KnnHnsw<PlainIPVecStoreType<Float16T>, SegmentOffset> *,
+                                         KnnHnsw<PlainL2VecStoreType<Float16T>, SegmentOffset> *,
+                                         KnnHnsw<PlainCosVecStoreType<BFloat16T>, SegmentOffset> *,
+                                         KnnHnsw<PlainIPVecStoreType<BFloat16T>, SegmentOffset> *,
+                                         KnnHnsw<PlainL2VecStoreType<BFloat16T>, SegmentOffset> *,
                                          KnnHnsw<LVQCosVecStoreType<float, i8>, SegmentOffset> *,
                                          KnnHnsw<LVQIPVecStoreType<float, i8>, SegmentOffset> *,
                                          KnnHnsw<LVQL2VecStoreType<float, i8>, SegmentOffset> *,
+                                         KnnHnsw<PQCosVecStoreType<float>, SegmentOffset> *,
+                                         KnnHnsw<PQIPVecStoreType<float>, SegmentOffset> *,
+                                         KnnHnsw<PQL2VecStoreType<float>, SegmentOffset> *,
+                                         KnnHnsw<RaBitQCosVecStoreType<float>, SegmentOffset> *,
+                                         KnnHnsw<RaBitQIPVecStoreType<float>, SegmentOffset> *,
+                                         KnnHnsw<RaBitQL2VecStoreType<float>, SegmentOffset> *,
+                                         KnnHnsw<PlainHammingVecStoreType<u8>, SegmentOffset> *,
                                          std::nullptr_t>;
 
 export struct HnswIndexInMem : public BaseMemIndex {
@@ -75,8 +88,13 @@ public:
 
 private:
     template <typename DataType>
-    static AbstractHnsw InitAbstractIndex(const IndexHnsw *index_hnsw) {
-        switch (index_hnsw->encode_type_) {
+    static AbstractHnsw InitAbstractIndex(const IndexHnsw *index_hnsw, bool build_in_mem) {
+        HnswEncodeType encode_type = index_hnsw->encode_type_;
+        if (build_in_mem && (encode_type == HnswEncodeType::kPQ || encode_type == HnswEncodeType::kRaBitQ)) {
+            // the quantizer is trained when dumping, so the graph is built on plain vectors
+            encode_type = HnswEncodeType::kPlain;
+        }
+        switch (encode_type) {
             case HnswEncodeType::kPlain: {
                 switch (index_hnsw->metric_type_) {
                     case MetricType::kMetricL2: {
@@ -97,7 +115,7 @@ private:
                 }
             }
             case HnswEncodeType::kLVQ: {
-                if constexpr (std::is_same_v<DataType, u8> || std::is_same_v<DataType, i8>) {
+                if constexpr (!std::is_same_v<DataType, float>) {
                     return nullptr;
                 } else {
                     switch (index_hnsw->metric_type_) {
@@ -119,15 +137,69 @@ private:
                     }
                 }
             }
+            case HnswEncodeType::kPQ: {
+                if constexpr (!std::is_same_v<DataType, float>) {
+                    return nullptr;
+                } else {
+                    switch (index_hnsw->metric_type_) {
+                        case MetricType::kMetricL2: {
+                            using HnswIndex = KnnHnsw<PQL2VecStoreType<DataType>, SegmentOffset>;
+                            return static_cast<HnswIndex *>(nullptr);
+                        }
+                        case MetricType::kMetricInnerProduct: {
+                            using HnswIndex = KnnHnsw<PQIPVecStoreType<DataType>, SegmentOffset>;
+                            return static_cast<HnswIndex *>(nullptr);
+                        }
+                        case MetricType::kMetricCosine: {
+                            using HnswIndex = KnnHnsw<PQCosVecStoreType<DataType>, SegmentOffset>;
+                            return static_cast<HnswIndex *>(nullptr);
+                        }
+                        default: {
+                            return nullptr;
+                        }
+                    }
+                }
+            }
+            case HnswEncodeType::kRaBitQ: {
+                if constexpr (!std::is_same_v<DataType, float>) {
+                    return nullptr;
+                } else {
+                    switch (index_hnsw->metric_type_) {
+                        case MetricType::kMetricL2: {
+                            using HnswIndex = KnnHnsw<RaBitQL2VecStoreType<DataType>, SegmentOffset>;
+                            return static_cast<HnswIndex *>(nullptr);
+                        }
+                        case MetricType::kMetricInnerProduct: {
+                            using HnswIndex = KnnHnsw<RaBitQIPVecStoreType<DataType>, SegmentOffset>;
+                            return static_cast<HnswIndex *>(nullptr);
+                        }
+                        case MetricType::kMetricCosine: {
+                            using HnswIndex = KnnHnsw<RaBitQCosVecStoreType<DataType>, SegmentOffset>;
+                            return static_cast<HnswIndex *>(nullptr);
+                        }
+                        default: {
+                            return nullptr;
+                        }
+                    }
+                }
+            }
             default: {
                 return nullptr;
             }
         }
     }
 
+public:
+    // Stores the vectors of `iter` and links them into the graph with the hnsw build thread pool.
+    // Every worker takes the next `kBuildBatchSize` vertices in insertion order, so that the concurrently inserted vertices are close in
+    // the order and a slow batch does not keep the other workers idle.
+    template <typename Iter, typename Index>
+    static void InsertVecsParallel(Index &index, Iter &&iter, const HnswInsertConfig &config, SizeT &mem_usage) {
+        InsertVecsParallel(index, std::forward<Iter>(iter), config, mem_usage, InfinityContext::instance().GetHnswBuildThreadPool());
+    }
+
     template <typename Iter, typename Index>
-    static void InsertVecs(Index &index, Iter &&iter, const HnswInsertConfig &config, SizeT &mem_usage) {
-        auto &thread_pool = InfinityContext::instance().GetHnswBuildThreadPool();
+    static void InsertVecsParallel(Index &index, Iter &&iter, const HnswInsertConfig &config, SizeT &mem_usage, ThreadPool &thread_pool) {
         if (thread_pool.size() == 0) {
             UnrecoverableError("Hnsw build thread pool is not initialized.");
         }
@@ -135,17 +207,24 @@ private:
         if constexpr (!std::is_same_v<T, std::nullptr_t>) {
             SizeT mem1 = index->mem_usage();
             auto [start, end] = index->StoreData(std::forward<Iter>(iter), config);
-            SizeT bucket_size = std::max(kBuildBucketSize, SizeT(end - start - 1) / thread_pool.size() + 1);
-            SizeT bucket_n = (end - start - 1) / bucket_size + 1;
+            if (start == end) {
+                mem_usage = index->mem_usage() - mem1;
+                return;
+            }
+            SizeT batch_n = (end - start - 1) / kBuildBatchSize + 1;
+            SizeT worker_n = std::min(SizeT(thread_pool.size()), batch_n);
 
+            Atomic<SizeT> next_batch = 0;
             Vector<std::future<void>> futs;
-            futs.reserve(bucket_n);
-            for (SizeT i = 0; i < bucket_n; ++i) {
-                SizeT i1 = start + i * bucket_size;
-                SizeT i2 = std::min(i1 + bucket_size, SizeT(end));
-                futs.emplace_back(thread_pool.push([&index, i1, i2](int id) {
-                    for (SizeT j = i1; j < i2; ++j) {
-                        index->Build(j);
+            futs.reserve(worker_n);
+            for (SizeT i = 0; i < worker_n; ++i) {
+                futs.emplace_back(thread_pool.push([&index, &next_batch, start, end, batch_n](int id) {
+                    for (SizeT batch_i = next_batch.fetch_add(1); batch_i < batch_n; batch_i = next_batch.fetch_add(1)) {
+                        SizeT i1 = start + batch_i * kBuildBatchSize;
+                        SizeT i2 = std::min(i1 + kBuildBatchSize, SizeT(end));
+                        for (SizeT j = i1; j < i2; ++j) {
+                            index->Build(j);
+                        }
                     }
                 }));
             }
@@ -158,7 +237,7 @@ private:
     }
 
 public:
-    static AbstractHnsw InitAbstractIndex(const IndexBase *index_base, const ColumnDef *column_def);
+    static AbstractHnsw InitAbstractIndex(const IndexBase *index_base, const ColumnDef *column_def, bool build_in_mem = false);
 
     HnswIndexInMem(const HnswIndexInMem &) = delete;
     HnswIndexInMem &operator=(const HnswIndexInMem &) = delete;
@@ -167,6 +246,8 @@ public:
 
     SizeT GetRowCount() const;
 
+    RowID GetBeginRowID() const { return begin_row_id_; }
+
     void InsertVecs(SizeT block_offset,
                     BlockColumnEntry *block_column_entry,
                     BufferManager *buffer_manager,
@@ -193,7 +274,9 @@ protected:
     MemIndexTracerInfo GetInfo() const override;
 
 private:
-    static constexpr SizeT kBuildBucketSize = 1024;
+    void CompressOnDump();
+
+    static constexpr SizeT kBuildBatchSize = 64;
 
     RowID begin_row_id_ = {};
     AbstractHnsw hnsw_ = nullptr;
@@ -202,6 +285,10 @@ private:
     bool trace_{};
     bool own_memory_{};
     BufferHandle chunk_handle_{};
+
+    // pq or rabitq encoding is applied to the plain index when dumping, kPlain if nothing to do
+    HnswEncodeType dump_encode_type_{HnswEncodeType::kPlain};
+    SizeT pq_subspace_num_{};
 };
 
 } // namespace infinity
\ No newline at end of file
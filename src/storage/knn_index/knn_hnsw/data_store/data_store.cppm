@@ -16,6 +16,7 @@ module;
 
 #include <cassert>
 #include <ostream>
+#include <sys/mman.h>
 #include <type_traits>
 
 export module data_store;
@@ -77,7 +78,7 @@ public:
         : chunk_size_(std::exchange(other.chunk_size_, 0)), max_chunk_n_(std::exchange(other.max_chunk_n_, 0)),
           chunk_shift_(std::exchange(other.chunk_shift_, 0)), cur_vec_num_(other.cur_vec_num_.exchange(0)),
           vec_store_meta_(std::move(other.vec_store_meta_)), graph_store_meta_(std::move(other.graph_store_meta_)),
-          inners_(std::exchange(other.inners_, nullptr)), mem_usage_(other.mem_usage_.exchange(0)) {}
+          inners_(std::exchange(other.inners_, nullptr)), mem_usage_(other.mem_usage_.exchange(0)), own_mem_(std::exchange(other.own_mem_, true)) {}
     DataStore &operator=(This &&other) {
         if (this != &other) {
             chunk_size_ = std::exchange(other.chunk_size_, 0);
@@ -88,6 +89,7 @@ public:
             graph_store_meta_ = std::move(other.graph_store_meta_);
             inners_ = std::exchange(other.inners_, nullptr);
             mem_usage_ = other.mem_usage_.exchange(0);
+            own_mem_ = std::exchange(other.own_mem_, true);
         }
         return *this;
     }
@@ -108,7 +110,10 @@ public:
         if constexpr (has_compress_type<VecStoreT>::value) {
             normalize = std::is_same_v<VecStoreMeta, typename LVQCosVecStoreType<DataType, typename VecStoreT::CompressType>::Meta>;
         }
-        VecStoreMeta vec_store_meta = VecStoreMeta::Make(dim, normalize);
+        return Make(chunk_size, max_chunk_n, VecStoreMeta::Make(dim, normalize), Mmax0, Mmax);
+    }
+
+    static This Make(SizeT chunk_size, SizeT max_chunk_n, VecStoreMeta &&vec_store_meta, SizeT Mmax0, SizeT Mmax) {
         GraphStoreMeta graph_store_meta = GraphStoreMeta::Make(Mmax0, Mmax);
         This ret(chunk_size, max_chunk_n, std::move(vec_store_meta), std::move(graph_store_meta));
         ret.cur_vec_num_ = 0;
@@ -187,8 +192,63 @@ public:
         return ret;
     }
 
+    void SaveToPtr(HnswPtrWriter &writer) const {
+        SizeT cur_vec_num = this->cur_vec_num();
+        auto [chunk_num, last_chunk_size] = ChunkInfo(cur_vec_num);
+
+        writer.Write(chunk_size_);
+        writer.Write(max_chunk_n_);
+        writer.Write(cur_vec_num);
+        vec_store_meta_.SaveToPtr(writer);
+        graph_store_meta_.SaveToPtr(writer);
+        writer.Align();
+        for (SizeT i = 0; i < chunk_num; ++i) {
+            SizeT chunk_size = (i < chunk_num - 1) ? chunk_size_ : last_chunk_size;
+            inners_[i].SaveToPtr(writer, chunk_size, vec_store_meta_, graph_store_meta_);
+        }
+    }
+
+    // the vectors, graph and labels are views of the memory, which is read only until `Materialize` is called
+    static This LoadFromPtr(HnswPtrReader &reader, bool lock_upper_layers) {
+        SizeT chunk_size = reader.Read<SizeT>();
+        SizeT max_chunk_n = reader.Read<SizeT>();
+        SizeT cur_vec_num = reader.Read<SizeT>();
+        VecStoreMeta vec_store_meta = VecStoreMeta::LoadFromPtr(reader);
+        GraphStoreMeta graph_store_meta = GraphStoreMeta::LoadFromPtr(reader);
+        reader.Align();
+
+        This ret = This(chunk_size, max_chunk_n, std::move(vec_store_meta), std::move(graph_store_meta));
+        ret.cur_vec_num_ = cur_vec_num;
+        ret.own_mem_ = false;
+
+        auto [chunk_num, last_chunk_size] = ret.ChunkInfo(cur_vec_num);
+        for (SizeT i = 0; i < chunk_num; ++i) {
+            SizeT cur_chunk_size = (i < chunk_num - 1) ? chunk_size : last_chunk_size;
+            ret.inners_[i] = Inner::LoadFromPtr(reader, cur_chunk_size, chunk_size, ret.vec_store_meta_, ret.graph_store_meta_, lock_upper_layers);
+        }
+        return ret;
+    }
+
+    // copy the memory of a data store loaded by `LoadFromPtr`, so that it can be modified
+    void Materialize() {
+        if (own_mem_) {
+            return;
+        }
+        SizeT mem_usage = 0;
+        auto [chunk_num, last_chunk_size] = ChunkInfo(cur_vec_num());
+        for (SizeT i = 0; i < chunk_num; ++i) {
+            SizeT cur_chunk_size = (i < chunk_num - 1) ? chunk_size_ : last_chunk_size;
+            inners_[i].Materialize(cur_chunk_size, chunk_size_, vec_store_meta_, graph_store_meta_, mem_usage);
+        }
+        mem_usage_.fetch_add(mem_usage);
+        own_mem_ = true;
+    }
+
+    bool own_mem() const { return own_mem_; }
+
     template <DataIteratorConcept<QueryVecType, LabelType> Iterator>
     Pair<SizeT, SizeT> AddVec(Iterator &&query_iter) {
+        Materialize();
         SizeT mem_usage = 0;
         SizeT cur_vec_num = this->cur_vec_num();
         SizeT start_idx = cur_vec_num;
@@ -217,6 +277,7 @@ public:
     template <DataIteratorConcept<QueryVecType, LabelType> Iterator>
     Pair<SizeT, SizeT> OptAddVec(Iterator &&query_iter) {
         if constexpr (VecStoreT::HasOptimize) {
+            Materialize();
             SizeT mem_usage = 0;
             SizeT cur_vec_num = this->cur_vec_num();
             auto [chunk_num, last_chunk_size] = ChunkInfo(cur_vec_num);
@@ -250,6 +311,13 @@ public:
     template <typename CompressVecStoreType>
     DataStore<CompressVecStoreType, LabelType> CompressToLVQ() &&;
 
+    // encode the vectors with a meta which is trained on the stored vectors
+    template <typename TrainedVecStoreType>
+    DataStore<TrainedVecStoreType, LabelType> CompressToTrained(typename TrainedVecStoreType::Meta meta) &&;
+
+    // renumber the vertices so that the neighbors of a vertex are stored close to it. A label moves with its vertex.
+    This Reorder(HnswReorderType reorder_type) &&;
+
     typename VecStoreT::QueryType MakeQuery(QueryVecType query) const { return vec_store_meta_.MakeQuery(query); }
 
     void PrefetchVec(SizeT vec_i) const {
@@ -310,6 +378,9 @@ private:
 
     Pair<const Inner &, SizeT> GetInner(SizeT vec_i) const { return {inners_[vec_i >> chunk_shift_], vec_i & (chunk_size_ - 1)}; }
 
+    // new2old[i] is the vertex which is renumbered to i
+    Vector<VertexType> ReorderPermutation(HnswReorderType reorder_type) const;
+
     // return chunk_num & last chunk size
     Pair<SizeT, SizeT> ChunkInfo(SizeT cur_vec_num) const {
         SizeT chunk_num = std::min(max_chunk_n_, (cur_vec_num >> chunk_shift_) + 1);
@@ -329,6 +400,7 @@ private:
 
     UniquePtr<Inner[]> inners_;
     Atomic<SizeT> mem_usage_ = 0;
+    bool own_mem_ = true;
 
 public:
     void Check() const {
@@ -388,7 +460,10 @@ public:
 private:
     DataStoreInner(SizeT chunk_size, VecStoreInner vec_store_inner, GraphStoreInner graph_store_inner)
         : vec_store_inner_(std::move(vec_store_inner)), graph_store_inner_(std::move(graph_store_inner)),
-          labels_(MakeUnique<LabelType[]>(chunk_size)), vertex_mutex_(MakeUnique<std::shared_mutex[]>(chunk_size)) {}
+          labels_(MakeUnique<LabelType[]>(chunk_size)), labels_p_(labels_.get()), vertex_mutex_(MakeUnique<std::shared_mutex[]>(chunk_size)) {}
+    DataStoreInner(SizeT chunk_size, VecStoreInner vec_store_inner, GraphStoreInner graph_store_inner, const LabelType *labels)
+        : vec_store_inner_(std::move(vec_store_inner)), graph_store_inner_(std::move(graph_store_inner)), labels_p_(const_cast<LabelType *>(labels)),
+          vertex_mutex_(MakeUnique<std::shared_mutex[]>(chunk_size)) {}
 
 public:
     DataStoreInner() = default;
@@ -412,7 +487,15 @@ public:
     void Save(LocalFileHandle &file_handle, SizeT cur_vec_num, const VecStoreMeta &vec_store_meta, const GraphStoreMeta &graph_store_meta) const {
         vec_store_inner_.Save(file_handle, cur_vec_num, vec_store_meta);
         graph_store_inner_.Save(file_handle, cur_vec_num, graph_store_meta);
-        file_handle.Append(labels_.get(), sizeof(LabelType) * cur_vec_num);
+        file_handle.Append(labels_p_, sizeof(LabelType) * cur_vec_num);
+    }
+
+    void SaveToPtr(HnswPtrWriter &writer, SizeT cur_vec_num, const VecStoreMeta &vec_store_meta, const GraphStoreMeta &graph_store_meta) const {
+        vec_store_inner_.SaveToPtr(writer, cur_vec_num, vec_store_meta);
+        writer.Align();
+        graph_store_inner_.SaveToPtr(writer, cur_vec_num, graph_store_meta);
+        writer.Write(labels_p_, sizeof(LabelType) * cur_vec_num);
+        writer.Align();
     }
 
     static This Load(LocalFileHandle &file_handle,
@@ -424,10 +507,34 @@ public:
         auto vec_store_inner = VecStoreInner::Load(file_handle, cur_vec_num, chunk_size, vec_store_meta, mem_usage);
         auto graph_store_iner = GraphStoreInner::Load(file_handle, cur_vec_num, chunk_size, graph_store_meta, mem_usage);
         This ret(chunk_size, std::move(vec_store_inner), std::move(graph_store_iner));
-        file_handle.Read(ret.labels_.get(), sizeof(LabelType) * cur_vec_num);
+        file_handle.Read(ret.labels_p_, sizeof(LabelType) * cur_vec_num);
         return ret;
     }
 
+    static This LoadFromPtr(HnswPtrReader &reader,
+                            SizeT cur_vec_num,
+                            SizeT chunk_size,
+                            const VecStoreMeta &vec_store_meta,
+                            const GraphStoreMeta &graph_store_meta,
+                            bool lock_upper_layers) {
+        const char *vec_begin = reader.Get(0);
+        auto vec_store_inner = VecStoreInner::LoadFromPtr(reader, cur_vec_num, vec_store_meta);
+        HnswMadvise(vec_begin, reader.Get(0) - vec_begin, MADV_RANDOM);
+        reader.Align();
+        auto graph_store_inner = GraphStoreInner::LoadFromPtr(reader, cur_vec_num, graph_store_meta, lock_upper_layers);
+        const auto *labels = reinterpret_cast<const LabelType *>(reader.Get(sizeof(LabelType) * cur_vec_num));
+        reader.Align();
+        return This(chunk_size, std::move(vec_store_inner), std::move(graph_store_inner), labels);
+    }
+
+    void Materialize(SizeT cur_vec_num, SizeT chunk_size, const VecStoreMeta &vec_store_meta, const GraphStoreMeta &graph_store_meta, SizeT &mem_usage) {
+        vec_store_inner_ = vec_store_inner_.ToOwned(cur_vec_num, chunk_size, vec_store_meta, mem_usage);
+        graph_store_inner_ = graph_store_inner_.ToOwned(cur_vec_num, chunk_size, graph_store_meta, mem_usage);
+        labels_ = MakeUnique<LabelType[]>(chunk_size);
+        Copy(labels_p_, labels_p_ + cur_vec_num, labels_.get());
+        labels_p_ = labels_.get();
+    }
+
     // vec store
     template <DataIteratorConcept<QueryVecType, LabelType> Iterator>
     Pair<SizeT, bool> AddVec(Iterator &&query_iter, VertexType start_idx, SizeT remain_num, const VecStoreMeta &meta, SizeT &mem_usage) {
@@ -437,7 +544,7 @@ public:
             if (auto ret = query_iter.Next(); ret) {
                 auto &[vec, label] = *ret;
                 vec_store_inner_.SetVec(start_idx + insert_n, vec, meta, mem_usage);
-                labels_[start_idx + insert_n] = label;
+                labels_p_[start_idx + insert_n] = label;
                 ++insert_n;
             } else {
                 used_up = true;
@@ -452,6 +559,18 @@ public:
     void PrefetchVec(VertexType vec_i, const VecStoreMeta &meta) const { vec_store_inner_.Prefetch(vec_i, meta); }
 
     // graph store
+    void CopyVertex(VertexType vec_i,
+                    const This &src,
+                    VertexType src_i,
+                    const VertexType *old2new,
+                    const VecStoreMeta &vec_store_meta,
+                    const GraphStoreMeta &graph_store_meta,
+                    SizeT &mem_usage) {
+        vec_store_inner_.CopyVec(vec_i, src.vec_store_inner_, src_i, vec_store_meta, mem_usage);
+        graph_store_inner_.CopyVertex(vec_i, src.graph_store_inner_, src_i, old2new, graph_store_meta, mem_usage);
+        labels_p_[vec_i] = src.labels_p_[src_i];
+    }
+
     void AddVertex(VertexType vec_i, i32 layer_n, const GraphStoreMeta &meta, SizeT &mem_usage) {
         graph_store_inner_.AddVertex(vec_i, layer_n, meta, mem_usage);
     }
@@ -463,7 +582,7 @@ public:
         return graph_store_inner_.GetNeighborsMut(vertex_i, layer_i, meta);
     }
 
-    LabelType GetLabel(VertexType vec_i) const { return labels_[vec_i]; }
+    LabelType GetLabel(VertexType vec_i) const { return labels_p_[vec_i]; }
 
     std::shared_lock<std::shared_mutex> SharedLock(VertexType vec_i) const { return std::shared_lock<std::shared_mutex>(vertex_mutex_[vec_i]); }
 
@@ -478,6 +597,7 @@ protected:
     VecStoreInner vec_store_inner_;
     GraphStoreInner graph_store_inner_;
     UniquePtr<LabelType[]> labels_;
+    LabelType *labels_p_ = nullptr; // `labels_` or the memory of a loaded file
 
 private:
     mutable UniquePtr<std::shared_mutex[]> vertex_mutex_;
@@ -491,7 +611,7 @@ public:
         vec_store_inner_.Dump(os, offset, chunk_size, meta);
         os << "labels: [";
         for (SizeT i = 0; i < chunk_size; ++i) {
-            os << labels_[i] << ", ";
+            os << labels_p_[i] << ", ";
         }
         os << "]" << std::endl;
     }
@@ -590,6 +710,7 @@ DataStore<CompressVecStoreType, LabelType> DataStore<VecStoreT, LabelType>::Comp
     if constexpr (std::is_same_v<CompressVecStoreType, VecStoreT>) {
         return std::move(*this);
     } else {
+        Materialize();
         const auto [chunk_num, last_chunk_size] = ChunkInfo(cur_vec_num());
         Vector<GraphStoreInner> graph_inners;
         for (SizeT i = 0; i < chunk_num; ++i) {
@@ -602,5 +723,134 @@ DataStore<CompressVecStoreType, LabelType> DataStore<VecStoreT, LabelType>::Comp
         return ret;
     }
 }
+template <typename VecStoreT, typename LabelType>
+template <typename TrainedVecStoreType>
+DataStore<TrainedVecStoreType, LabelType> DataStore<VecStoreT, LabelType>::CompressToTrained(typename TrainedVecStoreType::Meta meta) && {
+    using TrainedMeta = typename TrainedVecStoreType::Meta;
+    Materialize();
+    SizeT cur_vec_num = this->cur_vec_num();
+    const auto [chunk_num, last_chunk_size] = ChunkInfo(cur_vec_num);
+
+    // the meta is trained on a sample of the stored vectors
+    SizeT step = cur_vec_num == 0 ? 1 : (cur_vec_num - 1) / TrainedMeta::max_train_num_ + 1;
+    SizeT train_num = cur_vec_num == 0 ? 0 : (cur_vec_num - 1) / step + 1;
+    SizeT dim = this->dim();
+    auto train_data = MakeUniqueForOverwrite<DataType[]>(train_num * dim);
+    for (SizeT i = 0; i < train_num; ++i) {
+        const DataType *vec = GetVec(i * step);
+        Copy(vec, vec + dim, train_data.get() + i * dim);
+    }
+    meta.Train(train_data.get(), train_num);
+    train_data.reset();
+
+    Vector<GraphStoreInner> graph_inners;
+    for (SizeT i = 0; i < chunk_num; ++i) {
+        graph_inners.emplace_back(std::move(*inners_[i].graph_store_inner()));
+    }
+    auto ret = DataStore<TrainedVecStoreType, LabelType>::Make(chunk_size_, max_chunk_n_, std::move(meta), Mmax0(), Mmax());
+    ret.AddVec(DataStoreIter<VecStoreT, LabelType>(this));
+    ret.SetGraph(std::move(graph_store_meta_), std::move(graph_inners));
+    this->inners_ = nullptr;
+    return ret;
+}
+
+template <typename VecStoreT, typename LabelType>
+Vector<VertexType> DataStore<VecStoreT, LabelType>::ReorderPermutation(HnswReorderType reorder_type) const {
+    const VertexType vertex_n = cur_vec_num();
+    Vector<VertexType> new2old;
+    new2old.reserve(vertex_n);
+    Vector<bool> visited(vertex_n, false);
+
+    // breadth first traversal of layer 0, `new2old` is used as the queue
+    auto bfs = [&](VertexType start, bool sort_by_degree) {
+        SizeT head = new2old.size();
+        visited[start] = true;
+        new2old.push_back(start);
+        Vector<Pair<VertexListSize, VertexType>> candidates;
+        while (head < new2old.size()) {
+            auto [neighbors, neighbor_n] = GetNeighbors(new2old[head++], 0);
+            candidates.clear();
+            for (VertexListSize i = 0; i < neighbor_n; ++i) {
+                VertexType n = neighbors[i];
+                if (!visited[n]) {
+                    visited[n] = true;
+                    candidates.emplace_back(sort_by_degree ? GetNeighbors(n, 0).second : 0, n);
+                }
+            }
+            if (sort_by_degree) {
+                std::stable_sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+            }
+            for (const auto &[_, n] : candidates) {
+                new2old.push_back(n);
+            }
+        }
+    };
+
+    switch (reorder_type) {
+        case HnswReorderType::kBFS: {
+            // start from the enter point, so that the vertices visited first by every search are packed together
+            if (auto [max_layer, ep] = GetEnterPoint(); max_layer >= 0) {
+                bfs(ep, false);
+            }
+            for (VertexType i = 0; i < vertex_n; ++i) {
+                if (!visited[i]) {
+                    bfs(i, false);
+                }
+            }
+            break;
+        }
+        case HnswReorderType::kRCM: {
+            // reverse Cuthill-McKee, every component starts from the vertex with the least degree
+            Vector<Pair<VertexListSize, VertexType>> by_degree;
+            by_degree.reserve(vertex_n);
+            for (VertexType i = 0; i < vertex_n; ++i) {
+                by_degree.emplace_back(GetNeighbors(i, 0).second, i);
+            }
+            std::stable_sort(by_degree.begin(), by_degree.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+            for (const auto &[_, i] : by_degree) {
+                if (!visited[i]) {
+                    bfs(i, true);
+                }
+            }
+            std::reverse(new2old.begin(), new2old.end());
+            break;
+        }
+    }
+    return new2old;
+}
+
+template <typename VecStoreT, typename LabelType>
+DataStore<VecStoreT, LabelType> DataStore<VecStoreT, LabelType>::Reorder(HnswReorderType reorder_type) && {
+    const SizeT cur_vec_num = this->cur_vec_num();
+    Vector<VertexType> new2old = ReorderPermutation(reorder_type);
+    Vector<VertexType> old2new(cur_vec_num);
+    for (SizeT i = 0; i < cur_vec_num; ++i) {
+        old2new[new2old[i]] = i;
+    }
+
+    This ret(chunk_size_, max_chunk_n_, std::move(vec_store_meta_), GraphStoreMeta::Make(Mmax0(), Mmax()));
+    ret.cur_vec_num_ = cur_vec_num;
+    SizeT mem_usage = 0;
+    const auto [chunk_num, last_chunk_size] = ChunkInfo(cur_vec_num);
+    for (SizeT i = 0; i < chunk_num; ++i) {
+        ret.inners_[i] = Inner::Make(chunk_size_, ret.vec_store_meta_, ret.graph_store_meta_, mem_usage);
+    }
+    for (SizeT i = 0; i < cur_vec_num; ++i) {
+        auto [inner, idx] = ret.GetInner(i);
+        const auto &[src_inner, src_idx] = GetInner(new2old[i]);
+        inner.CopyVertex(idx, src_inner, src_idx, old2new.data(), ret.vec_store_meta_, ret.graph_store_meta_, mem_usage);
+    }
+    if (auto [max_layer, ep] = GetEnterPoint(); max_layer >= 0) {
+        ret.TryUpdateEnterPoint(max_layer, old2new[ep]);
+    }
+    ret.mem_usage_.store(mem_usage);
+
+    for (SizeT i = 0; i < chunk_num; ++i) {
+        SizeT chunk_size = (i < chunk_num - 1) ? chunk_size_ : last_chunk_size;
+        inners_[i].Free(chunk_size, graph_store_meta_);
+    }
+    this->inners_ = nullptr;
+    return ret;
+}
 
-} // namespace infinity
\ No newline at end of file
+} // namespace infinity
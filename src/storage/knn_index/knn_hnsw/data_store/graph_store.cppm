@@ -16,12 +16,15 @@ module;
 
 #include <cassert>
 #include <ostream>
+#include <sys/mman.h>
 
 export module graph_store;
 
 import stl;
 import hnsw_common;
 import local_file_handle;
+import logger;
+import third_party;
 
 namespace infinity {
 
@@ -91,6 +94,22 @@ public:
         return meta;
     }
 
+    void SaveToPtr(HnswPtrWriter &writer) const {
+        writer.Write(Mmax0_);
+        writer.Write(Mmax_);
+        writer.Write(max_layer_);
+        writer.Write(enterpoint_);
+    }
+
+    static GraphStoreMeta LoadFromPtr(HnswPtrReader &reader) {
+        SizeT Mmax0 = reader.Read<SizeT>();
+        SizeT Mmax = reader.Read<SizeT>();
+        GraphStoreMeta meta(Mmax0, Mmax);
+        meta.max_layer_ = reader.Read<i32>();
+        meta.enterpoint_ = reader.Read<VertexType>();
+        return meta;
+    }
+
     SizeT Mmax0() const { return Mmax0_; }
     SizeT Mmax() const { return Mmax_; }
     SizeT level0_size() const { return level0_size_; }
@@ -136,7 +155,7 @@ public:
 export class GraphStoreInner {
 private:
     GraphStoreInner(SizeT max_vertex, const GraphStoreMeta &meta, SizeT loaded_vertex_n)
-        : graph_(MakeUnique<char[]>(max_vertex * meta.level0_size())), loaded_vertex_n_(loaded_vertex_n) {}
+        : graph_(MakeUnique<char[]>(max_vertex * meta.level0_size())), graph_p_(graph_.get()), loaded_vertex_n_(loaded_vertex_n) {}
 
 public:
     GraphStoreInner() = default;
@@ -149,7 +168,7 @@ public:
 
     static GraphStoreInner Make(SizeT max_vertex, const GraphStoreMeta &meta, SizeT &mem_usage) {
         GraphStoreInner graph_store(max_vertex, meta, 0);
-        std::fill(graph_store.graph_.get(), graph_store.graph_.get() + max_vertex * meta.level0_size(), 0);
+        std::fill(graph_store.graph_p_, graph_store.graph_p_ + max_vertex * meta.level0_size(), 0);
         mem_usage += max_vertex * meta.level0_size();
         return graph_store;
     }
@@ -160,7 +179,7 @@ public:
             const VertexL0 *v = GetLevel0(vertex_i, meta);
             size += sizeof(v->layer_n_) + sizeof(v->neighbor_n_) + sizeof(VertexType) * v->neighbor_n_;
             for (i32 layer_i = 1; layer_i <= v->layer_n_; ++layer_i) {
-                const VertexLX *vx = GetLevelX(v->layers_p_, layer_i, meta);
+                const VertexLX *vx = GetLevelX(LayersP(v), layer_i, meta);
                 size += sizeof(vx->neighbor_n_) + sizeof(VertexType) * vx->neighbor_n_;
             }
         }
@@ -173,15 +192,86 @@ public:
             layer_sum += GetLevel0(vertex_i, meta)->layer_n_;
         }
         file_handle.Append(&layer_sum, sizeof(layer_sum));
-        file_handle.Append(graph_.get(), cur_vertex_n * meta.level0_size());
+        file_handle.Append(graph_p_, cur_vertex_n * meta.level0_size());
         for (VertexType vertex_i = 0; vertex_i < (VertexType)cur_vertex_n; ++vertex_i) {
             const VertexL0 *v = GetLevel0(vertex_i, meta);
             if (v->layer_n_) {
-                file_handle.Append(v->layers_p_, meta.levelx_size() * v->layer_n_);
+                file_handle.Append(LayersP(v), meta.levelx_size() * v->layer_n_);
             }
         }
     }
 
+    // level 0 of all vertices with fixed stride, followed by the upper layers of all vertices.
+    // `layers_p_` of a vertex is saved as the offset of its upper layers.
+    void SaveToPtr(HnswPtrWriter &writer, SizeT cur_vertex_n, const GraphStoreMeta &meta) const {
+        SizeT level0_size = cur_vertex_n * meta.level0_size();
+        auto level0 = MakeUniqueForOverwrite<char[]>(level0_size);
+        std::memcpy(level0.get(), graph_p_, level0_size);
+        SizeT layer_sum = 0;
+        for (VertexType vertex_i = 0; vertex_i < (VertexType)cur_vertex_n; ++vertex_i) {
+            auto *v = reinterpret_cast<VertexL0 *>(level0.get() + vertex_i * meta.level0_size());
+            v->layers_p_ = reinterpret_cast<char *>(layer_sum * meta.levelx_size());
+            layer_sum += v->layer_n_;
+        }
+        writer.Write(layer_sum);
+        writer.Align();
+        writer.Write(level0.get(), level0_size);
+        writer.Align();
+        for (VertexType vertex_i = 0; vertex_i < (VertexType)cur_vertex_n; ++vertex_i) {
+            const VertexL0 *v = GetLevel0(vertex_i, meta);
+            if (v->layer_n_) {
+                writer.Write(LayersP(v), meta.levelx_size() * v->layer_n_);
+            }
+        }
+        writer.Align();
+    }
+
+    // view of the graph saved by `SaveToPtr`, which must not be modified. The upper layers are read on every search so they are
+    // prefetched and optionally locked in memory, level 0 is accessed randomly.
+    static GraphStoreInner LoadFromPtr(HnswPtrReader &reader, SizeT cur_vertex_n, const GraphStoreMeta &meta, bool lock_upper_layers) {
+        SizeT layer_sum = reader.Read<SizeT>();
+        reader.Align();
+        GraphStoreInner graph_store;
+        graph_store.graph_p_ = const_cast<char *>(reader.Get(cur_vertex_n * meta.level0_size()));
+        reader.Align();
+        graph_store.layers_base_ = reader.Get(layer_sum * meta.levelx_size());
+        reader.Align();
+        graph_store.loaded_vertex_n_ = cur_vertex_n;
+
+        HnswMadvise(graph_store.graph_p_, cur_vertex_n * meta.level0_size(), MADV_RANDOM);
+        HnswMadvise(graph_store.layers_base_, layer_sum * meta.levelx_size(), MADV_WILLNEED);
+        if (lock_upper_layers && HnswMlock(graph_store.layers_base_, layer_sum * meta.levelx_size()) != 0) {
+            LOG_WARN(fmt::format("Failed to lock {} bytes of hnsw upper layers in memory", layer_sum * meta.levelx_size()));
+        }
+        return graph_store;
+    }
+
+    // copy of a graph which is loaded by `LoadFromPtr`
+    GraphStoreInner ToOwned(SizeT cur_vertex_n, SizeT max_vertex, const GraphStoreMeta &meta, SizeT &mem_usage) const {
+        GraphStoreInner graph_store(max_vertex, meta, cur_vertex_n);
+        std::memcpy(graph_store.graph_p_, graph_p_, cur_vertex_n * meta.level0_size());
+        SizeT layer_sum = 0;
+        for (VertexType vertex_i = 0; vertex_i < (VertexType)cur_vertex_n; ++vertex_i) {
+            layer_sum += GetLevel0(vertex_i, meta)->layer_n_;
+        }
+        auto loaded_layers = MakeUniqueForOverwrite<char[]>(layer_sum * meta.levelx_size());
+        char *loaded_layers_p = loaded_layers.get();
+        for (VertexType vertex_i = 0; vertex_i < (VertexType)cur_vertex_n; ++vertex_i) {
+            VertexL0 *v = graph_store.GetLevel0(vertex_i, meta);
+            if (v->layer_n_) {
+                std::memcpy(loaded_layers_p, LayersP(v), meta.levelx_size() * v->layer_n_);
+                v->layers_p_ = loaded_layers_p;
+                loaded_layers_p += meta.levelx_size() * v->layer_n_;
+            } else {
+                v->layers_p_ = nullptr;
+            }
+        }
+        graph_store.loaded_layers_ = std::move(loaded_layers);
+
+        mem_usage += max_vertex * meta.level0_size() + layer_sum * meta.levelx_size();
+        return graph_store;
+    }
+
     static GraphStoreInner Load(LocalFileHandle &file_handle, SizeT cur_vertex_n, SizeT max_vertex, const GraphStoreMeta &meta, SizeT &mem_usage) {
         assert(cur_vertex_n <= max_vertex);
 
@@ -189,7 +279,7 @@ public:
         file_handle.Read(&layer_sum, sizeof(layer_sum));
 
         GraphStoreInner graph_store(max_vertex, meta, cur_vertex_n);
-        file_handle.Read(graph_store.graph_.get(), cur_vertex_n * meta.level0_size());
+        file_handle.Read(graph_store.graph_p_, cur_vertex_n * meta.level0_size());
 
         auto loaded_layers = MakeUnique<char[]>(meta.levelx_size() * layer_sum);
         char *loaded_layers_p = loaded_layers.get();
@@ -225,12 +315,36 @@ public:
         }
     }
 
+    // copy vertex `src_i` of `src` to `vertex_i`, the neighbors are renumbered by `old2new`
+    void CopyVertex(VertexType vertex_i,
+                    const GraphStoreInner &src,
+                    VertexType src_i,
+                    const VertexType *old2new,
+                    const GraphStoreMeta &meta,
+                    SizeT &mem_usage) {
+        const VertexL0 *src_v = src.GetLevel0(src_i, meta);
+        AddVertex(vertex_i, src_v->layer_n_, meta, mem_usage);
+        VertexL0 *v = GetLevel0(vertex_i, meta);
+        v->neighbor_n_ = src_v->neighbor_n_;
+        for (VertexListSize i = 0; i < src_v->neighbor_n_; ++i) {
+            v->neighbors_[i] = old2new[src_v->neighbors_[i]];
+        }
+        for (i32 layer_i = 1; layer_i <= src_v->layer_n_; ++layer_i) {
+            const VertexLX *src_vx = src.GetLevelX(src.LayersP(src_v), layer_i, meta);
+            VertexLX *vx = GetLevelX(v->layers_p_, layer_i, meta);
+            vx->neighbor_n_ = src_vx->neighbor_n_;
+            for (VertexListSize i = 0; i < src_vx->neighbor_n_; ++i) {
+                vx->neighbors_[i] = old2new[src_vx->neighbors_[i]];
+            }
+        }
+    }
+
     Pair<const VertexType *, VertexListSize> GetNeighbors(VertexType vertex_i, i32 layer_i, const GraphStoreMeta &meta) const {
         const VertexL0 *v = GetLevel0(vertex_i, meta);
         if (layer_i == 0) {
             return {v->neighbors_, v->neighbor_n_};
         }
-        const VertexLX *vx = GetLevelX(v->layers_p_, layer_i, meta);
+        const VertexLX *vx = GetLevelX(LayersP(v), layer_i, meta);
         return {vx->neighbors_, vx->neighbor_n_};
     }
     Pair<VertexType *, VertexListSize *> GetNeighborsMut(VertexType vertex_i, i32 layer_i, const GraphStoreMeta &meta) {
@@ -244,10 +358,15 @@ public:
 
 private:
     const VertexL0 *GetLevel0(VertexType vertex_i, const GraphStoreMeta &meta) const {
-        return reinterpret_cast<const VertexL0 *>(graph_.get() + vertex_i * meta.level0_size());
+        return reinterpret_cast<const VertexL0 *>(graph_p_ + vertex_i * meta.level0_size());
     }
     VertexL0 *GetLevel0(VertexType vertex_i, const GraphStoreMeta &meta) {
-        return reinterpret_cast<VertexL0 *>(graph_.get() + vertex_i * meta.level0_size());
+        return reinterpret_cast<VertexL0 *>(graph_p_ + vertex_i * meta.level0_size());
+    }
+
+    // in a graph loaded by `LoadFromPtr`, `layers_p_` is the offset in `layers_base_`
+    const char *LayersP(const VertexL0 *v) const {
+        return layers_base_ == nullptr ? v->layers_p_ : layers_base_ + reinterpret_cast<SizeT>(v->layers_p_);
     }
 
     const VertexLX *GetLevelX(const char *layer_p, i32 layer_i, const GraphStoreMeta &meta) const {
@@ -261,8 +380,10 @@ private:
 
 private:
     UniquePtr<char[]> graph_;
+    char *graph_p_ = nullptr; // `graph_` or the memory of a loaded file
     SizeT loaded_vertex_n_;
     UniquePtr<char[]> loaded_layers_;
+    const char *layers_base_ = nullptr;
 
     //---------------------------------------------- Following is the tmp debug function. ----------------------------------------------
 
@@ -283,7 +404,7 @@ public:
                 assert(neighbor_idx != out_vertex_i);
             }
             for (int layer_i = 1; layer_i <= v->layer_n_; ++layer_i) {
-                const VertexLX *vx = GetLevelX(v->layers_p_, layer_i, meta);
+                const VertexLX *vx = GetLevelX(LayersP(v), layer_i, meta);
                 for (int i = 0; i < vx->neighbor_n_; ++i) {
                     VertexType neighbor_idx = vx->neighbors_[i];
                     assert(neighbor_idx < (VertexType)cur_vec_num && neighbor_idx >= 0);
@@ -323,7 +444,7 @@ public:
                     neighbors = v->neighbors_;
                     neighbor_n = v->neighbor_n_;
                 } else {
-                    const VertexLX *vx = GetLevelX(v->layers_p_, layer, meta);
+                    const VertexLX *vx = GetLevelX(LayersP(v), layer, meta);
                     neighbors = vx->neighbors_;
                     neighbor_n = vx->neighbor_n_;
                 }
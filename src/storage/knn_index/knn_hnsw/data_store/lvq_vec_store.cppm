@@ -113,6 +113,20 @@ public:
         return meta;
     }
 
+    void SaveToPtr(HnswPtrWriter &writer) const {
+        writer.Write(dim_);
+        writer.Write(mean_.get(), sizeof(MeanType) * dim_);
+        writer.Write(&global_cache_, sizeof(GlobalCacheType));
+    }
+
+    static This LoadFromPtr(HnswPtrReader &reader) {
+        SizeT dim = reader.Read<SizeT>();
+        This meta(dim);
+        std::memcpy(meta.mean_.get(), reader.Get(sizeof(MeanType) * dim), sizeof(MeanType) * dim);
+        std::memcpy(&meta.global_cache_, reader.Get(sizeof(GlobalCacheType)), sizeof(GlobalCacheType));
+        return meta;
+    }
+
     LVQQuery MakeQuery(const DataType *vec) const {
         LVQQuery query(compress_data_size_);
         CompressTo(vec, query.inner_.get());
@@ -252,7 +266,8 @@ public:
     using LVQData = LVQData<DataType, LocalCacheType, CompressType>;
 
 private:
-    LVQVecStoreInner(SizeT max_vec_num, const Meta &meta) : ptr_(MakeUnique<char[]>(max_vec_num * meta.compress_data_size())) {}
+    LVQVecStoreInner(SizeT max_vec_num, const Meta &meta) : ptr_(MakeUnique<char[]>(max_vec_num * meta.compress_data_size())), data_(ptr_.get()) {}
+    LVQVecStoreInner(const char *data) : data_(const_cast<char *>(data)) {}
 
 public:
     LVQVecStoreInner() = default;
@@ -266,30 +281,52 @@ public:
     SizeT GetSizeInBytes(SizeT cur_vec_num, const Meta &meta) const { return cur_vec_num * meta.compress_data_size(); }
 
     void Save(LocalFileHandle &file_handle, SizeT cur_vec_num, const Meta &meta) const {
-        file_handle.Append(ptr_.get(), cur_vec_num * meta.compress_data_size());
+        file_handle.Append(data_, cur_vec_num * meta.compress_data_size());
     }
 
     static This Load(LocalFileHandle &file_handle, SizeT cur_vec_num, SizeT max_vec_num, const Meta &meta, SizeT &mem_usage) {
         assert(cur_vec_num <= max_vec_num);
         This ret(max_vec_num, meta);
-        file_handle.Read(ret.ptr_.get(), cur_vec_num * meta.compress_data_size());
+        file_handle.Read(ret.data_, cur_vec_num * meta.compress_data_size());
+        mem_usage += max_vec_num * meta.compress_data_size();
+        return ret;
+    }
+
+    void SaveToPtr(HnswPtrWriter &writer, SizeT cur_vec_num, const Meta &meta) const {
+        writer.Write(data_, cur_vec_num * meta.compress_data_size());
+    }
+
+    // view of the vectors saved by `SaveToPtr`, which must not be modified
+    static This LoadFromPtr(HnswPtrReader &reader, SizeT cur_vec_num, const Meta &meta) {
+        return This(reader.Get(cur_vec_num * meta.compress_data_size()));
+    }
+
+    This ToOwned(SizeT cur_vec_num, SizeT max_vec_num, const Meta &meta, SizeT &mem_usage) const {
+        This ret(max_vec_num, meta);
+        std::memcpy(ret.data_, data_, cur_vec_num * meta.compress_data_size());
         mem_usage += max_vec_num * meta.compress_data_size();
         return ret;
     }
 
     void SetVec(SizeT idx, const DataType *vec, const Meta &meta, SizeT &mem_usage) { meta.CompressTo(vec, GetVecMut(idx, meta)); }
 
+    // copy the compressed vector, which is encoded with the same meta
+    void CopyVec(SizeT idx, const This &src, SizeT src_idx, const Meta &meta, SizeT &mem_usage) {
+        std::memcpy(GetVecMut(idx, meta), src.GetVec(src_idx, meta), meta.compress_data_size());
+    }
+
     const LVQData *GetVec(SizeT idx, const Meta &meta) const {
-        return reinterpret_cast<const LVQData *>(ptr_.get() + idx * meta.compress_data_size());
+        return reinterpret_cast<const LVQData *>(data_ + idx * meta.compress_data_size());
     }
 
     void Prefetch(VertexType vec_i, const Meta &meta) const { _mm_prefetch(reinterpret_cast<const char *>(GetVec(vec_i, meta)), _MM_HINT_T0); }
 
 private:
-    LVQData *GetVecMut(SizeT idx, const Meta &meta) { return reinterpret_cast<LVQData *>(ptr_.get() + idx * meta.compress_data_size()); }
+    LVQData *GetVecMut(SizeT idx, const Meta &meta) { return reinterpret_cast<LVQData *>(data_ + idx * meta.compress_data_size()); }
 
 private:
     UniquePtr<char[]> ptr_;
+    char *data_ = nullptr; // `ptr_` or the memory of a loaded file
 
 public:
     void Dump(std::ostream &os, SizeT offset, SizeT chunk_size, const Meta &meta) const {
@@ -64,6 +64,10 @@ public:
         return This(dim);
     }
 
+    void SaveToPtr(HnswPtrWriter &writer) const { writer.Write(dim_); }
+
+    static This LoadFromPtr(HnswPtrReader &reader) { return This(reader.Read<SizeT>()); }
+
     QueryType MakeQuery(const DataType *vec) const { return vec; }
 
     SizeT dim() const { return dim_; }
@@ -82,7 +86,8 @@ public:
     using Meta = PlainVecStoreMeta<DataType>;
 
 private:
-    PlainVecStoreInner(SizeT max_vec_num, const Meta &meta) : ptr_(MakeUnique<DataType[]>(max_vec_num * meta.dim())) {}
+    PlainVecStoreInner(SizeT max_vec_num, const Meta &meta) : ptr_(MakeUnique<DataType[]>(max_vec_num * meta.dim())), data_(ptr_.get()) {}
+    PlainVecStoreInner(const DataType *data) : data_(const_cast<DataType *>(data)) {}
 
 public:
     PlainVecStoreInner() = default;
@@ -95,28 +100,50 @@ public:
     SizeT GetSizeInBytes(SizeT cur_vec_num, const Meta &meta) const { return sizeof(DataType) * cur_vec_num * meta.dim(); }
 
     void Save(LocalFileHandle &file_handle, SizeT cur_vec_num, const Meta &meta) const {
-        file_handle.Append(ptr_.get(), sizeof(DataType) * cur_vec_num * meta.dim());
+        file_handle.Append(data_, sizeof(DataType) * cur_vec_num * meta.dim());
     }
 
     static This Load(LocalFileHandle &file_handle, SizeT cur_vec_num, SizeT max_vec_num, const Meta &meta, SizeT &mem_usage) {
         assert(cur_vec_num <= max_vec_num);
         This ret(max_vec_num, meta);
-        file_handle.Read(ret.ptr_.get(), sizeof(DataType) * cur_vec_num * meta.dim());
+        file_handle.Read(ret.data_, sizeof(DataType) * cur_vec_num * meta.dim());
+        mem_usage += sizeof(DataType) * max_vec_num * meta.dim();
+        return ret;
+    }
+
+    void SaveToPtr(HnswPtrWriter &writer, SizeT cur_vec_num, const Meta &meta) const {
+        writer.Write(data_, sizeof(DataType) * cur_vec_num * meta.dim());
+    }
+
+    // view of the vectors saved by `SaveToPtr`, which must not be modified
+    static This LoadFromPtr(HnswPtrReader &reader, SizeT cur_vec_num, const Meta &meta) {
+        return This(reinterpret_cast<const DataType *>(reader.Get(sizeof(DataType) * cur_vec_num * meta.dim())));
+    }
+
+    This ToOwned(SizeT cur_vec_num, SizeT max_vec_num, const Meta &meta, SizeT &mem_usage) const {
+        This ret(max_vec_num, meta);
+        Copy(data_, data_ + cur_vec_num * meta.dim(), ret.data_);
         mem_usage += sizeof(DataType) * max_vec_num * meta.dim();
         return ret;
     }
 
     void SetVec(SizeT idx, const DataType *vec, const Meta &meta, SizeT &mem_usage) { Copy(vec, vec + meta.dim(), GetVecMut(idx, meta)); }
 
-    const DataType *GetVec(SizeT idx, const Meta &meta) const { return ptr_.get() + idx * meta.dim(); }
+    void CopyVec(SizeT idx, const This &src, SizeT src_idx, const Meta &meta, SizeT &mem_usage) {
+        const DataType *vec = src.GetVec(src_idx, meta);
+        Copy(vec, vec + meta.dim(), GetVecMut(idx, meta));
+    }
+
+    const DataType *GetVec(SizeT idx, const Meta &meta) const { return data_ + idx * meta.dim(); }
 
     void Prefetch(VertexType vec_i, const Meta &meta) const { _mm_prefetch(reinterpret_cast<const char *>(GetVec(vec_i, meta)), _MM_HINT_T0); }
 
 private:
-    DataType *GetVecMut(SizeT idx, const Meta &meta) { return ptr_.get() + idx * meta.dim(); }
+    DataType *GetVecMut(SizeT idx, const Meta &meta) { return data_ + idx * meta.dim(); }
 
 private:
     UniquePtr<DataType[]> ptr_;
+    DataType *data_ = nullptr; // `ptr_` or the memory of a loaded file
 
 public:
     void Dump(std::ostream &os, SizeT offset, SizeT chunk_size, const Meta &meta) const {
@@ -0,0 +1,389 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+#include <cassert>
+#include <ostream>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <xmmintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+#include <simde/x86/sse.h>
+#endif
+
+export module pq_vec_store;
+
+import stl;
+import local_file_handle;
+import hnsw_common;
+import index_base;
+import kmeans_partition;
+import simd_functions;
+import simd_init;
+import infinity_exception;
+import third_party;
+
+namespace infinity {
+
+// Reference to a pq encoded vector. `lut_` is only set for the query side, it holds the distances between the query and every centroid.
+export struct PQVecRef {
+    const u8 *codes_ = nullptr;
+    const f32 *lut_ = nullptr;
+};
+
+export template <typename DataType, MetricType metric>
+class PQVecStoreInner;
+
+// Product quantization with 8 bit codes: the vector is split into `subspace_num_` sub vectors, each is encoded as the id of its nearest
+// centroid in the subspace codebook. Distance from a query is computed asymmetrically by summing up a query-to-centroid lookup table.
+export template <typename DataType, MetricType metric>
+class PQVecStoreMeta {
+public:
+    static_assert(metric == MetricType::kMetricL2 || metric == MetricType::kMetricInnerProduct || metric == MetricType::kMetricCosine);
+
+    constexpr static SizeT centroid_num_ = 256;
+    constexpr static SizeT max_train_num_ = 256 * centroid_num_;
+    constexpr static SizeT default_subspace_dim_ = 4;
+    constexpr static bool normalize_ = metric == MetricType::kMetricCosine;
+
+    using This = PQVecStoreMeta<DataType, metric>;
+    using Inner = PQVecStoreInner<DataType, metric>;
+    using StoreType = PQVecRef;
+    struct PQQuery {
+        UniquePtr<f32[]> lut_;
+        operator PQVecRef() const { return {nullptr, lut_.get()}; }
+    };
+    using QueryType = PQQuery;
+    using DistanceType = f32;
+
+private:
+    PQVecStoreMeta(SizeT dim, SizeT subspace_num)
+        : dim_(dim), subspace_num_(subspace_num), subspace_dim_(dim / subspace_num), real_centroid_num_(0),
+          centroids_(MakeUnique<f32[]>(dim * centroid_num_)) {
+        if constexpr (metric == MetricType::kMetricL2) {
+            SIMDFunc = GetSIMD_FUNCTIONS().HNSW_F32L2_ptr_;
+        } else {
+            SIMDFunc = GetSIMD_FUNCTIONS().HNSW_F32IP_ptr_;
+        }
+    }
+
+public:
+    PQVecStoreMeta() : dim_(0), subspace_num_(0), subspace_dim_(0), real_centroid_num_(0) {}
+    PQVecStoreMeta(This &&other)
+        : dim_(std::exchange(other.dim_, 0)), subspace_num_(std::exchange(other.subspace_num_, 0)),
+          subspace_dim_(std::exchange(other.subspace_dim_, 0)), real_centroid_num_(std::exchange(other.real_centroid_num_, 0)),
+          centroids_(std::move(other.centroids_)), SIMDFunc(std::exchange(other.SIMDFunc, nullptr)) {}
+    PQVecStoreMeta &operator=(This &&other) {
+        if (this != &other) {
+            dim_ = std::exchange(other.dim_, 0);
+            subspace_num_ = std::exchange(other.subspace_num_, 0);
+            subspace_dim_ = std::exchange(other.subspace_dim_, 0);
+            real_centroid_num_ = std::exchange(other.real_centroid_num_, 0);
+            centroids_ = std::move(other.centroids_);
+            SIMDFunc = std::exchange(other.SIMDFunc, nullptr);
+        }
+        return *this;
+    }
+
+    // the smallest divisor of dim which is not less than `default_subspace_dim_`
+    static SizeT DefaultSubspaceNum(SizeT dim) {
+        for (SizeT subspace_dim = default_subspace_dim_; subspace_dim < dim; ++subspace_dim) {
+            if (dim % subspace_dim == 0) {
+                return dim / subspace_dim;
+            }
+        }
+        return 1;
+    }
+
+    static This Make(SizeT dim) { return Make(dim, DefaultSubspaceNum(dim), false); }
+    static This Make(SizeT dim, bool) { return Make(dim, DefaultSubspaceNum(dim), false); }
+    static This Make(SizeT dim, SizeT subspace_num, bool) {
+        if (subspace_num == 0) {
+            subspace_num = DefaultSubspaceNum(dim);
+        }
+        if (dim % subspace_num != 0) {
+            UnrecoverableError(fmt::format("PQ subspace num {} does not divide dimension {}", subspace_num, dim));
+        }
+        return This(dim, subspace_num);
+    }
+
+    SizeT GetSizeInBytes() const {
+        return sizeof(dim_) + sizeof(subspace_num_) + sizeof(real_centroid_num_) + sizeof(f32) * dim_ * centroid_num_;
+    }
+
+    void Save(LocalFileHandle &file_handle) const {
+        file_handle.Append(&dim_, sizeof(dim_));
+        file_handle.Append(&subspace_num_, sizeof(subspace_num_));
+        file_handle.Append(&real_centroid_num_, sizeof(real_centroid_num_));
+        file_handle.Append(centroids_.get(), sizeof(f32) * dim_ * centroid_num_);
+    }
+
+    static This Load(LocalFileHandle &file_handle) {
+        SizeT dim;
+        file_handle.Read(&dim, sizeof(dim));
+        SizeT subspace_num;
+        file_handle.Read(&subspace_num, sizeof(subspace_num));
+        This meta(dim, subspace_num);
+        file_handle.Read(&meta.real_centroid_num_, sizeof(meta.real_centroid_num_));
+        file_handle.Read(meta.centroids_.get(), sizeof(f32) * dim * centroid_num_);
+        return meta;
+    }
+
+    void SaveToPtr(HnswPtrWriter &writer) const {
+        writer.Write(dim_);
+        writer.Write(subspace_num_);
+        writer.Write(real_centroid_num_);
+        writer.Write(centroids_.get(), sizeof(f32) * dim_ * centroid_num_);
+    }
+
+    static This LoadFromPtr(HnswPtrReader &reader) {
+        SizeT dim = reader.Read<SizeT>();
+        SizeT subspace_num = reader.Read<SizeT>();
+        This meta(dim, subspace_num);
+        meta.real_centroid_num_ = reader.Read<SizeT>();
+        std::memcpy(meta.centroids_.get(), reader.Get(sizeof(f32) * dim * centroid_num_), sizeof(f32) * dim * centroid_num_);
+        return meta;
+    }
+
+    // train the codebook of every subspace with k-means on (at most `max_train_num_` sampled) vectors
+    void Train(const DataType *vecs, SizeT vec_num) {
+        if (vec_num == 0) {
+            return;
+        }
+        SizeT step = (vec_num - 1) / max_train_num_ + 1;
+        SizeT train_num = (vec_num - 1) / step + 1;
+        auto train_data = MakeUniqueForOverwrite<f32[]>(train_num * dim_);
+        for (SizeT i = 0; i < train_num; ++i) {
+            ToF32(vecs + i * step * dim_, train_data.get() + i * dim_);
+        }
+        real_centroid_num_ = std::min(centroid_num_, train_num);
+
+        auto sub_data = MakeUniqueForOverwrite<f32[]>(train_num * subspace_dim_);
+        Vector<f32> sub_centroids;
+        for (SizeT m = 0; m < subspace_num_; ++m) {
+            for (SizeT i = 0; i < train_num; ++i) {
+                Copy(train_data.get() + i * dim_ + m * subspace_dim_,
+                     train_data.get() + i * dim_ + (m + 1) * subspace_dim_,
+                     sub_data.get() + i * subspace_dim_);
+            }
+            f32 *output = centroids_.get() + m * centroid_num_ * subspace_dim_;
+            if (train_num <= centroid_num_) {
+                // no k-means
+                Copy(sub_data.get(), sub_data.get() + train_num * subspace_dim_, output);
+                continue;
+            }
+            const auto centroid_cnt = GetKMeansCentroids(MetricType::kMetricL2,
+                                                           subspace_dim_,
+                                                           train_num,
+                                                           sub_data.get(),
+                                                           sub_centroids,
+                                                           centroid_num_,
+                                                           0,
+                                                           KMeansOption{.kmeans_plus_plus_ = true});
+            if (centroid_cnt != centroid_num_ || sub_centroids.size() != centroid_num_ * subspace_dim_) {
+                UnrecoverableError(fmt::format("KMeans failed to find {} centroids for subspace {}", centroid_num_, m));
+            }
+            Copy(sub_centroids.begin(), sub_centroids.end(), output);
+        }
+    }
+
+    void Encode(const DataType *vec, u8 *codes) const {
+        auto vec_f32 = MakeUniqueForOverwrite<f32[]>(dim_);
+        ToF32(vec, vec_f32.get());
+        for (SizeT m = 0; m < subspace_num_; ++m) {
+            const f32 *sub_vec = vec_f32.get() + m * subspace_dim_;
+            f32 min_dist = std::numeric_limits<f32>::max();
+            u8 min_id = 0;
+            for (SizeT k = 0; k < real_centroid_num_; ++k) {
+                f32 dist = GetSIMD_FUNCTIONS().HNSW_F32L2_ptr_(sub_vec, centroid(m, k), subspace_dim_);
+                if (dist < min_dist) {
+                    min_dist = dist;
+                    min_id = k;
+                }
+            }
+            codes[m] = min_id;
+        }
+    }
+
+    QueryType MakeQuery(const DataType *vec) const {
+        PQQuery query{MakeUnique<f32[]>(subspace_num_ * centroid_num_)};
+        auto vec_f32 = MakeUniqueForOverwrite<f32[]>(dim_);
+        ToF32(vec, vec_f32.get());
+        for (SizeT m = 0; m < subspace_num_; ++m) {
+            f32 *lut = query.lut_.get() + m * centroid_num_;
+            for (SizeT k = 0; k < real_centroid_num_; ++k) {
+                lut[k] = SubspaceDistance(vec_f32.get() + m * subspace_dim_, centroid(m, k));
+            }
+        }
+        return query;
+    }
+
+    // distance between two encoded vectors, only used when inserting into a pq index
+    f32 SymmetricDistance(const u8 *codes1, const u8 *codes2) const {
+        f32 res = 0;
+        for (SizeT m = 0; m < subspace_num_; ++m) {
+            res += SubspaceDistance(centroid(m, codes1[m]), centroid(m, codes2[m]));
+        }
+        return res;
+    }
+
+    SizeT dim() const { return dim_; }
+    SizeT subspace_num() const { return subspace_num_; }
+    SizeT subspace_dim() const { return subspace_dim_; }
+    SizeT real_centroid_num() const { return real_centroid_num_; }
+
+    const f32 *centroid(SizeT subspace_i, SizeT centroid_i) const {
+        return centroids_.get() + (subspace_i * centroid_num_ + centroid_i) * subspace_dim_;
+    }
+
+private:
+    f32 SubspaceDistance(const f32 *v1, const f32 *v2) const {
+        if constexpr (metric == MetricType::kMetricL2) {
+            return SIMDFunc(v1, v2, subspace_dim_);
+        } else {
+            return -SIMDFunc(v1, v2, subspace_dim_);
+        }
+    }
+
+    void ToF32(const DataType *src, f32 *dest) const {
+        for (SizeT i = 0; i < dim_; ++i) {
+            dest[i] = static_cast<f32>(src[i]);
+        }
+        if constexpr (normalize_) {
+            f32 norm = 0;
+            for (SizeT i = 0; i < dim_; ++i) {
+                norm += dest[i] * dest[i];
+            }
+            if (norm > 0) {
+                f32 norm_inv = 1 / std::sqrt(norm);
+                for (SizeT i = 0; i < dim_; ++i) {
+                    dest[i] *= norm_inv;
+                }
+            }
+        }
+    }
+
+private:
+    SizeT dim_;
+    SizeT subspace_num_;
+    SizeT subspace_dim_;
+    SizeT real_centroid_num_;
+
+    // [subspace_num_][centroid_num_][subspace_dim_]
+    UniquePtr<f32[]> centroids_;
+
+    F32DistanceFuncType SIMDFunc = nullptr;
+
+public:
+    void Dump(std::ostream &os) const {
+        os << "[CONST] dim: " << dim_ << ", subspace_num: " << subspace_num_ << ", subspace_dim: " << subspace_dim_
+           << ", centroid_num: " << real_centroid_num_ << std::endl;
+        for (SizeT m = 0; m < subspace_num_; ++m) {
+            os << "subspace " << m << " centroids: ";
+            for (SizeT k = 0; k < real_centroid_num_; ++k) {
+                os << "[";
+                for (SizeT j = 0; j < subspace_dim_; ++j) {
+                    os << centroid(m, k)[j] << " ";
+                }
+                os << "] ";
+            }
+            os << std::endl;
+        }
+    }
+};
+
+export template <typename DataType, MetricType metric>
+class PQVecStoreInner {
+public:
+    using This = PQVecStoreInner<DataType, metric>;
+    using Meta = PQVecStoreMeta<DataType, metric>;
+
+private:
+    PQVecStoreInner(SizeT max_vec_num, const Meta &meta) : ptr_(MakeUnique<u8[]>(max_vec_num * meta.subspace_num())), data_(ptr_.get()) {}
+    PQVecStoreInner(const u8 *data) : data_(const_cast<u8 *>(data)) {}
+
+public:
+    PQVecStoreInner() = default;
+
+    static This Make(SizeT max_vec_num, const Meta &meta, SizeT &mem_usage) {
+        mem_usage += max_vec_num * meta.subspace_num();
+        return This(max_vec_num, meta);
+    }
+
+    SizeT GetSizeInBytes(SizeT cur_vec_num, const Meta &meta) const { return cur_vec_num * meta.subspace_num(); }
+
+    void Save(LocalFileHandle &file_handle, SizeT cur_vec_num, const Meta &meta) const {
+        file_handle.Append(data_, cur_vec_num * meta.subspace_num());
+    }
+
+    static This Load(LocalFileHandle &file_handle, SizeT cur_vec_num, SizeT max_vec_num, const Meta &meta, SizeT &mem_usage) {
+        assert(cur_vec_num <= max_vec_num);
+        This ret(max_vec_num, meta);
+        file_handle.Read(ret.data_, cur_vec_num * meta.subspace_num());
+        mem_usage += max_vec_num * meta.subspace_num();
+        return ret;
+    }
+
+    void SaveToPtr(HnswPtrWriter &writer, SizeT cur_vec_num, const Meta &meta) const { writer.Write(data_, cur_vec_num * meta.subspace_num()); }
+
+    // view of the codes saved by `SaveToPtr`, which must not be modified
+    static This LoadFromPtr(HnswPtrReader &reader, SizeT cur_vec_num, const Meta &meta) {
+        return This(reinterpret_cast<const u8 *>(reader.Get(cur_vec_num * meta.subspace_num())));
+    }
+
+    This ToOwned(SizeT cur_vec_num, SizeT max_vec_num, const Meta &meta, SizeT &mem_usage) const {
+        This ret(max_vec_num, meta);
+        std::memcpy(ret.data_, data_, cur_vec_num * meta.subspace_num());
+        mem_usage += max_vec_num * meta.subspace_num();
+        return ret;
+    }
+
+    void SetVec(SizeT idx, const DataType *vec, const Meta &meta, SizeT &mem_usage) {
+        if (meta.real_centroid_num() == 0) {
+            UnrecoverableError("PQ codebook is not trained.");
+        }
+        meta.Encode(vec, GetVecMut(idx, meta));
+    }
+
+    void CopyVec(SizeT idx, const This &src, SizeT src_idx, const Meta &meta, SizeT &mem_usage) {
+        std::memcpy(GetVecMut(idx, meta), src.GetVec(src_idx, meta).codes_, meta.subspace_num());
+    }
+
+    PQVecRef GetVec(SizeT idx, const Meta &meta) const { return {data_ + idx * meta.subspace_num(), nullptr}; }
+
+    void Prefetch(VertexType vec_i, const Meta &meta) const {
+        _mm_prefetch(reinterpret_cast<const char *>(GetVec(vec_i, meta).codes_), _MM_HINT_T0);
+    }
+
+private:
+    u8 *GetVecMut(SizeT idx, const Meta &meta) { return data_ + idx * meta.subspace_num(); }
+
+private:
+    UniquePtr<u8[]> ptr_;
+    u8 *data_ = nullptr; // `ptr_` or the memory of a loaded file
+
+public:
+    void Dump(std::ostream &os, SizeT offset, SizeT chunk_size, const Meta &meta) const {
+        for (int i = 0; i < (int)chunk_size; ++i) {
+            os << "vec " << i << "(" << offset + i << "): ";
+            const u8 *codes = GetVec(i, meta).codes_;
+            for (SizeT j = 0; j < meta.subspace_num(); ++j) {
+                os << static_cast<int>(codes[j]) << " ";
+            }
+            os << std::endl;
+        }
+    }
+};
+
+} // namespace infinity
@@ -0,0 +1,288 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+#include <cassert>
+#include <ostream>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <xmmintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+#include <simde/x86/sse.h>
+#endif
+
+export module rabitq_vec_store;
+
+import stl;
+import local_file_handle;
+import hnsw_common;
+import index_base;
+import rabitq_quantizer;
+
+namespace infinity {
+
+// Reference to a 1 bit encoded vector. `query_` is only set for the query side.
+export struct RaBitQVecRef {
+    const RaBitQFactor *factor_ = nullptr;
+    const u8 *code_ = nullptr;
+    const RaBitQQuery *query_ = nullptr;
+};
+
+export template <typename DataType, MetricType metric>
+class RaBitQVecStoreInner;
+
+// 1 bit quantization of the residual to the mean of the stored vectors, see `rabitq_quantizer`.
+// The mean is computed when the plain index is compressed, an untrained meta quantizes the vectors themselves.
+export template <typename DataType, MetricType metric>
+class RaBitQVecStoreMeta {
+public:
+    static_assert(metric == MetricType::kMetricL2 || metric == MetricType::kMetricInnerProduct || metric == MetricType::kMetricCosine);
+
+    constexpr static SizeT max_train_num_ = 65536;
+    constexpr static bool normalize_ = metric == MetricType::kMetricCosine;
+
+    using This = RaBitQVecStoreMeta<DataType, metric>;
+    using Inner = RaBitQVecStoreInner<DataType, metric>;
+    using StoreType = RaBitQVecRef;
+    struct RaBitQQueryHolder {
+        UniquePtr<RaBitQQuery> query_;
+        operator RaBitQVecRef() const { return {nullptr, nullptr, query_.get()}; }
+    };
+    using QueryType = RaBitQQueryHolder;
+    using DistanceType = f32;
+
+private:
+    RaBitQVecStoreMeta(SizeT dim) : dim_(dim), code_bytes_(RaBitQCodeBytes(dim)), centroid_(MakeUnique<f32[]>(dim)), rotation_(dim) {}
+
+public:
+    RaBitQVecStoreMeta() : dim_(0), code_bytes_(0) {}
+    RaBitQVecStoreMeta(This &&other)
+        : dim_(std::exchange(other.dim_, 0)), code_bytes_(std::exchange(other.code_bytes_, 0)), centroid_(std::move(other.centroid_)),
+          centroid_norm_sqr_(std::exchange(other.centroid_norm_sqr_, 0)), rotation_(std::move(other.rotation_)) {}
+    RaBitQVecStoreMeta &operator=(This &&other) {
+        if (this != &other) {
+            dim_ = std::exchange(other.dim_, 0);
+            code_bytes_ = std::exchange(other.code_bytes_, 0);
+            centroid_ = std::move(other.centroid_);
+            centroid_norm_sqr_ = std::exchange(other.centroid_norm_sqr_, 0);
+            rotation_ = std::move(other.rotation_);
+        }
+        return *this;
+    }
+
+    static This Make(SizeT dim) { return This(dim); }
+    static This Make(SizeT dim, bool) { return This(dim); }
+
+    SizeT GetSizeInBytes() const { return sizeof(dim_) + sizeof(f32) * dim_; }
+
+    void Save(LocalFileHandle &file_handle) const {
+        file_handle.Append(&dim_, sizeof(dim_));
+        file_handle.Append(centroid_.get(), sizeof(f32) * dim_);
+    }
+
+    static This Load(LocalFileHandle &file_handle) {
+        SizeT dim;
+        file_handle.Read(&dim, sizeof(dim));
+        This meta(dim);
+        file_handle.Read(meta.centroid_.get(), sizeof(f32) * dim);
+        meta.UpdateCentroidNorm();
+        return meta;
+    }
+
+    void SaveToPtr(HnswPtrWriter &writer) const {
+        writer.Write(dim_);
+        writer.Write(centroid_.get(), sizeof(f32) * dim_);
+    }
+
+    static This LoadFromPtr(HnswPtrReader &reader) {
+        SizeT dim = reader.Read<SizeT>();
+        This meta(dim);
+        std::memcpy(meta.centroid_.get(), reader.Get(sizeof(f32) * dim), sizeof(f32) * dim);
+        meta.UpdateCentroidNorm();
+        return meta;
+    }
+
+    // the centroid is the mean of (at most `max_train_num_` sampled) vectors
+    void Train(const DataType *vecs, SizeT vec_num) {
+        if (vec_num == 0) {
+            return;
+        }
+        SizeT step = (vec_num - 1) / max_train_num_ + 1;
+        SizeT train_num = (vec_num - 1) / step + 1;
+        Vector<f64> sum(dim_);
+        auto vec_f32 = MakeUniqueForOverwrite<f32[]>(dim_);
+        for (SizeT i = 0; i < train_num; ++i) {
+            ToF32(vecs + i * step * dim_, vec_f32.get());
+            for (SizeT j = 0; j < dim_; ++j) {
+                sum[j] += vec_f32[j];
+            }
+        }
+        for (SizeT j = 0; j < dim_; ++j) {
+            centroid_[j] = sum[j] / train_num;
+        }
+        UpdateCentroidNorm();
+    }
+
+    RaBitQFactor Encode(const DataType *vec, u8 *code) const {
+        auto vec_f32 = MakeUniqueForOverwrite<f32[]>(dim_);
+        ToF32(vec, vec_f32.get());
+        return RaBitQEncode(vec_f32.get(), centroid_.get(), rotation_, code);
+    }
+
+    QueryType MakeQuery(const DataType *vec) const {
+        auto vec_f32 = MakeUniqueForOverwrite<f32[]>(dim_);
+        ToF32(vec, vec_f32.get());
+        return {MakeUnique<RaBitQQuery>(RaBitQEncodeQuery(vec_f32.get(), centroid_.get(), rotation_))};
+    }
+
+    SizeT dim() const { return dim_; }
+    SizeT code_bytes() const { return code_bytes_; }
+    // a factor followed by the code
+    SizeT record_size() const { return sizeof(RaBitQFactor) + code_bytes_; }
+    const f32 *centroid() const { return centroid_.get(); }
+    f32 centroid_norm_sqr() const { return centroid_norm_sqr_; }
+
+private:
+    void UpdateCentroidNorm() {
+        centroid_norm_sqr_ = 0;
+        for (SizeT j = 0; j < dim_; ++j) {
+            centroid_norm_sqr_ += centroid_[j] * centroid_[j];
+        }
+    }
+
+    void ToF32(const DataType *src, f32 *dest) const {
+        for (SizeT i = 0; i < dim_; ++i) {
+            dest[i] = static_cast<f32>(src[i]);
+        }
+        if constexpr (normalize_) {
+            f32 norm = 0;
+            for (SizeT i = 0; i < dim_; ++i) {
+                norm += dest[i] * dest[i];
+            }
+            if (norm > 0) {
+                f32 norm_inv = 1 / std::sqrt(norm);
+                for (SizeT i = 0; i < dim_; ++i) {
+                    dest[i] *= norm_inv;
+                }
+            }
+        }
+    }
+
+private:
+    SizeT dim_;
+    SizeT code_bytes_;
+    UniquePtr<f32[]> centroid_;
+
+    f32 centroid_norm_sqr_ = 0;
+    // not stored, it is made again from the dimension
+    RaBitQRotation rotation_;
+
+public:
+    void Dump(std::ostream &os) const {
+        os << "[CONST] dim: " << dim_ << ", code_bytes: " << code_bytes_ << std::endl;
+        os << "centroid: ";
+        for (SizeT i = 0; i < dim_; ++i) {
+            os << centroid_[i] << " ";
+        }
+        os << std::endl;
+    }
+};
+
+export template <typename DataType, MetricType metric>
+class RaBitQVecStoreInner {
+public:
+    using This = RaBitQVecStoreInner<DataType, metric>;
+    using Meta = RaBitQVecStoreMeta<DataType, metric>;
+
+private:
+    RaBitQVecStoreInner(SizeT max_vec_num, const Meta &meta) : ptr_(MakeUnique<u8[]>(max_vec_num * meta.record_size())), data_(ptr_.get()) {}
+    RaBitQVecStoreInner(const u8 *data) : data_(const_cast<u8 *>(data)) {}
+
+public:
+    RaBitQVecStoreInner() = default;
+
+    static This Make(SizeT max_vec_num, const Meta &meta, SizeT &mem_usage) {
+        mem_usage += max_vec_num * meta.record_size();
+        return This(max_vec_num, meta);
+    }
+
+    SizeT GetSizeInBytes(SizeT cur_vec_num, const Meta &meta) const { return cur_vec_num * meta.record_size(); }
+
+    void Save(LocalFileHandle &file_handle, SizeT cur_vec_num, const Meta &meta) const {
+        file_handle.Append(data_, cur_vec_num * meta.record_size());
+    }
+
+    static This Load(LocalFileHandle &file_handle, SizeT cur_vec_num, SizeT max_vec_num, const Meta &meta, SizeT &mem_usage) {
+        assert(cur_vec_num <= max_vec_num);
+        This ret(max_vec_num, meta);
+        file_handle.Read(ret.data_, cur_vec_num * meta.record_size());
+        mem_usage += max_vec_num * meta.record_size();
+        return ret;
+    }
+
+    void SaveToPtr(HnswPtrWriter &writer, SizeT cur_vec_num, const Meta &meta) const { writer.Write(data_, cur_vec_num * meta.record_size()); }
+
+    // view of the codes saved by `SaveToPtr`, which must not be modified
+    static This LoadFromPtr(HnswPtrReader &reader, SizeT cur_vec_num, const Meta &meta) {
+        return This(reinterpret_cast<const u8 *>(reader.Get(cur_vec_num * meta.record_size())));
+    }
+
+    This ToOwned(SizeT cur_vec_num, SizeT max_vec_num, const Meta &meta, SizeT &mem_usage) const {
+        This ret(max_vec_num, meta);
+        std::memcpy(ret.data_, data_, cur_vec_num * meta.record_size());
+        mem_usage += max_vec_num * meta.record_size();
+        return ret;
+    }
+
+    void SetVec(SizeT idx, const DataType *vec, const Meta &meta, SizeT &mem_usage) {
+        u8 *record = GetRecordMut(idx, meta);
+        RaBitQFactor factor = meta.Encode(vec, record + sizeof(RaBitQFactor));
+        std::memcpy(record, &factor, sizeof(RaBitQFactor));
+    }
+
+    void CopyVec(SizeT idx, const This &src, SizeT src_idx, const Meta &meta, SizeT &mem_usage) {
+        std::memcpy(GetRecordMut(idx, meta), src.data_ + src_idx * meta.record_size(), meta.record_size());
+    }
+
+    RaBitQVecRef GetVec(SizeT idx, const Meta &meta) const {
+        const u8 *record = data_ + idx * meta.record_size();
+        return {reinterpret_cast<const RaBitQFactor *>(record), record + sizeof(RaBitQFactor), nullptr};
+    }
+
+    void Prefetch(VertexType vec_i, const Meta &meta) const {
+        _mm_prefetch(reinterpret_cast<const char *>(GetVec(vec_i, meta).factor_), _MM_HINT_T0);
+    }
+
+private:
+    u8 *GetRecordMut(SizeT idx, const Meta &meta) { return data_ + idx * meta.record_size(); }
+
+private:
+    UniquePtr<u8[]> ptr_;
+    u8 *data_ = nullptr; // `ptr_` or the memory of a loaded file
+
+public:
+    void Dump(std::ostream &os, SizeT offset, SizeT chunk_size, const Meta &meta) const {
+        for (int i = 0; i < (int)chunk_size; ++i) {
+            os << "vec " << i << "(" << offset + i << "): ";
+            const auto [factor, code, _] = GetVec(i, meta);
+            os << "norm: " << factor->norm_ << ", ip_factor: " << factor->ip_factor_ << ", rc_ip: " << factor->rc_ip_ << ", code: ";
+            for (SizeT j = 0; j < meta.code_bytes(); ++j) {
+                os << static_cast<int>(code[j]) << " ";
+            }
+            os << std::endl;
+        }
+    }
+};
+
+} // namespace infinity
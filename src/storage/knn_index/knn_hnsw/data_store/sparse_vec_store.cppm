@@ -27,6 +27,7 @@ import stl;
 import local_file_handle;
 import hnsw_common;
 import sparse_util;
+import sparse_vec_codec;
 
 namespace infinity {
 
@@ -142,6 +143,10 @@ public:
         Copy(vec.data_, vec.data_ + vec.nnz_, dst.data_.get());
     }
 
+    void CopyVec(SizeT idx, const This &src, SizeT src_idx, const Meta &meta, SizeT &mem_usage) {
+        SetVec(idx, src.GetVec(src_idx, meta), meta, mem_usage);
+    }
+
     SparseVecRef GetVec(SizeT idx, const Meta &meta) const {
         const SparseVecEle &vec = vecs_[idx];
         return SparseVecRef(vec.nnz_, vec.indices_.get(), vec.data_.get());
@@ -169,4 +174,128 @@ public:
     }
 };
 
-} // namespace infinity
\ No newline at end of file
+// the vectors are kept in the compressed sparse format, a query is compressed in the same way
+export template <typename DataType, typename IdxType>
+class CompressedSparseVecStoreMeta {
+public:
+    using This = CompressedSparseVecStoreMeta<DataType, IdxType>;
+    using Codec = SparseVecCodec<DataType, IdxType>;
+    using QueryVecType = SparseVecRef<DataType, IdxType>;
+    using StoreType = CompressedSparseVecRef<DataType>;
+    struct CompressedSparseQuery {
+        UniquePtr<char[]> inner_;
+        operator StoreType() const { return Codec::View(inner_.get()); }
+    };
+    using QueryType = CompressedSparseQuery;
+    using DistanceType = std::conditional_t<std::is_same_v<DataType, f64>, f64, f32>;
+
+private:
+    CompressedSparseVecStoreMeta(SizeT max_dim) : max_dim_(max_dim) {}
+
+public:
+    static This Make(SizeT max_dim) { return This(max_dim); }
+    static This Make(SizeT max_dim, bool) { return This(max_dim); }
+
+    void Save(LocalFileHandle &file_handle) const { file_handle.Append(&max_dim_, sizeof(max_dim_)); }
+
+    static This Load(LocalFileHandle &file_handle) {
+        SizeT max_dim;
+        file_handle.Read(&max_dim, sizeof(max_dim));
+        return This(max_dim);
+    }
+
+    QueryType MakeQuery(QueryVecType vec) const {
+        QueryType query{MakeUniqueForOverwrite<char[]>(Codec::EncodedSize(vec))};
+        Codec::Encode(vec, query.inner_.get());
+        return query;
+    }
+
+    SizeT dim() const { return max_dim_; }
+
+private:
+    SizeT max_dim_;
+
+public:
+    void Dump(std::ostream &os) const { os << "[CONST] max dim: " << max_dim_ << std::endl; }
+};
+
+export template <typename DataType, typename IdxType>
+class CompressedSparseVecStoreInner {
+public:
+    using This = CompressedSparseVecStoreInner<DataType, IdxType>;
+    using Meta = CompressedSparseVecStoreMeta<DataType, IdxType>;
+    using Codec = SparseVecCodec<DataType, IdxType>;
+    using SparseVecRef = SparseVecRef<DataType, IdxType>;
+    using StoreType = CompressedSparseVecRef<DataType>;
+
+private:
+    CompressedSparseVecStoreInner(SizeT max_vec_num, const Meta &meta)
+        : sizes_(MakeUniqueForOverwrite<u32[]>(max_vec_num)), vecs_(MakeUnique<UniquePtr<char[]>[]>(max_vec_num)) {}
+
+public:
+    CompressedSparseVecStoreInner() = default;
+
+    static This Make(SizeT max_vec_num, const Meta &meta, SizeT &mem_usage) {
+        auto ret = This(max_vec_num, meta);
+        mem_usage += (sizeof(u32) + sizeof(UniquePtr<char[]>)) * max_vec_num;
+        return ret;
+    }
+
+    void Save(LocalFileHandle &file_handle, SizeT cur_vec_num, const Meta &meta) const {
+        file_handle.Append(sizes_.get(), sizeof(u32) * cur_vec_num);
+        for (SizeT i = 0; i < cur_vec_num; ++i) {
+            file_handle.Append(vecs_[i].get(), sizes_[i]);
+        }
+    }
+
+    static This Load(LocalFileHandle &file_handle, SizeT cur_vec_num, SizeT max_vec_num, const Meta &meta, SizeT &mem_usage) {
+        This ret(max_vec_num, meta);
+        mem_usage += (sizeof(u32) + sizeof(UniquePtr<char[]>)) * max_vec_num;
+        file_handle.Read(ret.sizes_.get(), sizeof(u32) * cur_vec_num);
+        for (SizeT i = 0; i < cur_vec_num; ++i) {
+            ret.vecs_[i] = MakeUniqueForOverwrite<char[]>(ret.sizes_[i]);
+            file_handle.Read(ret.vecs_[i].get(), ret.sizes_[i]);
+            mem_usage += ret.sizes_[i];
+        }
+        return ret;
+    }
+
+    void SetVec(SizeT idx, const SparseVecRef &vec, const Meta &meta, SizeT &mem_usage) {
+        sizes_[idx] = Codec::EncodedSize(vec);
+        vecs_[idx] = MakeUniqueForOverwrite<char[]>(sizes_[idx]);
+        Codec::Encode(vec, vecs_[idx].get());
+        mem_usage += sizes_[idx];
+    }
+
+    void CopyVec(SizeT idx, const This &src, SizeT src_idx, const Meta &meta, SizeT &mem_usage) {
+        sizes_[idx] = src.sizes_[src_idx];
+        vecs_[idx] = MakeUniqueForOverwrite<char[]>(sizes_[idx]);
+        Copy(src.vecs_[src_idx].get(), src.vecs_[src_idx].get() + sizes_[idx], vecs_[idx].get());
+        mem_usage += sizes_[idx];
+    }
+
+    StoreType GetVec(SizeT idx, const Meta &meta) const { return Codec::View(vecs_[idx].get()); }
+
+    void Prefetch(SizeT idx, const Meta &meta) const { _mm_prefetch(vecs_[idx].get(), _MM_HINT_T0); }
+
+private:
+    UniquePtr<u32[]> sizes_;
+    UniquePtr<UniquePtr<char[]>[]> vecs_;
+
+public:
+    void Dump(std::ostream &os, SizeT offset, SizeT chunk_size, const Meta &meta) const {
+        for (int i = 0; i < (int)chunk_size; ++i) {
+            os << "vec " << i << "(" << i + offset << "): ";
+            StoreType vec = GetVec(i, meta);
+            auto indices = MakeUniqueForOverwrite<IdxType[]>(vec.nnz_);
+            auto data = MakeUniqueForOverwrite<DataType[]>(vec.nnz_);
+            Codec::Decode(vec, indices.get(), data.get());
+            for (i32 j = 0; j < vec.nnz_; ++j) {
+                os << indices[j] << ":" << data[j] << " ";
+            }
+            os << std::endl;
+        }
+    }
+};
+
+} // namespace infinity
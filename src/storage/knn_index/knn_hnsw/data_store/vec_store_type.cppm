@@ -20,11 +20,17 @@ import stl;
 import plain_vec_store;
 import sparse_vec_store;
 import lvq_vec_store;
+import pq_vec_store;
+import rabitq_vec_store;
 import dist_func_cos;
 import dist_func_l2;
 import dist_func_ip;
+import dist_func_hamming;
 import dist_func_sparse_ip;
+import dist_func_pq;
+import dist_func_rabitq;
 import sparse_util;
+import index_base;
 
 namespace infinity {
 
@@ -37,6 +43,24 @@ class LVQL2VecStoreType;
 export template <typename DataT, typename CompressT>
 class LVQIPVecStoreType;
 
+export template <typename DataT>
+class PQCosVecStoreType;
+
+export template <typename DataT>
+class PQL2VecStoreType;
+
+export template <typename DataT>
+class PQIPVecStoreType;
+
+export template <typename DataT>
+class RaBitQCosVecStoreType;
+
+export template <typename DataT>
+class RaBitQL2VecStoreType;
+
+export template <typename DataT>
+class RaBitQIPVecStoreType;
+
 export template <typename DataT>
 class PlainCosVecStoreType {
 public:
@@ -55,6 +79,10 @@ public:
     static constexpr LVQCosVecStoreType<DataType, CompressType> ToLVQ() {
         return {};
     }
+
+    static constexpr PQCosVecStoreType<DataType> ToPQ() { return {}; }
+
+    static constexpr RaBitQCosVecStoreType<DataType> ToRaBitQ() { return {}; }
 };
 
 export template <typename DataT>
@@ -75,6 +103,10 @@ public:
     static constexpr LVQL2VecStoreType<DataType, CompressType> ToLVQ() {
         return {};
     }
+
+    static constexpr PQL2VecStoreType<DataType> ToPQ() { return {}; }
+
+    static constexpr RaBitQL2VecStoreType<DataType> ToRaBitQ() { return {}; }
 };
 
 export template <typename DataT>
@@ -95,6 +127,32 @@ public:
     static constexpr LVQIPVecStoreType<DataType, CompressType> ToLVQ() {
         return {};
     }
+
+    static constexpr PQIPVecStoreType<DataType> ToPQ() { return {}; }
+
+    static constexpr RaBitQIPVecStoreType<DataType> ToRaBitQ() { return {}; }
+};
+
+// bit vectors, packed 8 bits a byte, are not encoded further
+export template <typename DataT>
+class PlainHammingVecStoreType {
+public:
+    using This = PlainHammingVecStoreType<DataT>;
+    using DataType = DataT;
+    using CompressType = void;
+    using Meta = PlainVecStoreMeta<DataType>;
+    using Inner = PlainVecStoreInner<DataType>;
+    using QueryVecType = const DataType *;
+    using StoreType = typename Meta::StoreType;
+    using QueryType = typename Meta::QueryType;
+    using Distance = PlainHammingDist<DataType>;
+
+    static constexpr bool HasOptimize = false;
+
+    template <typename CompressType>
+    static constexpr This ToLVQ() {
+        return {};
+    }
 };
 
 export template <typename DataT, typename IndexT>
@@ -117,6 +175,28 @@ public:
     }
 };
 
+// The sparse vectors in the format of `SparseVecCodec`. It is chosen explicitly as the store of a sparse graph, the LVQ compression of
+// `SparseIPVecStoreType` keeps the raw vectors.
+export template <typename DataT, typename IndexT>
+class CompressedSparseIPVecStoreType {
+public:
+    using DataType = DataT;
+    using CompressType = i8;
+    using Meta = CompressedSparseVecStoreMeta<DataT, IndexT>;
+    using Inner = CompressedSparseVecStoreInner<DataT, IndexT>;
+    using QueryVecType = SparseVecRef<DataT, IndexT>;
+    using StoreType = typename Meta::StoreType;
+    using QueryType = typename Meta::QueryType;
+    using Distance = CompressedSparseIPDist<DataT, IndexT>;
+
+    static constexpr bool HasOptimize = false;
+
+    template <typename CompressType>
+    static constexpr CompressedSparseIPVecStoreType<DataType, IndexT> ToLVQ() {
+        return {};
+    }
+};
+
 export template <typename DataT, typename CompressT>
 class LVQCosVecStoreType {
 public:
@@ -177,4 +257,139 @@ public:
     }
 };
 
+export template <typename DataT>
+class PQCosVecStoreType {
+public:
+    using DataType = DataT;
+    using CompressType = void;
+    using Meta = PQVecStoreMeta<DataType, MetricType::kMetricCosine>;
+    using Inner = PQVecStoreInner<DataType, MetricType::kMetricCosine>;
+    using QueryVecType = const DataType *;
+    using StoreType = typename Meta::StoreType;
+    using QueryType = typename Meta::QueryType;
+    using Distance = PQDist<DataType, MetricType::kMetricCosine>;
+
+    static constexpr bool HasOptimize = false;
+
+    template <typename CompressType>
+    static constexpr PQCosVecStoreType<DataType> ToLVQ() {
+        return {};
+    }
+};
+
+export template <typename DataT>
+class PQL2VecStoreType {
+public:
+    using DataType = DataT;
+    using CompressType = void;
+    using Meta = PQVecStoreMeta<DataType, MetricType::kMetricL2>;
+    using Inner = PQVecStoreInner<DataType, MetricType::kMetricL2>;
+    using QueryVecType = const DataType *;
+    using StoreType = typename Meta::StoreType;
+    using QueryType = typename Meta::QueryType;
+    using Distance = PQDist<DataType, MetricType::kMetricL2>;
+
+    static constexpr bool HasOptimize = false;
+
+    template <typename CompressType>
+    static constexpr PQL2VecStoreType<DataType> ToLVQ() {
+        return {};
+    }
+};
+
+export template <typename DataT>
+class PQIPVecStoreType {
+public:
+    using DataType = DataT;
+    using CompressType = void;
+    using Meta = PQVecStoreMeta<DataType, MetricType::kMetricInnerProduct>;
+    using Inner = PQVecStoreInner<DataType, MetricType::kMetricInnerProduct>;
+    using QueryVecType = const DataType *;
+    using StoreType = typename Meta::StoreType;
+    using QueryType = typename Meta::QueryType;
+    using Distance = PQDist<DataType, MetricType::kMetricInnerProduct>;
+
+    static constexpr bool HasOptimize = false;
+
+    template <typename CompressType>
+    static constexpr PQIPVecStoreType<DataType> ToLVQ() {
+        return {};
+    }
+};
+
+export template <typename DataT>
+class RaBitQCosVecStoreType {
+public:
+    using DataType = DataT;
+    using CompressType = void;
+    using Meta = RaBitQVecStoreMeta<DataType, MetricType::kMetricCosine>;
+    using Inner = RaBitQVecStoreInner<DataType, MetricType::kMetricCosine>;
+    using QueryVecType = const DataType *;
+    using StoreType = typename Meta::StoreType;
+    using QueryType = typename Meta::QueryType;
+    using Distance = RaBitQDist<DataType, MetricType::kMetricCosine>;
+
+    static constexpr bool HasOptimize = false;
+    static constexpr bool NeedRerank = true;
+
+    template <typename CompressType>
+    static constexpr RaBitQCosVecStoreType<DataType> ToLVQ() {
+        return {};
+    }
+};
+
+export template <typename DataT>
+class RaBitQL2VecStoreType {
+public:
+    using DataType = DataT;
+    using CompressType = void;
+    using Meta = RaBitQVecStoreMeta<DataType, MetricType::kMetricL2>;
+    using Inner = RaBitQVecStoreInner<DataType, MetricType::kMetricL2>;
+    using QueryVecType = const DataType *;
+    using StoreType = typename Meta::StoreType;
+    using QueryType = typename Meta::QueryType;
+    using Distance = RaBitQDist<DataType, MetricType::kMetricL2>;
+
+    static constexpr bool HasOptimize = false;
+    static constexpr bool NeedRerank = true;
+
+    template <typename CompressType>
+    static constexpr RaBitQL2VecStoreType<DataType> ToLVQ() {
+        return {};
+    }
+};
+
+export template <typename DataT>
+class RaBitQIPVecStoreType {
+public:
+    using DataType = DataT;
+    using CompressType = void;
+    using Meta = RaBitQVecStoreMeta<DataType, MetricType::kMetricInnerProduct>;
+    using Inner = RaBitQVecStoreInner<DataType, MetricType::kMetricInnerProduct>;
+    using QueryVecType = const DataType *;
+    using StoreType = typename Meta::StoreType;
+    using QueryType = typename Meta::QueryType;
+    using Distance = RaBitQDist<DataType, MetricType::kMetricInnerProduct>;
+
+    static constexpr bool HasOptimize = false;
+    static constexpr bool NeedRerank = true;
+
+    template <typename CompressType>
+    static constexpr RaBitQIPVecStoreType<DataType> ToLVQ() {
+        return {};
+    }
+};
+
+// plain vec store types which can be encoded with product quantization
+export template <typename VecStoreType>
+concept PQCompressible = requires { VecStoreType::ToPQ(); };
+
+// plain vec store types which can be encoded with 1 bit quantization
+export template <typename VecStoreType>
+concept RaBitQCompressible = requires { VecStoreType::ToRaBitQ(); };
+
+// vec store types whose distances are too coarse to be returned without reranking with the exact distance
+export template <typename VecStoreType>
+concept RerankRequired = requires { requires VecStoreType::NeedRerank; };
+
 } // namespace infinity
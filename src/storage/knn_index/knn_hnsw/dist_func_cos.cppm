@@ -20,6 +20,7 @@ import stl;
 import logger;
 import third_party;
 import hnsw_common;
+import internal_types;
 import plain_vec_store;
 import lvq_vec_store;
 import simd_functions;
@@ -39,7 +40,10 @@ public:
     using DistanceType = typename VecStoreMeta::DistanceType;
 
 private:
-    using SIMDFuncType = f32 (*)(const DataType *, const DataType *, SizeT);
+    // fp16 and bf16 are computed from their raw bits
+    static constexpr bool kHalf = std::is_same_v<DataType, Float16T> || std::is_same_v<DataType, BFloat16T>;
+    using SIMDDataType = std::conditional_t<kHalf, u16, DataType>;
+    using SIMDFuncType = f32 (*)(const SIMDDataType *, const SIMDDataType *, SizeT);
 
     SIMDFuncType SIMDFunc = nullptr;
 
@@ -65,11 +69,19 @@ public:
             SIMDFunc = GetSIMD_FUNCTIONS().HNSW_U8Cos_ptr_;
         } else if constexpr (std::is_same<DataType, i8>()) {
             SIMDFunc = GetSIMD_FUNCTIONS().HNSW_I8Cos_ptr_;
+        } else if constexpr (std::is_same<DataType, Float16T>()) {
+            SIMDFunc = GetSIMD_FUNCTIONS().F16CosineDistance_func_ptr_;
+        } else if constexpr (std::is_same<DataType, BFloat16T>()) {
+            SIMDFunc = GetSIMD_FUNCTIONS().BF16CosineDistance_func_ptr_;
         }
     }
 
     DistanceType operator()(const StoreType &v1, const StoreType &v2, const VecStoreMeta &vec_store_meta) const {
-        return -SIMDFunc(v1, v2, vec_store_meta.dim());
+        if constexpr (kHalf) {
+            return -SIMDFunc(reinterpret_cast<const u16 *>(v1), reinterpret_cast<const u16 *>(v2), vec_store_meta.dim());
+        } else {
+            return -SIMDFunc(v1, v2, vec_store_meta.dim());
+        }
     }
 
     LVQCosDist<DataType, i8> ToLVQDistance(SizeT dim) &&;
@@ -0,0 +1,59 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+import stl;
+import hnsw_common;
+import plain_vec_store;
+import simd_functions;
+
+export module dist_func_hamming;
+
+namespace infinity {
+
+// The hamming distance of bit vectors, which are stored packed, 8 bits a byte. The dimension of the store is the number of bytes.
+export template <typename DataType>
+class PlainHammingDist {
+    static_assert(std::is_same_v<DataType, u8>, "bit vectors are stored as u8");
+
+public:
+    using VecStoreMeta = PlainVecStoreMeta<DataType>;
+    using StoreType = typename VecStoreMeta::StoreType;
+    using DistanceType = typename VecStoreMeta::DistanceType;
+
+private:
+    using SIMDFuncType = f32 (*)(const u8 *, const u8 *, SizeT);
+
+    SIMDFuncType SIMDFunc = nullptr;
+
+public:
+    PlainHammingDist() : SIMDFunc(nullptr) {}
+    PlainHammingDist(PlainHammingDist &&other) : SIMDFunc(std::exchange(other.SIMDFunc, nullptr)) {}
+    PlainHammingDist &operator=(PlainHammingDist &&other) {
+        if (this != &other) {
+            SIMDFunc = std::exchange(other.SIMDFunc, nullptr);
+        }
+        return *this;
+    }
+    ~PlainHammingDist() = default;
+
+    PlainHammingDist(SizeT) { SIMDFunc = GetSIMD_FUNCTIONS().HammingDistance_func_ptr_; }
+
+    DistanceType operator()(const StoreType &v1, const StoreType &v2, const VecStoreMeta &vec_store_meta) const {
+        return SIMDFunc(v1, v2, vec_store_meta.dim());
+    }
+};
+
+} // namespace infinity
@@ -18,6 +18,7 @@ module;
 
 import stl;
 import hnsw_common;
+import internal_types;
 import plain_vec_store;
 import lvq_vec_store;
 import simd_functions;
@@ -37,7 +38,10 @@ public:
     using DistanceType = typename VecStoreMeta::DistanceType;
 
 private:
-    using SIMDFuncType = std::conditional_t<std::is_same_v<DataType, float>, f32, i32> (*)(const DataType *, const DataType *, SizeT);
+    // fp16 and bf16 are computed from their raw bits
+    static constexpr bool kHalf = std::is_same_v<DataType, Float16T> || std::is_same_v<DataType, BFloat16T>;
+    using SIMDDataType = std::conditional_t<kHalf, u16, DataType>;
+    using SIMDFuncType = std::conditional_t<std::is_same_v<DataType, float> || kHalf, f32, i32> (*)(const SIMDDataType *, const SIMDDataType *, SizeT);
 
     SIMDFuncType SIMDFunc = nullptr;
 
@@ -78,11 +82,19 @@ public:
             } else {
                 SIMDFunc = GetSIMD_FUNCTIONS().HNSW_U8IP_ptr_;
             }
+        } else if constexpr (std::is_same<DataType, Float16T>()) {
+            SIMDFunc = GetSIMD_FUNCTIONS().F16IPDistance_func_ptr_;
+        } else if constexpr (std::is_same<DataType, BFloat16T>()) {
+            SIMDFunc = GetSIMD_FUNCTIONS().BF16IPDistance_func_ptr_;
         }
     }
 
     DistanceType operator()(const StoreType &v1, const StoreType &v2, const VecStoreMeta &vec_store_meta) const {
-        return -SIMDFunc(v1, v2, vec_store_meta.dim());
+        if constexpr (kHalf) {
+            return -SIMDFunc(reinterpret_cast<const u16 *>(v1), reinterpret_cast<const u16 *>(v2), vec_store_meta.dim());
+        } else {
+            return -SIMDFunc(v1, v2, vec_store_meta.dim());
+        }
     }
 
     LVQIPDist<DataType, i8> ToLVQDistance(SizeT dim) &&;
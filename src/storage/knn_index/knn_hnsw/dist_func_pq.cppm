@@ -0,0 +1,60 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+export module dist_func_pq;
+
+import stl;
+import pq_vec_store;
+import index_base;
+import simd_functions;
+import simd_init;
+
+namespace infinity {
+
+export template <typename DataType, MetricType metric>
+class PQDist {
+public:
+    using VecStoreMeta = PQVecStoreMeta<DataType, metric>;
+    using StoreType = typename VecStoreMeta::StoreType;
+    using DistanceType = typename VecStoreMeta::DistanceType;
+
+private:
+    PQ8ADCFuncType SIMDFunc = nullptr;
+
+public:
+    PQDist() : SIMDFunc(nullptr) {}
+    PQDist(PQDist &&other) : SIMDFunc(std::exchange(other.SIMDFunc, nullptr)) {}
+    PQDist &operator=(PQDist &&other) {
+        if (this != &other) {
+            SIMDFunc = std::exchange(other.SIMDFunc, nullptr);
+        }
+        return *this;
+    }
+    ~PQDist() = default;
+    PQDist(SizeT) : SIMDFunc(GetSIMD_FUNCTIONS().HNSW_PQ8ADC_ptr_) {}
+
+    DistanceType operator()(const StoreType &v1, const StoreType &v2, const VecStoreMeta &vec_store_meta) const {
+        if (v1.lut_ != nullptr) {
+            return SIMDFunc(v1.lut_, v2.codes_, vec_store_meta.subspace_num());
+        }
+        if (v2.lut_ != nullptr) {
+            return SIMDFunc(v2.lut_, v1.codes_, vec_store_meta.subspace_num());
+        }
+        return vec_store_meta.SymmetricDistance(v1.codes_, v2.codes_);
+    }
+};
+
+} // namespace infinity
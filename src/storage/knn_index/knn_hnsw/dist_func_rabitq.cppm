@@ -0,0 +1,65 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+export module dist_func_rabitq;
+
+import stl;
+import rabitq_vec_store;
+import rabitq_quantizer;
+import index_base;
+
+namespace infinity {
+
+export template <typename DataType, MetricType metric>
+class RaBitQDist {
+public:
+    using VecStoreMeta = RaBitQVecStoreMeta<DataType, metric>;
+    using StoreType = typename VecStoreMeta::StoreType;
+    using DistanceType = typename VecStoreMeta::DistanceType;
+
+public:
+    RaBitQDist() = default;
+    RaBitQDist(RaBitQDist &&other) = default;
+    RaBitQDist &operator=(RaBitQDist &&other) = default;
+    ~RaBitQDist() = default;
+    RaBitQDist(SizeT) {}
+
+    DistanceType operator()(const StoreType &v1, const StoreType &v2, const VecStoreMeta &vec_store_meta) const {
+        if (v1.query_ != nullptr) {
+            return QueryDistance(*v1.query_, v2, vec_store_meta);
+        }
+        if (v2.query_ != nullptr) {
+            return QueryDistance(*v2.query_, v1, vec_store_meta);
+        }
+        const f32 residual_ip = RaBitQResidualIP(*v1.factor_, v1.code_, *v2.factor_, v2.code_, vec_store_meta.dim());
+        if constexpr (metric == MetricType::kMetricL2) {
+            return v1.factor_->norm_ * v1.factor_->norm_ + v2.factor_->norm_ * v2.factor_->norm_ - 2 * residual_ip;
+        } else {
+            return -(residual_ip + v1.factor_->rc_ip_ + v2.factor_->rc_ip_ + vec_store_meta.centroid_norm_sqr());
+        }
+    }
+
+private:
+    static DistanceType QueryDistance(const RaBitQQuery &query, const StoreType &v, const VecStoreMeta &vec_store_meta) {
+        if constexpr (metric == MetricType::kMetricL2) {
+            return RaBitQL2Distance(*v.factor_, v.code_, query, vec_store_meta.code_bytes());
+        } else {
+            return -RaBitQIPDistance(*v.factor_, v.code_, query, vec_store_meta.code_bytes());
+        }
+    }
+};
+
+} // namespace infinity
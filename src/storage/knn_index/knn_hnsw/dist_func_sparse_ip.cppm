@@ -20,6 +20,7 @@ import stl;
 import sparse_vec_store;
 import sparse_vector_distance;
 import sparse_util;
+import sparse_vec_codec;
 
 namespace infinity {
 
@@ -38,4 +39,19 @@ public:
     }
 };
 
+export template <typename DataType, typename IdxType>
+class CompressedSparseIPDist {
+public:
+    using VecStoreMeta = CompressedSparseVecStoreMeta<DataType, IdxType>;
+    using StoreType = typename VecStoreMeta::StoreType;
+    using DistanceType = typename VecStoreMeta::DistanceType;
+
+public:
+    CompressedSparseIPDist(SizeT dim) {}
+
+    DataType operator()(const StoreType &v1, const StoreType &v2, const VecStoreMeta &vec_store_meta) const {
+        return -CompressedSparseIP(v1, v2);
+    }
+};
+
 } // namespace infinity
\ No newline at end of file
@@ -41,12 +41,28 @@ namespace infinity {
 export struct KnnSearchOption {
     SizeT ef_ = 0;
     LogicalType column_logical_type_ = LogicalType::kEmbedding;
+    // walk only the vertices passing the filter, see `SearchLayer`
+    bool predicate_aware_ = false;
+    // the number of vertices of the index passing the filter if it is known, a predicate aware search finding fewer is retried by walking
+    // all the vertices
+    SizeT filter_pass_n_ = std::numeric_limits<SizeT>::max();
+    // stop the search of layer 0 after this many expansions in a row do not change the result, 0 means no early termination
+    SizeT patience_ = 0;
+    // the vertices further than this are not in the final result, e.g. the k-th distance found by the other tasks of a scan
+    f32 distance_bound_ = std::numeric_limits<f32>::max();
 };
 
+// a filter passing less than this fraction of the rows switches to the predicate aware search
+export constexpr f32 kHnswPredicateAwareSelectivity = 0.1;
+
+// candidates per result of a graph built on the truncated vectors, which are reranked with the full vectors
+export constexpr SizeT kHnswTruncatedRerankFactor = 4;
+
 export template <typename VecStoreType, typename LabelType>
 class KnnHnsw {
 public:
     using This = KnnHnsw<VecStoreType, LabelType>;
+    using VecStoreT = VecStoreType;
     using DataType = typename VecStoreType::DataType;
     using QueryVecType = typename VecStoreType::QueryVecType;
     using StoreType = typename VecStoreType::StoreType;
@@ -116,6 +132,38 @@ public:
         return MakeUnique<This>(M, ef_construction, std::move(data_store), std::move(distance));
     }
 
+    // the layout which can be searched from a memory mapping of the file, see `kHnswFileMagic`
+    void SaveToPtr(LocalFileHandle &file_handle) const {
+        HnswPtrWriter writer(file_handle);
+        writer.Write(kHnswFileMagic);
+        writer.Write(M_);
+        writer.Write(ef_construction_);
+        data_store_.SaveToPtr(writer);
+    }
+
+    // `ptr` is the content of a file saved by `SaveToPtr`, aligned to `kHnswFileAlign`. The index searches it without copy, so it must
+    // outlive the index or until `Materialize` is called. The index copies the memory by itself before it is modified.
+    static UniquePtr<This> LoadFromPtr(const char *ptr, SizeT size, bool lock_upper_layers = false) {
+        if (reinterpret_cast<SizeT>(ptr) % kHnswFileAlign != 0) {
+            UnrecoverableError("Hnsw file is not aligned in memory.");
+        }
+        HnswPtrReader reader(ptr, size);
+        if (reader.Read<u64>() != kHnswFileMagic) {
+            UnrecoverableError("Invalid hnsw file.");
+        }
+        SizeT M = reader.Read<SizeT>();
+        SizeT ef_construction = reader.Read<SizeT>();
+
+        auto data_store = DataStore::LoadFromPtr(reader, lock_upper_layers);
+        Distance distance(data_store.dim());
+
+        return MakeUnique<This>(M, ef_construction, std::move(data_store), std::move(distance));
+    }
+
+    void Materialize() { data_store_.Materialize(); }
+
+    bool own_mem() const { return data_store_.own_mem(); }
+
 private:
     // >= 0
     i32 GenerateRandomLayer() {
@@ -130,12 +178,24 @@ private:
     using SearchLayerReturnParam3T = std::conditional_t<ColumnLogicalType == LogicalType::kEmbedding, VertexType, LabelType>;
 
     // return the nearest `ef_construction_` neighbors of `query` in layer `layer_idx`
+    // With `option.predicate_aware_` (ACORN-1), only the vertices passing `filter` are computed and expanded. A filtered out neighbor is
+    // replaced by its own neighbors, so that the search keeps connected through the sparse subgraph of matching vertices under a restrictive
+    // filter. If it finds fewer than `result_n` of the matching vertices, the search is run again without it.
+    // With `option.patience_`, the search stops once that many expansions in a row have not brought a closer vertex into a full result, so
+    // that an easy query does not walk until the whole `result_n` frontier is exhausted.
+    // With `option.distance_bound_`, the vertices further than the bound are left out of the returned result. The walk itself still follows
+    // the local result, a tighter threshold would stop it before it reaches the region of the true neighbors.
     template <bool WithLock,
               FilterConcept<LabelType> Filter = NoneType,
               LogicalType ColumnLogicalType = LogicalType::kEmbedding,
               typename MultiVectorInnerTopnIndexType = void>
     Tuple<SizeT, UniquePtr<DistanceType[]>, UniquePtr<SearchLayerReturnParam3T<ColumnLogicalType>[]>>
-    SearchLayer(VertexType enter_point, const StoreType &query, i32 layer_idx, SizeT result_n, const Filter &filter) const {
+    SearchLayer(VertexType enter_point,
+                const StoreType &query,
+                i32 layer_idx,
+                SizeT result_n,
+                const Filter &filter,
+                const KnnSearchOption &option = {}) const {
         static_assert(ColumnLogicalType == LogicalType::kEmbedding || ColumnLogicalType == LogicalType::kMultiVector);
         auto d_ptr = MakeUniqueForOverwrite<DistanceType[]>(result_n);
         auto i_ptr = MakeUniqueForOverwrite<SearchLayerReturnParam3T<ColumnLogicalType>[]>(result_n);
@@ -180,13 +240,90 @@ private:
         Vector<bool> visited(cur_vec_num, false);
         visited[enter_point] = true;
 
+        Vector<VertexType> hop1;
+        Vector<VertexType> hop2;
+        auto copy_neighbors = [&](VertexType v_idx, Vector<VertexType> &dest) {
+            std::shared_lock<std::shared_mutex> lock;
+            if constexpr (WithLock) {
+                lock = data_store_.SharedLock(v_idx);
+            }
+            const auto [neighbors_p, neighbor_size] = data_store_.GetNeighbors(v_idx, layer_idx);
+            dest.assign(neighbors_p, neighbors_p + neighbor_size);
+        };
+        bool improved = false;
+        SizeT stale_n = 0;
+        // the furthest distance of a full result which is worth expanding
+        auto furthest = [&] { return result_handler.GetDistance0(0); };
+        auto visit = [&](VertexType n_idx) {
+            auto dist = distance_(query, data_store_.GetVec(n_idx), data_store_.vec_store_meta());
+            if (result_handler.GetSize(0) < result_n || dist <= furthest()) {
+                improved = true;
+                candidate.emplace(-dist, n_idx);
+                add_result(dist, n_idx);
+            }
+        };
+
         while (!candidate.empty()) {
+            if (option.patience_ > 0) {
+                if (improved || result_handler.GetSize(0) < result_n) {
+                    stale_n = 0;
+                } else if (++stale_n > option.patience_) {
+                    break;
+                }
+                improved = false;
+            }
             const auto [minus_c_dist, c_idx] = candidate.top();
             candidate.pop();
-            if (result_handler.GetSize(0) == result_n && -minus_c_dist > result_handler.GetDistance0(0)) {
+            if (result_handler.GetSize(0) == result_n && -minus_c_dist > furthest()) {
                 break;
             }
 
+            if constexpr (!std::is_same_v<Filter, NoneType>) {
+                if (option.predicate_aware_) {
+                    // the neighbor lists are copied out, so that no two vertex locks are held together
+                    copy_neighbors(c_idx, hop1);
+                    SizeT hop1_size = hop1.size();
+                    if constexpr (PrefetchFilterConcept<Filter, LabelType>) {
+                        for (VertexType n_idx : hop1) {
+                            if (n_idx < (VertexType)cur_vec_num) {
+                                filter.Prefetch(this->GetLabel(n_idx));
+                            }
+                        }
+                    }
+                    for (SizeT i = 0; i < hop1_size; ++i) {
+                        VertexType n_idx = hop1[i];
+                        if (n_idx >= (VertexType)cur_vec_num || visited[n_idx]) {
+                            continue;
+                        }
+                        visited[n_idx] = true;
+                        if (filter(this->GetLabel(n_idx))) {
+                            visit(n_idx);
+                        } else {
+                            hop1.push_back(n_idx);
+                        }
+                    }
+                    for (SizeT i = hop1_size; i < hop1.size(); ++i) {
+                        copy_neighbors(hop1[i], hop2);
+                        if constexpr (PrefetchFilterConcept<Filter, LabelType>) {
+                            for (VertexType m_idx : hop2) {
+                                if (m_idx < (VertexType)cur_vec_num) {
+                                    filter.Prefetch(this->GetLabel(m_idx));
+                                }
+                            }
+                        }
+                        for (VertexType m_idx : hop2) {
+                            // a filtered out vertex is not marked, it can still lead to the matching vertices around it
+                            if (m_idx >= (VertexType)cur_vec_num || visited[m_idx] || !filter(this->GetLabel(m_idx))) {
+                                continue;
+                            }
+                            visited[m_idx] = true;
+                            visit(m_idx);
+                        }
+                    }
+                    continue;
+                }
+            }
+
             std::shared_lock<std::shared_mutex> lock;
             if constexpr (WithLock) {
                 lock = data_store_.SharedLock(c_idx);
@@ -208,15 +345,36 @@ private:
                     }
                     prefetch_start -= prefetch_step_;
                 }
-                auto dist = distance_(query, data_store_.GetVec(n_idx), data_store_.vec_store_meta());
-                if (result_handler.GetSize(0) < result_n || dist <= result_handler.GetDistance0(0)) {
-                    candidate.emplace(-dist, n_idx);
-                    add_result(dist, n_idx);
-                }
+                visit(n_idx);
             }
         }
         result_handler.EndWithoutSort();
-        return {result_handler.GetSize(0), std::move(d_ptr), std::move(i_ptr)};
+        if constexpr (!std::is_same_v<Filter, NoneType>) {
+            if (option.predicate_aware_ && result_handler.GetSize(0) < std::min(result_n, option.filter_pass_n_)) {
+                // the matching vertices are not connected through their 2 hop neighbors, walk all the vertices instead
+                KnnSearchOption fallback_option = option;
+                fallback_option.predicate_aware_ = false;
+                return SearchLayer<WithLock, Filter, ColumnLogicalType, MultiVectorInnerTopnIndexType>(enter_point,
+                                                                                                        query,
+                                                                                                        layer_idx,
+                                                                                                        result_n,
+                                                                                                        filter,
+                                                                                                        fallback_option);
+            }
+        }
+        SizeT result_size = result_handler.GetSize(0);
+        if (option.distance_bound_ < std::numeric_limits<f32>::max()) {
+            SizeT kept_n = 0;
+            for (SizeT i = 0; i < result_size; ++i) {
+                if (static_cast<f64>(d_ptr[i]) <= option.distance_bound_) {
+                    d_ptr[kept_n] = d_ptr[i];
+                    i_ptr[kept_n] = i_ptr[i];
+                    ++kept_n;
+                }
+            }
+            result_size = kept_n;
+        }
+        return {result_size, std::move(d_ptr), std::move(i_ptr)};
     }
 
     template <bool WithLock>
@@ -246,6 +404,62 @@ private:
         return cur_p;
     }
 
+    // greedy search in layer `layer_idx` for a batch of queries, `cur_ps` are the enter points and are replaced by the nearest vertices.
+    // Queries which stand on the same vertex read its neighbor list under one lock, and the vector of a neighbor is loaded once for all of them.
+    template <bool WithLock>
+    void SearchLayerNearestBatch(VertexType *cur_ps, const StoreType *queries, SizeT query_n, i32 layer_idx) const {
+        Vector<DistanceType> cur_dists(query_n);
+        Vector<SizeT> active(query_n);
+        for (SizeT q = 0; q < query_n; ++q) {
+            cur_dists[q] = distance_(queries[q], data_store_.GetVec(cur_ps[q]), data_store_.vec_store_meta());
+            active[q] = q;
+        }
+        Vector<bool> changed(query_n, false);
+        Vector<SizeT> next_active;
+        while (!active.empty()) {
+            std::sort(active.begin(), active.end(), [&](SizeT q1, SizeT q2) { return cur_ps[q1] < cur_ps[q2]; });
+            next_active.clear();
+            for (SizeT group_begin = 0; group_begin < active.size();) {
+                const VertexType group_p = cur_ps[active[group_begin]];
+                SizeT group_end = group_begin + 1;
+                while (group_end < active.size() && cur_ps[active[group_end]] == group_p) {
+                    ++group_end;
+                }
+
+                std::shared_lock<std::shared_mutex> lock;
+                if constexpr (WithLock) {
+                    lock = data_store_.SharedLock(group_p);
+                }
+
+                const auto [neighbors_p, neighbor_size] = data_store_.GetNeighbors(group_p, layer_idx);
+                for (int i = neighbor_size - 1; i >= 0; --i) {
+                    if (i > 0) {
+                        data_store_.PrefetchVec(neighbors_p[i - 1]);
+                    }
+                    VertexType n_idx = neighbors_p[i];
+                    StoreType n_vec = data_store_.GetVec(n_idx);
+                    for (SizeT j = group_begin; j < group_end; ++j) {
+                        SizeT q = active[j];
+                        auto n_dist = distance_(queries[q], n_vec, data_store_.vec_store_meta());
+                        if (n_dist < cur_dists[q]) {
+                            cur_ps[q] = n_idx;
+                            cur_dists[q] = n_dist;
+                            changed[q] = true;
+                        }
+                    }
+                }
+                for (SizeT j = group_begin; j < group_end; ++j) {
+                    if (SizeT q = active[j]; changed[q]) {
+                        changed[q] = false;
+                        next_active.push_back(q);
+                    }
+                }
+                group_begin = group_end;
+            }
+            std::swap(active, next_active);
+        }
+    }
+
     // the function does not need mutex because the lock of `result_p` is already acquired
     void SelectNeighborsHeuristic(Vector<PDV> candidates, SizeT M, VertexType *result_p, VertexListSize *result_size_p) const {
         VertexListSize result_size = 0;
@@ -310,18 +524,23 @@ private:
     LabelType GetLabel(VertexType vertex_i) const { return data_store_.GetLabel(vertex_i); }
 
     template <bool WithLock, FilterConcept<LabelType> Filter, LogicalType ColumnLogicalType>
-    auto SearchLayerHelper(VertexType enter_point, const StoreType &query, i32 layer_idx, SizeT result_n, const Filter &filter) const {
+    auto SearchLayerHelper(VertexType enter_point,
+                           const StoreType &query,
+                           i32 layer_idx,
+                           SizeT result_n,
+                           const Filter &filter,
+                           const KnnSearchOption &option) const {
         if constexpr (ColumnLogicalType == LogicalType::kEmbedding) {
-            return SearchLayer<WithLock, Filter, ColumnLogicalType>(enter_point, query, layer_idx, result_n, filter);
+            return SearchLayer<WithLock, Filter, ColumnLogicalType>(enter_point, query, layer_idx, result_n, filter, option);
         } else if constexpr (ColumnLogicalType == LogicalType::kMultiVector) {
             if (result_n <= std::numeric_limits<u8>::max()) {
-                return SearchLayer<WithLock, Filter, ColumnLogicalType, u8>(enter_point, query, layer_idx, result_n, filter);
+                return SearchLayer<WithLock, Filter, ColumnLogicalType, u8>(enter_point, query, layer_idx, result_n, filter, option);
             }
             if (result_n <= std::numeric_limits<u16>::max()) {
-                return SearchLayer<WithLock, Filter, ColumnLogicalType, u16>(enter_point, query, layer_idx, result_n, filter);
+                return SearchLayer<WithLock, Filter, ColumnLogicalType, u16>(enter_point, query, layer_idx, result_n, filter, option);
             }
             if (result_n <= std::numeric_limits<u32>::max()) {
-                return SearchLayer<WithLock, Filter, ColumnLogicalType, u32>(enter_point, query, layer_idx, result_n, filter);
+                return SearchLayer<WithLock, Filter, ColumnLogicalType, u32>(enter_point, query, layer_idx, result_n, filter, option);
             }
             UnrecoverableError(fmt::format("Unsupported result_n : {}, which is larger than u32::max()", result_n));
             return Tuple<SizeT, UniquePtr<DistanceType[]>, UniquePtr<SearchLayerReturnParam3T<ColumnLogicalType>[]>>{};
@@ -345,7 +564,7 @@ private:
         for (i32 cur_layer = max_layer; cur_layer > 0; --cur_layer) {
             ep = SearchLayerNearest<WithLock>(ep, query, cur_layer);
         }
-        return SearchLayerHelper<WithLock, Filter, ColumnLogicalType>(ep, query, 0, ef, filter);
+        return SearchLayerHelper<WithLock, Filter, ColumnLogicalType>(ep, query, 0, ef, filter, option);
     }
 
 public:
@@ -368,6 +587,8 @@ public:
 
     void Optimize() { data_store_.Optimize(); }
 
+    void Reorder(HnswReorderType reorder_type) { data_store_ = std::move(data_store_).Reorder(reorder_type); }
+
     void Build(VertexType vertex_i) {
         std::unique_lock<std::shared_mutex> lock = data_store_.UniqueLock(vertex_i);
 
@@ -409,6 +630,30 @@ public:
         }
     }
 
+    // encode the stored vectors with product quantization, the graph is kept as it is
+    auto CompressToPQ(SizeT subspace_num) && {
+        using PQVecStoreType = decltype(VecStoreType::ToPQ());
+        auto meta = PQVecStoreType::Meta::Make(data_store_.dim(), subspace_num, false);
+        return std::move(*this).template CompressToTrained<PQVecStoreType>(std::move(meta));
+    }
+
+    // encode the stored vectors with 1 bit quantization, the graph is kept as it is
+    auto CompressToRaBitQ() && {
+        using RaBitQVecStoreType = decltype(VecStoreType::ToRaBitQ());
+        auto meta = RaBitQVecStoreType::Meta::Make(data_store_.dim());
+        return std::move(*this).template CompressToTrained<RaBitQVecStoreType>(std::move(meta));
+    }
+
+private:
+    template <typename TrainedVecStoreType>
+    UniquePtr<KnnHnsw<TrainedVecStoreType, LabelType>> CompressToTrained(typename TrainedVecStoreType::Meta meta) && {
+        using TrainedDistance = typename TrainedVecStoreType::Distance;
+        TrainedDistance distance(data_store_.dim());
+        auto compressed_datastore = std::move(data_store_).template CompressToTrained<TrainedVecStoreType>(std::move(meta));
+        return MakeUnique<KnnHnsw<TrainedVecStoreType, LabelType>>(M_, ef_construction_, std::move(compressed_datastore), std::move(distance));
+    }
+
+public:
     template <FilterConcept<LabelType> Filter = NoneType, bool WithLock = true>
     Tuple<SizeT, UniquePtr<DistanceType[]>, UniquePtr<LabelType[]>>
     KnnSearch(const QueryVecType &q, SizeT k, const Filter &filter, const KnnSearchOption &option = {}) const {
@@ -437,6 +682,56 @@ public:
         return KnnSearch<NoneType, WithLock>(q, k, None, option);
     }
 
+    // search several queries together. The queries walk the upper layers in lockstep so that the hot vertices near the enter point are
+    // visited once per batch, then every query searches layer 0 by itself.
+    template <FilterConcept<LabelType> Filter = NoneType, bool WithLock = true>
+    Vector<Tuple<SizeT, UniquePtr<DistanceType[]>, UniquePtr<LabelType[]>>>
+    KnnSearchBatch(const QueryVecType *qs, SizeT query_n, SizeT k, const Filter &filter, const KnnSearchOption &option = {}) const {
+        if (option.column_logical_type_ != LogicalType::kEmbedding) {
+            UnrecoverableError(fmt::format("Unsupported column logical type: {}", LogicalType2Str(option.column_logical_type_)));
+        }
+        SizeT ef = option.ef_;
+        if (ef == 0) {
+            ef = k;
+        }
+        Vector<Tuple<SizeT, UniquePtr<DistanceType[]>, UniquePtr<LabelType[]>>> results(query_n);
+        auto [max_layer, ep] = data_store_.GetEnterPoint();
+        if (ep == -1) {
+            return results;
+        }
+
+        Vector<QueryType> queries;
+        queries.reserve(query_n);
+        for (SizeT q = 0; q < query_n; ++q) {
+            queries.push_back(data_store_.MakeQuery(qs[q]));
+        }
+        Vector<StoreType> store_queries;
+        store_queries.reserve(query_n);
+        for (SizeT q = 0; q < query_n; ++q) {
+            store_queries.push_back(queries[q]);
+        }
+
+        Vector<VertexType> eps(query_n, ep);
+        for (i32 cur_layer = max_layer; cur_layer > 0; --cur_layer) {
+            SearchLayerNearestBatch<WithLock>(eps.data(), store_queries.data(), query_n, cur_layer);
+        }
+        for (SizeT q = 0; q < query_n; ++q) {
+            auto [result_n, d_ptr, v_ptr] = SearchLayer<WithLock, Filter>(eps[q], store_queries[q], 0, ef, filter, option);
+            auto labels = MakeUniqueForOverwrite<LabelType[]>(result_n);
+            for (SizeT i = 0; i < result_n; ++i) {
+                labels[i] = GetLabel(v_ptr[i]);
+            }
+            results[q] = {result_n, std::move(d_ptr), std::move(labels)};
+        }
+        return results;
+    }
+
+    template <bool WithLock = true>
+    Vector<Tuple<SizeT, UniquePtr<DistanceType[]>, UniquePtr<LabelType[]>>>
+    KnnSearchBatch(const QueryVecType *qs, SizeT query_n, SizeT k, const KnnSearchOption &option = {}) const {
+        return KnnSearchBatch<NoneType, WithLock>(qs, query_n, k, None, option);
+    }
+
     // function for test, add sort for convenience
     template <FilterConcept<LabelType> Filter = NoneType, bool WithLock = true>
     Vector<Pair<DistanceType, LabelType>>
@@ -457,6 +752,9 @@ public:
 
     SizeT GetVecNum() const { return data_store_.cur_vec_num(); }
 
+    // less than the dimension of the column if the graph is built on the truncated vectors
+    SizeT dim() const { return data_store_.dim(); }
+
     SizeT mem_usage() const { return data_store_.mem_usage(); }
 
 private:
@@ -14,7 +14,12 @@
 
 module;
 
+#include <bit>
+#include <concepts>
+#include <cstring>
 #include <limits>
+#include <sys/mman.h>
+#include <unistd.h>
 #include <utility>
 
 export module hnsw_common;
@@ -22,6 +27,8 @@ export module hnsw_common;
 import stl;
 import infinity_exception;
 import sparse_util;
+import local_file_handle;
+import third_party;
 
 namespace infinity {
 
@@ -29,6 +36,12 @@ export struct HnswConfig {
     SizeT lvq_buffer_size_;
 };
 
+// vertex order for cache locality of the graph, see `DataStore::Reorder`
+export enum class HnswReorderType : i8 {
+    kBFS,
+    kRCM,
+};
+
 export constexpr SizeT AlignTo(SizeT a, SizeT b) { return (a + b - 1) / b * b; }
 
 export using MeanType = double;
@@ -86,14 +99,15 @@ public:
     }
 };
 
-export template <typename LabelType>
-class FilterBase {
-public:
-    virtual bool operator()(const LabelType &vertex_i) const = 0;
+// A filter is called for every candidate in the inner loops of the searches, it is a plain class so that the call is inlined.
+// It may provide `Prefetch(label)` to load what the check reads ahead of time. `NoneType` and `std::nullptr_t` mean no filter.
+export template <typename Filter, typename LabelType>
+concept FilterConcept = std::is_same_v<Filter, NoneType> || std::is_same_v<Filter, std::nullptr_t> || requires(const Filter &filter, const LabelType &label) {
+    { filter(label) } -> std::convertible_to<bool>;
 };
 
 export template <typename Filter, typename LabelType>
-concept FilterConcept = requires(LabelType label) { std::is_same_v<Filter, NoneType> || std::is_base_of_v<FilterBase<LabelType>, Filter>; };
+concept PrefetchFilterConcept = requires(const Filter &filter, const LabelType &label) { filter.Prefetch(label); };
 
 export struct HnswInsertConfig {
     bool optimize_;
@@ -103,4 +117,84 @@ export constexpr HnswInsertConfig kDefaultHnswInsertConfig = {
     .optimize_ = false,
 };
 
-} // namespace infinity
\ No newline at end of file
+// An index saved by `SaveToPtr` starts with the magic, and every section is aligned to `kHnswFileAlign` bytes from the start of the file.
+// The layout is the in memory layout on a little endian machine, so the index can be searched from a memory mapping of the file.
+static_assert(std::endian::native == std::endian::little);
+export constexpr u64 kHnswFileMagic = 0x50414D4D57534E48; // "HNSWMMAP"
+export constexpr SizeT kHnswFileAlign = 64;
+
+export class HnswPtrWriter {
+public:
+    explicit HnswPtrWriter(LocalFileHandle &file_handle) : file_handle_(file_handle) {}
+
+    void Write(const void *data, SizeT size) {
+        file_handle_.Append(data, size);
+        offset_ += size;
+    }
+
+    template <typename T>
+    void Write(const T &value) {
+        Write(&value, sizeof(T));
+    }
+
+    void Align() {
+        constexpr char padding[kHnswFileAlign] = {};
+        Write(padding, AlignTo(offset_, kHnswFileAlign) - offset_);
+    }
+
+private:
+    LocalFileHandle &file_handle_;
+    SizeT offset_ = 0;
+};
+
+export class HnswPtrReader {
+public:
+    HnswPtrReader(const char *ptr, SizeT size) : begin_(ptr), cur_(ptr), end_(ptr + size) {}
+
+    // return the next `size` bytes without copy
+    const char *Get(SizeT size) {
+        if (size > SizeT(end_ - cur_)) {
+            UnrecoverableError(fmt::format("Hnsw file is truncated, read {} bytes at offset {} of {}", size, cur_ - begin_, end_ - begin_));
+        }
+        const char *ret = cur_;
+        cur_ += size;
+        return ret;
+    }
+
+    template <typename T>
+    T Read() {
+        T value;
+        std::memcpy(&value, Get(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    void Align() {
+        SizeT offset = cur_ - begin_;
+        Get(AlignTo(offset, kHnswFileAlign) - offset);
+    }
+
+private:
+    const char *begin_;
+    const char *cur_;
+    const char *end_;
+};
+
+// madvise and mlock on the pages which contain [ptr, ptr + size), the results are only hints so errors are ignored by the callers
+export int HnswMadvise(const void *ptr, SizeT size, int advice) {
+    if (size == 0) {
+        return 0;
+    }
+    const SizeT page_size = getpagesize();
+    SizeT begin = reinterpret_cast<SizeT>(ptr) / page_size * page_size;
+    SizeT end = AlignTo(reinterpret_cast<SizeT>(ptr) + size, page_size);
+    return madvise(reinterpret_cast<void *>(begin), end - begin, advice);
+}
+
+export int HnswMlock(const void *ptr, SizeT size) {
+    if (size == 0) {
+        return 0;
+    }
+    return mlock(ptr, size);
+}
+
+} // namespace infinity
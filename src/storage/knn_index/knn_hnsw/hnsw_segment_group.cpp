@@ -0,0 +1,237 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+#include <mutex>
+
+module hnsw_segment_group;
+
+import stl;
+import abstract_hnsw;
+import hnsw_common;
+import index_hnsw;
+import embedding_info;
+import logical_type;
+import segment_entry;
+import segment_iter;
+import buffer_manager;
+import infinity_exception;
+import third_party;
+import logger;
+import infinity_context;
+import storage;
+import memindex_tracer;
+
+namespace infinity {
+
+namespace {
+
+// rows of one segment, labeled with their offset in the group
+template <typename DataType>
+class GroupPartIter {
+public:
+    GroupPartIter(const SegmentEntry *segment_entry,
+                  BufferManager *buffer_mgr,
+                  ColumnID column_id,
+                  TxnTimeStamp begin_ts,
+                  const HnswSegmentGroupPart &part)
+        : iter_(segment_entry, buffer_mgr, column_id, begin_ts, part.row_count_), base_offset_(part.base_offset_) {}
+
+    Optional<Pair<const DataType *, SegmentOffset>> Next() {
+        auto ret = iter_.Next();
+        if (ret) {
+            ret->second += base_offset_;
+        }
+        return ret;
+    }
+
+private:
+    CappedOneColumnIterator<DataType, true> iter_;
+    SegmentOffset base_offset_;
+};
+
+} // namespace
+
+HnswSegmentGroupGraph::HnswSegmentGroupGraph(AbstractHnsw hnsw, SizeT capacity) : hnsw_(hnsw), capacity_(capacity) {}
+
+HnswSegmentGroupGraph::~HnswSegmentGroupGraph() {
+    std::visit(
+        [&](auto &&arg) {
+            using T = std::decay_t<decltype(arg)>;
+            if constexpr (!std::is_same_v<T, std::nullptr_t>) {
+                delete arg;
+            }
+        },
+        hnsw_);
+    auto *memindex_tracer = InfinityContext::instance().storage()->memindex_tracer();
+    if (memindex_tracer != nullptr) {
+        memindex_tracer->DecreaseMemUsed(traced_mem_usage_);
+    }
+}
+
+SizeT HnswSegmentGroupGraph::row_count() const {
+    return std::visit(
+        [](auto &&index) {
+            using T = std::decay_t<decltype(index)>;
+            if constexpr (std::is_same_v<T, std::nullptr_t>) {
+                return SizeT(0);
+            } else {
+                return index->GetVecNum();
+            }
+        },
+        hnsw_);
+}
+
+void HnswSegmentGroupGraph::Insert(const Vector<SegmentEntry *> &segment_entries,
+                                   const Vector<HnswSegmentGroupPart> &parts,
+                                   SizeT part_begin,
+                                   ColumnID column_id,
+                                   BufferManager *buffer_mgr,
+                                   TxnTimeStamp begin_ts) {
+    SizeT mem_usage = 0;
+    std::visit(
+        [&](auto &&index) {
+            using T = std::decay_t<decltype(index)>;
+            if constexpr (!std::is_same_v<T, std::nullptr_t>) {
+                using DataType = typename std::decay_t<decltype(*index)>::DataType;
+                const SizeT mem_usage_before = index->mem_usage();
+                for (SizeT i = part_begin; i < segment_entries.size(); ++i) {
+                    GroupPartIter<DataType> iter(segment_entries[i], buffer_mgr, column_id, begin_ts, parts[i]);
+                    SizeT insert_mem_usage = 0;
+                    HnswIndexInMem::InsertVecsParallel(index, std::move(iter), kDefaultHnswInsertConfig, insert_mem_usage);
+                }
+                mem_usage = index->mem_usage() - mem_usage_before;
+            }
+        },
+        hnsw_);
+    auto *memindex_tracer = InfinityContext::instance().storage()->memindex_tracer();
+    if (memindex_tracer != nullptr) {
+        memindex_tracer->AddMemUsed(mem_usage);
+        traced_mem_usage_ += mem_usage;
+    }
+}
+
+SharedPtr<HnswSegmentGroup> HnswSegmentGroup::Make(const IndexBase *index_base,
+                                                   const ColumnDef *column_def,
+                                                   const Vector<SegmentEntry *> &segment_entries,
+                                                   BufferManager *buffer_mgr,
+                                                   TxnTimeStamp begin_ts) {
+    if (column_def->type()->type() != LogicalType::kEmbedding) {
+        return nullptr;
+    }
+    Vector<HnswSegmentGroupPart> parts;
+    SizeT row_count = 0;
+    for (const auto *segment_entry : segment_entries) {
+        SizeT segment_row_count = segment_entry->row_count();
+        parts.push_back({segment_entry->segment_id(), static_cast<SegmentOffset>(row_count), static_cast<SegmentOffset>(segment_row_count)});
+        row_count += segment_row_count;
+    }
+    if (row_count == 0) {
+        return nullptr;
+    }
+    if (row_count > kMaxRowCount) {
+        UnrecoverableError(fmt::format("Too many rows in hnsw segment group: {}", row_count));
+    }
+
+    const auto *index_hnsw = static_cast<const IndexHnsw *>(index_base);
+    const auto *embedding_info = static_cast<const EmbeddingInfo *>(column_def->type()->type_info().get());
+    SizeT chunk_size = index_hnsw->block_size_;
+    // room for as many rows again, which are inserted by `Extend`
+    SizeT capacity = std::min(row_count * 2, kMaxRowCount);
+    SizeT max_chunk_num = (capacity - 1) / chunk_size + 1;
+    capacity = std::min(max_chunk_num * chunk_size, kMaxRowCount);
+    SizeT dim = index_hnsw->IndexDimension(embedding_info);
+    SizeT M = index_hnsw->M_;
+    SizeT ef_construction = index_hnsw->ef_construction_;
+
+    AbstractHnsw hnsw = HnswIndexInMem::InitAbstractIndex(index_base, column_def, true /*build_in_mem*/);
+    bool supported = false;
+    std::visit(
+        [&](auto &&index) {
+            using T = std::decay_t<decltype(index)>;
+            if constexpr (!std::is_same_v<T, std::nullptr_t>) {
+                using IndexT = std::decay_t<decltype(*index)>;
+                index = IndexT::Make(chunk_size, max_chunk_num, dim, M, ef_construction).release();
+                supported = true;
+            }
+        },
+        hnsw);
+    if (!supported) {
+        return nullptr;
+    }
+    auto graph = MakeShared<HnswSegmentGroupGraph>(hnsw, capacity);
+    graph->Insert(segment_entries, parts, 0, column_def->id(), buffer_mgr, begin_ts);
+    LOG_INFO(fmt::format("Built hnsw segment group of {} segments, {} rows", parts.size(), row_count));
+    return MakeShared<HnswSegmentGroup>(std::move(graph), std::move(parts), row_count);
+}
+
+SharedPtr<HnswSegmentGroup> HnswSegmentGroup::Extend(const ColumnDef *column_def,
+                                                     const Vector<SegmentEntry *> &segment_entries,
+                                                     BufferManager *buffer_mgr,
+                                                     TxnTimeStamp begin_ts) const {
+    if (graph_ == nullptr || segment_entries.size() <= parts_.size()) {
+        return nullptr;
+    }
+    Vector<SegmentEntry *> prefix(segment_entries.begin(), segment_entries.begin() + parts_.size());
+    if (!Match(prefix)) {
+        return nullptr;
+    }
+    Vector<HnswSegmentGroupPart> parts = parts_;
+    SizeT row_count = row_count_;
+    for (SizeT i = parts_.size(); i < segment_entries.size(); ++i) {
+        SizeT segment_row_count = segment_entries[i]->row_count();
+        parts.push_back({segment_entries[i]->segment_id(), static_cast<SegmentOffset>(row_count), static_cast<SegmentOffset>(segment_row_count)});
+        row_count += segment_row_count;
+    }
+    if (row_count > graph_->capacity()) {
+        return nullptr;
+    }
+    {
+        std::lock_guard lock(graph_->insert_mutex());
+        if (graph_->row_count() != row_count_) {
+            return nullptr;
+        }
+        graph_->Insert(segment_entries, parts, parts_.size(), column_def->id(), buffer_mgr, begin_ts);
+    }
+    LOG_INFO(fmt::format("Extended hnsw segment group by {} segments to {} rows", parts.size() - parts_.size(), row_count));
+    return MakeShared<HnswSegmentGroup>(graph_, std::move(parts), row_count);
+}
+
+HnswSegmentGroup::HnswSegmentGroup(SharedPtr<HnswSegmentGroupGraph> graph, Vector<HnswSegmentGroupPart> parts, SizeT row_count)
+    : graph_(std::move(graph)), parts_(std::move(parts)), row_count_(row_count) {}
+
+const HnswSegmentGroupPart &HnswSegmentGroup::GetPart(SegmentOffset label) const {
+    auto iter = std::upper_bound(parts_.begin(), parts_.end(), label, [](SegmentOffset label, const HnswSegmentGroupPart &part) {
+        return label < part.base_offset_;
+    });
+    if (iter == parts_.begin() || label >= row_count_) {
+        UnrecoverableError(fmt::format("Label {} out of hnsw segment group", label));
+    }
+    return *(iter - 1);
+}
+
+bool HnswSegmentGroup::Match(const Vector<SegmentEntry *> &segment_entries) const {
+    if (segment_entries.size() != parts_.size()) {
+        return false;
+    }
+    for (SizeT i = 0; i < parts_.size(); ++i) {
+        if (segment_entries[i]->segment_id() != parts_[i].segment_id_ || segment_entries[i]->row_count() != parts_[i].row_count_) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace infinity
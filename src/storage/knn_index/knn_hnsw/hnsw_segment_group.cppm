@@ -0,0 +1,118 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+#include <mutex>
+
+export module hnsw_segment_group;
+
+import stl;
+import abstract_hnsw;
+import hnsw_common;
+import internal_types;
+import index_base;
+import column_def;
+
+namespace infinity {
+
+class BufferManager;
+struct SegmentEntry;
+
+export struct HnswSegmentGroupPart {
+    SegmentID segment_id_{};
+    SegmentOffset base_offset_{}; // label of the first row of the segment
+    SegmentOffset row_count_{};
+};
+
+// The graph of a segment group. Groups extended from one another share it, see `HnswSegmentGroup::Extend`. It leaves room for more rows
+// than it is built with, so that the rows of newly sealed segments can be inserted while the smaller groups are being searched.
+// Its memory is counted by the memindex tracer.
+export class HnswSegmentGroupGraph {
+public:
+    HnswSegmentGroupGraph(AbstractHnsw hnsw, SizeT capacity);
+
+    HnswSegmentGroupGraph(const HnswSegmentGroupGraph &) = delete;
+    HnswSegmentGroupGraph &operator=(const HnswSegmentGroupGraph &) = delete;
+
+    ~HnswSegmentGroupGraph();
+
+    const AbstractHnsw &get() const { return hnsw_; }
+
+    SizeT capacity() const { return capacity_; }
+
+    SizeT row_count() const;
+
+    // insert the rows of `segment_entries[part_begin..]`, labeled by `parts`
+    void Insert(const Vector<SegmentEntry *> &segment_entries,
+                const Vector<HnswSegmentGroupPart> &parts,
+                SizeT part_begin,
+                ColumnID column_id,
+                BufferManager *buffer_mgr,
+                TxnTimeStamp begin_ts);
+
+    std::mutex &insert_mutex() { return insert_mutex_; }
+
+private:
+    AbstractHnsw hnsw_ = nullptr;
+    const SizeT capacity_ = 0;
+    SizeT traced_mem_usage_ = 0;
+    std::mutex insert_mutex_;
+};
+
+// One hnsw graph over the rows of several sealed segments, so that a knn scan searches them with one graph instead of one per segment.
+// The label of a row is its segment offset plus the base offset of its segment. The group is built on optimize and only kept in memory.
+// The graph may hold the rows of the segments sealed after the group too, a search must filter the labels to `row_count()`.
+export class HnswSegmentGroup {
+public:
+    // the vertices of a graph are indexed by VertexType
+    static constexpr SizeT kMaxRowCount = std::numeric_limits<VertexType>::max();
+
+    // nullptr if the index or the column type is not supported
+    static SharedPtr<HnswSegmentGroup> Make(const IndexBase *index_base,
+                                            const ColumnDef *column_def,
+                                            const Vector<SegmentEntry *> &segment_entries,
+                                            BufferManager *buffer_mgr,
+                                            TxnTimeStamp begin_ts);
+
+    // A group of `segment_entries`, which start with the segments of this group, made by inserting the rows of the other segments into
+    // the graph of this group. nullptr if the group must be built again by `Make`: the segments of this group changed, the graph has no
+    // room left or another group was extended from the same graph.
+    SharedPtr<HnswSegmentGroup>
+    Extend(const ColumnDef *column_def, const Vector<SegmentEntry *> &segment_entries, BufferManager *buffer_mgr, TxnTimeStamp begin_ts) const;
+
+    HnswSegmentGroup(SharedPtr<HnswSegmentGroupGraph> graph, Vector<HnswSegmentGroupPart> parts, SizeT row_count);
+
+    HnswSegmentGroup(const HnswSegmentGroup &) = delete;
+    HnswSegmentGroup &operator=(const HnswSegmentGroup &) = delete;
+
+    const AbstractHnsw &get() const { return graph_->get(); }
+
+    const Vector<HnswSegmentGroupPart> &parts() const { return parts_; }
+
+    SizeT row_count() const { return row_count_; }
+
+    // the part which contains `label`
+    const HnswSegmentGroupPart &GetPart(SegmentOffset label) const;
+
+    // whether the group is built from these segments with these row counts
+    bool Match(const Vector<SegmentEntry *> &segment_entries) const;
+
+private:
+    SharedPtr<HnswSegmentGroupGraph> graph_;
+    Vector<HnswSegmentGroupPart> parts_;
+    SizeT row_count_ = 0;
+};
+
+} // namespace infinity
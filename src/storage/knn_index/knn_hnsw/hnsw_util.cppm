@@ -22,12 +22,14 @@ import stl;
 import statement_common;
 import infinity_exception;
 import status;
+import hnsw_common;
 
 namespace infinity {
 
 export struct HnswOptimizeOptions {
     bool compress_to_lvq = false;
     bool lvq_avg = false;
+    Optional<HnswReorderType> reorder{};
 };
 
 export struct HnswUtil {
@@ -38,12 +40,22 @@ export struct HnswUtil {
                 options.compress_to_lvq = true;
             } else if (IsEqual(param->param_name_, "lvq_avg")) {
                 options.lvq_avg = true;
+            } else if (IsEqual(param->param_name_, "reorder")) {
+                String reorder = param->param_value_;
+                ToLower(reorder);
+                if (reorder.empty() || IsEqual(reorder, "bfs")) {
+                    options.reorder = HnswReorderType::kBFS;
+                } else if (IsEqual(reorder, "rcm")) {
+                    options.reorder = HnswReorderType::kRCM;
+                } else {
+                    RecoverableError(Status::InvalidIndexParam("Invalid reorder type: " + param->param_value_));
+                }
             }
         }
         if (options.compress_to_lvq && options.lvq_avg) {
             RecoverableError(Status::InvalidIndexParam("compress_to_lvq and lvq_avg cannot be set at the same time"));
         }
-        if (!options.compress_to_lvq && !options.lvq_avg) {
+        if (!options.compress_to_lvq && !options.lvq_avg && !options.reorder.has_value()) {
             return None;
         }
         return options;
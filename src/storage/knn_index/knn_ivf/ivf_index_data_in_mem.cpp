@@ -199,7 +199,7 @@ public:
     void SearchIndexInMem(const KnnDistanceBase1 *knn_distance,
                           const void *query_ptr,
                           const EmbeddingDataType query_element_type,
-                          const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                          const IVFSearchFilter &satisfy_filter_func,
                           const std::function<void(f32, SegmentOffset)> &add_result_func) const override {
         auto ReturnT = [&]<EmbeddingDataType query_element_type> {
             if constexpr ((query_element_type == EmbeddingDataType::kElemFloat && IsAnyOf<ColumnEmbeddingElementT, f64, f32, Float16T, BFloat16T>) ||
@@ -232,7 +232,7 @@ public:
     template <EmbeddingDataType query_element_type>
     void SearchIndexInMemT(const KnnDistanceBase1 *knn_distance,
                            const EmbeddingDataTypeToCppTypeT<query_element_type> *query_ptr,
-                           const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                           const IVFSearchFilter &satisfy_filter_func,
                            const std::function<void(f32, SegmentOffset)> &add_result_func) const {
         using QueryDataType = EmbeddingDataTypeToCppTypeT<query_element_type>;
         auto knn_distance_1 = dynamic_cast<const KnnDistance1<QueryDataType, f32> *>(knn_distance);
@@ -324,7 +324,7 @@ void IVFIndexInMem::SearchIndex(const KnnDistanceBase1 *knn_distance,
                                 const void *query_ptr,
                                 const EmbeddingDataType query_element_type,
                                 const u32 nprobe,
-                                const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                                const IVFSearchFilter &satisfy_filter_func,
                                 const std::function<void(f32, SegmentOffset)> &add_result_func) const {
     std::shared_lock lock(rw_mutex_);
     if (have_ivf_index_.test(std::memory_order_acquire)) {
@@ -334,4 +334,26 @@ void IVFIndexInMem::SearchIndex(const KnnDistanceBase1 *knn_distance,
     }
 }
 
+void IVFIndexInMem::SearchIndexMulti(const KnnDistanceBase1 *knn_distance,
+                                     const void *query_ptr,
+                                     const EmbeddingDataType query_element_type,
+                                     const u32 query_count,
+                                     const u32 nprobe,
+                                     const IVFSearchFilter &satisfy_filter_func,
+                                     const std::function<void(u32, f32, SegmentOffset)> &add_result_func) const {
+    std::shared_lock lock(rw_mutex_);
+    if (have_ivf_index_.test(std::memory_order_acquire)) {
+        ivf_index_storage_->SearchIndexMulti(knn_distance, query_ptr, query_element_type, query_count, nprobe, satisfy_filter_func, add_result_func);
+        return;
+    }
+    const auto query_bytes = EmbeddingType::EmbeddingSize(query_element_type, embedding_dimension());
+    for (u32 query_id = 0; query_id < query_count; ++query_id) {
+        SearchIndexInMem(knn_distance,
+                         static_cast<const char *>(query_ptr) + query_id * query_bytes,
+                         query_element_type,
+                         satisfy_filter_func,
+                         [&add_result_func, query_id](const f32 d, const SegmentOffset segment_offset) { add_result_func(query_id, d, segment_offset); });
+    }
+}
+
 } // namespace infinity
\ No newline at end of file
@@ -20,6 +20,7 @@ import stl;
 import internal_types;
 import index_ivf;
 import ivf_index_storage;
+import ivf_index_util_func;
 import column_def;
 import logical_type;
 import buffer_handle;
@@ -65,15 +66,22 @@ public:
                      const void *query_ptr,
                      EmbeddingDataType query_element_type,
                      u32 nprobe,
-                     const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                     const IVFSearchFilter &satisfy_filter_func,
                      const std::function<void(f32, SegmentOffset)> &add_result_func) const;
+    void SearchIndexMulti(const KnnDistanceBase1 *knn_distance,
+                          const void *query_ptr,
+                          EmbeddingDataType query_element_type,
+                          u32 query_count,
+                          u32 nprobe,
+                          const IVFSearchFilter &satisfy_filter_func,
+                          const std::function<void(u32, f32, SegmentOffset)> &add_result_func) const;
     static SharedPtr<IVFIndexInMem> NewIVFIndexInMem(const ColumnDef *column_def, const IndexBase *index_base, RowID begin_row_id);
 
 private:
     virtual void SearchIndexInMem(const KnnDistanceBase1 *knn_distance,
                                   const void *query_ptr,
                                   EmbeddingDataType query_element_type,
-                                  const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                                  const IVFSearchFilter &satisfy_filter_func,
                                   const std::function<void(f32, SegmentOffset)> &add_result_func) const = 0;
 };
 
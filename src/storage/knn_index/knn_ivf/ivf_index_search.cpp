@@ -38,10 +38,8 @@ IVF_Search_Params IVF_Search_Params::Make(const KnnScanFunctionData *knn_scan_fu
     params.knn_distance_ = knn_scan_function_data->knn_distance_.get();
     const auto *knn_scan_shared_data = knn_scan_function_data->knn_scan_shared_data_;
     params.knn_scan_shared_data_ = knn_scan_shared_data;
-    if (knn_scan_shared_data->query_count_ != 1) {
-        RecoverableError(Status::SyntaxError(fmt::format("Invalid query_count: {} which is not 1.", knn_scan_shared_data->query_count_)));
-    }
     params.topk_ = knn_scan_shared_data->topk_;
+    params.query_count_ = knn_scan_shared_data->query_count_;
     params.query_embedding_ = knn_scan_shared_data->query_embedding_;
     params.query_elem_type_ = knn_scan_shared_data->query_elem_type_;
     params.knn_distance_type_ = knn_scan_shared_data->knn_distance_type_;
@@ -52,6 +50,13 @@ IVF_Search_Params IVF_Search_Params::Make(const KnnScanFunctionData *knn_scan_fu
             if (params.nprobe_ <= 0) {
                 RecoverableError(Status::SyntaxError(fmt::format("Invalid negative nprobe value: {}", opt_param.param_name_)));
             }
+        } else if (opt_param.param_name_ == "rerank") {
+            params.rerank_ = true;
+        } else if (opt_param.param_name_ == "threads") {
+            params.threads_ = DataType::StringToValue<IntegerT>(opt_param.param_value_);
+            if (params.threads_ <= 0) {
+                RecoverableError(Status::SyntaxError(fmt::format("Invalid threads value: {}", opt_param.param_value_)));
+            }
         }
     }
     if (params.topk_ <= 0 || params.topk_ > std::numeric_limits<u32>::max()) {
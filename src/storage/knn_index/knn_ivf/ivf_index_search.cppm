@@ -15,7 +15,9 @@
 module;
 
 #include <cassert>
+#include <cmath>
 #include <functional>
+#include <future>
 export module ivf_index_search;
 
 import stl;
@@ -34,19 +36,27 @@ import knn_filter;
 import ivf_index_data;
 import ivf_index_data_in_mem;
 import ivf_index_storage;
+import ivf_index_util_func;
 import search_top_1;
 import search_top_k;
+import infinity_context;
 
 namespace infinity {
 
+// candidates per result of the 4 bit pq fast scan, which are reranked with the raw vectors
+export constexpr SizeT kPQFastScanRerankFactor = 2;
+
 export struct IVF_Search_Params {
     const KnnDistanceBase1 *knn_distance_{};
     const KnnScanSharedData *knn_scan_shared_data_{};
     i64 topk_{};
+    u64 query_count_{1};
     const void *query_embedding_{};
     EmbeddingDataType query_elem_type_{EmbeddingDataType::kElemInvalid};
     KnnDistanceType knn_distance_type_{KnnDistanceType::kInvalid};
     i32 nprobe_{1};
+    bool rerank_{false};
+    i32 threads_{1}; // workers of the knn search thread pool which share the parts probed by one query
 
     static IVF_Search_Params Make(const KnnScanFunctionData *knn_scan_function_data);
 };
@@ -59,19 +69,20 @@ protected:
     UniquePtr<SegmentOffset[]> segment_offset_output_ptr_{};
 
     explicit IVF_Search_Handler(const IVF_Search_Params &ivf_params) : ivf_params_(ivf_params) {
-        distance_output_ptr_ = MakeUniqueForOverwrite<DistanceDataType[]>(ivf_params_.topk_);
-        segment_offset_output_ptr_ = MakeUniqueForOverwrite<SegmentOffset[]>(ivf_params_.topk_);
+        distance_output_ptr_ = MakeUniqueForOverwrite<DistanceDataType[]>(ivf_params_.topk_ * ivf_params_.query_count_);
+        segment_offset_output_ptr_ = MakeUniqueForOverwrite<SegmentOffset[]>(ivf_params_.topk_ * ivf_params_.query_count_);
     }
-    virtual SizeT EndWithoutSortAndGetResultSize() = 0;
+    virtual Vector<SizeT> EndWithoutSortAndGetResultSizes() = 0;
 
 public:
     virtual ~IVF_Search_Handler() = default;
     virtual void Begin() = 0;
     virtual void Search(const IVFIndexInChunk *ivf_index_in_chunk) = 0;
     virtual void Search(const IVFIndexInMem *ivf_index_in_mem) = 0;
-    Tuple<SizeT, UniquePtr<DistanceDataType[]>, UniquePtr<SegmentOffset[]>> EndWithoutSort() {
-        const auto result_cnt = EndWithoutSortAndGetResultSize();
-        return {result_cnt, std::move(distance_output_ptr_), std::move(segment_offset_output_ptr_)};
+    // the results of query i start at i * topk
+    Tuple<Vector<SizeT>, UniquePtr<DistanceDataType[]>, UniquePtr<SegmentOffset[]>> EndWithoutSort() {
+        auto result_cnts = EndWithoutSortAndGetResultSizes();
+        return {std::move(result_cnts), std::move(distance_output_ptr_), std::move(segment_offset_output_ptr_)};
     }
 };
 
@@ -82,14 +93,14 @@ template <>
 struct IVF_Filter<true> {
     BitmaskFilter<SegmentOffset> filter_;
     IVF_Filter(const Bitmask &bitmask, const SegmentOffset max_segment_offset) : filter_(bitmask) {}
-    bool operator()(const SegmentOffset segment_offset) const { return filter_(segment_offset); }
+    IVFSearchFilter View() const { return {filter_.words(), static_cast<SegmentOffset>(filter_.count())}; }
 };
 
 template <>
 struct IVF_Filter<false> {
-    AppendFilter filter_;
-    IVF_Filter(const Bitmask &bitmask, const SegmentOffset max_segment_offset) : filter_(max_segment_offset) {}
-    bool operator()(const SegmentOffset segment_offset) const { return filter_(segment_offset); }
+    SegmentOffset max_segment_offset_;
+    IVF_Filter(const Bitmask &bitmask, const SegmentOffset max_segment_offset) : max_segment_offset_(max_segment_offset) {}
+    IVFSearchFilter View() const { return {nullptr, max_segment_offset_}; }
 };
 
 template <LogicalType t,
@@ -107,35 +118,76 @@ class IVF_Search_HandlerT final : public IVF_Search_Handler<DistanceDataType> {
                                              MultiVectorResultHandler<DistanceDataType, SegmentOffset, MultiVectorInnerTopnIndexType>>;
     IVF_Filter<use_bitmask> filter_;
     ResultHandler result_handler_;
+    // the k-th distances of each query found by the other tasks of the scan, see `LoadSharedBounds`
+    Vector<DistanceDataType> bounds_;
 
 public:
     IVF_Search_HandlerT(const IVF_Search_Params &ivf_params, const Bitmask &bitmask, SegmentOffset max_segment_offset)
-        : IVF_Search_Handler<DistanceDataType>(ivf_params), filter_(bitmask, max_segment_offset),
-          result_handler_(1, this->ivf_params_.topk_, this->distance_output_ptr_.get(), this->segment_offset_output_ptr_.get()) {}
+        : IVF_Search_Handler<DistanceDataType>(ivf_params), filter_(bitmask, max_segment_offset), result_handler_(MakeResultHandler()) {}
     void Begin() override { result_handler_.Begin(); }
     void Search(const IVFIndexInChunk *ivf_index_in_chunk) override {
+        LoadSharedBounds();
         const auto *ivf_index_storage = ivf_index_in_chunk->GetIVFIndexStoragePtr();
+        if constexpr (t == LogicalType::kEmbedding) {
+            if (this->ivf_params_.query_count_ > 1) {
+                ivf_index_storage->SearchIndexMulti(this->ivf_params_.knn_distance_,
+                                                    this->ivf_params_.query_embedding_,
+                                                    this->ivf_params_.query_elem_type_,
+                                                    this->ivf_params_.query_count_,
+                                                    this->ivf_params_.nprobe_,
+                                                    filter_.View(),
+                                                    std::bind(&IVF_Search_HandlerT::AddQueryResult,
+                                                              this,
+                                                              std::placeholders::_1,
+                                                              std::placeholders::_2,
+                                                              std::placeholders::_3));
+                return;
+            }
+            if (this->ivf_params_.threads_ > 1) {
+                SearchParallel(ivf_index_storage);
+                return;
+            }
+        }
         ivf_index_storage->SearchIndex(this->ivf_params_.knn_distance_,
                                        this->ivf_params_.query_embedding_,
                                        this->ivf_params_.query_elem_type_,
                                        this->ivf_params_.nprobe_,
-                                       std::bind(&IVF_Search_HandlerT::SatisfyFilter, this, std::placeholders::_1),
+                                       filter_.View(),
                                        std::bind(&IVF_Search_HandlerT::AddResult, this, std::placeholders::_1, std::placeholders::_2));
     }
     void Search(const IVFIndexInMem *ivf_index_in_mem) override {
+        LoadSharedBounds();
+        if constexpr (t == LogicalType::kEmbedding) {
+            if (this->ivf_params_.query_count_ > 1) {
+                ivf_index_in_mem->SearchIndexMulti(this->ivf_params_.knn_distance_,
+                                                   this->ivf_params_.query_embedding_,
+                                                   this->ivf_params_.query_elem_type_,
+                                                   this->ivf_params_.query_count_,
+                                                   this->ivf_params_.nprobe_,
+                                                   filter_.View(),
+                                                   std::bind(&IVF_Search_HandlerT::AddQueryResult,
+                                                             this,
+                                                             std::placeholders::_1,
+                                                             std::placeholders::_2,
+                                                             std::placeholders::_3));
+                return;
+            }
+        }
         ivf_index_in_mem->SearchIndex(this->ivf_params_.knn_distance_,
                                       this->ivf_params_.query_embedding_,
                                       this->ivf_params_.query_elem_type_,
                                       this->ivf_params_.nprobe_,
-                                      std::bind(&IVF_Search_HandlerT::SatisfyFilter, this, std::placeholders::_1),
+                                      filter_.View(),
                                       std::bind(&IVF_Search_HandlerT::AddResult, this, std::placeholders::_1, std::placeholders::_2));
     }
-    bool SatisfyFilter(SegmentOffset i) { return filter_(i); }
     void AddResult(DistanceDataType d, SegmentOffset i) {
-        assert(SatisfyFilter(i));
+        assert(filter_.View()(i));
         if constexpr (NEED_FLIP) {
             d = -d;
         }
+        if (d > bounds_[0]) {
+            return;
+        }
         if constexpr (t == LogicalType::kEmbedding) {
             result_handler_.AddResult(0, d, i);
         } else {
@@ -143,15 +195,118 @@ public:
             result_handler_.AddResult(d, i);
         }
     }
-    SizeT EndWithoutSortAndGetResultSize() override {
-        result_handler_.EndWithoutSort();
-        const auto result_cnt = result_handler_.GetSize(0);
+    void AddQueryResult(u32 query_id, DistanceDataType d, SegmentOffset i) {
+        static_assert(t == LogicalType::kEmbedding);
+        assert(filter_.View()(i));
         if constexpr (NEED_FLIP) {
-            for (u32 i = 0; i < result_cnt; ++i) {
-                this->distance_output_ptr_[i] = -(this->distance_output_ptr_[i]);
+            d = -d;
+        }
+        if (d > bounds_[query_id]) {
+            return;
+        }
+        result_handler_.AddResult(query_id, d, i);
+    }
+    Vector<SizeT> EndWithoutSortAndGetResultSizes() override {
+        result_handler_.EndWithoutSort();
+        const auto query_count = this->ivf_params_.query_count_;
+        const auto top_k = this->ivf_params_.topk_;
+        Vector<SizeT> result_cnts(query_count);
+        for (u64 query_id = 0; query_id < query_count; ++query_id) {
+            if constexpr (t == LogicalType::kEmbedding) {
+                result_cnts[query_id] = result_handler_.GetSize(query_id);
+            } else {
+                result_cnts[query_id] = result_handler_.GetSize(0);
+            }
+            if constexpr (NEED_FLIP) {
+                for (u32 i = 0; i < result_cnts[query_id]; ++i) {
+                    this->distance_output_ptr_[query_id * top_k + i] = -(this->distance_output_ptr_[query_id * top_k + i]);
+                }
+            }
+        }
+        return result_cnts;
+    }
+
+private:
+    // The results worse than the bounds are not in the merged top k. The candidates of a rerank have approximate distances, they are
+    // not bounded.
+    void LoadSharedBounds() {
+        const auto &params = this->ivf_params_;
+        bounds_.assign(params.query_count_, std::numeric_limits<DistanceDataType>::max());
+        if (params.knn_scan_shared_data_ == nullptr || params.rerank_) {
+            return;
+        }
+        for (u64 query_id = 0; query_id < params.query_count_; ++query_id) {
+            if (const f32 bound = params.knn_scan_shared_data_->shared_bound_.Get(query_id); !std::isnan(bound)) {
+                bounds_[query_id] = NEED_FLIP ? -bound : bound;
+            }
+        }
+    }
+
+    ResultHandler MakeResultHandler() {
+        if constexpr (t == LogicalType::kEmbedding) {
+            return ResultHandler(this->ivf_params_.query_count_,
+                                 this->ivf_params_.topk_,
+                                 this->distance_output_ptr_.get(),
+                                 this->segment_offset_output_ptr_.get());
+        } else {
+            return ResultHandler(1, this->ivf_params_.topk_, this->distance_output_ptr_.get(), this->segment_offset_output_ptr_.get());
+        }
+    }
+
+    // The parts probed by the query are split over the workers of the knn search thread pool, every worker keeps its own top k
+    // which are merged at the end.
+    void SearchParallel(const IVF_Index_Storage *ivf_index_storage) {
+        const auto &params = this->ivf_params_;
+        const auto part_ids = ivf_index_storage->SearchCentroids(params.knn_distance_, params.query_embedding_, params.query_elem_type_, 1, params.nprobe_);
+        auto &thread_pool = InfinityContext::instance().GetKnnSearchThreadPool();
+        const SizeT worker_n = std::min({static_cast<SizeT>(params.threads_), static_cast<SizeT>(thread_pool.size()), part_ids.size()});
+        if (worker_n <= 1) {
+            ivf_index_storage->SearchParts(part_ids,
+                                           params.knn_distance_,
+                                           params.query_embedding_,
+                                           params.query_elem_type_,
+                                           filter_.View(),
+                                           std::bind(&IVF_Search_HandlerT::AddResult, this, std::placeholders::_1, std::placeholders::_2));
+            return;
+        }
+        const auto top_k = params.topk_;
+        const auto worker_distances = MakeUniqueForOverwrite<DistanceDataType[]>(worker_n * top_k);
+        const auto worker_offsets = MakeUniqueForOverwrite<SegmentOffset[]>(worker_n * top_k);
+        // one "query" per worker
+        ResultHandler worker_handler(worker_n, top_k, worker_distances.get(), worker_offsets.get());
+        const auto filter = filter_.View();
+        const DistanceDataType bound = bounds_[0];
+        Vector<std::future<void>> futs;
+        futs.reserve(worker_n);
+        for (SizeT worker_id = 0; worker_id < worker_n; ++worker_id) {
+            futs.emplace_back(thread_pool.push([&, worker_id](int) {
+                const SizeT begin = part_ids.size() * worker_id / worker_n;
+                const SizeT end = part_ids.size() * (worker_id + 1) / worker_n;
+                const Vector<u32> worker_part_ids(part_ids.begin() + begin, part_ids.begin() + end);
+                ivf_index_storage->SearchParts(worker_part_ids,
+                                               params.knn_distance_,
+                                               params.query_embedding_,
+                                               params.query_elem_type_,
+                                               filter,
+                                               [&worker_handler, worker_id, bound](DistanceDataType d, const SegmentOffset i) {
+                                                   if constexpr (NEED_FLIP) {
+                                                       d = -d;
+                                                   }
+                                                   if (d > bound) {
+                                                       return;
+                                                   }
+                                                   worker_handler.AddResult(worker_id, d, i);
+                                               });
+            }));
+        }
+        for (auto &fut : futs) {
+            fut.get();
+        }
+        for (SizeT worker_id = 0; worker_id < worker_n; ++worker_id) {
+            for (u32 i = 0; i < worker_handler.GetSize(worker_id); ++i) {
+                result_handler_.AddResult(0, worker_distances[worker_id * top_k + i], worker_offsets[worker_id * top_k + i]);
             }
         }
-        return result_cnt;
     }
 };
 
@@ -161,6 +316,10 @@ GetIVFSearchHandler(const IVF_Search_Params &ivf_params, const Bitmask &bitmask,
     if constexpr (t == LogicalType::kEmbedding) {
         return MakeUnique<IVF_Search_HandlerT<t, C, DistanceDataType, use_bitmask>>(ivf_params, bitmask, max_segment_offset);
     } else if constexpr (t == LogicalType::kMultiVector) {
+        if (ivf_params.query_count_ != 1) {
+            RecoverableError(Status::SyntaxError(fmt::format("Invalid query_count: {} which is not 1.", ivf_params.query_count_)));
+            return nullptr;
+        }
         const auto top_k = ivf_params.topk_;
         if (top_k <= 0) {
             RecoverableError(Status::SyntaxError(fmt::format("Invalid topk: {}", top_k)));
@@ -283,30 +283,38 @@ void IVF_Index_Storage::AddMultiVectorT(const SegmentOffset segment_offset,
 void IVF_Index_Storage::SearchIndex(const KnnDistanceBase1 *knn_distance,
                                     const void *query_ptr,
                                     const EmbeddingDataType query_element_type,
-                                    u32 nprobe,
-                                    const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                                    const u32 nprobe,
+                                    const IVFSearchFilter &satisfy_filter_func,
                                     const std::function<void(f32, SegmentOffset)> &add_result_func) const {
+    const auto nprobe_result = SearchCentroids(knn_distance, query_ptr, query_element_type, 1, nprobe);
+    SearchParts(nprobe_result, knn_distance, query_ptr, query_element_type, satisfy_filter_func, add_result_func);
+}
+
+Vector<u32> IVF_Index_Storage::SearchCentroids(const KnnDistanceBase1 *knn_distance,
+                                               const void *query_ptr,
+                                               const EmbeddingDataType query_element_type,
+                                               const u32 query_count,
+                                               u32 nprobe) const {
     const auto dimension = embedding_dimension();
-    const auto [centroids_num, centroids_data] = ivf_centroids_storage_.GetCentroidDataForMetric(knn_distance);
-    nprobe = std::min<u32>(nprobe, centroids_num);
-    auto [query_f32_ptr, _] = ApplyEmbeddingDataTypeToFunc(
+    auto [queries_f32, _] = ApplyEmbeddingDataTypeToFunc(
         query_element_type,
-        [query_ptr, dimension]<EmbeddingDataType query_element_type> {
-            return GetF32Ptr(static_cast<const EmbeddingDataTypeToCppTypeT<query_element_type> *>(query_ptr), dimension);
+        [query_ptr, dimension, query_count]<EmbeddingDataType query_element_type> {
+            return GetF32Ptr(static_cast<const EmbeddingDataTypeToCppTypeT<query_element_type> *>(query_ptr), dimension * query_count);
         },
         [] { return Pair<const f32 *, UniquePtr<f32[]>>(); });
-    Vector<u32> nprobe_result;
+    const auto [centroids_num, centroids_data] = ivf_centroids_storage_.GetCentroidDataForMetric(knn_distance);
+    nprobe = std::min<u32>(nprobe, centroids_num);
+    Vector<u32> nprobe_result(query_count * nprobe);
     switch (knn_distance->dist_type_) {
         case KnnDistanceType::kL2: {
-            nprobe_result.resize(nprobe);
             if (nprobe == 1) {
-                search_top_1_without_dis<f32>(dimension, 1, query_f32_ptr, centroids_num, centroids_data, nprobe_result.data());
+                search_top_1_without_dis<f32>(dimension, query_count, queries_f32, centroids_num, centroids_data, nprobe_result.data());
             } else {
-                const auto centroid_dists = MakeUniqueForOverwrite<f32[]>(nprobe);
+                const auto centroid_dists = MakeUniqueForOverwrite<f32[]>(query_count * nprobe);
                 search_top_k_with_dis(nprobe,
                                       dimension,
-                                      1,
-                                      query_f32_ptr,
+                                      query_count,
+                                      queries_f32,
                                       centroids_num,
                                       centroids_data,
                                       nprobe_result.data(),
@@ -317,21 +325,56 @@ void IVF_Index_Storage::SearchIndex(const KnnDistanceBase1 *knn_distance,
         }
         case KnnDistanceType::kCosine:
         case KnnDistanceType::kInnerProduct: {
-            const auto ip_result = MakeUniqueForOverwrite<f32[]>(centroids_num);
-            matrixA_multiply_matrixB_output_to_C(centroids_data, query_f32_ptr, centroids_num, 1, dimension, ip_result.get());
-            nprobe_result.resize(centroids_num);
-            std::iota(nprobe_result.begin(), nprobe_result.end(), static_cast<u32>(0));
-            std::nth_element(nprobe_result.begin(), nprobe_result.begin() + nprobe, nprobe_result.end(), [&ip_result](const u32 a, const u32 b) {
-                return ip_result[a] > ip_result[b];
-            });
-            nprobe_result.resize(nprobe);
+            // one row of centroid scores per query
+            const auto ip_result = MakeUniqueForOverwrite<f32[]>(query_count * centroids_num);
+            if (query_count == 1) {
+                matrixA_multiply_matrixB_output_to_C(centroids_data, queries_f32, centroids_num, 1, dimension, ip_result.get());
+            } else {
+                matrixA_multiply_transpose_matrixB_output_to_C(queries_f32, centroids_data, query_count, centroids_num, dimension, ip_result.get());
+            }
+            Vector<u32> part_ids(centroids_num);
+            for (u32 query_id = 0; query_id < query_count; ++query_id) {
+                const f32 *query_ip_result = ip_result.get() + query_id * centroids_num;
+                std::iota(part_ids.begin(), part_ids.end(), static_cast<u32>(0));
+                std::nth_element(part_ids.begin(), part_ids.begin() + nprobe, part_ids.end(), [query_ip_result](const u32 a, const u32 b) {
+                    return query_ip_result[a] > query_ip_result[b];
+                });
+                std::copy_n(part_ids.begin(), nprobe, nprobe_result.begin() + query_id * nprobe);
+            }
             break;
         }
         default: {
             UnrecoverableError("Unsupported distance type");
         }
     }
-    ivf_parts_storage_->SearchIndex(nprobe_result, this, knn_distance, query_ptr, query_element_type, satisfy_filter_func, add_result_func);
+    return nprobe_result;
+}
+
+void IVF_Index_Storage::SearchParts(const Vector<u32> &part_ids,
+                                    const KnnDistanceBase1 *knn_distance,
+                                    const void *query_ptr,
+                                    const EmbeddingDataType query_element_type,
+                                    const IVFSearchFilter &satisfy_filter_func,
+                                    const std::function<void(f32, SegmentOffset)> &add_result_func) const {
+    ivf_parts_storage_->SearchIndex(part_ids, this, knn_distance, query_ptr, query_element_type, satisfy_filter_func, add_result_func);
+}
+
+void IVF_Index_Storage::SearchIndexMulti(const KnnDistanceBase1 *knn_distance,
+                                         const void *query_ptr,
+                                         const EmbeddingDataType query_element_type,
+                                         const u32 query_count,
+                                         const u32 nprobe,
+                                         const IVFSearchFilter &satisfy_filter_func,
+                                         const std::function<void(u32, f32, SegmentOffset)> &add_result_func) const {
+    const auto nprobe_result = SearchCentroids(knn_distance, query_ptr, query_element_type, query_count, nprobe);
+    ivf_parts_storage_->SearchIndexMulti(nprobe_result,
+                                         query_count,
+                                         this,
+                                         knn_distance,
+                                         query_ptr,
+                                         query_element_type,
+                                         satisfy_filter_func,
+                                         add_result_func);
 }
 
 } // namespace infinity
@@ -76,8 +76,18 @@ public:
                              const KnnDistanceBase1 *knn_distance,
                              const void *query_ptr,
                              EmbeddingDataType query_element_type,
-                             const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                             const IVFSearchFilter &satisfy_filter_func,
                              const std::function<void(f32, SegmentOffset)> &add_result_func) const = 0;
+
+    // `part_ids` holds `nprobe` parts per query, every probed part is scanned once for all the queries which probe it
+    virtual void SearchIndexMulti(const Vector<u32> &part_ids,
+                                  u32 query_count,
+                                  const IVF_Index_Storage *ivf_index_storage,
+                                  const KnnDistanceBase1 *knn_distance,
+                                  const void *query_ptr,
+                                  EmbeddingDataType query_element_type,
+                                  const IVFSearchFilter &satisfy_filter_func,
+                                  const std::function<void(u32, f32, SegmentOffset)> &add_result_func) const = 0;
 };
 
 class IVF_Index_Storage {
@@ -112,9 +122,30 @@ public:
                      const void *query_ptr,
                      EmbeddingDataType query_element_type,
                      u32 nprobe,
-                     const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                     const IVFSearchFilter &satisfy_filter_func,
                      const std::function<void(f32, SegmentOffset)> &add_result_func) const;
 
+    // the ids of the `nprobe` nearest parts of every query, `nprobe` is capped by the number of parts
+    Vector<u32>
+    SearchCentroids(const KnnDistanceBase1 *knn_distance, const void *query_ptr, EmbeddingDataType query_element_type, u32 query_count, u32 nprobe) const;
+
+    // searches the given parts only, the parts may be a slice of the result of `SearchCentroids`
+    void SearchParts(const Vector<u32> &part_ids,
+                     const KnnDistanceBase1 *knn_distance,
+                     const void *query_ptr,
+                     EmbeddingDataType query_element_type,
+                     const IVFSearchFilter &satisfy_filter_func,
+                     const std::function<void(f32, SegmentOffset)> &add_result_func) const;
+
+    // `query_count` queries, the nearest parts of all queries are found with one matrix multiplication
+    void SearchIndexMulti(const KnnDistanceBase1 *knn_distance,
+                          const void *query_ptr,
+                          EmbeddingDataType query_element_type,
+                          u32 query_count,
+                          u32 nprobe,
+                          const IVFSearchFilter &satisfy_filter_func,
+                          const std::function<void(u32, f32, SegmentOffset)> &add_result_func) const;
+
     void GetMemData(IVF_Index_Storage &&mem_data);
     void Save(LocalFileHandle &file_handle) const;
     void Load(LocalFileHandle &file_handle);
@@ -40,6 +40,8 @@ import mlas_matrix_multiply;
 import vector_distance;
 import index_base;
 import knn_expr;
+import rabitq_quantizer;
+import simd_functions;
 
 namespace infinity {
 
@@ -115,7 +117,7 @@ public:
                              const KnnDistanceBase1 *knn_distance,
                              const void *query_ptr,
                              EmbeddingDataType query_element_type,
-                             const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                             const IVFSearchFilter &satisfy_filter_func,
                              const std::function<void(f32, SegmentOffset)> &add_result_func,
                              SearchIndexPartsReuseContext &context) const = 0;
 };
@@ -137,6 +139,25 @@ public:
     void Train(const u32 training_embedding_num, const f32 *training_data, const IVF_Centroids_Storage *ivf_centroids_storage) final {}
 };
 
+// the residuals are encoded to the centroids of the parts, nothing to train
+// the rotation shared by the parts is made from the dimension, it is not stored
+template <>
+class IVF_Parts_Storage_Info<IndexIVFStorageOption::Type::kRaBitQ> : public IVF_Parts_Storage {
+    const RaBitQRotation rotation_;
+
+public:
+    IVF_Parts_Storage_Info(const u32 embedding_dimension,
+                           const u32 centroids_num,
+                           const EmbeddingDataType embedding_data_type,
+                           const IndexIVFStorageOption &ivf_storage_option)
+        : IVF_Parts_Storage(embedding_dimension, centroids_num), rotation_(embedding_dimension) {}
+    ~IVF_Parts_Storage_Info() override = default;
+    const RaBitQRotation &rotation() const { return rotation_; }
+    void Save(LocalFileHandle &file_handle) const override {}
+    void Load(LocalFileHandle &file_handle) override {}
+    void Train(const u32 training_embedding_num, const f32 *training_data, const IVF_Centroids_Storage *ivf_centroids_storage) final {}
+};
+
 UniquePtr<f32[]> GetTrainingResidual(const u32 training_embedding_num,
                                      const f32 *training_data,
                                      const IVF_Centroids_Storage *ivf_centroids_storage,
@@ -350,7 +371,9 @@ public:
                                                                     training_embedding_num,
                                                                     part_train_data.get(),
                                                                     subspace_centroids_v,
-                                                                    real_subspace_centroid_num_);
+                                                                    real_subspace_centroid_num_,
+                                                                    0,
+                                                                    KMeansOption{.kmeans_plus_plus_ = true});
                 if (centroid_cnt_result != real_subspace_centroid_num_) {
                     UnrecoverableError(fmt::format("KMeans failed to find {} centroids for subspace", real_subspace_centroid_num_));
                 }
@@ -454,7 +477,7 @@ public:
                      const KnnDistanceBase1 *knn_distance,
                      const void *query_ptr,
                      const EmbeddingDataType query_element_type,
-                     const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                     const IVFSearchFilter &satisfy_filter_func,
                      const std::function<void(f32, SegmentOffset)> &add_result_func) const override {
         SearchIndexPartsReuseContext context;
         for (const auto part_id : part_ids) {
@@ -462,6 +485,43 @@ public:
                 ->SearchIndex(ivf_index_storage, knn_distance, query_ptr, query_element_type, satisfy_filter_func, add_result_func, context);
         }
     }
+
+    void SearchIndexMulti(const Vector<u32> &part_ids,
+                          const u32 query_count,
+                          const IVF_Index_Storage *ivf_index_storage,
+                          const KnnDistanceBase1 *knn_distance,
+                          const void *query_ptr,
+                          const EmbeddingDataType query_element_type,
+                          const IVFSearchFilter &satisfy_filter_func,
+                          const std::function<void(u32, f32, SegmentOffset)> &add_result_func) const override {
+        if (query_count == 0) {
+            return;
+        }
+        const u32 nprobe = part_ids.size() / query_count;
+        // the queries which probe every part
+        Vector<Vector<u32>> part_queries(ivf_part_storages_.size());
+        for (u32 query_id = 0; query_id < query_count; ++query_id) {
+            for (u32 i = 0; i < nprobe; ++i) {
+                part_queries[part_ids[query_id * nprobe + i]].push_back(query_id);
+            }
+        }
+        const auto query_bytes = EmbeddingType::EmbeddingSize(query_element_type, embedding_dimension());
+        auto get_query = [&](const u32 query_id) { return static_cast<const char *>(query_ptr) + query_id * query_bytes; };
+        // the query tables are computed once per query and reused by all its parts
+        Vector<SearchIndexPartsReuseContext> contexts(query_count);
+        for (u32 part_id = 0; part_id < part_queries.size(); ++part_id) {
+            for (const auto query_id : part_queries[part_id]) {
+                ivf_part_storages_[part_id]->SearchIndex(
+                    ivf_index_storage,
+                    knn_distance,
+                    get_query(query_id),
+                    query_element_type,
+                    satisfy_filter_func,
+                    [&add_result_func, query_id](const f32 d, const SegmentOffset segment_offset) { add_result_func(query_id, d, segment_offset); },
+                    contexts[query_id]);
+            }
+        }
+    }
 };
 
 UniquePtr<IVF_Parts_Storage> IVF_Parts_Storage::Make(const u32 embedding_dimension,
@@ -481,6 +541,9 @@ UniquePtr<IVF_Parts_Storage> IVF_Parts_Storage::Make(const u32 embedding_dimensi
         case IndexIVFStorageOption::Type::kProductQuantization: {
             return GetPartsStorageT.template operator()<IndexIVFStorageOption::Type::kProductQuantization>();
         }
+        case IndexIVFStorageOption::Type::kRaBitQ: {
+            return GetPartsStorageT.template operator()<IndexIVFStorageOption::Type::kRaBitQ>();
+        }
     }
     return {};
 }
@@ -542,7 +605,7 @@ public:
                      const KnnDistanceBase1 *knn_distance,
                      const void *query_ptr,
                      const EmbeddingDataType query_element_type,
-                     const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                     const IVFSearchFilter &satisfy_filter_func,
                      const std::function<void(f32, SegmentOffset)> &add_result_func,
                      SearchIndexPartsReuseContext &) const override {
         auto ReturnT = [&]<EmbeddingDataType query_element_type> {
@@ -576,15 +639,28 @@ public:
     template <EmbeddingDataType query_element_type>
     void SearchIndexT(const KnnDistanceBase1 *knn_distance,
                       const EmbeddingDataTypeToCppTypeT<query_element_type> *query_ptr,
-                      const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                      const IVFSearchFilter &satisfy_filter_func,
                       const std::function<void(f32, SegmentOffset)> &add_result_func) const {
         using QueryDataType = EmbeddingDataTypeToCppTypeT<query_element_type>;
         auto knn_distance_1 = dynamic_cast<const KnnDistance1<QueryDataType, f32> *>(knn_distance);
         if (!knn_distance_1) [[unlikely]] {
             UnrecoverableError("Invalid KnnDistance1");
         }
-        auto dist_func = knn_distance_1->dist_func_;
         const auto total_embedding_num = embedding_num();
+        if constexpr (IsAnyOf<StorageDataT, Float16T, BFloat16T>) {
+            // half precision data are computed directly, without casting every embedding to f32
+            const auto half_dist_func = std::is_same_v<StorageDataT, Float16T> ? knn_distance_1->f16_dist_func_ : knn_distance_1->bf16_dist_func_;
+            for (u32 i = 0; i < total_embedding_num; ++i) {
+                const auto segment_offset = embedding_segment_offset(i);
+                if (!satisfy_filter_func(segment_offset)) {
+                    continue;
+                }
+                const auto *v_ptr = reinterpret_cast<const u16 *>(data_.data() + i * embedding_dimension());
+                add_result_func(half_dist_func(query_ptr, v_ptr, embedding_dimension()), segment_offset);
+            }
+            return;
+        }
+        auto dist_func = knn_distance_1->dist_func_;
         for (u32 i = 0; i < total_embedding_num; ++i) {
             const auto segment_offset = embedding_segment_offset(i);
             if (!satisfy_filter_func(segment_offset)) {
@@ -676,7 +752,7 @@ public:
                      const KnnDistanceBase1 *knn_distance,
                      const void *query_ptr,
                      const EmbeddingDataType query_element_type,
-                     const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                     const IVFSearchFilter &satisfy_filter_func,
                      const std::function<void(f32, SegmentOffset)> &add_result_func,
                      SearchIndexPartsReuseContext &context) const override {
         auto ReturnT = [&]<EmbeddingDataType query_element_type> {
@@ -725,7 +801,7 @@ public:
     void SearchIndexT(const IVF_Index_Storage *ivf_index_storage,
                       const KnnDistanceBase1 *knn_distance,
                       const EmbeddingDataTypeToCppTypeT<query_element_type> *query_ptr,
-                      const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                      const IVFSearchFilter &satisfy_filter_func,
                       const std::function<void(f32, SegmentOffset)> &add_result_func,
                       SearchIndexPartsReuseContext &context) const {
         using QueryDataType = EmbeddingDataTypeToCppTypeT<query_element_type>;
@@ -866,28 +942,82 @@ template <u32 storage_bits>
 struct PQ_Code_StorageT;
 
 // 4 bits per code
+// The codes are kept in blocks of kPQFastScanBlockSize vectors for the fast scan, see PQ4FastScan_common.
+// Files keep the row major layout of the other storages.
+constexpr u32 kPQFastScanBlockSize = 32;
+
 template <>
-struct PQ_Code_StorageT<4> final : PQ_Code_StorageB<u8> {
-    using PQ_Code_StorageB<u8>::PQ_Code_StorageB;
+struct PQ_Code_StorageT<4> final : PQ_Code_Storage {
+    // the simd kernels handle two subspaces per step
+    const u64 padded_subspace_num_ = (subspace_num_ + 1) / 2 * 2;
+    u32 vector_num_ = 0;
+    Vector<u8> blocks_{};
+    using PQ_Code_Storage::PQ_Code_Storage;
+
+    u32 vector_num() const { return vector_num_; }
+    u32 block_num() const { return (vector_num_ + kPQFastScanBlockSize - 1) / kPQFastScanBlockSize; }
+    const u8 *block(const u32 block_id) const { return blocks_.data() + block_id * block_bytes(); }
+
+    void Save(LocalFileHandle &file_handle) const override {
+        const u64 last_code_id = vector_num_ * subspace_num_;
+        Vector<u8> storage((last_code_id + 1) / 2);
+        const auto codes = MakeUniqueForOverwrite<u32[]>(subspace_num_);
+        u64 write_pos = 0;
+        for (u32 idx = 0; idx < vector_num_; ++idx) {
+            ExtractCodes(idx, codes.get());
+            for (u32 i = 0; i < subspace_num_; ++i) {
+                storage[write_pos >> 1] |= (write_pos & 1) ? (codes[i] << 4) : codes[i];
+                ++write_pos;
+            }
+        }
+        file_handle.Append(&last_code_id, sizeof(last_code_id));
+        const u32 storage_size = storage.size();
+        file_handle.Append(&storage_size, sizeof(storage_size));
+        file_handle.Append(storage.data(), storage.size());
+    }
+    void Load(LocalFileHandle &file_handle) override {
+        u64 last_code_id = 0;
+        file_handle.Read(&last_code_id, sizeof(last_code_id));
+        u32 storage_size = 0;
+        file_handle.Read(&storage_size, sizeof(storage_size));
+        Vector<u8> storage(storage_size);
+        file_handle.Read(storage.data(), storage_size);
+        vector_num_ = 0;
+        blocks_.clear();
+        const u32 load_vector_num = subspace_num_ ? last_code_id / subspace_num_ : 0;
+        const auto codes = MakeUniqueForOverwrite<u32[]>(subspace_num_);
+        u64 read_pos = 0;
+        for (u32 idx = 0; idx < load_vector_num; ++idx) {
+            for (u32 i = 0; i < subspace_num_; ++i) {
+                const auto access_pos = read_pos >> 1;
+                codes[i] = ((read_pos & 1) ? (storage[access_pos] >> 4) : (storage[access_pos] & 0xf));
+                ++read_pos;
+            }
+            AppendCodes(codes.get());
+        }
+    }
     void ExtractCodes(const u32 idx, u32 *output_codes) const override {
-        auto read_pos = idx * subspace_num_;
+        const u8 *block_ptr = block(idx / kPQFastScanBlockSize);
+        const u32 pos = idx % kPQFastScanBlockSize;
         for (u32 i = 0; i < subspace_num_; ++i) {
-            const auto access_pos = read_pos >> 1;
-            output_codes[i] = ((read_pos & 1) ? (storage_[access_pos] >> 4) : (storage_[access_pos] & 0xf));
-            ++read_pos;
+            const u8 byte = block_ptr[i * 16 + (pos & 15)];
+            output_codes[i] = (pos & 16) ? (byte >> 4) : (byte & 0xf);
         }
     }
     void AppendCodes(const u32 *input_codes) override {
-        storage_.resize((last_code_id_ + subspace_num_ + 1) / 2);
-        auto write_pos = last_code_id_;
+        const u32 pos = vector_num_ % kPQFastScanBlockSize;
+        if (pos == 0) {
+            blocks_.resize(blocks_.size() + block_bytes());
+        }
+        u8 *block_ptr = blocks_.data() + (vector_num_ / kPQFastScanBlockSize) * block_bytes();
         for (u32 i = 0; i < subspace_num_; ++i) {
-            const auto access_pos = write_pos >> 1;
-            const auto input_code = input_codes[i];
-            storage_[access_pos] |= (write_pos & 1) ? (input_code << 4) : input_code;
-            ++write_pos;
+            block_ptr[i * 16 + (pos & 15)] |= (pos & 16) ? (input_codes[i] << 4) : input_codes[i];
         }
-        last_code_id_ += subspace_num_;
+        ++vector_num_;
     }
+
+private:
+    SizeT block_bytes() const { return padded_subspace_num_ * 16; }
 };
 
 // 8 bits per code
@@ -1036,7 +1166,7 @@ public:
                      const KnnDistanceBase1 *knn_distance,
                      const void *query_ptr,
                      const EmbeddingDataType query_element_type,
-                     const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                     const IVFSearchFilter &satisfy_filter_func,
                      const std::function<void(f32, SegmentOffset)> &add_result_func,
                      SearchIndexPartsReuseContext &context) const override {
         auto ReturnT = [&]<EmbeddingDataType query_element_type> {
@@ -1069,11 +1199,61 @@ public:
         }
     }
 
+    // d = base + sum of terms[j * real_subspace_centroid_num + code_j], approximated with u8 tables and u16 sums.
+    // The error is bounded by half a quantization step per subspace, the knn scan reranks the results with the raw vectors.
+    void FastScan4Bit(const PQ_Code_StorageT<4> &storage,
+                      const f32 *terms,
+                      const u32 real_subspace_centroid_num,
+                      const f32 base,
+                      const IVFSearchFilter &satisfy_filter_func,
+                      const std::function<void(f32, SegmentOffset)> &add_result_func) const {
+        const u32 padded_subspace_num = storage.padded_subspace_num_;
+        Vector<f32> term_min(subspace_num_, std::numeric_limits<f32>::max());
+        f32 max_range = 0.0f;
+        f32 base_q = base;
+        for (u32 j = 0; j < subspace_num_; ++j) {
+            const f32 *subspace_terms = terms + j * real_subspace_centroid_num;
+            f32 term_max = std::numeric_limits<f32>::lowest();
+            for (u32 c = 0; c < real_subspace_centroid_num; ++c) {
+                term_min[j] = std::min(term_min[j], subspace_terms[c]);
+                term_max = std::max(term_max, subspace_terms[c]);
+            }
+            max_range = std::max(max_range, term_max - term_min[j]);
+            base_q += term_min[j];
+        }
+        // the sum of all subspaces must fit in u16
+        const f32 q_max = std::min<u32>(255, 65535 / padded_subspace_num);
+        const f32 delta = max_range > 0.0f ? max_range / q_max : 1.0f;
+        const f32 delta_inv = 1.0f / delta;
+        Vector<u8> lut(padded_subspace_num * 16);
+        for (u32 j = 0; j < subspace_num_; ++j) {
+            const f32 *subspace_terms = terms + j * real_subspace_centroid_num;
+            for (u32 c = 0; c < real_subspace_centroid_num; ++c) {
+                lut[j * 16 + c] = static_cast<u8>(std::min(q_max, std::round((subspace_terms[c] - term_min[j]) * delta_inv)));
+            }
+        }
+        const auto fast_scan_func = GetSIMD_FUNCTIONS().PQ4FastScan_func_ptr_;
+        u16 sums[kPQFastScanBlockSize];
+        const u32 vector_num = storage.vector_num();
+        for (u32 block_id = 0; block_id < storage.block_num(); ++block_id) {
+            fast_scan_func(storage.block(block_id), lut.data(), padded_subspace_num, sums);
+            const u32 begin = block_id * kPQFastScanBlockSize;
+            const u32 end = std::min(begin + kPQFastScanBlockSize, vector_num);
+            for (u32 i = begin; i < end; ++i) {
+                const auto segment_offset = embedding_segment_offset(i);
+                if (!satisfy_filter_func(segment_offset)) {
+                    continue;
+                }
+                add_result_func(base_q + delta * sums[i - begin], segment_offset);
+            }
+        }
+    }
+
     template <EmbeddingDataType query_element_type>
     void SearchIndexT(const IVF_Index_Storage *ivf_index_storage,
                       const KnnDistanceBase1 *knn_distance,
                       const EmbeddingDataTypeToCppTypeT<query_element_type> *query_ptr,
-                      const std::function<bool(SegmentOffset)> &satisfy_filter_func,
+                      const IVFSearchFilter &satisfy_filter_func,
                       const std::function<void(f32, SegmentOffset)> &add_result_func,
                       SearchIndexPartsReuseContext &context) const {
         using QueryDataType = EmbeddingDataTypeToCppTypeT<query_element_type>;
@@ -1095,6 +1275,10 @@ public:
                 if (!ip_table) {
                     ip_table = ivf_parts_storage.GetIPTable(query_f32);
                 }
+                if (const auto *storage_4bit = dynamic_cast<const PQ_Code_StorageT<4> *>(pq_code_storage_.get())) {
+                    FastScan4Bit(*storage_4bit, ip_table.get(), real_subspace_centroid_num, query_centroid_ip, satisfy_filter_func, add_result_func);
+                    break;
+                }
                 const auto encoded_codes = MakeUniqueForOverwrite<u32[]>(subspace_num_);
                 for (u32 i = 0; i < total_embedding_num; ++i) {
                     const auto segment_offset = embedding_segment_offset(i);
@@ -1146,6 +1330,19 @@ public:
                 }
                 const auto residual_query_l2 = L2NormSquare<f32>(residual_query.get(), dimension);
                 const auto residual_ip_table = ivf_parts_storage.GetIPTable(residual_query.get());
+                if (const auto *storage_4bit = dynamic_cast<const PQ_Code_StorageT<4> *>(pq_code_storage_.get())) {
+                    // d = residual_query_l2 - 2 * sum(residual_ip + norms_neg_half)
+                    const auto terms = MakeUniqueForOverwrite<f32[]>(subspace_num * real_subspace_centroid_num);
+                    for (u32 j = 0; j < subspace_num; ++j) {
+                        const auto norms_neg_half = ivf_parts_storage.subspace_centroid_norms_neg_half_at_subspace(j);
+                        for (u32 c = 0; c < real_subspace_centroid_num; ++c) {
+                            const auto idx = j * real_subspace_centroid_num + c;
+                            terms[idx] = -2.0f * (residual_ip_table[idx] + norms_neg_half[c]);
+                        }
+                    }
+                    FastScan4Bit(*storage_4bit, terms.get(), real_subspace_centroid_num, residual_query_l2, satisfy_filter_func, add_result_func);
+                    break;
+                }
                 const auto encoded_codes = MakeUniqueForOverwrite<u32[]>(subspace_num_);
                 for (u32 i = 0; i < total_embedding_num; ++i) {
                     const auto segment_offset = embedding_segment_offset(i);
@@ -1172,6 +1369,109 @@ public:
     }
 };
 
+// RaBitQ storage
+// every record is a RaBitQFactor followed by the 1 bit code of the residual to the part centroid
+template <EmbeddingDataType src_embedding_data_type>
+class IVF_Part_Storage_RaBitQ final : public IVF_Part_Storage {
+    using ColumnEmbeddingElementT = EmbeddingDataTypeToCppTypeT<src_embedding_data_type>;
+    static_assert(IsAnyOf<ColumnEmbeddingElementT, f64, f32, Float16T, BFloat16T>);
+
+    const u32 embedding_dimension_ = 0;
+    const u32 code_bytes_ = RaBitQCodeBytes(embedding_dimension_);
+    const u32 record_size_ = sizeof(RaBitQFactor) + code_bytes_;
+    Vector<u8> records_{};
+
+public:
+    IVF_Part_Storage_RaBitQ(const u32 part_id, const u32 embedding_dimension)
+        : IVF_Part_Storage(part_id), embedding_dimension_(embedding_dimension) {}
+
+    void Save(LocalFileHandle &file_handle) const override {
+        IVF_Part_Storage::Save(file_handle);
+        assert(embedding_num() * record_size_ == records_.size());
+        file_handle.Append(records_.data(), records_.size());
+    }
+
+    void Load(LocalFileHandle &file_handle) override {
+        IVF_Part_Storage::Load(file_handle);
+        records_.resize(embedding_num() * record_size_);
+        file_handle.Read(records_.data(), records_.size());
+    }
+
+    void AppendOneEmbedding(const void *embedding_ptr,
+                            const SegmentOffset segment_offset,
+                            const IVF_Centroids_Storage *ivf_centroids_storage,
+                            const IVF_Parts_Storage *ivf_parts_storage) override {
+        const auto &rotation = static_cast<const IVF_Parts_Storage_Info<IndexIVFStorageOption::Type::kRaBitQ> *>(ivf_parts_storage)->rotation();
+        const auto [src_embedding_f32, _] = GetF32Ptr(static_cast<const ColumnEmbeddingElementT *>(embedding_ptr), embedding_dimension_);
+        const auto centroid_data = ivf_centroids_storage->data() + part_id() * embedding_dimension_;
+        const auto old_size = records_.size();
+        records_.resize(old_size + record_size_);
+        u8 *record = records_.data() + old_size;
+        const RaBitQFactor factor = RaBitQEncode(src_embedding_f32, centroid_data, rotation, record + sizeof(RaBitQFactor));
+        std::memcpy(record, &factor, sizeof(RaBitQFactor));
+        embedding_segment_offsets_.push_back(segment_offset);
+        ++embedding_num_;
+    }
+
+    void SearchIndex(const IVF_Index_Storage *ivf_index_storage,
+                     const KnnDistanceBase1 *knn_distance,
+                     const void *query_ptr,
+                     const EmbeddingDataType query_element_type,
+                     const IVFSearchFilter &satisfy_filter_func,
+                     const std::function<void(f32, SegmentOffset)> &add_result_func,
+                     SearchIndexPartsReuseContext &context) const override {
+        if (query_element_type != EmbeddingDataType::kElemFloat) {
+            UnrecoverableError("Invalid Query EmbeddingDataType");
+        }
+        const auto *query_f32 = static_cast<const f32 *>(query_ptr);
+        const auto dimension = embedding_dimension_;
+        const auto centroid_data = ivf_index_storage->ivf_centroids_storage().data() + part_id() * dimension;
+        const auto &rotation =
+            static_cast<const IVF_Parts_Storage_Info<IndexIVFStorageOption::Type::kRaBitQ> &>(ivf_index_storage->ivf_parts_storage()).rotation();
+        const auto query = RaBitQEncodeQuery(query_f32, centroid_data, rotation);
+        const auto total_embedding_num = embedding_num();
+        context.dim_ = dimension;
+        context.x_ptr_ = query_f32;
+        auto search = [&](auto &&get_distance) {
+            for (u32 i = 0; i < total_embedding_num; ++i) {
+                const auto segment_offset = embedding_segment_offset(i);
+                if (!satisfy_filter_func(segment_offset)) {
+                    continue;
+                }
+                const u8 *record = records_.data() + i * record_size_;
+                RaBitQFactor factor;
+                std::memcpy(&factor, record, sizeof(RaBitQFactor));
+                add_result_func(get_distance(factor, record + sizeof(RaBitQFactor)), segment_offset);
+            }
+        };
+        switch (knn_distance->dist_type_) {
+            case KnnDistanceType::kInnerProduct: {
+                search([&](const RaBitQFactor &factor, const u8 *code) { return RaBitQIPDistance(factor, code, query, code_bytes_); });
+                break;
+            }
+            case KnnDistanceType::kCosine: {
+                // ||v||^2 = ||r||^2 + 2 * dot(r, c) + ||c||^2
+                const auto query_l2 = context.get_x_l2();
+                const auto centroid_l2 = L2NormSquare<f32>(centroid_data, dimension);
+                search([&](const RaBitQFactor &factor, const u8 *code) {
+                    const f32 target_l2 = factor.norm_ * factor.norm_ + 2 * factor.rc_ip_ + centroid_l2;
+                    return RaBitQIPDistance(factor, code, query, code_bytes_) / std::sqrt(query_l2 * target_l2);
+                });
+                break;
+            }
+            case KnnDistanceType::kL2: {
+                search([&](const RaBitQFactor &factor, const u8 *code) { return RaBitQL2Distance(factor, code, query, code_bytes_); });
+                break;
+            }
+            default: {
+                RecoverableError(Status::SyntaxError(
+                    fmt::format("IVFRaBitQ does not support {} metric now.", KnnExpr::KnnDistanceType2Str(knn_distance->dist_type_))));
+                break;
+            }
+        }
+    }
+};
+
 UniquePtr<IVF_Part_Storage> IVF_Part_Storage::Make(const u32 part_id,
                                                    const u32 embedding_dimension,
                                                    const EmbeddingDataType embedding_data_type,
@@ -1285,6 +1585,30 @@ UniquePtr<IVF_Part_Storage> IVF_Part_Storage::Make(const u32 part_id,
             }
             break;
         }
+        case IndexIVFStorageOption::Type::kRaBitQ: {
+            auto GetRaBitQResult = [part_id, embedding_dimension]<EmbeddingDataType src_embedding_data_type>() {
+                return MakeUnique<IVF_Part_Storage_RaBitQ<src_embedding_data_type>>(part_id, embedding_dimension);
+            };
+            switch (embedding_data_type) {
+                case EmbeddingDataType::kElemDouble: {
+                    return GetRaBitQResult.template operator()<EmbeddingDataType::kElemDouble>();
+                }
+                case EmbeddingDataType::kElemFloat: {
+                    return GetRaBitQResult.template operator()<EmbeddingDataType::kElemFloat>();
+                }
+                case EmbeddingDataType::kElemFloat16: {
+                    return GetRaBitQResult.template operator()<EmbeddingDataType::kElemFloat16>();
+                }
+                case EmbeddingDataType::kElemBFloat16: {
+                    return GetRaBitQResult.template operator()<EmbeddingDataType::kElemBFloat16>();
+                }
+                default: {
+                    UnrecoverableError("Unsupported embedding data type for IVFRaBitQ.");
+                    return {};
+                }
+            }
+            break;
+        }
     }
     return {};
 }
@@ -22,6 +22,17 @@ import column_vector;
 
 namespace infinity {
 
+// The rows of a segment to be searched. It is passed through the non template search interfaces and checked inline in the scan loops.
+// `words_` is the flattened filter bitmap, or nullptr when all the rows before `end_` are searched.
+export struct IVFSearchFilter {
+    const u64 *words_ = nullptr;
+    SegmentOffset end_ = 0;
+
+    bool operator()(const SegmentOffset segment_offset) const {
+        return segment_offset < end_ && (words_ == nullptr || ((words_[segment_offset >> 6] >> (segment_offset & 63)) & 1));
+    }
+};
+
 export template <IsAnyOf<u8, i8, f64, f32, Float16T, BFloat16T> ColumnEmbeddingElementT>
 Pair<const f32 *, UniquePtr<f32[]>> GetF32Ptr(const ColumnEmbeddingElementT *src_data_ptr, const u32 src_data_cnt) {
     Pair<const f32 *, UniquePtr<f32[]>> dst_data_ptr;
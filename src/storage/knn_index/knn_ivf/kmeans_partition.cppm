@@ -15,6 +15,8 @@
 module;
 
 #include <cstring>
+#include <future>
+#include <numeric>
 #include <random>
 export module kmeans_partition;
 
@@ -24,6 +26,7 @@ import index_base;
 import vector_distance;
 import logger;
 import simd_functions;
+import infinity_context;
 
 namespace infinity {
 
@@ -61,10 +64,186 @@ inline void NormalizeCentroids(const u32 dimension, const u32 partition_num, Cen
     }
 }
 
+export struct KMeansOption {
+    // slices of the assignment and update steps, 0 for one per thread of the index build pool and one for the calling thread
+    u32 thread_num_ = 0;
+    // if positive, the centroids are updated after every mini batch of this size, and an iteration is one pass over the training data
+    u32 mini_batch_size_ = 0;
+    // seed the centroids by k-means++ instead of a random choice
+    bool kmeans_plus_plus_ = false;
+};
+
+// a thread works on at least one block of search_top_1
+constexpr u32 min_rows_per_thread = 4096;
+// k-means++ seeds from a sample of the training data
+constexpr u32 kmeans_plus_plus_sample_ratio = 16;
+
+inline u32 KMeansThreadNum(const KMeansOption &option, const u32 row_num) {
+    const u32 pool_thread_num = InfinityContext::instance().GetHnswBuildThreadPool().size();
+    const u32 thread_num = option.thread_num_ > 0 ? option.thread_num_ : pool_thread_num + 1;
+    return std::max(1u, std::min(thread_num, row_num / min_rows_per_thread));
+}
+
+// call work(begin, end) on thread_num slices of [0, n), thread_num <= n. The last slice is done by the calling thread, the others by the
+// index build pool, which bounds the threads of all the k-means running at the same time.
+template <typename Work>
+inline void KMeansParallelFor(const u32 thread_num, const u32 n, Work &&work) {
+    if (thread_num <= 1) {
+        work(0u, n);
+        return;
+    }
+    auto &thread_pool = InfinityContext::instance().GetHnswBuildThreadPool();
+    const u32 step = n / thread_num;
+    Vector<std::future<void>> futs;
+    futs.reserve(thread_num - 1);
+    for (u32 i = 0; i + 1 < thread_num; ++i) {
+        futs.emplace_back(thread_pool.push([&work, begin = i * step, end = (i + 1) * step](int) { work(begin, end); }));
+    }
+    work((thread_num - 1) * step, n);
+    for (auto &fut : futs) {
+        fut.get();
+    }
+}
+
+// assign each vector to the nearest centroid, each thread runs the blocked sgemm search on its rows
+inline void AssignPartitions(const u32 thread_num,
+                             const u32 dimension,
+                             const u32 vector_count,
+                             const f32 *vectors,
+                             const u32 partition_num,
+                             const f32 *centroids,
+                             u32 *partition_ids,
+                             f32 *distances) {
+    auto search_top_1_with_dis = GetSIMD_FUNCTIONS().SearchTop1WithDisF32U32_func_ptr_;
+    KMeansParallelFor(thread_num, vector_count, [&](const u32 begin, const u32 end) {
+        search_top_1_with_dis(dimension,
+                              end - begin,
+                              vectors + static_cast<SizeT>(begin) * dimension,
+                              partition_num,
+                              centroids,
+                              partition_ids + begin,
+                              distances + begin);
+    });
+}
+
+// centroids = sum of the vectors of each partition, the partitions are split among the threads
+inline void SumPartitions(const u32 thread_num,
+                          const u32 dimension,
+                          const u32 vector_count,
+                          const f32 *vectors,
+                          const u32 partition_num,
+                          const u32 *partition_ids,
+                          const Vector<u32> &partition_element_count,
+                          f32 *centroids) {
+    // group the vectors by partition
+    Vector<u32> offsets(partition_num + 1, 0);
+    for (u32 i = 0; i < partition_num; ++i) {
+        offsets[i + 1] = offsets[i] + partition_element_count[i];
+    }
+    Vector<u32> members(vector_count);
+    {
+        Vector<u32> pos(offsets.begin(), offsets.end() - 1);
+        for (u32 i = 0; i < vector_count; ++i) {
+            members[pos[partition_ids[i]]++] = i;
+        }
+    }
+    KMeansParallelFor(std::min(thread_num, partition_num), partition_num, [&](const u32 begin, const u32 end) {
+        for (u32 p = begin; p < end; ++p) {
+            f32 *centroid = centroids + static_cast<SizeT>(p) * dimension;
+            std::fill_n(centroid, dimension, 0.0f);
+            for (u32 k = offsets[p]; k < offsets[p + 1]; ++k) {
+                const f32 *vector = vectors + static_cast<SizeT>(members[k]) * dimension;
+                for (u32 j = 0; j < dimension; ++j) {
+                    centroid[j] += vector[j];
+                }
+            }
+        }
+    });
+}
+
+// k-means++ on a sample of the vectors: the next centroid is drawn with probability proportional to its squared distance to the
+// nearest chosen one
+inline void KMeansPlusPlusInit(const KMeansOption &option,
+                               const u32 dimension,
+                               const u32 vector_count,
+                               const f32 *vectors,
+                               const u32 partition_num,
+                               f32 *centroids) {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    const u32 sample_num = static_cast<u32>(std::min<u64>(vector_count, static_cast<u64>(partition_num) * kmeans_plus_plus_sample_ratio));
+    Vector<u32> sample_ids = RandomPermutatePartially(vector_count, sample_num);
+    sample_ids.resize(sample_num);
+    const u32 thread_num = KMeansThreadNum(option, sample_num);
+    Vector<f32> min_distance(sample_num, std::numeric_limits<f32>::max());
+    u32 chosen = sample_ids[std::uniform_int_distribution<u32>(0, sample_num - 1)(gen)];
+    for (u32 c = 0; c < partition_num; ++c) {
+        f32 *centroid = centroids + static_cast<SizeT>(c) * dimension;
+        memcpy(centroid, vectors + static_cast<SizeT>(chosen) * dimension, sizeof(f32) * dimension);
+        if (c + 1 == partition_num) {
+            break;
+        }
+        KMeansParallelFor(thread_num, sample_num, [&](const u32 begin, const u32 end) {
+            for (u32 i = begin; i < end; ++i) {
+                const f32 distance = L2Distance<f32>(vectors + static_cast<SizeT>(sample_ids[i]) * dimension, centroid, dimension);
+                min_distance[i] = std::min(min_distance[i], distance);
+            }
+        });
+        const f64 total = std::accumulate(min_distance.begin(), min_distance.end(), 0.0);
+        if (total <= 0) {
+            // all the samples are chosen, the rest are duplicates
+            chosen = sample_ids[std::uniform_int_distribution<u32>(0, sample_num - 1)(gen)];
+            continue;
+        }
+        f64 target = std::uniform_real_distribution<f64>(0, total)(gen);
+        u32 i = 0;
+        for (; i + 1 < sample_num; ++i) {
+            target -= min_distance[i];
+            if (target < 0) {
+                break;
+            }
+        }
+        chosen = sample_ids[i];
+    }
+}
+
+// For every vacant partition, split the partition with the most vectors.
+template <typename CentroidType>
+inline void SplitVacantPartitions(const u32 dimension, const u32 partition_num, Vector<u32> &partition_element_count, CentroidType *centroids) {
+    for (u32 i = 0; i < partition_num; ++i) {
+        if (partition_element_count[i] == 0) {
+            // find the partition with the most vectors
+            u32 max_partition_id = 0;
+            u32 max_partition_element_count = 0;
+            for (u32 j = 0; j < partition_num; ++j) {
+                if (partition_element_count[j] > max_partition_element_count) {
+                    max_partition_id = j;
+                    max_partition_element_count = partition_element_count[j];
+                }
+            }
+            // split the partition
+            partition_element_count[i] = max_partition_element_count / 2;
+            partition_element_count[max_partition_id] -= partition_element_count[i];
+            // copy the centroid vector
+            memcpy(centroids + i * dimension, centroids + max_partition_id * dimension, dimension * sizeof(CentroidType));
+            // slightly change che i and max_partition_id centroid vector
+            constexpr f32 epsilon = 1 / 1024.0;
+            constexpr f32 plus_epsilon = 1 + epsilon;
+            constexpr f32 minus_epsilon = 1 - epsilon;
+            for (u32 j = 0; j < dimension; ++j) {
+                centroids[i * dimension + j] *= ((j & 1) ? plus_epsilon : minus_epsilon);
+                centroids[max_partition_id * dimension + j] *= ((j & 1) ? minus_epsilon : plus_epsilon);
+            }
+        }
+    }
+}
+
 // CentroidsType: the type to calculate centroids
 // partition_num: the number of partitions, default to sqrt(vector_count)
 // iteration_max: the max iteration count, default to 10
 constexpr int default_iteration_max = 10;
+constexpr u32 default_min_points_per_centroid = 32;
+constexpr u32 default_max_points_per_centroid = 256;
 export template <typename ElemType, typename CentroidsOutputType>
 [[nodiscard]] u32 GetKMeansCentroids(const MetricType metric,
                                      const u32 dimension,
@@ -73,9 +252,10 @@ export template <typename ElemType, typename CentroidsOutputType>
                                      Vector<CentroidsOutputType> &centroids_output_vector,
                                      u32 partition_num = 0,
                                      u32 iteration_max = 0,
-                                     u32 min_points_per_centroid = 32,
-                                     u32 max_points_per_centroid = 256,
-                                     float centroids_num_ratio = 1.0f) {
+                                     u32 min_points_per_centroid = default_min_points_per_centroid,
+                                     u32 max_points_per_centroid = default_max_points_per_centroid,
+                                     float centroids_num_ratio = 1.0f,
+                                     const KMeansOption &option = {}) {
     using CentroidsType = f32;
     switch (metric) {
         case MetricType::kMetricL2:
@@ -83,6 +263,7 @@ export template <typename ElemType, typename CentroidsOutputType>
         case MetricType::kMetricInnerProduct: {
             break;
         }
+        case MetricType::kMetricHamming:
         case MetricType::kInvalid: {
             UnrecoverableError("Metric type not implemented");
         }
@@ -163,26 +344,30 @@ export template <typename ElemType, typename CentroidsOutputType>
 
     // Initializing centroids
     {
-        // If training vectors are randomly chosen, centroids can be copied from training data.
-        // Otherwise, centroids need to be randomly generated.
-        if (random_elemtype_training_data_destructor) {
-            if constexpr (std::is_same_v<ElemType, CentroidsType>) {
-                memcpy(centroids, training_data, sizeof(ElemType) * partition_num * dimension);
-            } else {
-                for (u32 i = 0; i < partition_num * dimension; ++i) {
-                    centroids[i] = training_data[i];
-                }
-            }
+        if (option.kmeans_plus_plus_) {
+            KMeansPlusPlusInit(option, dimension, training_data_num, training_data, partition_num, centroids);
         } else {
-            Vector<u32> random_ids = RandomPermutatePartially(training_data_num, partition_num);
-            if constexpr (std::is_same_v<ElemType, CentroidsType>) {
-                for (u32 i = 0; i < partition_num; ++i) {
-                    memcpy(centroids + i * dimension, training_data + random_ids[i] * dimension, sizeof(ElemType) * dimension);
+            // If training vectors are randomly chosen, centroids can be copied from training data.
+            // Otherwise, centroids need to be randomly generated.
+            if (random_elemtype_training_data_destructor) {
+                if constexpr (std::is_same_v<ElemType, CentroidsType>) {
+                    memcpy(centroids, training_data, sizeof(ElemType) * partition_num * dimension);
+                } else {
+                    for (u32 i = 0; i < partition_num * dimension; ++i) {
+                        centroids[i] = training_data[i];
+                    }
                 }
             } else {
-                for (u32 i = 0; i < partition_num; ++i) {
-                    for (u32 j = 0; j < dimension; ++j) {
-                        centroids[i * dimension + j] = training_data[random_ids[i] * dimension + j];
+                Vector<u32> random_ids = RandomPermutatePartially(training_data_num, partition_num);
+                if constexpr (std::is_same_v<ElemType, CentroidsType>) {
+                    for (u32 i = 0; i < partition_num; ++i) {
+                        memcpy(centroids + i * dimension, training_data + random_ids[i] * dimension, sizeof(ElemType) * dimension);
+                    }
+                } else {
+                    for (u32 i = 0; i < partition_num; ++i) {
+                        for (u32 j = 0; j < dimension; ++j) {
+                            centroids[i * dimension + j] = training_data[random_ids[i] * dimension + j];
+                        }
                     }
                 }
             }
@@ -193,61 +378,107 @@ export template <typename ElemType, typename CentroidsOutputType>
         }
     }
 
+    const bool mini_batch = option.mini_batch_size_ > 0 && option.mini_batch_size_ < training_data_num;
+    const u32 batch_size = mini_batch ? option.mini_batch_size_ : training_data_num;
+    const u32 thread_num = KMeansThreadNum(option, batch_size);
+    const bool normalize = metric == MetricType::kMetricInnerProduct || metric == MetricType::kMetricCosine;
+
     // Record some information
     f32 previous_total_distance = std::numeric_limits<f32>::max();
     // Assign each vector to a partition
-    Vector<u32> training_data_partition_id(training_data_num);
+    Vector<u32> training_data_partition_id(batch_size);
     // Distance
-    Vector<f32> partition_element_distance(training_data_num);
+    Vector<f32> partition_element_distance(batch_size);
     // Record the number of vectors in each partition
     Vector<u32> partition_element_count(partition_num);
+    // Mini batch: the vectors of a batch, and the number of vectors ever assigned to each partition
+    UniquePtr<CentroidsType[]> batch_data;
+    Vector<u32> partition_seen_count;
+    if (mini_batch) {
+        batch_data = MakeUniqueForOverwrite<CentroidsType[]>(static_cast<SizeT>(batch_size) * dimension);
+        partition_seen_count.resize(partition_num, 0);
+    }
 
     // Iteration
     for (u32 iter = 1; iter <= iteration_max; ++iter) {
         // info
         f32 this_iter_distance = 0;
-        // First : assign each training vector to a partition
-        {
-            // search top 1
-            auto search_top_1_with_dis = GetSIMD_FUNCTIONS().SearchTop1WithDisF32U32_func_ptr_;
-            search_top_1_with_dis(dimension,
-                                  training_data_num,
-                                  training_data,
-                                  partition_num,
-                                  centroids,
-                                  training_data_partition_id.data(),
-                                  partition_element_distance.data());
-            // Clear partition_element_count
-            memset(partition_element_count.data(), 0, sizeof(u32) * partition_num);
-            // calculate partition_element_count
-            for (auto i : training_data_partition_id)
-                ++partition_element_count[i];
-
-            // add distance to this_iter_distance
-            this_iter_distance += std::reduce(partition_element_distance.begin(), partition_element_distance.end());
-        }
-        // Second : update centroids
-        {
-            // Clear old centroids data
-            memset(centroids, 0, sizeof(CentroidsType) * partition_num * dimension);
-            // Sum
-            for (u32 i = 0; i < training_data_num; ++i) {
-                auto vector_pos_i = training_data + i * dimension;
-                auto centroid_pos_i = centroids + training_data_partition_id[i] * dimension;
-                for (u32 j = 0; j < dimension; ++j) {
-                    centroid_pos_i[j] += vector_pos_i[j];
+        // Clear partition_element_count
+        memset(partition_element_count.data(), 0, sizeof(u32) * partition_num);
+        if (mini_batch) {
+            // One pass over the shuffled training data. Every vector moves its centroid towards it by 1 / (the vectors seen in the
+            // partition), so a centroid is the mean of all the vectors ever assigned to it.
+            Vector<u32> order = RandomPermutatePartially(training_data_num);
+            for (u32 batch_begin = 0; batch_begin < training_data_num; batch_begin += batch_size) {
+                const u32 batch_num = std::min(batch_size, training_data_num - batch_begin);
+                for (u32 i = 0; i < batch_num; ++i) {
+                    memcpy(batch_data.get() + static_cast<SizeT>(i) * dimension,
+                           training_data + static_cast<SizeT>(order[batch_begin + i]) * dimension,
+                           sizeof(CentroidsType) * dimension);
+                }
+                AssignPartitions(KMeansThreadNum(option, batch_num),
+                                 dimension,
+                                 batch_num,
+                                 batch_data.get(),
+                                 partition_num,
+                                 centroids,
+                                 training_data_partition_id.data(),
+                                 partition_element_distance.data());
+                this_iter_distance += std::reduce(partition_element_distance.begin(), partition_element_distance.begin() + batch_num);
+                for (u32 i = 0; i < batch_num; ++i) {
+                    const u32 partition_id = training_data_partition_id[i];
+                    ++partition_element_count[partition_id];
+                    const f32 eta = 1.0f / static_cast<f32>(++partition_seen_count[partition_id]);
+                    const CentroidsType *vector_pos_i = batch_data.get() + static_cast<SizeT>(i) * dimension;
+                    CentroidsType *centroid_pos_i = centroids + static_cast<SizeT>(partition_id) * dimension;
+                    for (u32 j = 0; j < dimension; ++j) {
+                        centroid_pos_i[j] += eta * (vector_pos_i[j] - centroid_pos_i[j]);
+                    }
+                }
+                if (normalize) {
+                    NormalizeCentroids(dimension, partition_num, centroids);
                 }
             }
-            // For L2 metric, divide the count. If there is no vector in a partition, the centroid of this partition will not be updated.
-            // For IP metric, normalize centroids.
-            if ((iter < iteration_max) && (metric == MetricType::kMetricInnerProduct || metric == MetricType::kMetricCosine)) {
-                NormalizeCentroids(dimension, partition_num, centroids);
-            } else {
-                for (u32 i = 0; i < partition_num; ++i) {
-                    if (const auto cnt = partition_element_count[i]; cnt > 0) {
-                        const f32 inv = 1.0f / static_cast<f32>(cnt);
-                        for (u32 j = 0; j < dimension; ++j) {
-                            centroids[i * dimension + j] *= inv;
+        } else {
+            // First : assign each training vector to a partition
+            {
+                AssignPartitions(thread_num,
+                                 dimension,
+                                 training_data_num,
+                                 training_data,
+                                 partition_num,
+                                 centroids,
+                                 training_data_partition_id.data(),
+                                 partition_element_distance.data());
+                // calculate partition_element_count
+                for (auto i : training_data_partition_id)
+                    ++partition_element_count[i];
+
+                // add distance to this_iter_distance
+                this_iter_distance += std::reduce(partition_element_distance.begin(), partition_element_distance.end());
+            }
+            // Second : update centroids
+            {
+                // Sum
+                SumPartitions(thread_num,
+                              dimension,
+                              training_data_num,
+                              training_data,
+                              partition_num,
+                              training_data_partition_id.data(),
+                              partition_element_count,
+                              centroids);
+                // For L2 metric, divide the count. If there is no vector in a partition, the centroid of this partition will not be updated.
+                // For IP metric, normalize centroids.
+                if ((iter < iteration_max) && normalize) {
+                    NormalizeCentroids(dimension, partition_num, centroids);
+                } else {
+                    for (u32 i = 0; i < partition_num; ++i) {
+                        if (const auto cnt = partition_element_count[i]; cnt > 0) {
+                            const f32 inv = 1.0f / static_cast<f32>(cnt);
+                            for (u32 j = 0; j < dimension; ++j) {
+                                centroids[i * dimension + j] *= inv;
+                            }
                         }
                     }
                 }
@@ -258,34 +489,7 @@ export template <typename ElemType, typename CentroidsOutputType>
         // TODO: When to split? How?
         //  Now sort the centroids by the number of vectors in each partition.
         //  For every vacant partition, split the partition with the most vectors.
-        {
-            for (u32 i = 0; i < partition_num; ++i) {
-                if (partition_element_count[i] == 0) {
-                    // find the partition with the most vectors
-                    u32 max_partition_id = 0;
-                    u32 max_partition_element_count = 0;
-                    for (u32 j = 0; j < partition_num; ++j) {
-                        if (partition_element_count[j] > max_partition_element_count) {
-                            max_partition_id = j;
-                            max_partition_element_count = partition_element_count[j];
-                        }
-                    }
-                    // split the partition
-                    partition_element_count[i] = max_partition_element_count / 2;
-                    partition_element_count[max_partition_id] -= partition_element_count[i];
-                    // copy the centroid vector
-                    memcpy(centroids + i * dimension, centroids + max_partition_id * dimension, dimension * sizeof(CentroidsType));
-                    // slightly change che i and max_partition_id centroid vector
-                    constexpr f32 epsilon = 1 / 1024.0;
-                    constexpr f32 plus_epsilon = 1 + epsilon;
-                    constexpr f32 minus_epsilon = 1 - epsilon;
-                    for (u32 j = 0; j < dimension; ++j) {
-                        centroids[i * dimension + j] *= ((j & 1) ? plus_epsilon : minus_epsilon);
-                        centroids[max_partition_id * dimension + j] *= ((j & 1) ? minus_epsilon : plus_epsilon);
-                    }
-                }
-            }
-        }
+        SplitVacantPartitions(dimension, partition_num, partition_element_count, centroids);
 
         // TODO:stop condition?
         if (metric == MetricType::kMetricL2 && this_iter_distance >= previous_total_distance)
@@ -304,4 +508,27 @@ export template <typename ElemType, typename CentroidsOutputType>
     return partition_num;
 }
 
+// the default points per centroid and ratio of centroids, with the option
+export template <typename ElemType, typename CentroidsOutputType>
+[[nodiscard]] u32 GetKMeansCentroids(const MetricType metric,
+                                     const u32 dimension,
+                                     const u32 vector_count,
+                                     const ElemType *vectors_ptr,
+                                     Vector<CentroidsOutputType> &centroids_output_vector,
+                                     const u32 partition_num,
+                                     const u32 iteration_max,
+                                     const KMeansOption &option) {
+    return GetKMeansCentroids(metric,
+                              dimension,
+                              vector_count,
+                              vectors_ptr,
+                              centroids_output_vector,
+                              partition_num,
+                              iteration_max,
+                              default_min_points_per_centroid,
+                              default_max_points_per_centroid,
+                              1.0f,
+                              option);
+}
+
 } // namespace infinity
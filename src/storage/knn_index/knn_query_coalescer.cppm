@@ -0,0 +1,86 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+
+export module knn_query_coalescer;
+
+import stl;
+
+namespace infinity {
+
+// the longest window a query waits for the others, see `KnnQueryCoalescer`
+export constexpr std::chrono::microseconds kKnnQueryCoalesceMaxWindow{10000};
+
+// Micro batching of the concurrent single queries of independent requests. The first query of a key waits `window` for the other
+// queries of the same key, then searches all of them in one batch and hands each query its own result.
+// The waiting queries block the threads calling `Submit`, which are the scheduler workers for a knn scan, so the window is capped at
+// `kKnnQueryCoalesceMaxWindow`.
+// The key identifies everything that the batch search depends on besides the queries, e.g. the index and the search options. The
+// queries must stay valid until `Submit` returns, which holds for the callers waiting on the batch.
+export template <typename Key, typename Query, typename Result>
+class KnnQueryCoalescer {
+    struct Batch {
+        Vector<Query> queries_;
+        Vector<Result> results_;
+        std::promise<void> done_;
+        std::shared_future<void> done_future_ = done_.get_future().share();
+    };
+
+public:
+    template <typename BatchSearch>
+    Result Submit(const Key &key, Query query, const std::chrono::microseconds window, BatchSearch &&batch_search) {
+        SharedPtr<Batch> batch;
+        SizeT query_idx = 0;
+        bool leader = false;
+        {
+            std::lock_guard lock(mutex_);
+            auto &open_batch = open_batches_[key];
+            if (!open_batch) {
+                open_batch = MakeShared<Batch>();
+                leader = true;
+            }
+            batch = open_batch;
+            query_idx = batch->queries_.size();
+            batch->queries_.push_back(std::move(query));
+        }
+        if (leader) {
+            std::this_thread::sleep_for(std::min(window, kKnnQueryCoalesceMaxWindow));
+            {
+                // no more queries join the batch
+                std::lock_guard lock(mutex_);
+                open_batches_.erase(key);
+            }
+            try {
+                batch->results_ = batch_search(batch->queries_);
+                batch->done_.set_value();
+            } catch (...) {
+                batch->done_.set_exception(std::current_exception());
+            }
+        }
+        batch->done_future_.get();
+        return std::move(batch->results_[query_idx]);
+    }
+
+private:
+    std::mutex mutex_;
+    Map<Key, SharedPtr<Batch>> open_batches_;
+};
+
+} // namespace infinity
@@ -0,0 +1,188 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+export module maxsim_batch;
+
+import stl;
+import internal_types;
+import column_vector;
+import mlas_matrix_multiply;
+
+namespace infinity {
+
+// MaxSim of a batch of target tensors with one matrix multiply.
+// The targets are stacked to one matrix and multiplied with the query tensor, the score of a target is the sum over the query embeddings of
+// the max in its part of the product. A target is added with a slot, the score of a slot is the max over its targets.
+export template <typename TensorElemT, typename QueryElemT>
+struct MaxSimBatch {
+    static constexpr bool kBatched = false;
+};
+
+// TensorElemT: f32, f64, f16, bf16, QueryElemT: f32
+export template <typename TensorElemT>
+    requires(IsAnyOf<TensorElemT, f32, f64, Float16T, BFloat16T>)
+struct MaxSimBatch<TensorElemT, f32> {
+    static constexpr bool kBatched = true;
+    // the zero point of both matrices
+    static constexpr u8 kShift = std::is_same_v<TensorElemT, i8> ? 0x80 : 0;
+
+    MaxSimBatch(const char *query_tensor_ptr, const u32 query_embedding_num, const u32 basic_embedding_dimension)
+        : query_tensor_ptr_(reinterpret_cast<const f32 *>(query_tensor_ptr)), query_embedding_num_(query_embedding_num),
+          dimension_(basic_embedding_dimension) {}
+
+    void Add(const char *raw_target_tensor_ptr, const u32 target_embedding_num, const u32 slot) {
+        const auto *src_ptr = reinterpret_cast<const TensorElemT *>(raw_target_tensor_ptr);
+        const SizeT offset = targets_.size();
+        targets_.resize(offset + static_cast<SizeT>(target_embedding_num) * dimension_);
+        if constexpr (std::is_same_v<TensorElemT, f32>) {
+            std::copy_n(src_ptr, static_cast<SizeT>(target_embedding_num) * dimension_, targets_.data() + offset);
+        } else {
+            for (SizeT i = 0; i < static_cast<SizeT>(target_embedding_num) * dimension_; ++i) {
+                targets_[offset + i] = static_cast<f32>(src_ptr[i]);
+            }
+        }
+        tensors_.push_back({embedding_num_, target_embedding_num, slot});
+        embedding_num_ += target_embedding_num;
+    }
+
+    u32 embedding_num() const { return embedding_num_; }
+
+    // slot_scores are initialized by the caller
+    void Score(float *slot_scores) {
+        output_.resize(static_cast<SizeT>(query_embedding_num_) * embedding_num_);
+        matrixA_multiply_transpose_matrixB_output_to_C(query_tensor_ptr_,
+                                                       targets_.data(),
+                                                       query_embedding_num_,
+                                                       embedding_num_,
+                                                       dimension_,
+                                                       output_.data());
+        for (const auto &[start, target_embedding_num, slot] : tensors_) {
+            float maxsim_score = 0.0f;
+            for (u32 query_i = 0; query_i < query_embedding_num_; ++query_i) {
+                const float *query_ip_ptr = output_.data() + static_cast<SizeT>(query_i) * embedding_num_ + start;
+                float max_score_i = std::numeric_limits<float>::lowest();
+                for (u32 k = 0; k < target_embedding_num; ++k) {
+                    max_score_i = std::max(max_score_i, query_ip_ptr[k]);
+                }
+                maxsim_score += max_score_i;
+            }
+            slot_scores[slot] = std::max(slot_scores[slot], maxsim_score);
+        }
+    }
+
+    void Clear() {
+        targets_.clear();
+        tensors_.clear();
+        embedding_num_ = 0;
+    }
+
+private:
+    const f32 *query_tensor_ptr_ = nullptr;
+    const u32 query_embedding_num_ = 0;
+    const u32 dimension_ = 0;
+    u32 embedding_num_ = 0;
+    Vector<f32> targets_;
+    Vector<Tuple<u32, u32, u32>> tensors_;
+    Vector<f32> output_;
+};
+
+// TensorElemT: u8, i8, QueryElemT: the same
+// Both matrices are u8, so that the product is exact in i32 on every CPU. i8 is shifted to u8 with zero point 128. The targets are the
+// left matrix, the query is transposed once.
+export template <typename TensorElemT>
+    requires(IsAnyOf<TensorElemT, u8, i8>)
+struct MaxSimBatch<TensorElemT, TensorElemT> {
+    static constexpr bool kBatched = true;
+    // the zero point of both matrices
+    static constexpr u8 kShift = std::is_same_v<TensorElemT, i8> ? 0x80 : 0;
+
+    MaxSimBatch(const char *query_tensor_ptr, const u32 query_embedding_num, const u32 basic_embedding_dimension)
+        : query_embedding_num_(query_embedding_num), dimension_(basic_embedding_dimension),
+          query_transposed_(static_cast<SizeT>(query_embedding_num) * basic_embedding_dimension), max_scores_(query_embedding_num) {
+        const auto *query_ptr = reinterpret_cast<const TensorElemT *>(query_tensor_ptr);
+        for (u32 query_i = 0; query_i < query_embedding_num_; ++query_i) {
+            for (u32 k = 0; k < dimension_; ++k) {
+                query_transposed_[static_cast<SizeT>(k) * query_embedding_num_ + query_i] =
+                    static_cast<u8>(query_ptr[static_cast<SizeT>(query_i) * dimension_ + k]) ^ kShift;
+            }
+        }
+    }
+
+    void Add(const char *raw_target_tensor_ptr, const u32 target_embedding_num, const u32 slot) {
+        const auto *src_ptr = reinterpret_cast<const u8 *>(raw_target_tensor_ptr);
+        const SizeT offset = targets_.size();
+        const SizeT size = static_cast<SizeT>(target_embedding_num) * dimension_;
+        targets_.resize(offset + size);
+        if constexpr (std::is_same_v<TensorElemT, u8>) {
+            std::copy_n(src_ptr, size, targets_.data() + offset);
+        } else {
+            for (SizeT i = 0; i < size; ++i) {
+                targets_[offset + i] = src_ptr[i] ^ kShift;
+            }
+        }
+        tensors_.push_back({embedding_num_, target_embedding_num, slot});
+        embedding_num_ += target_embedding_num;
+    }
+
+    u32 embedding_num() const { return embedding_num_; }
+
+    void Score(float *slot_scores) {
+        output_.resize(static_cast<SizeT>(embedding_num_) * query_embedding_num_);
+        u8_matrixA_multiply_matrixB_output_to_C(targets_.data(),
+                                                kShift,
+                                                query_transposed_.data(),
+                                                kShift,
+                                                embedding_num_,
+                                                query_embedding_num_,
+                                                dimension_,
+                                                output_.data());
+        for (const auto &[start, target_embedding_num, slot] : tensors_) {
+            std::fill(max_scores_.begin(), max_scores_.end(), std::numeric_limits<i32>::lowest());
+            for (u32 k = 0; k < target_embedding_num; ++k) {
+                const i32 *target_ip_ptr = output_.data() + static_cast<SizeT>(start + k) * query_embedding_num_;
+                for (u32 query_i = 0; query_i < query_embedding_num_; ++query_i) {
+                    max_scores_[query_i] = std::max(max_scores_[query_i], target_ip_ptr[query_i]);
+                }
+            }
+            i32 maxsim_score = 0;
+            for (u32 query_i = 0; query_i < query_embedding_num_; ++query_i) {
+                maxsim_score += max_scores_[query_i];
+            }
+            slot_scores[slot] = std::max(slot_scores[slot], static_cast<float>(maxsim_score));
+        }
+    }
+
+    void Clear() {
+        targets_.clear();
+        tensors_.clear();
+        embedding_num_ = 0;
+    }
+
+private:
+    const u32 query_embedding_num_ = 0;
+    const u32 dimension_ = 0;
+    u32 embedding_num_ = 0;
+    Vector<u8> query_transposed_;
+    Vector<u8> targets_;
+    Vector<Tuple<u32, u32, u32>> tensors_;
+    Vector<i32> output_;
+    Vector<i32> max_scores_;
+};
+
+// a batch is scored when it has this many target embeddings
+export constexpr u32 kMaxSimBatchEmbeddingNum = 4096;
+
+} // namespace infinity
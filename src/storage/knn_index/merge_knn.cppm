@@ -14,6 +14,8 @@
 
 module;
 
+#include <cmath>
+
 export module merge_knn;
 
 import stl;
@@ -90,6 +92,30 @@ export Optional<f32> GetKnnThreshold(const Vector<InitParameter> &opt_params);
 
 export Optional<f32> GetKnnThreshold(const Vector<UniquePtr<InitParameter>> &opt_params);
 
+// The best k-th distance which any task of a knn scan has found for each query. The merged top k can only be better, so the results
+// worse than it are dropped by every task. It is NaN until some task has k results of the query.
+export class KnnSharedBound {
+public:
+    explicit KnnSharedBound(const SizeT query_count) : bounds_(MakeUnique<Atomic<f32>[]>(query_count)) {
+        for (SizeT i = 0; i < query_count; ++i) {
+            bounds_[i].store(std::numeric_limits<f32>::quiet_NaN(), std::memory_order_relaxed);
+        }
+    }
+
+    [[nodiscard]] f32 Get(const SizeT query_id) const { return bounds_[query_id].load(std::memory_order_relaxed); }
+
+    template <template <typename, typename> typename C>
+    void Tighten(const SizeT query_id, const f32 d) {
+        f32 cur = bounds_[query_id].load(std::memory_order_relaxed);
+        while ((std::isnan(cur) || C<f32, RowID>::Compare(cur, d)) &&
+               !bounds_[query_id].compare_exchange_weak(cur, d, std::memory_order_relaxed)) {
+        }
+    }
+
+private:
+    UniquePtr<Atomic<f32>[]> bounds_;
+};
+
 export template <typename QueryElemType, template <typename, typename> typename C, typename DistType>
 class MergeKnn final : public MergeKnnBase {
     using DistFunc = DistType (*)(const QueryElemType *, const QueryElemType *, SizeT);
@@ -114,6 +140,29 @@ public:
 
     void Search(const QueryElemType *query, const QueryElemType *data, u32 dim, DistFunc dist_f, u16 row_cnt, u32 segment_id, u16 block_id, const Bitmask &bitmask);
 
+    // the data may have another element type than the query, e.g. fp16 data with f32 query
+    template <typename DataElemType>
+    void Search(const QueryElemType *query,
+                const DataElemType *data,
+                u32 dim,
+                DistType (*dist_f)(const QueryElemType *, const DataElemType *, SizeT),
+                u16 row_cnt,
+                u32 segment_id,
+                u16 block_id,
+                const Bitmask &bitmask);
+
+    // The distance is a sum over the dimensions which only grows, i.e. the squared L2. A row is dropped as soon as the sum over its first
+    // dimensions is worse than the k-th distance of the query, see `Bound`.
+    template <typename DataElemType>
+    void SearchPartial(const QueryElemType *query,
+                       const DataElemType *data,
+                       u32 dim,
+                       DistType (*dist_f)(const QueryElemType *, const DataElemType *, SizeT),
+                       u16 row_cnt,
+                       u32 segment_id,
+                       u16 block_id,
+                       const Bitmask &bitmask);
+
     void Search(const DistType *dist, const RowID *row_ids, u16 count);
 
     void Search(SizeT query_id, const DistType *dist, const RowID *row_ids, u16 count);
@@ -136,6 +185,52 @@ public:
 
     i64 total_input_count() const { return total_count_; }
 
+    u64 query_count() const { return query_count_; }
+
+    i64 topk() const { return topk_; }
+
+    // publish the k-th distances of this heap to the other tasks of the scan
+    void SetSharedBound(KnnSharedBound *shared_bound) {
+        shared_bound_ = shared_bound;
+        published_.assign(query_count_, C<DistType, RowID>::InitialValue());
+    }
+
+    // the results of the query worse than this are not in the merged top k
+    Optional<DistType> GetSharedBound(SizeT query_id) const {
+        if (shared_bound_ == nullptr) {
+            return None;
+        }
+        if (const f32 bound = shared_bound_->Get(query_id); !std::isnan(bound)) {
+            return static_cast<DistType>(bound);
+        }
+        return None;
+    }
+
+private:
+    // the better of the k-th distances of this heap and of the other tasks, the initial value of C if there is none yet
+    DistType Bound(SizeT query_id) const {
+        DistType bound = C<DistType, RowID>::InitialValue();
+        if (static_cast<i64>(result_handler_->GetSize(query_id)) == topk_) {
+            bound = distance_array_[query_id * topk_];
+        }
+        if (const auto shared = GetSharedBound(query_id); shared.has_value() && C<DistType, RowID>::Compare(bound, shared.value())) {
+            bound = shared.value();
+        }
+        return bound;
+    }
+
+    void ShareBound(SizeT query_id) {
+        if (shared_bound_ == nullptr || static_cast<i64>(result_handler_->GetSize(query_id)) < topk_) {
+            return;
+        }
+        // the root of a full heap is its k-th distance, only a better one than published before touches the shared atomic
+        const DistType d = distance_array_[query_id * topk_];
+        if (C<DistType, RowID>::Compare(published_[query_id], d)) {
+            published_[query_id] = d;
+            shared_bound_->Tighten<C>(query_id, d);
+        }
+    }
+
 private:
     i64 total_count_{};
     bool begin_{false};
@@ -144,6 +239,9 @@ private:
     UniquePtr<RowID[]> idx_array_{};
     UniquePtr<DistType[]> distance_array_{};
     Optional<u32> result_size_;
+    KnnSharedBound *shared_bound_{};
+    // the k-th distances last published to `shared_bound_`
+    Vector<DistType> published_;
 
 private:
     UniquePtr<MergeKnnResultHandler<DistType>> result_handler_{};
@@ -160,6 +258,7 @@ void MergeKnn<QueryElemType, C, DistType>::Search(const QueryElemType *query, co
             auto dist = dist_f(x_i, y_j, dim);
             result_handler_->AddResult(i, dist, RowID(segment_id, segment_offset_start + j));
         }
+        ShareBound(i);
     }
 }
 
@@ -170,6 +269,7 @@ void MergeKnn<QueryElemType, C, DistType>::Search(const QueryElemType *query, co
         const QueryElemType *x_i = query + i * dim;
         auto dist = dist_f(x_i, data, dim);
         result_handler_->AddResult(i, dist, RowID(segment_id, segment_offset));
+        ShareBound(i);
     }
 }
 
@@ -199,6 +299,82 @@ void MergeKnn<QueryElemType, C, DistType>::Search(const QueryElemType *query,
                 result_handler_->AddResult(i, dist, RowID(segment_id, segment_offset_start + j));
             }
         }
+        ShareBound(i);
+    }
+}
+
+template <typename QueryElemType, template <typename, typename> typename C, typename DistType>
+template <typename DataElemType>
+void MergeKnn<QueryElemType, C, DistType>::Search(const QueryElemType *query,
+                                                  const DataElemType *data,
+                                                  u32 dim,
+                                                  DistType (*dist_f)(const QueryElemType *, const DataElemType *, SizeT),
+                                                  u16 row_cnt,
+                                                  u32 segment_id,
+                                                  u16 block_id,
+                                                  const Bitmask &bitmask) {
+    const bool all_true = bitmask.IsAllTrue();
+    u32 segment_offset_start = block_id * DEFAULT_BLOCK_CAPACITY;
+    for (u64 i = 0; i < this->query_count_; ++i) {
+        const QueryElemType *x_i = query + i * dim;
+        const DataElemType *y_j = data;
+        for (u16 j = 0; j < row_cnt; ++j, y_j += dim) {
+            if (all_true || bitmask.IsTrue(j)) {
+                if (i == 0) {
+                    ++this->total_count_;
+                }
+                auto dist = dist_f(x_i, y_j, dim);
+                result_handler_->AddResult(i, dist, RowID(segment_id, segment_offset_start + j));
+            }
+        }
+        ShareBound(i);
+    }
+}
+
+template <typename QueryElemType, template <typename, typename> typename C, typename DistType>
+template <typename DataElemType>
+void MergeKnn<QueryElemType, C, DistType>::SearchPartial(const QueryElemType *query,
+                                                         const DataElemType *data,
+                                                         u32 dim,
+                                                         DistType (*dist_f)(const QueryElemType *, const DataElemType *, SizeT),
+                                                         u16 row_cnt,
+                                                         u32 segment_id,
+                                                         u16 block_id,
+                                                         const Bitmask &bitmask) {
+    static_assert(C<DistType, RowID>::IsMax, "a partial sum is only a lower bound of a distance which is smaller the better");
+    // the dimensions summed up before each check of the bound
+    constexpr u32 kPartialDim = 64;
+    if (dim < 2 * kPartialDim) {
+        Search(query, data, dim, dist_f, row_cnt, segment_id, block_id, bitmask);
+        return;
+    }
+    const bool all_true = bitmask.IsAllTrue();
+    u32 segment_offset_start = block_id * DEFAULT_BLOCK_CAPACITY;
+    for (u64 i = 0; i < this->query_count_; ++i) {
+        const QueryElemType *x_i = query + i * dim;
+        const DataElemType *y_j = data;
+        DistType bound = Bound(i);
+        for (u16 j = 0; j < row_cnt; ++j, y_j += dim) {
+            if (!all_true && !bitmask.IsTrue(j)) {
+                continue;
+            }
+            if (i == 0) {
+                ++this->total_count_;
+            }
+            DistType dist = 0;
+            u32 k = 0;
+            for (; k < dim && dist <= bound; k += kPartialDim) {
+                dist += dist_f(x_i + k, y_j + k, std::min(kPartialDim, dim - k));
+            }
+            if (k < dim) {
+                continue;
+            }
+            result_handler_->AddResult(i, dist, RowID(segment_id, segment_offset_start + j));
+            if (static_cast<i64>(result_handler_->GetSize(i)) == topk_ && C<DistType, RowID>::Compare(bound, distance_array_[i * topk_])) {
+                bound = distance_array_[i * topk_];
+            }
+        }
+        ShareBound(i);
     }
 }
 
@@ -211,6 +387,7 @@ void MergeKnn<QueryElemType, C, DistType>::Search(const DistType *dist, const Ro
         for (u16 j = 0; j < count; j++) {
             result_handler_->AddResult(i, d[j], r[j]);
         }
+        ShareBound(i);
     }
 }
 
@@ -222,6 +399,7 @@ void MergeKnn<QueryElemType, C, DistType>::Search(SizeT query_id, const DistType
     for (u16 j = 0; j < count; j++) {
         result_handler_->AddResult(query_id, dist[j], row_ids[j]);
     }
+    ShareBound(query_id);
 }
 
 template <typename QueryElemType, template <typename, typename> typename C, typename DistType>
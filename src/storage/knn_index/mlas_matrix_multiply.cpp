@@ -83,6 +83,31 @@ void transpose_matrixA_multiply_transpose_matrixB_output_to_C(const float *x,
              nullptr);
 }
 
+void u8_matrixA_multiply_matrixB_output_to_C(const u8 *x,
+                                             const u8 x_zero_point,
+                                             const u8 *y,
+                                             const u8 y_zero_point,
+                                             const SizeT x_row_num,
+                                             const SizeT y_col_num,
+                                             const SizeT common_dimension,
+                                             i32 *output) {
+    MLAS_GEMM_QUANT_SHAPE_PARAMS shape;
+    shape.M = x_row_num;
+    shape.N = y_col_num;
+    shape.K = common_dimension;
+    shape.BIsSigned = false;
+    MLAS_GEMM_QUANT_DATA_PARAMS data;
+    data.A = x;
+    data.lda = common_dimension;
+    data.ZeroPointA = x_zero_point;
+    data.B = y;
+    data.ldb = y_col_num;
+    data.ZeroPointB = &y_zero_point;
+    data.C = output;
+    data.ldc = y_col_num;
+    MlasGemm(shape, data, nullptr);
+}
+
 void TransposeMatrix(const float *input, float *output, const SizeT input_row_count, const SizeT input_column_count) {
     MlasTranspose(input, output, input_row_count, input_column_count);
 }
@@ -37,6 +37,18 @@ export void transpose_matrixA_multiply_transpose_matrixB_output_to_C(const float
                                                                      SizeT common_dimension,
                                                                      float *output);
 
+// x and y are u8 with a zero point each, the output is the exact i32 product of (x - x_zero_point) and (y - y_zero_point).
+// i8 data is shifted to u8 with the zero point 128. The u8 x i8 kernels of x86 without VNNI saturate the i16 sums of pairs, so y is
+// never passed as signed.
+export void u8_matrixA_multiply_matrixB_output_to_C(const u8 *x,
+                                                    u8 x_zero_point,
+                                                    const u8 *y,
+                                                    u8 y_zero_point,
+                                                    SizeT x_row_num,
+                                                    SizeT y_col_num,
+                                                    SizeT common_dimension,
+                                                    i32 *output);
+
 export void TransposeMatrix(const float *input, float *output, SizeT input_row_count, SizeT input_column_count);
 
 } // namespace infinity
@@ -0,0 +1,235 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+#include <random>
+
+export module rabitq_quantizer;
+
+import stl;
+import simd_functions;
+
+// RaBitQ style 1 bit quantization of the residual r = x - c to a centroid c.
+// Every dimension of r is encoded by its sign, the query residual is scalar quantized to 4 bits, so that the inner product between the
+// two can be computed with popcount on bit planes. The estimated distance is corrected with per vector factors stored along with the code.
+// The residuals of both sides are randomly rotated before they are quantized, so that the error of the sign code does not depend on how
+// the variance is spread over the dimensions. The rotation is fixed, it needs not be stored with the index.
+
+namespace infinity {
+
+constexpr SizeT kRaBitQRotateRounds = 3;
+constexpr u32 kRaBitQRotateSeed = 0x5eed;
+
+// in place normalized walsh hadamard transform of n (a power of 2) values
+void FastHadamard(f32 *x, SizeT n) {
+    for (SizeT h = 1; h < n; h *= 2) {
+        for (SizeT i = 0; i < n; i += 2 * h) {
+            for (SizeT j = i; j < i + h; ++j) {
+                const f32 a = x[j];
+                const f32 b = x[j + h];
+                x[j] = a + b;
+                x[j + h] = a - b;
+            }
+        }
+    }
+    const f32 scale = 1 / std::sqrt(f32(n));
+    for (SizeT i = 0; i < n; ++i) {
+        x[i] *= scale;
+    }
+}
+
+// A random orthogonal transform of `dim` values which keeps the dimension: every round flips the signs of a fixed random subset of the
+// values, then applies the hadamard transform to the first and to the last power of 2 values. The signs come from the raw output of
+// mt19937, which is the same on every platform. They are drawn once when the rotation is made, it is kept by the owner of the codes.
+export class RaBitQRotation {
+public:
+    RaBitQRotation() = default;
+
+    explicit RaBitQRotation(SizeT dim) : dim_(dim), words_((dim + 31) / 32) {
+        if (dim_ < 2) {
+            return;
+        }
+        block_ = 1;
+        while (block_ * 2 <= dim_) {
+            block_ *= 2;
+        }
+        signs_.resize(kRaBitQRotateRounds * words_);
+        std::mt19937 rng(kRaBitQRotateSeed);
+        for (u32 &signs : signs_) {
+            signs = rng();
+        }
+    }
+
+    SizeT dim() const { return dim_; }
+
+    void Apply(f32 *x) const {
+        if (dim_ < 2) {
+            return;
+        }
+        for (SizeT round = 0; round < kRaBitQRotateRounds; ++round) {
+            const u32 *round_signs = signs_.data() + round * words_;
+            for (SizeT i = 0; i < dim_; i += 32) {
+                const u32 signs = round_signs[i / 32];
+                for (SizeT j = i; j < std::min(dim_, i + 32); ++j) {
+                    if ((signs >> (j - i)) & 1) {
+                        x[j] = -x[j];
+                    }
+                }
+            }
+            FastHadamard(x, block_);
+            if (block_ < dim_) {
+                FastHadamard(x + dim_ - block_, block_);
+            }
+        }
+    }
+
+private:
+    SizeT dim_ = 0;
+    SizeT words_ = 0;
+    SizeT block_ = 1;
+    Vector<u32> signs_; // `kRaBitQRotateRounds` rounds of `words_` masks
+};
+
+// results of an index which stores 1 bit codes are reranked with the exact distance, this many times of topk candidates are kept
+export constexpr SizeT kRaBitQRerankFactor = 4;
+
+// the codes are padded to 64 bits
+export constexpr SizeT RaBitQCodeBytes(SizeT dim) { return (dim + 63) / 64 * 8; }
+
+export struct RaBitQFactor {
+    f32 norm_ = 0;      // ||r||
+    f32 ip_factor_ = 0; // <x_bar, r / ||r||>, x_bar is the sign vector of r normalized by sqrt(dim)
+    f32 rc_ip_ = 0;     // <r, c>
+    u32 popcnt_ = 0;    // number of positive dimensions of r
+};
+
+export struct RaBitQQuery {
+    constexpr static SizeT query_bits_ = 4;
+
+    UniquePtr<u8[]> planes_; // `query_bits_` bit planes of the quantized query residual
+    f32 norm_ = 0;           // ||q - c||
+    f32 qc_ip_ = 0;          // <q, c>
+    // <x_bar, (q - c) / ||q - c||> = popcnt_scale_ * popcnt + bit_ip_scale_ * <code, planes> + bias_
+    f32 popcnt_scale_ = 0;
+    f32 bit_ip_scale_ = 0;
+    f32 bias_ = 0;
+};
+
+// `code` has RaBitQCodeBytes(dim) bytes, dim is the one of `rotation`
+export RaBitQFactor RaBitQEncode(const f32 *vec, const f32 *centroid, const RaBitQRotation &rotation, u8 *code) {
+    const SizeT dim = rotation.dim();
+    std::fill_n(code, RaBitQCodeBytes(dim), 0);
+    RaBitQFactor factor;
+    auto residual = MakeUniqueForOverwrite<f32[]>(dim);
+    for (SizeT i = 0; i < dim; ++i) {
+        residual[i] = vec[i] - centroid[i];
+        factor.rc_ip_ += residual[i] * centroid[i];
+    }
+    // the rotation keeps the norm and the inner products
+    rotation.Apply(residual.get());
+    f32 norm_sqr = 0;
+    f32 abs_sum = 0;
+    for (SizeT i = 0; i < dim; ++i) {
+        const f32 r = residual[i];
+        norm_sqr += r * r;
+        abs_sum += std::abs(r);
+        if (r > 0) {
+            code[i / 8] |= u8(1) << (i % 8);
+            ++factor.popcnt_;
+        }
+    }
+    factor.norm_ = std::sqrt(norm_sqr);
+    if (norm_sqr > 0) {
+        factor.ip_factor_ = abs_sum / (factor.norm_ * std::sqrt(f32(dim)));
+    }
+    return factor;
+}
+
+export RaBitQQuery RaBitQEncodeQuery(const f32 *query, const f32 *centroid, const RaBitQRotation &rotation) {
+    const SizeT dim = rotation.dim();
+    constexpr SizeT query_bits = RaBitQQuery::query_bits_;
+    constexpr u32 max_value = (1u << query_bits) - 1;
+    const SizeT code_bytes = RaBitQCodeBytes(dim);
+    RaBitQQuery res;
+    res.planes_ = MakeUnique<u8[]>(query_bits * code_bytes);
+
+    auto residual = MakeUniqueForOverwrite<f32[]>(dim);
+    f32 norm_sqr = 0;
+    for (SizeT i = 0; i < dim; ++i) {
+        residual[i] = query[i] - centroid[i];
+        norm_sqr += residual[i] * residual[i];
+        res.qc_ip_ += query[i] * centroid[i];
+    }
+    rotation.Apply(residual.get());
+    res.norm_ = std::sqrt(norm_sqr);
+    if (norm_sqr == 0) {
+        return res;
+    }
+    f32 lo = std::numeric_limits<f32>::max();
+    f32 hi = std::numeric_limits<f32>::lowest();
+    for (SizeT i = 0; i < dim; ++i) {
+        residual[i] /= res.norm_;
+        lo = std::min(lo, residual[i]);
+        hi = std::max(hi, residual[i]);
+    }
+    const f32 delta = (hi - lo) / max_value;
+    u32 sum = 0;
+    for (SizeT i = 0; i < dim; ++i) {
+        u32 u = 0;
+        if (delta > 0) {
+            u = std::min(max_value, static_cast<u32>(std::lround((residual[i] - lo) / delta)));
+        }
+        sum += u;
+        for (SizeT j = 0; j < query_bits; ++j) {
+            if ((u >> j) & 1) {
+                res.planes_[j * code_bytes + i / 8] |= u8(1) << (i % 8);
+            }
+        }
+    }
+    // sum_i (2 * bit_i - 1) * (lo + delta * u_i) / sqrt(dim)
+    const f32 inv_sqrt_dim = 1 / std::sqrt(f32(dim));
+    res.popcnt_scale_ = 2 * lo * inv_sqrt_dim;
+    res.bit_ip_scale_ = 2 * delta * inv_sqrt_dim;
+    res.bias_ = -(dim * lo + delta * sum) * inv_sqrt_dim;
+    return res;
+}
+
+// estimated <x - c, q - c>
+export f32 RaBitQResidualIP(const RaBitQFactor &factor, const u8 *code, const RaBitQQuery &query, SizeT code_bytes) {
+    if (factor.ip_factor_ == 0 || query.norm_ == 0) {
+        return 0;
+    }
+    const u32 bit_ip = GetSIMD_FUNCTIONS().RaBitQ4BitIP_func_ptr_(code, query.planes_.get(), code_bytes);
+    const f32 est = query.popcnt_scale_ * factor.popcnt_ + query.bit_ip_scale_ * bit_ip + query.bias_;
+    return factor.norm_ * query.norm_ * est / factor.ip_factor_;
+}
+
+// estimated <x1 - c, x2 - c> of two encoded vectors, the angle is taken from the hamming distance of the codes
+export f32 RaBitQResidualIP(const RaBitQFactor &factor1, const u8 *code1, const RaBitQFactor &factor2, const u8 *code2, SizeT dim) {
+    const f32 hamming = GetSIMD_FUNCTIONS().HammingDistance_func_ptr_(code1, code2, RaBitQCodeBytes(dim));
+    return factor1.norm_ * factor2.norm_ * (dim - 2 * hamming) / dim;
+}
+
+// estimated ||x - q||^2
+export f32 RaBitQL2Distance(const RaBitQFactor &factor, const u8 *code, const RaBitQQuery &query, SizeT code_bytes) {
+    return factor.norm_ * factor.norm_ + query.norm_ * query.norm_ - 2 * RaBitQResidualIP(factor, code, query, code_bytes);
+}
+
+// estimated <x, q>
+export f32 RaBitQIPDistance(const RaBitQFactor &factor, const u8 *code, const RaBitQQuery &query, SizeT code_bytes) {
+    return RaBitQResidualIP(factor, code, query, code_bytes) + factor.rc_ip_ + query.qc_ip_;
+}
+
+} // namespace infinity
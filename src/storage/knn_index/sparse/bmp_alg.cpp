@@ -25,6 +25,7 @@ import third_party;
 import serialize;
 import segment_iter;
 import bp_reordering;
+import simd_functions;
 
 namespace infinity {
 
@@ -59,6 +60,13 @@ void BMPIvt<DataType, CompressType>::Optimize(i32 topk, Vector<Vector<DataType>>
     }
 }
 
+template <typename DataType, BMPCompressType CompressType>
+void BMPIvt<DataType, CompressType>::Finalize() {
+    for (auto &posting : postings_) {
+        posting.data_.Finalize();
+    }
+}
+
 template class BMPIvt<f32, BMPCompressType::kCompressed>;
 template class BMPIvt<f32, BMPCompressType::kRaw>;
 template class BMPIvt<f64, BMPCompressType::kCompressed>;
@@ -222,9 +230,13 @@ void BlockFwd<DataType, IdxType>::Calculate(SizeT block_size,
                                             const DataType *scores,
                                             Vector<DataType> &res,
                                             DataType query_score) {
-    for (SizeT i = 0; i < block_size; ++i) {
-        BMPBlockOffset block_offset = block_offsets[i];
-        res[block_offset] += query_score * scores[i];
+    if constexpr (std::is_same_v<DataType, f32>) {
+        GetSIMD_FUNCTIONS().BMPScatterAdd_func_ptr_(block_offsets, scores, block_size, query_score, res.data());
+    } else {
+        for (SizeT i = 0; i < block_size; ++i) {
+            BMPBlockOffset block_offset = block_offsets[i];
+            res[block_offset] += query_score * scores[i];
+        }
     }
 }
 
@@ -297,6 +309,7 @@ void BMPAlg<DataType, IdxType, CompressType>::Optimize(const BMPOptimizeOptions
         Vector<Vector<DataType>> ivt_scores = block_fwd_.GetIvtScores(term_num);
         bm_ivt_.Optimize(options.topk_, std::move(ivt_scores));
     }
+    bm_ivt_.Finalize();
 }
 
 template <typename DataType, typename IdxType, BMPCompressType CompressType>
@@ -40,6 +40,9 @@ public:
 
     void Optimize(i32 topk, Vector<Vector<DataType>> ivt_scores);
 
+    // quantize the block max scores of the postings which have new blocks
+    void Finalize();
+
     const BlockPostings<DataType, CompressType> &GetPostings(SizeT term_id) const { return postings_[term_id]; }
 
     void Prefetch(SizeT term_id) const { postings_[term_id].Prefetch(); }
@@ -14,29 +14,75 @@
 
 module;
 
+#include <cmath>
 #include "common/simd/simd_common_intrin_include.h"
 
 module bm_posting;
 
 import stl;
 import infinity_exception;
+import simd_functions;
 
 namespace infinity {
 
+template <typename DataType>
+u8 QuantizedMaxScores<DataType>::Quantize(DataType score, DataType scale) {
+    if (score <= 0.0 || scale <= 0.0) {
+        return 0;
+    }
+    auto q = static_cast<u32>(std::min<DataType>(std::ceil(score / scale), 255.0));
+    // the division may round down to an integer
+    if (q < 255 && q * scale < score) {
+        ++q;
+    }
+    return static_cast<u8>(q);
+}
+
+template <typename DataType>
+void QuantizedMaxScores<DataType>::QuantizeFrom(const Vector<DataType> &scores, Vector<u8> &max_scores) {
+    max_scores.resize(scores.size());
+    const DataType max_score = scores.empty() ? 0.0 : *std::max_element(scores.begin(), scores.end());
+    // one ulp up, so that 255 * scale is not below the max score
+    scale_ = max_score > 0.0 ? std::nextafter(max_score / 255, std::numeric_limits<DataType>::infinity()) : 0.0;
+    for (SizeT i = 0; i < scores.size(); ++i) {
+        max_scores[i] = Quantize(scores[i], scale_);
+    }
+}
+
+template struct QuantizedMaxScores<f32>;
+template struct QuantizedMaxScores<f64>;
+
 template <typename DataType>
 void BlockData<DataType, BMPCompressType::kCompressed>::Calculate(Vector<DataType> &upper_bounds, DataType query_score) const {
     SizeT block_size = block_ids_.size();
-    for (SizeT i = 0; i < block_size; ++i) {
-        BMPBlockID block_id = block_ids_[i];
-        DataType score = max_scores_[i];
-        upper_bounds[block_id] += score * query_score;
+    if (!quantized()) {
+        for (SizeT i = 0; i < block_size; ++i) {
+            upper_bounds[block_ids_[i]] += exact_max_scores_[i] * query_score;
+        }
+        return;
+    }
+    DataType weight = quantizer_.scale_ * query_score;
+    if constexpr (std::is_same_v<DataType, f32>) {
+        GetSIMD_FUNCTIONS().BMPBlockMaxSparse_func_ptr_(block_ids_.data(), max_scores_.data(), block_size, weight, upper_bounds.data());
+    } else {
+        for (SizeT i = 0; i < block_size; ++i) {
+            upper_bounds[block_ids_[i]] += weight * max_scores_[i];
+        }
     }
 }
 
 template <typename DataType>
 void BlockData<DataType, BMPCompressType::kCompressed>::AddBlock(BMPBlockID block_id, DataType max_score) {
     block_ids_.push_back(block_id);
-    max_scores_.push_back(max_score);
+    exact_max_scores_.push_back(max_score);
+    max_scores_.clear();
+}
+
+template <typename DataType>
+void BlockData<DataType, BMPCompressType::kCompressed>::Finalize() {
+    if (!quantized()) {
+        quantizer_.QuantizeFrom(exact_max_scores_, max_scores_);
+    }
 }
 
 template <typename DataType>
@@ -50,19 +96,39 @@ template struct BlockData<f64, BMPCompressType::kCompressed>;
 
 template <typename DataType>
 void BlockData<DataType, BMPCompressType::kRaw>::Calculate(Vector<DataType> &upper_bounds, DataType query_score) const {
-    for (BMPBlockID block_id = 0; block_id < (BMPBlockID)max_scores_.size(); ++block_id) {
-        if (max_scores_[block_id] > 0.0) {
-            upper_bounds[block_id] += max_scores_[block_id] * query_score;
+    SizeT block_num = exact_max_scores_.size();
+    if (!quantized()) {
+        for (SizeT block_id = 0; block_id < block_num; ++block_id) {
+            if (exact_max_scores_[block_id] > 0.0) {
+                upper_bounds[block_id] += exact_max_scores_[block_id] * query_score;
+            }
+        }
+        return;
+    }
+    DataType weight = quantizer_.scale_ * query_score;
+    if constexpr (std::is_same_v<DataType, f32>) {
+        GetSIMD_FUNCTIONS().BMPBlockMaxDense_func_ptr_(max_scores_.data(), block_num, weight, upper_bounds.data());
+    } else {
+        for (SizeT block_id = 0; block_id < block_num; ++block_id) {
+            upper_bounds[block_id] += weight * max_scores_[block_id];
         }
     }
 }
 
 template <typename DataType>
 void BlockData<DataType, BMPCompressType::kRaw>::AddBlock(BMPBlockID block_id, DataType max_score) {
-    if (block_id >= (BMPBlockID)max_scores_.size()) {
-        max_scores_.resize(block_id + 1, 0.0);
+    if (block_id >= (BMPBlockID)exact_max_scores_.size()) {
+        exact_max_scores_.resize(block_id + 1, 0.0);
+    }
+    exact_max_scores_[block_id] = max_score;
+    max_scores_.clear();
+}
+
+template <typename DataType>
+void BlockData<DataType, BMPCompressType::kRaw>::Finalize() {
+    if (!quantized()) {
+        quantizer_.QuantizeFrom(exact_max_scores_, max_scores_);
     }
-    max_scores_[block_id] = max_score;
 }
 
 template <typename DataType>
@@ -21,6 +21,23 @@ import bmp_util;
 
 namespace infinity {
 
+// The block max scores of a term are quantized to u8 with one scale per term, rounded up so that the upper bounds of the blocks
+// stay upper bounds. The codes are always made from the exact scores, which are also what is serialized, so they do not drift
+// when blocks are added or the index is saved and loaded again.
+export template <typename DataType>
+struct QuantizedMaxScores {
+public:
+    static u8 Quantize(DataType score, DataType scale);
+
+    DataType Dequantize(u8 q) const { return scale_ * q; }
+
+    // `max_scores` is resized to the size of `scores`
+    void QuantizeFrom(const Vector<DataType> &scores, Vector<u8> &max_scores);
+
+public:
+    DataType scale_ = 0.0; // max score / 255
+};
+
 export template <typename DataType, BMPCompressType CompressType>
 struct BlockData {};
 
@@ -31,33 +48,48 @@ public:
 
     void AddBlock(BMPBlockID block_id, DataType max_score);
 
+    // quantize the max scores, the exact scores are used until then and after a block is added again
+    void Finalize();
+
     void Prefetch() const;
 
     SizeT GetSizeInBytes() const;
     void WriteAdv(char *&p) const;
     static BlockData<DataType, BMPCompressType::kCompressed> ReadAdv(const char *&p);
 
+private:
+    bool quantized() const { return max_scores_.size() == exact_max_scores_.size(); }
+
 private:
     Vector<BMPBlockID> block_ids_;
-    Vector<DataType> max_scores_;
+    Vector<DataType> exact_max_scores_;
+    Vector<u8> max_scores_;
+    QuantizedMaxScores<DataType> quantizer_;
 };
 
 export template <typename DataType>
 struct BlockData<DataType, BMPCompressType::kRaw> {
 public:
-    // template <bool UseSIMD = false>
     void Calculate(Vector<DataType> &upper_bounds, DataType query_score) const;
 
     void AddBlock(BMPBlockID block_id, DataType max_score);
 
+    // quantize the max scores, the exact scores are used until then and after a block is added again
+    void Finalize();
+
     void Prefetch() const;
 
     SizeT GetSizeInBytes() const;
     void WriteAdv(char *&p) const;
     static BlockData<DataType, BMPCompressType::kRaw> ReadAdv(const char *&p);
 
+private:
+    bool quantized() const { return max_scores_.size() == exact_max_scores_.size(); }
+
 public:
-    Vector<DataType> max_scores_;
+    Vector<DataType> exact_max_scores_;
+    Vector<u8> max_scores_;
+    QuantizedMaxScores<DataType> quantizer_;
 };
 
 export template <typename DataType, BMPCompressType CompressType>
@@ -25,15 +25,15 @@ namespace infinity {
 
 template <typename DataType>
 SizeT BlockData<DataType, BMPCompressType::kCompressed>::GetSizeInBytes() const {
-    return sizeof(SizeT) + block_ids_.size() * sizeof(BMPBlockID) + max_scores_.size() * sizeof(DataType);
+    return sizeof(SizeT) + block_ids_.size() * sizeof(BMPBlockID) + exact_max_scores_.size() * sizeof(DataType);
 }
 
 template <typename DataType>
 void BlockData<DataType, BMPCompressType::kCompressed>::WriteAdv(char *&p) const {
-    SizeT max_score_size = max_scores_.size();
+    SizeT max_score_size = exact_max_scores_.size();
     WriteBufAdv<SizeT>(p, max_score_size);
     WriteBufVecAdv(p, block_ids_.data(), block_ids_.size());
-    WriteBufVecAdv(p, max_scores_.data(), max_scores_.size());
+    WriteBufVecAdv(p, exact_max_scores_.data(), exact_max_scores_.size());
 }
 
 template <typename DataType>
@@ -41,13 +41,14 @@ BlockData<DataType, BMPCompressType::kCompressed> BlockData<DataType, BMPCompres
     BlockData<DataType, BMPCompressType::kCompressed> res;
     SizeT max_score_size = ReadBufAdv<SizeT>(p);
     res.block_ids_.resize(max_score_size);
-    res.max_scores_.resize(max_score_size);
+    res.exact_max_scores_.resize(max_score_size);
     for (SizeT i = 0; i < max_score_size; ++i) {
         res.block_ids_[i] = ReadBufAdv<BMPBlockID>(p);
     }
     for (SizeT i = 0; i < max_score_size; ++i) {
-        res.max_scores_[i] = ReadBufAdv<DataType>(p);
+        res.exact_max_scores_[i] = ReadBufAdv<DataType>(p);
     }
+    res.Finalize();
     return res;
 }
 
@@ -58,24 +59,25 @@ template struct BlockData<f64, BMPCompressType::kCompressed>;
 
 template <typename DataType>
 SizeT BlockData<DataType, BMPCompressType::kRaw>::GetSizeInBytes() const {
-    return sizeof(SizeT) + max_scores_.size() * sizeof(DataType);
+    return sizeof(SizeT) + exact_max_scores_.size() * sizeof(DataType);
 }
 
 template <typename DataType>
 void BlockData<DataType, BMPCompressType::kRaw>::WriteAdv(char *&p) const {
-    SizeT max_score_size = max_scores_.size();
+    SizeT max_score_size = exact_max_scores_.size();
     WriteBufAdv<SizeT>(p, max_score_size);
-    WriteBufVecAdv(p, max_scores_.data(), max_scores_.size());
+    WriteBufVecAdv(p, exact_max_scores_.data(), exact_max_scores_.size());
 }
 
 template <typename DataType>
 BlockData<DataType, BMPCompressType::kRaw> BlockData<DataType, BMPCompressType::kRaw>::ReadAdv(const char *&p) {
     BlockData<DataType, BMPCompressType::kRaw> res;
     SizeT max_score_size = ReadBufAdv<SizeT>(p);
-    res.max_scores_.resize(max_score_size);
+    res.exact_max_scores_.resize(max_score_size);
     for (SizeT i = 0; i < max_score_size; ++i) {
-        res.max_scores_[i] = ReadBufAdv<DataType>(p);
+        res.exact_max_scores_[i] = ReadBufAdv<DataType>(p);
     }
+    res.Finalize();
     return res;
 }
 
@@ -0,0 +1,227 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+module;
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include "common/simd/simd_common_intrin_include.h"
+
+export module sparse_vec_codec;
+
+import stl;
+import sparse_util;
+import infinity_exception;
+import third_party;
+
+namespace infinity {
+
+// A compressed sparse vector, in one buffer:
+// nnz (i32) | size of the deltas (u32) | scale (DataType) | stream vbyte deltas of the indices: control bytes, then data bytes | values quantized to i8
+// The deltas are in groups of 4 with one control byte of their byte lengths, so that a group is decoded with one shuffle.
+// A value is q * scale, scale is max |value| / 127.
+export template <typename DataType>
+struct CompressedSparseVecRef {
+    i32 nnz_ = 0;
+    DataType scale_ = 0;
+    const u8 *control_ = nullptr;
+    const u8 *deltas_ = nullptr;
+    const i8 *data_ = nullptr;
+};
+
+struct StreamVByteTables {
+    u8 shuffle_[256][16];
+    u8 length_[256];
+
+    constexpr StreamVByteTables() : shuffle_(), length_() {
+        for (u32 c = 0; c < 256; ++c) {
+            u8 pos = 0;
+            for (u32 k = 0; k < 4; ++k) {
+                const u32 len = ((c >> (2 * k)) & 3) + 1;
+                for (u32 b = 0; b < 4; ++b) {
+                    shuffle_[c][4 * k + b] = b < len ? pos + b : 0x80;
+                }
+                pos += len;
+            }
+            length_[c] = pos;
+        }
+    }
+};
+
+constexpr StreamVByteTables kStreamVByteTables;
+
+// the decoder reads whole groups of 16 bytes
+export constexpr SizeT kSparseVecCodecPadding = 16;
+
+inline u32 DeltaByteLen(u32 delta) { return delta < (1u << 8) ? 1 : delta < (1u << 16) ? 2 : delta < (1u << 24) ? 3 : 4; }
+
+inline SizeT ControlBytes(SizeT nnz) { return (nnz + 3) / 4; }
+
+export template <typename DataType, typename IdxType>
+class SparseVecCodec {
+public:
+    static constexpr SizeT kHeaderSize = sizeof(i32) + sizeof(u32) + sizeof(DataType);
+
+    static SizeT EncodedSize(const SparseVecRef<DataType, IdxType> &vec) {
+        return kHeaderSize + ControlBytes(vec.nnz_) + DeltaBytes(vec) + vec.nnz_ + kSparseVecCodecPadding;
+    }
+
+    // `dst` has `EncodedSize(vec)` bytes, the indices are sorted and distinct
+    static void Encode(const SparseVecRef<DataType, IdxType> &vec, char *dst) {
+        const SizeT nnz = vec.nnz_;
+        DataType max_abs = 0;
+        for (SizeT i = 0; i < nnz; ++i) {
+            max_abs = std::max<DataType>(max_abs, std::abs(vec.data_[i]));
+        }
+        const DataType scale = max_abs / 127;
+        const u32 delta_bytes = DeltaBytes(vec);
+        std::memcpy(dst, &vec.nnz_, sizeof(i32));
+        std::memcpy(dst + sizeof(i32), &delta_bytes, sizeof(u32));
+        std::memcpy(dst + sizeof(i32) + sizeof(u32), &scale, sizeof(DataType));
+
+        u8 *control = reinterpret_cast<u8 *>(dst + kHeaderSize);
+        u8 *deltas = control + ControlBytes(nnz);
+        std::memset(control, 0, ControlBytes(nnz));
+        u32 prev = 0;
+        for (SizeT i = 0; i < nnz; ++i) {
+            const u32 idx = CheckedIndex(vec.indices_[i]);
+            const u32 delta = idx - prev;
+            prev = idx;
+            const u32 len = DeltaByteLen(delta);
+            control[i / 4] |= (len - 1) << (2 * (i % 4));
+            for (u32 b = 0; b < len; ++b) {
+                *deltas++ = static_cast<u8>(delta >> (8 * b));
+            }
+        }
+        i8 *data = reinterpret_cast<i8 *>(deltas);
+        for (SizeT i = 0; i < nnz; ++i) {
+            data[i] = scale == 0 ? 0 : static_cast<i8>(std::lround(vec.data_[i] / scale));
+        }
+        std::memset(data + nnz, 0, kSparseVecCodecPadding);
+    }
+
+    static CompressedSparseVecRef<DataType> View(const char *src) {
+        CompressedSparseVecRef<DataType> ret;
+        u32 delta_bytes = 0;
+        std::memcpy(&ret.nnz_, src, sizeof(i32));
+        std::memcpy(&delta_bytes, src + sizeof(i32), sizeof(u32));
+        std::memcpy(&ret.scale_, src + sizeof(i32) + sizeof(u32), sizeof(DataType));
+        ret.control_ = reinterpret_cast<const u8 *>(src + kHeaderSize);
+        ret.deltas_ = ret.control_ + ControlBytes(ret.nnz_);
+        ret.data_ = reinterpret_cast<const i8 *>(ret.deltas_ + delta_bytes);
+        return ret;
+    }
+
+    // `indices` has `ControlBytes(nnz) * 4` entries
+    static void DecodeIndices(const CompressedSparseVecRef<DataType> &vec, u32 *indices) {
+        const SizeT group_n = ControlBytes(vec.nnz_);
+        const u8 *p = vec.deltas_;
+#if defined(__SSE4_1__)
+        __m128i base = _mm_setzero_si128();
+        for (SizeT g = 0; g < group_n; ++g) {
+            const u8 c = vec.control_[g];
+            const __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i *>(kStreamVByteTables.shuffle_[c]));
+            __m128i v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), shuffle);
+            // prefix sum of the 4 deltas
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi32(v, base);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(indices + 4 * g), v);
+            base = _mm_shuffle_epi32(v, 0xFF);
+            p += kStreamVByteTables.length_[c];
+        }
+#else
+        u32 prev = 0;
+        for (SizeT g = 0; g < group_n; ++g) {
+            const u8 c = vec.control_[g];
+            for (u32 k = 0; k < 4; ++k) {
+                const u32 len = ((c >> (2 * k)) & 3) + 1;
+                u32 delta = 0;
+                for (u32 b = 0; b < len; ++b) {
+                    delta |= u32(*p++) << (8 * b);
+                }
+                prev += delta;
+                indices[4 * g + k] = prev;
+            }
+        }
+#endif
+    }
+
+    static void Decode(const CompressedSparseVecRef<DataType> &vec, IdxType *indices, DataType *data) {
+        Vector<u32> buf(ControlBytes(vec.nnz_) * 4);
+        DecodeIndices(vec, buf.data());
+        for (i32 i = 0; i < vec.nnz_; ++i) {
+            indices[i] = static_cast<IdxType>(buf[i]);
+            data[i] = vec.data_[i] * vec.scale_;
+        }
+    }
+
+private:
+    static u32 DeltaBytes(const SparseVecRef<DataType, IdxType> &vec) {
+        u32 delta_bytes = 0;
+        u32 prev = 0;
+        for (i32 i = 0; i < vec.nnz_; ++i) {
+            const u32 idx = CheckedIndex(vec.indices_[i]);
+            delta_bytes += DeltaByteLen(idx - prev);
+            prev = idx;
+        }
+        return delta_bytes;
+    }
+
+    static u32 CheckedIndex(IdxType idx) {
+        if constexpr (sizeof(IdxType) >= sizeof(u32)) {
+            if (static_cast<i64>(idx) < 0 || static_cast<u64>(idx) > std::numeric_limits<u32>::max()) {
+                UnrecoverableError(fmt::format("Sparse index {} out of the range of the compressed format", idx));
+            }
+        }
+        return static_cast<u32>(idx);
+    }
+};
+
+// the indices of a compressed vector decoded to a reused buffer
+template <typename DataType>
+const u32 *DecodeToBuffer(const CompressedSparseVecRef<DataType> &vec, Vector<u32> &buf) {
+    const SizeT n = ControlBytes(vec.nnz_) * 4;
+    if (buf.size() < n) {
+        buf.resize(n);
+    }
+    SparseVecCodec<DataType, i32>::DecodeIndices(vec, buf.data());
+    return buf.data();
+}
+
+// the values are multiplied as i8 and scaled once
+export template <typename DataType>
+DataType CompressedSparseIP(const CompressedSparseVecRef<DataType> &vec1, const CompressedSparseVecRef<DataType> &vec2) {
+    thread_local Vector<u32> buf1;
+    thread_local Vector<u32> buf2;
+    const u32 *index1 = DecodeToBuffer(vec1, buf1);
+    const u32 *index2 = DecodeToBuffer(vec2, buf2);
+    i32 sum = 0;
+    i32 i = 0, j = 0;
+    while (i < vec1.nnz_ && j < vec2.nnz_) {
+        if (index1[i] == index2[j]) {
+            sum += i32(vec1.data_[i]) * i32(vec2.data_[j]);
+            ++i;
+            ++j;
+        } else if (index1[i] < index2[j]) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+    return sum * vec1.scale_ * vec2.scale_;
+}
+
+} // namespace infinity
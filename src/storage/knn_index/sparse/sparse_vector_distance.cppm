@@ -17,11 +17,15 @@ module;
 export module sparse_vector_distance;
 
 import stl;
+import simd_functions;
 
 namespace infinity {
 
 export template <typename DataType, typename IndexType, typename ResultType = DataType>
 ResultType SparseIPDistance(const DataType *data1, const IndexType *index1, SizeT nnz1, const DataType *data2, const IndexType *index2, SizeT nnz2) {
+    if constexpr (std::is_same_v<DataType, f32> && std::is_same_v<IndexType, i32> && std::is_same_v<ResultType, f32>) {
+        return GetSIMD_FUNCTIONS().SparseIPF32I32_func_ptr_(data1, index1, nnz1, data2, index2, nnz2);
+    }
     ResultType distance{};
     SizeT i = 0, j = 0;
     while (i < nnz1 && j < nnz2) {
@@ -40,6 +44,9 @@ ResultType SparseIPDistance(const DataType *data1, const IndexType *index1, Size
 
 export template <typename IndexType, typename ResultType = IndexType>
 ResultType SparseBitIPDistance(const IndexType *idx1, SizeT nnz1, const IndexType *idx2, SizeT nnz2) {
+    if constexpr (std::is_same_v<IndexType, i32>) {
+        return static_cast<ResultType>(GetSIMD_FUNCTIONS().SparseBitIPI32_func_ptr_(idx1, nnz1, idx2, nnz2));
+    }
     ResultType distance{};
     SizeT i = 0, j = 0;
     while (i < nnz1 && j < nnz2) {
@@ -56,4 +63,54 @@ ResultType SparseBitIPDistance(const IndexType *idx1, SizeT nnz1, const IndexTyp
     return distance;
 }
 
+// One query scattered to a dense array, so that the documents scanned against it are scored with lookups instead of merging the indices.
+export template <typename DataType, typename IndexType, typename ResultType = DataType>
+class SparseDenseQuery {
+public:
+    // larger indices are merged with `SparseIPDistance`
+    static constexpr SizeT kMaxDenseSize = 1 << 20;
+
+    // false if the query has too large indices for a dense array
+    bool Init(const DataType *data, const IndexType *index, SizeT nnz) {
+        for (IndexType i : query_index_) {
+            dense_[i] = 0;
+        }
+        query_index_.clear();
+        dense_size_ = 0;
+        const SizeT dense_size = nnz == 0 ? 0 : static_cast<SizeT>(index[nnz - 1]) + 1;
+        if (dense_size > kMaxDenseSize) {
+            return false;
+        }
+        if (dense_.size() < dense_size) {
+            dense_.resize(dense_size, 0);
+        }
+        for (SizeT i = 0; i < nnz; ++i) {
+            dense_[index[i]] = data[i];
+        }
+        query_index_.assign(index, index + nnz);
+        dense_size_ = dense_size;
+        return true;
+    }
+
+    ResultType IP(const DataType *data, const IndexType *index, SizeT nnz) const {
+        if constexpr (std::is_same_v<DataType, f32> && std::is_same_v<IndexType, i32> && std::is_same_v<ResultType, f32>) {
+            return GetSIMD_FUNCTIONS().SparseDenseIPF32I32_func_ptr_(dense_.data(), dense_size_, data, index, nnz);
+        }
+        ResultType distance{};
+        for (SizeT i = 0; i < nnz; ++i) {
+            if (static_cast<SizeT>(index[i]) >= dense_size_) {
+                break;
+            }
+            distance += data[i] * dense_[index[i]];
+        }
+        return distance;
+    }
+
+private:
+    Vector<DataType> dense_;
+    SizeT dense_size_ = 0;
+    // the indices of the current query, reset in the next `Init`
+    Vector<IndexType> query_index_;
+};
+
 } // namespace infinity
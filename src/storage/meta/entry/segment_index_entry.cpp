@@ -36,6 +36,7 @@ import hnsw_common;
 import hnsw_alg;
 import catalog_delta_entry;
 import column_vector;
+import internal_types;
 import secondary_index_data;
 import type_info;
 import embedding_info;
@@ -62,6 +63,7 @@ import ivf_index_data_in_mem;
 import ivf_index_data;
 import emvb_index;
 import emvb_index_in_mem;
+import diskann_index_in_chunk;
 import bmp_util;
 import hnsw_util;
 import wal_entry;
@@ -270,9 +272,7 @@ void SegmentIndexEntry::MemIndexInsert(SharedPtr<BlockEntry> block_entry,
             break;
         }
         case IndexType::kDiskAnn: {
-            UniquePtr<String> err_msg =
-                MakeUnique<String>(fmt::format("{} realtime index is not supported yet", IndexInfo::IndexTypeToString(index_base->index_type_)));
-            LOG_WARN(*err_msg);
+            // the graph is only built from whole segments, the rows appended later are searched by brute force
             break;
         }
         default: {
@@ -383,6 +383,10 @@ SharedPtr<ChunkIndexEntry> SegmentIndexEntry::MemIndexDump(bool spill, SizeT *du
             memory_bmp_index_.reset();
             break;
         }
+        case IndexType::kDiskAnn: {
+            // no memory index, the graph is built over the whole segment in `PopulateEntirely` and `RebuildChunkIndexEntries`
+            return nullptr;
+        }
         default: {
             UnrecoverableError("Not implemented.");
             break;
@@ -542,10 +546,20 @@ void SegmentIndexEntry::PopulateEntirely(const SegmentEntry *segment_entry, Txn
             dumped_memindex_entry = MemIndexDump();
             break;
         }
-        case IndexType::kDiskAnn: { // TODO
-            UniquePtr<String> err_msg =
-                MakeUnique<String>(fmt::format("{} PopulateEntirely is not supported yet", IndexInfo::IndexTypeToString(index_base->index_type_)));
-            LOG_WARN(*err_msg);
+        case IndexType::kDiskAnn: {
+            const u32 row_count = segment_entry->row_count();
+            if (!DiskAnnIndexInChunk::CanBuild(row_count)) {
+                LOG_INFO(fmt::format("Segment {} has only {} rows, skip building the DiskAnn index", seg_id, row_count));
+                break;
+            }
+            SharedPtr<ChunkIndexEntry> diskann_chunk_index_entry = CreateDiskAnnIndexChunkIndexEntry(base_row_id, row_count, buffer_mgr);
+            this->AddChunkIndexEntry(diskann_chunk_index_entry);
+            BufferHandle handle = diskann_chunk_index_entry->GetIndex();
+            auto data_ptr = static_cast<DiskAnnIndexInChunk *>(handle.GetDataMut());
+            data_ptr->BuildDiskAnnIndex(base_row_id, row_count, segment_entry, column_def.get(), buffer_mgr);
+
+            diskann_chunk_index_entry->SaveIndexFile();
+            dumped_memindex_entry = std::move(diskann_chunk_index_entry);
             break;
         }
         default: {
@@ -751,7 +765,7 @@ void SegmentIndexEntry::OptIndex(IndexBase *index_base,
                         } else {
                             using HnswIndexDataType = typename std::remove_pointer_t<T>::DataType;
                             if (params->compress_to_lvq) {
-                                if constexpr (IsAnyOf<HnswIndexDataType, i8, u8>) {
+                                if constexpr (IsAnyOf<HnswIndexDataType, i8, u8, Float16T, BFloat16T>) {
                                     UnrecoverableError("Invalid index type.");
                                 } else {
                                     auto *p = std::move(*index).CompressToLVQ().release();
@@ -765,6 +779,17 @@ void SegmentIndexEntry::OptIndex(IndexBase *index_base,
                         }
                     },
                     *abstract_hnsw);
+                if (params->reorder.has_value()) {
+                    // reorder the compressed index if it is replaced above
+                    std::visit(
+                        [&](auto &&index) {
+                            using T = std::decay_t<decltype(index)>;
+                            if constexpr (!std::is_same_v<T, std::nullptr_t>) {
+                                index->Reorder(*params->reorder);
+                            }
+                        },
+                        *abstract_hnsw);
+                }
             };
 
             const auto [chunk_index_entries, memory_index_entry] = this->GetHnswIndexSnapshot();
@@ -890,7 +915,12 @@ ChunkIndexEntry *SegmentIndexEntry::RebuildChunkIndexEntries(TxnTableStore *txn_
                 old_ids.push_back(chunk_index_entry->chunk_id_);
             }
         }
-        if (old_chunks.size() <= 1) { // TODO
+        if (index_base->index_type_ == IndexType::kDiskAnn) {
+            // the diskann chunk does not grow with appends, rebuild it when the segment has rows out of the chunk
+            if (segment_entry->row_count() <= row_count || !DiskAnnIndexInChunk::CanBuild(segment_entry->row_count())) {
+                return nullptr;
+            }
+        } else if (old_chunks.size() <= 1) { // TODO
             return nullptr;
         }
     }
@@ -912,7 +942,8 @@ ChunkIndexEntry *SegmentIndexEntry::RebuildChunkIndexEntries(TxnTableStore *txn_
                         CappedOneColumnIterator<DataType, true /*check ts*/> iter(segment_entry, buffer_mgr, column_def->id(), begin_ts, row_count);
                         HnswInsertConfig insert_config;
                         insert_config.optimize_ = true;
-                        index->InsertVecs(std::move(iter), insert_config);
+                        SizeT mem_usage{};
+                        HnswIndexInMem::InsertVecsParallel(index, std::move(iter), insert_config, mem_usage);
                     }
                 },
                 abstract_hnsw);
@@ -963,6 +994,14 @@ ChunkIndexEntry *SegmentIndexEntry::RebuildChunkIndexEntries(TxnTableStore *txn_
             data_ptr->BuildIVFIndex(base_rowid, row_count, segment_entry, column_def, buffer_mgr);
             break;
         }
+        case IndexType::kDiskAnn: {
+            row_count = segment_entry->row_count();
+            merged_chunk_index_entry = CreateDiskAnnIndexChunkIndexEntry(base_rowid, row_count, buffer_mgr);
+            BufferHandle handle = merged_chunk_index_entry->GetIndex();
+            auto data_ptr = static_cast<DiskAnnIndexInChunk *>(handle.GetDataMut());
+            data_ptr->BuildDiskAnnIndex(base_rowid, row_count, segment_entry, column_def.get(), buffer_mgr);
+            break;
+        }
         default: {
             String error_message = "RebuildChunkIndexEntries is not supported for this index type.";
             UnrecoverableError(error_message);
@@ -1012,6 +1051,11 @@ SharedPtr<ChunkIndexEntry> SegmentIndexEntry::CreateEMVBIndexChunkIndexEntry(Row
     return ChunkIndexEntry::NewEMVBIndexChunkIndexEntry(chunk_id, this, "", base_rowid, row_count, buffer_mgr);
 }
 
+SharedPtr<ChunkIndexEntry> SegmentIndexEntry::CreateDiskAnnIndexChunkIndexEntry(RowID base_rowid, u32 row_count, BufferManager *buffer_mgr) {
+    ChunkID chunk_id = this->GetNextChunkID();
+    return ChunkIndexEntry::NewDiskAnnIndexChunkIndexEntry(chunk_id, this, "", base_rowid, row_count, buffer_mgr);
+}
+
 SharedPtr<ChunkIndexEntry>
 SegmentIndexEntry::CreateBMPIndexChunkIndexEntry(RowID base_rowid, u32 row_count, BufferManager *buffer_mgr, SizeT index_size) {
     ChunkID chunk_id = this->GetNextChunkID();
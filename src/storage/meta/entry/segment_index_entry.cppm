@@ -180,6 +180,12 @@ public:
         return {chunk_index_entries_, memory_emvb_index_};
     }
 
+    // diskann has no memory index
+    Vector<SharedPtr<ChunkIndexEntry>> GetDiskAnnIndexSnapshot() {
+        std::shared_lock lock(rw_locker_);
+        return chunk_index_entries_;
+    }
+
     Pair<u64, u32> GetFulltextColumnLenInfo() {
         std::shared_lock lock(rw_locker_);
         if (ft_column_len_sum_ == 0 && memory_indexer_.get() != nullptr) {
@@ -204,6 +210,8 @@ public:
 
     SharedPtr<ChunkIndexEntry> CreateBMPIndexChunkIndexEntry(RowID base_rowid, u32 row_count, BufferManager *buffer_mgr, SizeT index_size);
 
+    SharedPtr<ChunkIndexEntry> CreateDiskAnnIndexChunkIndexEntry(RowID base_rowid, u32 row_count, BufferManager *buffer_mgr);
+
     void AddChunkIndexEntry(SharedPtr<ChunkIndexEntry> chunk_index_entry);
 
     SharedPtr<ChunkIndexEntry> AddFtChunkIndexEntry(const String &base_name, RowID base_rowid, u32 row_count);
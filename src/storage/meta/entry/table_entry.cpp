@@ -48,6 +48,7 @@ import compact_statement;
 import build_fast_rough_filter_task;
 import block_entry;
 import segment_index_entry;
+import hnsw_segment_group;
 import chunk_index_entry;
 import memory_indexer;
 import cleanup_scanner;
@@ -1005,7 +1006,8 @@ void TableEntry::OptimizeIndex(Txn *txn) {
             case IndexType::kIVF:
             case IndexType::kEMVB:
             case IndexType::kSecondary:
-            case IndexType::kBMP: {
+            case IndexType::kBMP:
+            case IndexType::kDiskAnn: {
                 TxnTimeStamp begin_ts = txn->BeginTS();
                 Map<SegmentID, SharedPtr<SegmentIndexEntry>> index_by_segment = table_index_entry->GetIndexBySegmentSnapshot(this, txn);
                 for (auto &[segment_id, segment_index_entry] : index_by_segment) {
@@ -1014,6 +1016,36 @@ void TableEntry::OptimizeIndex(Txn *txn) {
                         [[maybe_unused]] auto *merged_chunk_entry = segment_index_entry->RebuildChunkIndexEntries(txn_table_store, segment_entry);
                     }
                 }
+                if (index_base->index_type_ == IndexType::kHnsw && InfinityContext::instance().config()->HnswSegmentGroup()) {
+                    // merge the sealed segments into one graph, so that a knn scan does not search them one by one
+                    Vector<SegmentEntry *> segment_entries;
+                    SizeT group_row_count = 0;
+                    for (auto &[segment_id, segment_index_entry] : index_by_segment) {
+                        SegmentEntry *segment_entry = GetSegmentByID(segment_id, begin_ts).get();
+                        if (segment_entry == nullptr || segment_entry->status() != SegmentStatus::kSealed) {
+                            continue;
+                        }
+                        if (group_row_count + segment_entry->row_count() > HnswSegmentGroup::kMaxRowCount) {
+                            break;
+                        }
+                        group_row_count += segment_entry->row_count();
+                        segment_entries.push_back(segment_entry);
+                    }
+                    if (segment_entries.size() < 2) {
+                        table_index_entry->SetHnswSegmentGroup(nullptr);
+                    } else if (auto old_group = table_index_entry->GetHnswSegmentGroup(); old_group == nullptr || !old_group->Match(segment_entries)) {
+                        const ColumnDef *column_def = table_index_entry->column_def().get();
+                        // the rows of the newly sealed segments are inserted into the graph of the old group if it has room
+                        SharedPtr<HnswSegmentGroup> group;
+                        if (old_group != nullptr) {
+                            group = old_group->Extend(column_def, segment_entries, txn->buffer_mgr(), begin_ts);
+                        }
+                        if (group == nullptr) {
+                            group = HnswSegmentGroup::Make(index_base, column_def, segment_entries, txn->buffer_mgr(), begin_ts);
+                        }
+                        table_index_entry->SetHnswSegmentGroup(std::move(group));
+                    }
+                }
                 break;
             }
             default: {
@@ -45,6 +45,7 @@ struct SegmentEntry;
 class BaseTableRef;
 class AddTableIndexEntryOp;
 class BaseMemIndex;
+class HnswSegmentGroup;
 
 export struct SegmentIndexesGuard {
     const Map<SegmentID, SharedPtr<SegmentIndexEntry>> &index_by_segment_;
@@ -154,6 +155,17 @@ public:
 
     bool CheckIfIndexColumn(ColumnID column_id) const;
 
+    // The hnsw graph merged from sealed segments by optimize, nullptr if not built.
+    SharedPtr<HnswSegmentGroup> GetHnswSegmentGroup() const {
+        std::shared_lock lock(rw_locker_);
+        return hnsw_segment_group_;
+    }
+
+    void SetHnswSegmentGroup(SharedPtr<HnswSegmentGroup> hnsw_segment_group) {
+        std::unique_lock lock(rw_locker_);
+        hnsw_segment_group_ = std::move(hnsw_segment_group);
+    }
+
 private:
     static SharedPtr<String> DetermineIndexDir(const String &parent_dir, const String &index_name);
 
@@ -170,6 +182,9 @@ private:
 
     Map<SegmentID, SharedPtr<SegmentIndexEntry>> index_by_segment_{};
 
+    // only kept in memory, rebuilt by the next optimize after restart
+    SharedPtr<HnswSegmentGroup> hnsw_segment_group_{};
+
 public:
     void Cleanup(CleanupInfoTracer *info_tracer = nullptr, bool dropped = true) override;
 
@@ -2,6 +2,8 @@
 import base_test;
 import stl;
 import simd_init;
+import simd_functions;
+import internal_types;
 
 using namespace infinity;
 
@@ -17,3 +19,170 @@ TEST_F(SimdInitTest, GetSupportedSimdTypesList) {
     alignas(alignof(u16)) u8 v[2] = {1, 0};
     EXPECT_EQ(*reinterpret_cast<const u16 *>(v), 1u);
 }
+
+template <typename HalfT>
+void TestHalfDistance(F32DistanceFuncType ref_l2,
+                      F32DistanceFuncType ref_ip,
+                      F32DistanceFuncType ref_cos,
+                      F16DistanceFuncType half_l2,
+                      F16DistanceFuncType half_ip,
+                      F16DistanceFuncType half_cos,
+                      F32F16DistanceFuncType mixed_l2,
+                      F32F16DistanceFuncType mixed_ip,
+                      F32F16DistanceFuncType mixed_cos) {
+    // not a multiple of the simd width
+    constexpr SizeT dim = 100;
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<f32> distrib(-1.0f, 1.0f);
+    Vector<HalfT> x(dim), y(dim);
+    Vector<f32> x_f32(dim), y_f32(dim), q(dim);
+    for (SizeT i = 0; i < dim; ++i) {
+        q[i] = distrib(rng);
+        x[i] = static_cast<HalfT>(distrib(rng));
+        y[i] = static_cast<HalfT>(q[i]);
+        x_f32[i] = static_cast<f32>(x[i]);
+        y_f32[i] = static_cast<f32>(y[i]);
+    }
+    const auto *x_raw = reinterpret_cast<const u16 *>(x.data());
+    const auto *y_raw = reinterpret_cast<const u16 *>(y.data());
+    EXPECT_NEAR(half_l2(x_raw, y_raw, dim), ref_l2(x_f32.data(), y_f32.data(), dim), 1e-3);
+    EXPECT_NEAR(half_ip(x_raw, y_raw, dim), ref_ip(x_f32.data(), y_f32.data(), dim), 1e-3);
+    EXPECT_NEAR(half_cos(x_raw, y_raw, dim), ref_cos(x_f32.data(), y_f32.data(), dim), 1e-4);
+    EXPECT_NEAR(mixed_l2(q.data(), x_raw, dim), ref_l2(q.data(), x_f32.data(), dim), 1e-3);
+    EXPECT_NEAR(mixed_ip(q.data(), x_raw, dim), ref_ip(q.data(), x_f32.data(), dim), 1e-3);
+    EXPECT_NEAR(mixed_cos(q.data(), x_raw, dim), ref_cos(q.data(), x_f32.data(), dim), 1e-4);
+}
+
+TEST_F(SimdInitTest, HalfPrecisionDistance) {
+    const auto &f = GetSIMD_FUNCTIONS();
+    TestHalfDistance<Float16T>(f.L2Distance_func_ptr_,
+                               f.IPDistance_func_ptr_,
+                               f.CosineDistance_func_ptr_,
+                               f.F16L2Distance_func_ptr_,
+                               f.F16IPDistance_func_ptr_,
+                               f.F16CosineDistance_func_ptr_,
+                               f.F32F16L2Distance_func_ptr_,
+                               f.F32F16IPDistance_func_ptr_,
+                               f.F32F16CosineDistance_func_ptr_);
+    TestHalfDistance<BFloat16T>(f.L2Distance_func_ptr_,
+                                f.IPDistance_func_ptr_,
+                                f.CosineDistance_func_ptr_,
+                                f.BF16L2Distance_func_ptr_,
+                                f.BF16IPDistance_func_ptr_,
+                                f.BF16CosineDistance_func_ptr_,
+                                f.F32BF16L2Distance_func_ptr_,
+                                f.F32BF16IPDistance_func_ptr_,
+                                f.F32BF16CosineDistance_func_ptr_);
+}
+
+TEST_F(SimdInitTest, PQ4FastScan) {
+    const auto fast_scan = GetSIMD_FUNCTIONS().PQ4FastScan_func_ptr_;
+    for (SizeT subspace_num : {2, 4, 6, 32, 254}) {
+        std::mt19937 rng(subspace_num);
+        std::uniform_int_distribution<u32> dist(0, 255);
+        Vector<u8> codes(subspace_num * 16);
+        Vector<u8> lut(subspace_num * 16);
+        for (auto &c : codes) {
+            c = dist(rng);
+        }
+        for (auto &l : lut) {
+            l = dist(rng);
+        }
+        u16 result[32];
+        fast_scan(codes.data(), lut.data(), subspace_num, result);
+        for (SizeT i = 0; i < 32; ++i) {
+            u16 expect = 0;
+            for (SizeT j = 0; j < subspace_num; ++j) {
+                const u8 byte = codes[j * 16 + (i & 15)];
+                expect += lut[j * 16 + (i < 16 ? (byte & 0x0f) : (byte >> 4))];
+            }
+            EXPECT_EQ(result[i], expect);
+        }
+    }
+}
+
+TEST_F(SimdInitTest, BMPBlockMax) {
+    const auto &f = GetSIMD_FUNCTIONS();
+    constexpr SizeT n = 100;
+    constexpr f32 weight = 0.37f;
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<u32> dist(0, 255);
+    Vector<u8> max_scores(n);
+    Vector<u8> offsets(n);
+    Vector<f32> scores(n);
+    for (SizeT i = 0; i < n; ++i) {
+        max_scores[i] = dist(rng);
+        scores[i] = dist(rng) / 255.0f;
+    }
+    // distinct ids and offsets in random order
+    Vector<i32> block_ids(n);
+    std::iota(block_ids.begin(), block_ids.end(), 0);
+    std::shuffle(block_ids.begin(), block_ids.end(), rng);
+    std::iota(offsets.begin(), offsets.end(), 0);
+    std::shuffle(offsets.begin(), offsets.end(), rng);
+
+    Vector<f32> init(n);
+    for (SizeT i = 0; i < n; ++i) {
+        init[i] = i * 0.5f;
+    }
+    Vector<f32> dense = init, sparse = init, scatter = init;
+    f.BMPBlockMaxDense_func_ptr_(max_scores.data(), n, weight, dense.data());
+    f.BMPBlockMaxSparse_func_ptr_(block_ids.data(), max_scores.data(), n, weight, sparse.data());
+    f.BMPScatterAdd_func_ptr_(offsets.data(), scores.data(), n, weight, scatter.data());
+    Vector<f32> expect_dense = init, expect_sparse = init, expect_scatter = init;
+    for (SizeT i = 0; i < n; ++i) {
+        expect_dense[i] += weight * max_scores[i];
+        expect_sparse[block_ids[i]] += weight * max_scores[i];
+        expect_scatter[offsets[i]] += weight * scores[i];
+    }
+    for (SizeT i = 0; i < n; ++i) {
+        EXPECT_FLOAT_EQ(dense[i], expect_dense[i]);
+        EXPECT_FLOAT_EQ(sparse[i], expect_sparse[i]);
+        EXPECT_FLOAT_EQ(scatter[i], expect_scatter[i]);
+    }
+}
+
+TEST_F(SimdInitTest, SparseIP) {
+    const auto &f = GetSIMD_FUNCTIONS();
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<f32> value_dist(0.0f, 1.0f);
+    auto make_sparse = [&](SizeT nnz, i32 term_num, Vector<i32> &indices, Vector<f32> &data) {
+        Set<i32> terms;
+        std::uniform_int_distribution<i32> term_dist(0, term_num - 1);
+        while (terms.size() < nnz) {
+            terms.insert(term_dist(rng));
+        }
+        indices.assign(terms.begin(), terms.end());
+        data.resize(nnz);
+        for (auto &v : data) {
+            v = value_dist(rng);
+        }
+    };
+    for (SizeT nnz1 : {0, 7, 8, 33, 100}) {
+        for (SizeT nnz2 : {0, 9, 16, 50}) {
+            Vector<i32> idx1, idx2;
+            Vector<f32> data1, data2;
+            make_sparse(nnz1, 128, idx1, data1);
+            make_sparse(nnz2, 128, idx2, data2);
+            f32 expect_ip = 0;
+            SizeT expect_n = 0;
+            for (SizeT i = 0; i < nnz1; ++i) {
+                for (SizeT j = 0; j < nnz2; ++j) {
+                    if (idx1[i] == idx2[j]) {
+                        expect_ip += data1[i] * data2[j];
+                        ++expect_n;
+                    }
+                }
+            }
+            EXPECT_NEAR(f.SparseIPF32I32_func_ptr_(data1.data(), idx1.data(), nnz1, data2.data(), idx2.data(), nnz2), expect_ip, 1e-4);
+            EXPECT_EQ(f.SparseBitIPI32_func_ptr_(idx1.data(), nnz1, idx2.data(), nnz2), expect_n);
+
+            // the query scattered to a dense array shorter than the indices of the document
+            Vector<f32> dense(nnz1 == 0 ? 0 : idx1.back() + 1, 0.0f);
+            for (SizeT i = 0; i < nnz1; ++i) {
+                dense[idx1[i]] = data1[i];
+            }
+            EXPECT_NEAR(f.SparseDenseIPF32I32_func_ptr_(dense.data(), dense.size(), data2.data(), idx2.data(), nnz2), expect_ip, 1e-4);
+        }
+    }
+}
@@ -91,6 +91,40 @@ TEST_F(IndexBaseTest, hnsw_readwrite) {
     EXPECT_EQ(*index_base, *index_base1);
 }
 
+TEST_F(IndexBaseTest, hnsw_pq_readwrite) {
+    using namespace infinity;
+
+    Vector<String> columns{"col1"};
+    Vector<InitParameter *> parameters;
+    parameters.emplace_back(new InitParameter("metric", "l2"));
+    parameters.emplace_back(new InitParameter("encode", "pq"));
+    parameters.emplace_back(new InitParameter("pq_subspace_num", "8"));
+    parameters.emplace_back(new InitParameter("truncate_dim", "32"));
+
+    auto index_base = IndexHnsw::Make(MakeShared<String>("idx1"), MakeShared<String>("test comment"), "tbl1_idx1", columns, parameters);
+    for (auto parameter : parameters) {
+        delete parameter;
+    }
+
+    int32_t exp_size = index_base->GetSizeInBytes();
+    Vector<char> buf(exp_size, char(0));
+    char *buf_beg = buf.data();
+    char *ptr = buf_beg;
+    index_base->WriteAdv(ptr);
+    EXPECT_EQ(ptr - buf_beg, exp_size);
+
+    const char *ptr_r = buf_beg;
+    int32_t maxbytes = exp_size;
+    SharedPtr<IndexBase> index_base1 = IndexBase::ReadAdv(ptr_r, maxbytes);
+    EXPECT_EQ(ptr_r - buf_beg, exp_size);
+    const auto *index_hnsw = dynamic_cast<const IndexHnsw *>(index_base1.get());
+    ASSERT_NE(index_hnsw, nullptr);
+    EXPECT_EQ(index_hnsw->encode_type_, HnswEncodeType::kPQ);
+    EXPECT_EQ(index_hnsw->pq_subspace_num_, 8u);
+    EXPECT_EQ(index_hnsw->truncate_dim_, 32u);
+    EXPECT_EQ(*index_base, *index_base1);
+}
+
 TEST_F(IndexBaseTest, full_text_readwrite) {
     using namespace infinity;
 
@@ -112,3 +112,131 @@ TEST_F(EMVBTest, test_fakepq) {
         EXPECT_EQ(doc_ids[i], 30 + i);
     }
 }
+
+// The centroid interaction prunes the centroids which score no higher than the first threshold with every query token.
+// Half of the centroids point away from the query tokens, they are pruned, and every document has a centroid of the other half,
+// so the pruned second stage keeps the exact ranking. The chunks are searched in parallel and merged in chunk order, like the
+// MatchTensor scan does, the result has to be the exhaustive top k.
+TEST_F(EMVBTest, test_pruned_parallel_chunks) {
+    constexpr u32 embedding_dimension = 16;
+    constexpr u32 centroid_num = 16;
+    constexpr u32 chunk_num = 4;
+    constexpr u32 docs_in_one_chunk = 50;
+    constexpr u32 n_docs = chunk_num * docs_in_one_chunk;
+    constexpr u32 FIXED_QUERY_TOKEN_NUM = 32;
+    constexpr u32 k = 10;
+
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<f32> dis(0.0f, 1.0f);
+    Vector<f32> centroids_data(centroid_num * embedding_dimension);
+    for (u32 i = 0; i < centroid_num; ++i) {
+        for (u32 j = 0; j < embedding_dimension; ++j) {
+            const f32 v = dis(gen);
+            centroids_data[i * embedding_dimension + j] = i < centroid_num / 2 ? v : -v;
+        }
+    }
+    Vector<f32> query(FIXED_QUERY_TOKEN_NUM * embedding_dimension);
+    for (auto &v : query) {
+        v = dis(gen);
+    }
+    std::uniform_int_distribution<u32> doclen_dis(2, 12);
+    std::uniform_int_distribution<u32> centroid_dis(0, centroid_num - 1);
+    Vector<Vector<u32>> doc_centroids(n_docs);
+    for (auto &centroids : doc_centroids) {
+        centroids.resize(doclen_dis(gen));
+        for (auto &cid : centroids) {
+            cid = centroid_dis(gen);
+        }
+        centroids[0] = centroid_dis(gen) % (centroid_num / 2);
+    }
+
+    // exhaustive MaxSim over the centroids, the residuals score 0 with the fake pq
+    Vector<f32> expected_scores(n_docs);
+    for (u32 doc_id = 0; doc_id < n_docs; ++doc_id) {
+        for (u32 t = 0; t < FIXED_QUERY_TOKEN_NUM; ++t) {
+            f32 max_score = std::numeric_limits<f32>::lowest();
+            for (const auto cid : doc_centroids[doc_id]) {
+                f32 ip = 0.0f;
+                for (u32 j = 0; j < embedding_dimension; ++j) {
+                    ip += query[t * embedding_dimension + j] * centroids_data[cid * embedding_dimension + j];
+                }
+                max_score = std::max(max_score, ip);
+            }
+            expected_scores[doc_id] += max_score;
+        }
+    }
+    Vector<u32> expected_ids(n_docs);
+    std::iota(expected_ids.begin(), expected_ids.end(), 0);
+    std::sort(expected_ids.begin(), expected_ids.end(), [&](u32 a, u32 b) { return expected_scores[a] > expected_scores[b]; });
+    expected_ids.resize(k);
+    std::sort(expected_ids.begin(), expected_ids.end());
+
+    struct Chunk {
+        Vector<u32> doc_lens;
+        Vector<u32> doc_offsets;
+        Vector<u32> centroid_id_assignments;
+        UniquePtr<EMVBSharedVec<u32>[]> centroids_to_docid;
+    };
+    Vector<Chunk> chunks(chunk_num);
+    for (u32 c = 0; c < chunk_num; ++c) {
+        auto &chunk = chunks[c];
+        chunk.centroids_to_docid = MakeUnique<EMVBSharedVec<u32>[]>(centroid_num);
+        for (u32 i = 0; i < docs_in_one_chunk; ++i) {
+            const auto &centroids = doc_centroids[c * docs_in_one_chunk + i];
+            chunk.doc_lens.push_back(centroids.size());
+            chunk.doc_offsets.push_back(chunk.centroid_id_assignments.size());
+            chunk.centroid_id_assignments.insert(chunk.centroid_id_assignments.end(), centroids.begin(), centroids.end());
+            for (const auto cid : Set<u32>(centroids.begin(), centroids.end())) {
+                chunk.centroids_to_docid[cid].PushBack(i);
+            }
+        }
+    }
+    FakePQ fake_pq;
+    Vector<EMVBSearch<FIXED_QUERY_TOKEN_NUM>> searches;
+    searches.reserve(chunk_num);
+    for (auto &chunk : chunks) {
+        searches.emplace_back(embedding_dimension,
+                              docs_in_one_chunk,
+                              centroid_num,
+                              chunk.doc_lens.data(),
+                              chunk.doc_offsets.data(),
+                              chunk.centroid_id_assignments.data(),
+                              centroids_data.data(),
+                              chunk.centroids_to_docid.get(),
+                              &fake_pq);
+    }
+
+    // every centroid is probed and every candidate is scored by the centroid interaction, which keeps only 2 * k of them
+    u32 nprobe = centroid_num;
+    f32 thresh = 0.0f;
+    u32 n_doc_to_score = docs_in_one_chunk;
+    u32 out_second_stage = 2 * k;
+    f32 thresh_query = 0.0f;
+    Vector<Tuple<u32, UniquePtr<f32[]>, UniquePtr<u32[]>>> chunk_results(chunk_num);
+    Vector<Thread> threads;
+    for (u32 c = 0; c < chunk_num; ++c) {
+        threads.emplace_back([&, c] {
+            chunk_results[c] = searches[c].GetQueryResult(query.data(), nprobe, thresh, n_doc_to_score, out_second_stage, k, thresh_query);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    Vector<Pair<f32, u32>> merged;
+    for (u32 c = 0; c < chunk_num; ++c) {
+        const auto &[n_result, scores, doc_ids] = chunk_results[c];
+        EXPECT_EQ(n_result, k);
+        for (u32 i = 0; i < n_result; ++i) {
+            const u32 doc_id = c * docs_in_one_chunk + doc_ids[i];
+            EXPECT_NEAR(scores[i], expected_scores[doc_id], 1e-4);
+            merged.emplace_back(scores[i], doc_id);
+        }
+    }
+    std::sort(merged.begin(), merged.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+    Vector<u32> result_ids;
+    for (u32 i = 0; i < k; ++i) {
+        result_ids.push_back(merged[i].second);
+    }
+    std::sort(result_ids.begin(), result_ids.end());
+    EXPECT_EQ(result_ids, expected_ids);
+}
@@ -18,7 +18,6 @@
 import stl;
 import base_test;
 import infinity_exception;
-import knn_diskann;
 import internal_types;
 import virtual_store;
 import index_base;
@@ -0,0 +1,213 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+import stl;
+import base_test;
+import infinity_exception;
+import internal_types;
+import virtual_store;
+import index_base;
+import index_diskann;
+import local_file_handle;
+import diskann_index_in_chunk;
+import diskann_utils;
+import default_values;
+
+using namespace infinity;
+
+class DiskAnnChunkTest : public BaseTest {
+public:
+    const std::string save_dir_ = GetFullTmpDir();
+};
+
+TEST_F(DiskAnnChunkTest, build_and_search) {
+    u32 dim = 32;
+    u32 row_count = 2000;
+    SegmentOffset start_offset = 100;
+    SizeT topk = 5;
+
+    auto data = MakeUnique<f32[]>(dim * row_count);
+    std::mt19937 rng;
+    rng.seed(0);
+    std::uniform_real_distribution<float> distrib_real;
+    for (u32 i = 0; i < dim * row_count; ++i) {
+        data[i] = distrib_real(rng);
+    }
+
+    IndexDiskAnn index_diskann(MakeShared<String>("idx"),
+                               MakeShared<String>(),
+                               "idx_file",
+                               {"col"},
+                               MetricType::kMetricL2,
+                               DiskAnnEncodeType::kPlain,
+                               32 /*R*/,
+                               100 /*L*/,
+                               4 /*num_pq_chunks*/,
+                               1 /*num_parts*/);
+
+    EXPECT_FALSE(DiskAnnIndexInChunk::CanBuild(DISKANN_NUM_CENTERS));
+    EXPECT_TRUE(DiskAnnIndexInChunk::CanBuild(row_count));
+
+    auto test_search = [&](const DiskAnnIndexInChunk &chunk) {
+        EXPECT_EQ(chunk.row_count(), row_count);
+        Vector<SegmentOffset> offsets(topk);
+        u32 hits = 0;
+        u32 query_n = 0;
+        for (u32 i = 0; i < row_count; i += 10, ++query_n) {
+            SizeT result_n = chunk.SearchIndex(data.get() + i * dim, topk, 100, 4, offsets.data());
+            ASSERT_EQ(result_n, topk);
+            for (SizeT r = 0; r < result_n; ++r) {
+                EXPECT_GE(offsets[r], start_offset);
+                EXPECT_LT(offsets[r], start_offset + row_count);
+            }
+            // the node id of a row is its offset from the start of the chunk
+            hits += offsets[0] == start_offset + i;
+        }
+        EXPECT_GE(hits, query_n * 95 / 100);
+    };
+
+    const String chunk_file = save_dir_ + "/chunk_index.bin";
+    // the index is not at the start of its file
+    const String header = "header";
+    {
+        DiskAnnIndexInChunk chunk(start_offset, &index_diskann, dim, save_dir_ + "/build_work");
+        chunk.BuildDiskAnnIndex(data.get(), row_count);
+        EXPECT_THROW(chunk.BuildDiskAnnIndex(data.get(), row_count), UnrecoverableException);
+        test_search(chunk);
+
+        auto [file_handle, status] = VirtualStore::Open(chunk_file, FileAccessMode::kWrite);
+        ASSERT_TRUE(status.ok());
+        file_handle->Append(header.data(), header.size());
+        chunk.SaveIndexInner(*file_handle);
+    }
+    // the work directory goes with the chunk, the saved file is self-contained
+    EXPECT_FALSE(VirtualStore::Exists(save_dir_ + "/build_work"));
+    {
+        DiskAnnIndexInChunk chunk(start_offset, &index_diskann, dim, save_dir_ + "/load_work");
+        auto [file_handle, status] = VirtualStore::Open(chunk_file, FileAccessMode::kRead);
+        ASSERT_TRUE(status.ok());
+        file_handle->Seek(header.size());
+        chunk.ReadIndexInner(*file_handle);
+        // the graph is read in place, nothing is copied out of the chunk file
+        EXPECT_FALSE(VirtualStore::Exists(save_dir_ + "/load_work"));
+        EXPECT_EQ(file_handle->Tell(), file_handle->FileSize());
+        test_search(chunk);
+    }
+}
+
+class DiskAnnReaderTest : public BaseTest {
+public:
+    const std::string save_dir_ = GetFullTmpDir();
+
+    static constexpr SizeT kSectorN = 16;
+
+    void SetUp() override {
+        BaseTest::SetUp();
+        // every byte of a sector holds the index of the sector
+        Vector<char> content(kSectorN * DISKANN_SECTOR_LEN);
+        for (SizeT i = 0; i < kSectorN; ++i) {
+            std::fill_n(content.begin() + i * DISKANN_SECTOR_LEN, DISKANN_SECTOR_LEN, static_cast<char>(i));
+        }
+        file_path_ = save_dir_ + "/sectors.bin";
+        auto [file_handle, status] = VirtualStore::Open(file_path_, FileAccessMode::kWrite);
+        ASSERT_TRUE(status.ok());
+        file_handle->Append(content.data(), content.size());
+
+        AllocAligned((void **)&buf_, kSectorN * DISKANN_SECTOR_LEN, DISKANN_SECTOR_LEN);
+    }
+
+    void TearDown() override {
+        AlignedFree(buf_);
+        BaseTest::TearDown();
+    }
+
+    // the sectors in reverse order, one request each
+    Vector<AlignedRead> MakeRequests() {
+        std::memset(buf_, 0xff, kSectorN * DISKANN_SECTOR_LEN);
+        Vector<AlignedRead> read_reqs;
+        for (SizeT i = 0; i < kSectorN; ++i) {
+            read_reqs.emplace_back((kSectorN - 1 - i) * DISKANN_SECTOR_LEN, DISKANN_SECTOR_LEN, buf_ + i * DISKANN_SECTOR_LEN);
+        }
+        return read_reqs;
+    }
+
+    void CheckRequests() {
+        for (SizeT i = 0; i < kSectorN; ++i) {
+            const char expect = static_cast<char>(kSectorN - 1 - i);
+            const char *sector = buf_ + i * DISKANN_SECTOR_LEN;
+            EXPECT_TRUE(std::all_of(sector, sector + DISKANN_SECTOR_LEN, [&](char c) { return c == expect; })) << "sector " << i;
+        }
+    }
+
+    String file_path_;
+    char *buf_ = nullptr;
+};
+
+TEST_F(DiskAnnReaderTest, read) {
+    AlignedFileReader reader;
+    reader.Open(file_path_);
+    for (bool async : {false, true}) {
+        auto read_reqs = MakeRequests();
+        reader.Read(read_reqs, async);
+        CheckRequests();
+    }
+    // more requests than the entries of the ring are submitted in several rounds
+    IoUringRing ring(4);
+    auto read_reqs = MakeRequests();
+    reader.Read(read_reqs, ring);
+    CheckRequests();
+    reader.Close();
+}
+
+// the offsets of the requests are from where the disk index starts in the file
+TEST_F(DiskAnnReaderTest, base_offset) {
+    constexpr SizeT base_sector = 3;
+    AlignedFileReader reader;
+    reader.Open(file_path_, base_sector * DISKANN_SECTOR_LEN);
+    IoUringRing ring(4);
+    for (bool use_ring : {false, true}) {
+        std::memset(buf_, 0xff, kSectorN * DISKANN_SECTOR_LEN);
+        Vector<AlignedRead> read_reqs;
+        for (SizeT i = 0; i + base_sector < kSectorN; ++i) {
+            read_reqs.emplace_back(i * DISKANN_SECTOR_LEN, DISKANN_SECTOR_LEN, buf_ + i * DISKANN_SECTOR_LEN);
+        }
+        if (use_ring) {
+            reader.Read(read_reqs, ring);
+        } else {
+            reader.Read(read_reqs, false);
+        }
+        for (SizeT i = 0; i < read_reqs.size(); ++i) {
+            const char expect = static_cast<char>(base_sector + i);
+            const char *sector = buf_ + i * DISKANN_SECTOR_LEN;
+            EXPECT_TRUE(std::all_of(sector, sector + DISKANN_SECTOR_LEN, [&](char c) { return c == expect; })) << "sector " << i;
+            // the requests keep their offsets
+            EXPECT_EQ(read_reqs[i].offset, i * DISKANN_SECTOR_LEN);
+        }
+    }
+    reader.Close();
+}
+
+TEST_F(DiskAnnReaderTest, pread_fallback) {
+    // a ring of no entries can not be set up, all requests are read by pread
+    IoUringRing ring(0);
+    EXPECT_FALSE(ring.ok());
+    AlignedFileReader reader;
+    reader.Open(file_path_);
+    auto read_reqs = MakeRequests();
+    reader.Read(read_reqs, ring);
+    CheckRequests();
+    reader.Close();
+}
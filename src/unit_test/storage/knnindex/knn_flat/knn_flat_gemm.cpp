@@ -0,0 +1,212 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include <cmath>
+#include <random>
+import base_test;
+
+import stl;
+import knn_expr;
+import knn_flat_gemm;
+
+using namespace infinity;
+
+class KnnFlatGemmTest : public BaseTest {
+protected:
+    static constexpr SizeT dim = 48;
+    static constexpr SizeT row_n = 500;
+    static constexpr SizeT query_n = 9;
+};
+
+TEST_F(KnnFlatGemmTest, int8_exact) {
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<i32> dist(-128, 127);
+    Vector<i8> rows(row_n * dim);
+    Vector<i8> queries(query_n * dim);
+    for (auto &x : rows) {
+        x = dist(gen);
+    }
+    for (auto &x : queries) {
+        x = dist(gen);
+    }
+    for (auto dist_type : {KnnDistanceType::kL2, KnnDistanceType::kInnerProduct}) {
+        KnnFlatGemm gemm(dist_type, dim);
+        Vector<f32> distances(query_n * row_n);
+        gemm.Distances(queries.data(), query_n, rows.data(), row_n, distances.data());
+        for (SizeT q = 0; q < query_n; ++q) {
+            for (SizeT r = 0; r < row_n; ++r) {
+                i32 expected = 0;
+                for (SizeT k = 0; k < dim; ++k) {
+                    const i32 x = rows[r * dim + k];
+                    const i32 y = queries[q * dim + k];
+                    expected += dist_type == KnnDistanceType::kL2 ? (x - y) * (x - y) : x * y;
+                }
+                EXPECT_EQ(distances[q * row_n + r], static_cast<f32>(expected));
+            }
+        }
+    }
+}
+
+TEST_F(KnnFlatGemmTest, float_rank) {
+    std::mt19937 gen(0);
+    std::normal_distribution<f32> dist(0, 1);
+    Vector<f32> rows(row_n * dim);
+    Vector<f32> queries(query_n * dim);
+    for (auto &x : rows) {
+        x = dist(gen);
+    }
+    for (auto &x : queries) {
+        x = dist(gen);
+    }
+    constexpr SizeT topk = 10;
+    KnnFlatGemm gemm(KnnDistanceType::kL2, dim);
+    Vector<f32> scores(query_n * row_n);
+    gemm.RankScores(queries.data(), query_n, rows.data(), row_n, scores.data());
+    for (SizeT q = 0; q < query_n; ++q) {
+        Vector<f32> exact(row_n, 0);
+        for (SizeT r = 0; r < row_n; ++r) {
+            for (SizeT k = 0; k < dim; ++k) {
+                const f32 diff = rows[r * dim + k] - queries[q * dim + k];
+                exact[r] += diff * diff;
+            }
+        }
+        Vector<SizeT> by_exact(row_n);
+        Vector<SizeT> by_score(row_n);
+        std::iota(by_exact.begin(), by_exact.end(), 0);
+        std::iota(by_score.begin(), by_score.end(), 0);
+        std::sort(by_exact.begin(), by_exact.end(), [&](SizeT a, SizeT b) { return exact[a] < exact[b]; });
+        std::sort(by_score.begin(), by_score.end(), [&](SizeT a, SizeT b) { return scores[q * row_n + a] < scores[q * row_n + b]; });
+        // the exact top k are within the candidates which are reranked
+        const HashSet<SizeT> candidates(by_score.begin(), by_score.begin() + topk * kKnnFlatGemmRerankFactor);
+        for (SizeT i = 0; i < topk; ++i) {
+            EXPECT_TRUE(candidates.contains(by_exact[i]));
+        }
+    }
+}
+
+TEST_F(KnnFlatGemmTest, float_skewed_rerank) {
+    std::mt19937 gen(0);
+    std::normal_distribution<f32> dist(0, 1);
+    // one outlier dimension and a growing scale of the others
+    auto dim_scale = [](SizeT k) { return (k == 0 ? 100.0f : 1.0f) * std::pow(1.05f, static_cast<f32>(k)); };
+    Vector<f32> rows(row_n * dim);
+    Vector<f32> queries(query_n * dim);
+    for (SizeT i = 0; i < rows.size(); ++i) {
+        rows[i] = dist(gen) * dim_scale(i % dim);
+    }
+    for (SizeT i = 0; i < queries.size(); ++i) {
+        queries[i] = dist(gen) * dim_scale(i % dim);
+    }
+    constexpr SizeT topk = 10;
+    for (auto dist_type : {KnnDistanceType::kL2, KnnDistanceType::kInnerProduct, KnnDistanceType::kCosine}) {
+        // exact distances, smaller is better
+        auto exact_dist = [&](SizeT q, SizeT r) {
+            f32 ip = 0;
+            f32 l2 = 0;
+            f32 norm = 0;
+            for (SizeT k = 0; k < dim; ++k) {
+                const f32 x = rows[r * dim + k];
+                const f32 y = queries[q * dim + k];
+                ip += x * y;
+                l2 += (x - y) * (x - y);
+                norm += x * x;
+            }
+            switch (dist_type) {
+                case KnnDistanceType::kL2:
+                    return l2;
+                case KnnDistanceType::kInnerProduct:
+                    return -ip;
+                default:
+                    return -ip / std::sqrt(norm);
+            }
+        };
+        KnnFlatGemm gemm(dist_type, dim);
+        Vector<f32> scores(query_n * row_n);
+        gemm.RankScores(queries.data(), query_n, rows.data(), row_n, scores.data());
+        SizeT found = 0;
+        for (SizeT q = 0; q < query_n; ++q) {
+            Vector<SizeT> by_exact(row_n);
+            std::iota(by_exact.begin(), by_exact.end(), 0);
+            std::sort(by_exact.begin(), by_exact.end(), [&](SizeT a, SizeT b) { return exact_dist(q, a) < exact_dist(q, b); });
+            // the candidates are reranked with the exact distances, as the brute force scan does
+            Vector<SizeT> candidates(row_n);
+            std::iota(candidates.begin(), candidates.end(), 0);
+            std::sort(candidates.begin(), candidates.end(), [&](SizeT a, SizeT b) { return scores[q * row_n + a] < scores[q * row_n + b]; });
+            candidates.resize(topk * kKnnFlatGemmRerankFactor);
+            std::sort(candidates.begin(), candidates.end(), [&](SizeT a, SizeT b) { return exact_dist(q, a) < exact_dist(q, b); });
+            const HashSet<SizeT> result(candidates.begin(), candidates.begin() + topk);
+            for (SizeT i = 0; i < topk; ++i) {
+                found += result.contains(by_exact[i]);
+            }
+        }
+        EXPECT_GE(found, query_n * topk * 95 / 100);
+    }
+}
+
+// the extreme values saturate the i16 sums of pairs of an u8 x i8 kernel, the products have to stay exact
+TEST_F(KnnFlatGemmTest, extreme_values_exact) {
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<i32> pick(0, 2);
+    auto check = [&]<typename ElemType>(const Vector<ElemType> &values) {
+        Vector<ElemType> rows(row_n * dim);
+        Vector<ElemType> queries(query_n * dim);
+        for (auto &x : rows) {
+            x = values[pick(gen)];
+        }
+        for (auto &x : queries) {
+            x = values[pick(gen)];
+        }
+        for (auto dist_type : {KnnDistanceType::kL2, KnnDistanceType::kInnerProduct}) {
+            KnnFlatGemm gemm(dist_type, dim);
+            Vector<f32> distances(query_n * row_n);
+            gemm.Distances(queries.data(), query_n, rows.data(), row_n, distances.data());
+            for (SizeT q = 0; q < query_n; ++q) {
+                for (SizeT r = 0; r < row_n; ++r) {
+                    i32 expected = 0;
+                    for (SizeT k = 0; k < dim; ++k) {
+                        const i32 x = rows[r * dim + k];
+                        const i32 y = queries[q * dim + k];
+                        expected += dist_type == KnnDistanceType::kL2 ? (x - y) * (x - y) : x * y;
+                    }
+                    ASSERT_EQ(distances[q * row_n + r], static_cast<f32>(expected)) << "query " << q << " row " << r;
+                }
+            }
+        }
+    };
+    check(Vector<i8>{-128, -127, 127});
+    check(Vector<u8>{0, 255, 254});
+
+    // every float is quantized to +-127, the quantized inner product is the exact one
+    Vector<f32> rows(row_n * dim);
+    Vector<f32> queries(query_n * dim);
+    for (auto &x : rows) {
+        x = pick(gen) % 2 ? 1.0f : -1.0f;
+    }
+    for (auto &x : queries) {
+        x = pick(gen) % 2 ? 1.0f : -1.0f;
+    }
+    KnnFlatGemm gemm(KnnDistanceType::kInnerProduct, dim);
+    Vector<f32> scores(query_n * row_n);
+    gemm.RankScores(queries.data(), query_n, rows.data(), row_n, scores.data());
+    for (SizeT q = 0; q < query_n; ++q) {
+        for (SizeT r = 0; r < row_n; ++r) {
+            f32 ip = 0;
+            for (SizeT k = 0; k < dim; ++k) {
+                ip += rows[r * dim + k] * queries[q * dim + k];
+            }
+            ASSERT_NEAR(scores[q * row_n + r], -ip, 1e-3) << "query " << q << " row " << r;
+        }
+    }
+}
@@ -0,0 +1,183 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include <random>
+import base_test;
+
+import stl;
+import internal_types;
+import maxsim_batch;
+
+using namespace infinity;
+
+class MaxSimBatchTest : public BaseTest {
+protected:
+    // none of the dimensions is a multiple of the block size of the matrix multiply
+    static constexpr u32 dims[] = {1, 7, 17, 33, 100};
+    static constexpr u32 query_embedding_num = 5;
+    static constexpr u32 slot_n = 6;
+
+    // the embedding number of each target, the target i is in the slot i % slot_n
+    static Vector<u32> TargetEmbeddingNums() {
+        Vector<u32> nums;
+        for (u32 i = 0; i < 20; ++i) {
+            nums.push_back(1 + (i * 7) % 11);
+        }
+        return nums;
+    }
+
+    template <typename TensorElemT, typename QueryElemT, typename ScoreT>
+    static Vector<f32> ScalarMaxSim(const Vector<QueryElemT> &query, const Vector<Vector<TensorElemT>> &targets, const u32 dim) {
+        Vector<f32> slot_scores(slot_n, std::numeric_limits<f32>::lowest());
+        for (SizeT t = 0; t < targets.size(); ++t) {
+            const u32 target_embedding_num = targets[t].size() / dim;
+            ScoreT maxsim_score = 0;
+            for (u32 q = 0; q < query_embedding_num; ++q) {
+                ScoreT max_score = std::numeric_limits<ScoreT>::lowest();
+                for (u32 e = 0; e < target_embedding_num; ++e) {
+                    ScoreT ip = 0;
+                    for (u32 k = 0; k < dim; ++k) {
+                        ip += static_cast<ScoreT>(query[q * dim + k]) * static_cast<ScoreT>(targets[t][e * dim + k]);
+                    }
+                    max_score = std::max(max_score, ip);
+                }
+                maxsim_score += max_score;
+            }
+            slot_scores[t % slot_n] = std::max(slot_scores[t % slot_n], static_cast<f32>(maxsim_score));
+        }
+        return slot_scores;
+    }
+
+    template <typename TensorElemT, typename QueryElemT>
+    static Vector<f32> BatchMaxSim(const Vector<QueryElemT> &query, const Vector<Vector<TensorElemT>> &targets, const u32 dim) {
+        Vector<f32> slot_scores(slot_n, std::numeric_limits<f32>::lowest());
+        MaxSimBatch<TensorElemT, QueryElemT> batch(reinterpret_cast<const char *>(query.data()), query_embedding_num, dim);
+        for (SizeT t = 0; t < targets.size(); ++t) {
+            batch.Add(reinterpret_cast<const char *>(targets[t].data()), targets[t].size() / dim, t % slot_n);
+            // score in several batches, the slot scores are kept over the batches
+            if (t % 7 == 6) {
+                batch.Score(slot_scores.data());
+                batch.Clear();
+                EXPECT_EQ(batch.embedding_num(), 0u);
+            }
+        }
+        batch.Score(slot_scores.data());
+        return slot_scores;
+    }
+
+    template <typename TensorElemT, typename Gen>
+    static Vector<Vector<TensorElemT>> MakeTargets(const u32 dim, Gen &&gen) {
+        Vector<Vector<TensorElemT>> targets;
+        for (const u32 target_embedding_num : TargetEmbeddingNums()) {
+            auto &target = targets.emplace_back(target_embedding_num * dim);
+            for (auto &x : target) {
+                x = gen();
+            }
+        }
+        return targets;
+    }
+};
+
+TEST_F(MaxSimBatchTest, float_approx) {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<f32> distrib(-1.0f, 1.0f);
+    auto gen = [&] { return distrib(rng); };
+    for (const u32 dim : dims) {
+        Vector<f32> query(query_embedding_num * dim);
+        for (auto &x : query) {
+            x = gen();
+        }
+        {
+            const auto targets = MakeTargets<f32>(dim, gen);
+            const auto expected = ScalarMaxSim<f32, f32, f64>(query, targets, dim);
+            const auto scores = BatchMaxSim<f32, f32>(query, targets, dim);
+            for (u32 slot = 0; slot < slot_n; ++slot) {
+                EXPECT_NEAR(scores[slot], expected[slot], 1e-3) << "dim " << dim << " slot " << slot;
+            }
+        }
+        {
+            const auto targets = MakeTargets<Float16T>(dim, [&] { return Float16T(gen()); });
+            const auto expected = ScalarMaxSim<Float16T, f32, f64>(query, targets, dim);
+            const auto scores = BatchMaxSim<Float16T, f32>(query, targets, dim);
+            for (u32 slot = 0; slot < slot_n; ++slot) {
+                EXPECT_NEAR(scores[slot], expected[slot], 1e-3) << "dim " << dim << " slot " << slot;
+            }
+        }
+    }
+}
+
+TEST_F(MaxSimBatchTest, int8_exact) {
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<i32> distrib_i8(-128, 127);
+    std::uniform_int_distribution<i32> distrib_u8(0, 255);
+    for (const u32 dim : dims) {
+        {
+            auto gen = [&] { return static_cast<i8>(distrib_i8(rng)); };
+            Vector<i8> query(query_embedding_num * dim);
+            for (auto &x : query) {
+                x = gen();
+            }
+            const auto targets = MakeTargets<i8>(dim, gen);
+            const auto expected = ScalarMaxSim<i8, i8, i32>(query, targets, dim);
+            const auto scores = BatchMaxSim<i8, i8>(query, targets, dim);
+            for (u32 slot = 0; slot < slot_n; ++slot) {
+                EXPECT_EQ(scores[slot], expected[slot]) << "dim " << dim << " slot " << slot;
+            }
+        }
+        {
+            auto gen = [&] { return static_cast<u8>(distrib_u8(rng)); };
+            Vector<u8> query(query_embedding_num * dim);
+            for (auto &x : query) {
+                x = gen();
+            }
+            const auto targets = MakeTargets<u8>(dim, gen);
+            const auto expected = ScalarMaxSim<u8, u8, i32>(query, targets, dim);
+            const auto scores = BatchMaxSim<u8, u8>(query, targets, dim);
+            for (u32 slot = 0; slot < slot_n; ++slot) {
+                EXPECT_EQ(scores[slot], expected[slot]) << "dim " << dim << " slot " << slot;
+            }
+        }
+    }
+}
+
+// the extreme values saturate the i16 sums of pairs of an u8 x i8 kernel, the scores have to stay exact
+TEST_F(MaxSimBatchTest, int8_extreme_exact) {
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<i32> pick(0, 2);
+    auto check = [&]<typename ElemT>(const Vector<ElemT> &values) {
+        auto gen = [&] { return values[pick(rng)]; };
+        for (const u32 dim : dims) {
+            Vector<ElemT> query(query_embedding_num * dim);
+            for (auto &x : query) {
+                x = gen();
+            }
+            const auto targets = MakeTargets<ElemT>(dim, gen);
+            const auto expected = ScalarMaxSim<ElemT, ElemT, i32>(query, targets, dim);
+            const auto scores = BatchMaxSim<ElemT, ElemT>(query, targets, dim);
+            for (u32 slot = 0; slot < slot_n; ++slot) {
+                EXPECT_EQ(scores[slot], expected[slot]) << "dim " << dim << " slot " << slot;
+            }
+        }
+    };
+    check(Vector<i8>{-128, -127, 127});
+    check(Vector<u8>{0, 255, 254});
+}
+
+TEST_F(MaxSimBatchTest, not_batched) {
+    EXPECT_FALSE((MaxSimBatch<f32, u8>::kBatched));
+    EXPECT_FALSE((MaxSimBatch<i8, f32>::kBatched));
+    EXPECT_TRUE((MaxSimBatch<BFloat16T, f32>::kBatched));
+    EXPECT_TRUE((MaxSimBatch<u8, u8>::kBatched));
+}
@@ -0,0 +1,136 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include <random>
+import base_test;
+
+import stl;
+import merge_knn;
+import knn_result_handler;
+import roaring_bitmap;
+import internal_types;
+import distance_simd_functions;
+
+using namespace infinity;
+
+class MergeKnnPartialTest : public BaseTest {
+protected:
+    // not a multiple of the dimensions summed up before each check of the bound
+    static constexpr u32 dim = 200;
+    static constexpr u16 row_n = 1000;
+    static constexpr u32 block_n = 3;
+    static constexpr u64 query_n = 3;
+    static constexpr u64 topk = 10;
+
+    using Heap = MergeKnn<f32, CompareMax, f32>;
+
+    static void ExpectSameResult(Heap &expected, Heap &heap) {
+        ASSERT_EQ(heap.GetSize(), expected.GetSize());
+        for (u64 q = 0; q < query_n; ++q) {
+            for (u32 i = 0; i < expected.GetSize(); ++i) {
+                EXPECT_EQ(heap.GetIDsByIdx(q)[i], expected.GetIDsByIdx(q)[i]) << "query " << q << " rank " << i;
+                EXPECT_NEAR(heap.GetDistancesByIdx(q)[i], expected.GetDistancesByIdx(q)[i], 1e-3) << "query " << q << " rank " << i;
+            }
+        }
+    }
+};
+
+TEST_F(MergeKnnPartialTest, same_top_k) {
+    std::mt19937 rng(0);
+    std::normal_distribution<f32> distrib(0, 1);
+    Vector<f32> queries(query_n * dim);
+    for (auto &x : queries) {
+        x = distrib(rng);
+    }
+    Vector<f32> data(block_n * row_n * dim);
+    for (auto &x : data) {
+        x = distrib(rng);
+    }
+    Bitmask bitmask(row_n);
+    for (u32 j = 0; j < row_n; j += 3) {
+        bitmask.SetFalse(j);
+    }
+
+    Heap expected(query_n, topk, None);
+    Heap heap(query_n, topk, None);
+    KnnSharedBound shared_bound(query_n);
+    heap.SetSharedBound(&shared_bound);
+    expected.Begin();
+    heap.Begin();
+    for (u32 b = 0; b < block_n; ++b) {
+        const f32 *block = data.data() + static_cast<SizeT>(b) * row_n * dim;
+        expected.Search(queries.data(), block, dim, L2Distance_common, row_n, 0, b, bitmask);
+        heap.SearchPartial(queries.data(), block, dim, L2Distance_common, row_n, 0, b, bitmask);
+    }
+    expected.End();
+    heap.End();
+    ExpectSameResult(expected, heap);
+    EXPECT_EQ(heap.total_input_count(), expected.total_input_count());
+    for (u64 q = 0; q < query_n; ++q) {
+        EXPECT_EQ(shared_bound.Get(q), heap.GetDistancesByIdx(q)[topk - 1]);
+    }
+}
+
+// the k-th distance of another task lets a heap drop the rows before it has k results itself
+TEST_F(MergeKnnPartialTest, shared_bound) {
+    std::mt19937 rng(0);
+    std::normal_distribution<f32> distrib(0, 1);
+    Vector<f32> query(dim);
+    for (auto &x : query) {
+        x = distrib(rng);
+    }
+    Vector<f32> data(2 * row_n * dim);
+    for (auto &x : data) {
+        x = distrib(rng);
+    }
+    const Bitmask bitmask(row_n);
+    const f32 *block0 = data.data();
+    const f32 *block1 = data.data() + static_cast<SizeT>(row_n) * dim;
+
+    Heap expected(1, topk, None);
+    expected.Begin();
+    expected.Search(query.data(), block0, dim, L2Distance_common, row_n, 0, 0, bitmask);
+    expected.Search(query.data(), block1, dim, L2Distance_common, row_n, 0, 1, bitmask);
+    expected.End();
+
+    // two tasks, each scans one block
+    KnnSharedBound shared_bound(1);
+    Heap task0(1, topk, None);
+    Heap task1(1, topk, None);
+    task0.SetSharedBound(&shared_bound);
+    task1.SetSharedBound(&shared_bound);
+    task0.Begin();
+    task1.Begin();
+    task0.SearchPartial(query.data(), block0, dim, L2Distance_common, row_n, 0, 0, bitmask);
+    task1.SearchPartial(query.data(), block1, dim, L2Distance_common, row_n, 0, 1, bitmask);
+    task0.End();
+    task1.End();
+    // the second task only keeps the rows which are better than the k-th of the first one
+    const f32 bound0 = task0.GetDistances()[topk - 1];
+    for (u32 i = 0; i < task1.GetSize(); ++i) {
+        EXPECT_LE(task1.GetDistances()[i], bound0);
+    }
+
+    Heap merged(1, topk, None);
+    merged.Begin();
+    for (Heap *task : {&task0, &task1}) {
+        merged.Search(0, task->GetDistances(), task->GetIDs(), task->GetSize());
+    }
+    merged.End();
+    ASSERT_EQ(merged.GetSize(), expected.GetSize());
+    for (u32 i = 0; i < expected.GetSize(); ++i) {
+        EXPECT_EQ(merged.GetIDs()[i], expected.GetIDs()[i]) << "rank " << i;
+    }
+}
@@ -33,6 +33,10 @@ import hnsw_common;
 import infinity_exception;
 import virtual_store;
 import local_file_handle;
+import rabitq_quantizer;
+import internal_types;
+import abstract_hnsw;
+import vector_distance;
 
 using namespace infinity;
 
@@ -44,6 +48,7 @@ public:
 
     template <typename Hnsw>
     void TestSimple() {
+        using DataType = typename Hnsw::DataType;
 
         int dim = 16;
         int M = 8;
@@ -56,9 +61,9 @@ public:
         rng.seed(0);
         std::uniform_real_distribution<float> distrib_real;
 
-        auto data = MakeUnique<float[]>(dim * element_size);
+        auto data = MakeUnique<DataType[]>(dim * element_size);
         for (int i = 0; i < dim * element_size; ++i) {
-            data[i] = distrib_real(rng);
+            data[i] = static_cast<DataType>(distrib_real(rng));
         }
 
         auto test_func = [&](auto &hnsw_index) {
@@ -70,7 +75,7 @@ public:
             KnnSearchOption search_option{.ef_ = 10};
             int correct = 0;
             for (int i = 0; i < element_size; ++i) {
-                const float *query = data.get() + i * dim;
+                const DataType *query = data.get() + i * dim;
                 auto result = hnsw_index->KnnSearchSorted(query, 1, search_option);
                 if (result[0].second == (LabelT)i) {
                     ++correct;
@@ -83,7 +88,7 @@ public:
 
         {
             auto hnsw_index = Hnsw::Make(chunk_size, max_chunk_n, dim, M, ef_construction);
-            auto iter = DenseVectorIter<float, LabelT>(data.get(), dim, element_size);
+            auto iter = DenseVectorIter<DataType, LabelT>(data.get(), dim, element_size);
             hnsw_index->InsertVecs(std::move(iter));
 
             test_func(hnsw_index);
@@ -104,6 +109,170 @@ public:
             auto hnsw_index = Hnsw::Load(*file_handle);
 
             test_func(hnsw_index);
+
+            auto [mmap_file_handle, mmap_status] = VirtualStore::Open(save_dir_ + "/test_hnsw_mmap.bin", FileAccessMode::kWrite);
+            if (!mmap_status.ok()) {
+                UnrecoverableError(mmap_status.message());
+            }
+            hnsw_index->SaveToPtr(*mmap_file_handle);
+        }
+
+        {
+            u8 *data_ptr = nullptr;
+            SizeT data_len = 0;
+            EXPECT_EQ(VirtualStore::MmapFile(save_dir_ + "/test_hnsw_mmap.bin", data_ptr, data_len), 0);
+
+            auto hnsw_index = Hnsw::LoadFromPtr(reinterpret_cast<const char *>(data_ptr), data_len, true);
+            EXPECT_FALSE(hnsw_index->own_mem());
+            test_func(hnsw_index);
+
+            hnsw_index->Materialize();
+            EXPECT_TRUE(hnsw_index->own_mem());
+            VirtualStore::MunmapFile(save_dir_ + "/test_hnsw_mmap.bin");
+            test_func(hnsw_index);
+        }
+    }
+
+    template <typename Hnsw>
+    void TestReorder(HnswReorderType reorder_type) {
+        int dim = 16;
+        int M = 8;
+        int ef_construction = 200;
+        int chunk_size = 128;
+        int max_chunk_n = 10;
+        int element_size = max_chunk_n * chunk_size - 10;
+
+        std::mt19937 rng;
+        rng.seed(0);
+        std::uniform_real_distribution<float> distrib_real;
+
+        auto data = MakeUnique<float[]>(dim * element_size);
+        for (int i = 0; i < dim * element_size; ++i) {
+            data[i] = distrib_real(rng);
+        }
+
+        auto test_func = [&](auto &hnsw_index) {
+            hnsw_index->Check();
+
+            KnnSearchOption search_option{.ef_ = 10};
+            int correct = 0;
+            for (int i = 0; i < element_size; ++i) {
+                const float *query = data.get() + i * dim;
+                auto result = hnsw_index->KnnSearchSorted(query, 1, search_option);
+                if (result[0].second == (LabelT)i) {
+                    ++correct;
+                }
+            }
+            float correct_rate = float(correct) / element_size;
+            EXPECT_GE(correct_rate, 0.95);
+        };
+
+        {
+            auto hnsw_index = Hnsw::Make(chunk_size, max_chunk_n, dim, M, ef_construction);
+            auto iter = DenseVectorIter<float, LabelT>(data.get(), dim, element_size);
+            hnsw_index->InsertVecs(std::move(iter));
+
+            hnsw_index->Reorder(reorder_type);
+            test_func(hnsw_index);
+
+            auto [file_handle, status] = VirtualStore::Open(save_dir_ + "/test_hnsw_reorder.bin", FileAccessMode::kWrite);
+            if (!status.ok()) {
+                UnrecoverableError(status.message());
+            }
+            hnsw_index->Save(*file_handle);
+        }
+
+        {
+            auto [file_handle, status] = VirtualStore::Open(save_dir_ + "/test_hnsw_reorder.bin", FileAccessMode::kRead);
+            if (!status.ok()) {
+                UnrecoverableError(status.message());
+            }
+            auto hnsw_index = Hnsw::Load(*file_handle);
+            test_func(hnsw_index);
+        }
+    }
+
+    template <typename Hnsw>
+    void TestBatch() {
+        int dim = 16;
+        int M = 8;
+        int ef_construction = 200;
+        int chunk_size = 128;
+        int max_chunk_n = 10;
+        int element_size = max_chunk_n * chunk_size;
+        int query_n = 64;
+        int topk = 5;
+
+        std::mt19937 rng;
+        rng.seed(0);
+        std::uniform_real_distribution<float> distrib_real;
+
+        auto data = MakeUnique<float[]>(dim * element_size);
+        for (int i = 0; i < dim * element_size; ++i) {
+            data[i] = distrib_real(rng);
+        }
+
+        auto hnsw_index = Hnsw::Make(chunk_size, max_chunk_n, dim, M, ef_construction);
+        auto iter = DenseVectorIter<float, LabelT>(data.get(), dim, element_size);
+        hnsw_index->InsertVecs(std::move(iter));
+
+        // the batch search walks the same path as the search of every single query
+        Vector<const float *> queries(query_n);
+        for (int i = 0; i < query_n; ++i) {
+            queries[i] = data.get() + (i * 17 % element_size) * dim;
+        }
+        KnnSearchOption search_option{.ef_ = 10};
+        auto batch_results = hnsw_index->KnnSearchBatch(queries.data(), query_n, topk, search_option);
+        ASSERT_EQ(batch_results.size(), SizeT(query_n));
+        for (int i = 0; i < query_n; ++i) {
+            auto [result_n, d_ptr, l_ptr] = hnsw_index->KnnSearch(queries[i], topk, search_option);
+            const auto &[batch_result_n, batch_d_ptr, batch_l_ptr] = batch_results[i];
+            ASSERT_EQ(batch_result_n, result_n);
+            for (SizeT j = 0; j < result_n; ++j) {
+                EXPECT_EQ(batch_d_ptr[j], d_ptr[j]);
+                EXPECT_EQ(batch_l_ptr[j], l_ptr[j]);
+            }
+        }
+    }
+
+    template <typename Hnsw>
+    void TestPatience() {
+        int dim = 16;
+        int M = 8;
+        int ef_construction = 200;
+        int chunk_size = 128;
+        int max_chunk_n = 10;
+        int element_size = max_chunk_n * chunk_size;
+        int topk = 5;
+
+        std::mt19937 rng;
+        rng.seed(0);
+        std::uniform_real_distribution<float> distrib_real;
+
+        auto data = MakeUnique<float[]>(dim * element_size);
+        for (int i = 0; i < dim * element_size; ++i) {
+            data[i] = distrib_real(rng);
+        }
+
+        auto hnsw_index = Hnsw::Make(chunk_size, max_chunk_n, dim, M, ef_construction);
+        auto iter = DenseVectorIter<float, LabelT>(data.get(), dim, element_size);
+        hnsw_index->InsertVecs(std::move(iter));
+
+        // a patience longer than any search gives the same results, a short one still fills the result
+        KnnSearchOption search_option{.ef_ = 50};
+        KnnSearchOption long_patience_option{.ef_ = 50, .patience_ = SizeT(element_size)};
+        KnnSearchOption short_patience_option{.ef_ = 50, .patience_ = 4};
+        for (int i = 0; i < element_size; i += 31) {
+            const float *query = data.get() + i * dim;
+            auto result = hnsw_index->KnnSearchSorted(query, topk, search_option);
+            auto long_result = hnsw_index->KnnSearchSorted(query, topk, long_patience_option);
+            ASSERT_EQ(long_result.size(), result.size());
+            for (SizeT j = 0; j < result.size(); ++j) {
+                EXPECT_EQ(long_result[j].second, result[j].second);
+            }
+            auto short_result = hnsw_index->KnnSearchSorted(query, topk, short_patience_option);
+            ASSERT_EQ(short_result.size(), SizeT(topk));
+            EXPECT_EQ(short_result[0].second, LabelT(i));
         }
     }
 
@@ -177,6 +346,301 @@ public:
         }
     }
 
+    // `dist_func` is the exact distance of the metric, the smaller the closer
+    template <typename Hnsw, typename CompressedHnsw, typename DistFunc>
+    void TestCompressPQ(DistFunc dist_func) {
+        int dim = 16;
+        int M = 8;
+        int ef_construction = 200;
+        int chunk_size = 128;
+        int max_chunk_n = 10;
+        int element_size = max_chunk_n * chunk_size;
+        int subspace_num = 8;
+
+        std::mt19937 rng;
+        rng.seed(0);
+        std::uniform_real_distribution<float> distrib_real;
+
+        auto data = MakeUnique<float[]>(dim * element_size);
+        for (int i = 0; i < dim * element_size; ++i) {
+            data[i] = distrib_real(rng);
+        }
+
+        // the exact nearest vector of every query, which is the query itself for l2 and cosine but not for inner product
+        Vector<LabelT> nearest(element_size);
+        for (int i = 0; i < element_size; ++i) {
+            const float *query = data.get() + i * dim;
+            float min_dist = std::numeric_limits<float>::max();
+            for (int j = 0; j < element_size; ++j) {
+                if (float dist = dist_func(query, data.get() + j * dim, dim); dist < min_dist) {
+                    min_dist = dist;
+                    nearest[i] = j;
+                }
+            }
+        }
+
+        auto test_func = [&](auto &hnsw_index) {
+            hnsw_index->Check();
+
+            // pq distance is approximate, check the exact nearest vector is in the top 10
+            KnnSearchOption search_option{.ef_ = 50};
+            int topk = 10;
+            int correct = 0;
+            for (int i = 0; i < element_size; ++i) {
+                const float *query = data.get() + i * dim;
+                auto result = hnsw_index->KnnSearchSorted(query, topk, search_option);
+                for (int j = 0; j < topk && j < (int)result.size(); ++j) {
+                    if (result[j].second == nearest[i]) {
+                        ++correct;
+                        break;
+                    }
+                }
+            }
+            float correct_rate = float(correct) / element_size;
+            EXPECT_GE(correct_rate, 0.9);
+        };
+
+        {
+            auto hnsw_index = Hnsw::Make(chunk_size, max_chunk_n, dim, M, ef_construction);
+
+            auto iter = DenseVectorIter<float, LabelT>(data.get(), dim, element_size);
+            hnsw_index->InsertVecs(std::move(iter));
+
+            auto compress_hnsw = std::move(*hnsw_index).CompressToPQ(subspace_num);
+            test_func(compress_hnsw);
+
+            auto [file_handle, status] = VirtualStore::Open(save_dir_ + "/test_hnsw.bin", FileAccessMode::kWrite);
+            if (!status.ok()) {
+                UnrecoverableError(status.message());
+            }
+            compress_hnsw->Save(*file_handle);
+        }
+        {
+            auto [file_handle, status] = VirtualStore::Open(save_dir_ + "/test_hnsw.bin", FileAccessMode::kRead);
+            if (!status.ok()) {
+                UnrecoverableError(status.message());
+            }
+
+            auto compress_hnsw = CompressedHnsw::Load(*file_handle);
+
+            test_func(compress_hnsw);
+        }
+    }
+
+    template <typename Hnsw, typename CompressedHnsw>
+    void TestCompressRaBitQ() {
+        int dim = 16;
+        int M = 8;
+        int ef_construction = 200;
+        int chunk_size = 128;
+        int max_chunk_n = 10;
+        int element_size = max_chunk_n * chunk_size;
+
+        std::mt19937 rng;
+        rng.seed(0);
+        std::uniform_real_distribution<float> distrib_real;
+
+        auto data = MakeUnique<float[]>(dim * element_size);
+        for (int i = 0; i < dim * element_size; ++i) {
+            data[i] = distrib_real(rng);
+        }
+
+        auto test_func = [&](auto &hnsw_index) {
+            hnsw_index->Check();
+
+            // 1 bit distance only gives candidates, check the vector itself is in the candidates kept for rerank
+            int topk = 10;
+            int candidate_n = topk * kRaBitQRerankFactor;
+            KnnSearchOption search_option{.ef_ = SizeT(candidate_n)};
+            int correct = 0;
+            for (int i = 0; i < element_size; ++i) {
+                const float *query = data.get() + i * dim;
+                auto result = hnsw_index->KnnSearchSorted(query, candidate_n, search_option);
+                for (int j = 0; j < (int)result.size(); ++j) {
+                    if (result[j].second == (LabelT)i) {
+                        ++correct;
+                        break;
+                    }
+                }
+            }
+            float correct_rate = float(correct) / element_size;
+            EXPECT_GE(correct_rate, 0.9);
+        };
+
+        {
+            auto hnsw_index = Hnsw::Make(chunk_size, max_chunk_n, dim, M, ef_construction);
+
+            auto iter = DenseVectorIter<float, LabelT>(data.get(), dim, element_size);
+            hnsw_index->InsertVecs(std::move(iter));
+
+            auto compress_hnsw = std::move(*hnsw_index).CompressToRaBitQ();
+            test_func(compress_hnsw);
+
+            auto [file_handle, status] = VirtualStore::Open(save_dir_ + "/test_hnsw.bin", FileAccessMode::kWrite);
+            if (!status.ok()) {
+                UnrecoverableError(status.message());
+            }
+            compress_hnsw->Save(*file_handle);
+        }
+        {
+            auto [file_handle, status] = VirtualStore::Open(save_dir_ + "/test_hnsw.bin", FileAccessMode::kRead);
+            if (!status.ok()) {
+                UnrecoverableError(status.message());
+            }
+
+            auto compress_hnsw = CompressedHnsw::Load(*file_handle);
+
+            test_func(compress_hnsw);
+        }
+    }
+
+    template <typename Hnsw, typename CompressedHnsw>
+    void TestRaBitQRecall() {
+        int dim = 64;
+        int M = 16;
+        int ef_construction = 200;
+        int chunk_size = 128;
+        int max_chunk_n = 10;
+        int element_size = max_chunk_n * chunk_size;
+        int query_n = 100;
+        int topk = 10;
+
+        std::mt19937 rng;
+        rng.seed(0);
+        std::uniform_real_distribution<float> distrib_real;
+
+        // the variance falls off over the dimensions, the sign codes of the residuals without rotation lose most of it
+        auto data = MakeUnique<float[]>(dim * element_size);
+        for (int i = 0; i < element_size; ++i) {
+            for (int j = 0; j < dim; ++j) {
+                data[i * dim + j] = distrib_real(rng) / (1 + j);
+            }
+        }
+        auto queries = MakeUnique<float[]>(dim * query_n);
+        for (int i = 0; i < query_n; ++i) {
+            for (int j = 0; j < dim; ++j) {
+                queries[i * dim + j] = distrib_real(rng) / (1 + j);
+            }
+        }
+        auto l2 = [&](const float *v1, const float *v2) {
+            float dist = 0;
+            for (int j = 0; j < dim; ++j) {
+                dist += (v1[j] - v2[j]) * (v1[j] - v2[j]);
+            }
+            return dist;
+        };
+
+        auto hnsw_index = Hnsw::Make(chunk_size, max_chunk_n, dim, M, ef_construction);
+        auto iter = DenseVectorIter<float, LabelT>(data.get(), dim, element_size);
+        hnsw_index->InsertVecs(std::move(iter));
+        auto compress_hnsw = std::move(*hnsw_index).CompressToRaBitQ();
+
+        // the candidates kept by a scan are reranked with the exact distance, as the scan does
+        int candidate_n = topk * kRaBitQRerankFactor;
+        KnnSearchOption search_option{.ef_ = SizeT(candidate_n)};
+        int correct = 0;
+        for (int q = 0; q < query_n; ++q) {
+            const float *query = queries.get() + q * dim;
+            Vector<Pair<float, LabelT>> exact(element_size);
+            for (int i = 0; i < element_size; ++i) {
+                exact[i] = {l2(data.get() + i * dim, query), LabelT(i)};
+            }
+            std::partial_sort(exact.begin(), exact.begin() + topk, exact.end());
+
+            auto candidates = compress_hnsw->KnnSearchSorted(query, candidate_n, search_option);
+            Vector<Pair<float, LabelT>> reranked;
+            for (const auto &[_, label] : candidates) {
+                reranked.emplace_back(l2(data.get() + label * dim, query), label);
+            }
+            std::sort(reranked.begin(), reranked.end());
+            reranked.resize(std::min<SizeT>(reranked.size(), topk));
+
+            for (const auto &[_, label] : reranked) {
+                for (int r = 0; r < topk; ++r) {
+                    if (exact[r].second == label) {
+                        ++correct;
+                        break;
+                    }
+                }
+            }
+        }
+        float recall = float(correct) / (query_n * topk);
+        EXPECT_GE(recall, 0.85);
+    }
+
+    template <typename Hnsw>
+    void TestParallelBuild() {
+        int dim = 16;
+        int M = 8;
+        int ef_construction = 200;
+        int chunk_size = 128;
+        int max_chunk_n = 32;
+        int element_size = max_chunk_n * chunk_size;
+        int query_n = 100;
+        int topk = 10;
+
+        std::mt19937 rng;
+        rng.seed(0);
+        std::uniform_real_distribution<float> distrib_real;
+
+        auto data = MakeUnique<float[]>(dim * element_size);
+        for (int i = 0; i < dim * element_size; ++i) {
+            data[i] = distrib_real(rng);
+        }
+        auto queries = MakeUnique<float[]>(dim * query_n);
+        for (int i = 0; i < dim * query_n; ++i) {
+            queries[i] = distrib_real(rng);
+        }
+        Vector<Vector<LabelT>> ground_truth(query_n);
+        for (int q = 0; q < query_n; ++q) {
+            const float *query = queries.get() + q * dim;
+            Vector<Pair<float, LabelT>> exact(element_size);
+            for (int i = 0; i < element_size; ++i) {
+                float dist = 0;
+                for (int j = 0; j < dim; ++j) {
+                    dist += (data[i * dim + j] - query[j]) * (data[i * dim + j] - query[j]);
+                }
+                exact[i] = {dist, LabelT(i)};
+            }
+            std::partial_sort(exact.begin(), exact.begin() + topk, exact.end());
+            for (int r = 0; r < topk; ++r) {
+                ground_truth[q].push_back(exact[r].second);
+            }
+        }
+        auto recall = [&](auto &hnsw_index) {
+            KnnSearchOption search_option{.ef_ = 50};
+            int correct = 0;
+            for (int q = 0; q < query_n; ++q) {
+                auto result = hnsw_index->KnnSearchSorted(queries.get() + q * dim, topk, search_option);
+                for (const auto &[_, label] : result) {
+                    correct += std::find(ground_truth[q].begin(), ground_truth[q].end(), label) != ground_truth[q].end();
+                }
+            }
+            return float(correct) / (query_n * topk);
+        };
+
+        auto sequential_index = Hnsw::Make(chunk_size, max_chunk_n, dim, M, ef_construction);
+        sequential_index->InsertVecs(DenseVectorIter<float, LabelT>(data.get(), dim, element_size));
+        sequential_index->Check();
+        const float sequential_recall = recall(sequential_index);
+
+        ThreadPool thread_pool(4);
+        auto parallel_index = Hnsw::Make(chunk_size, max_chunk_n, dim, M, ef_construction);
+        SizeT mem_usage = 0;
+        HnswIndexInMem::InsertVecsParallel(parallel_index,
+                                           DenseVectorIter<float, LabelT>(data.get(), dim, element_size),
+                                           HnswInsertConfig(),
+                                           mem_usage,
+                                           thread_pool);
+        EXPECT_GT(mem_usage, 0u);
+        parallel_index->Check();
+        EXPECT_EQ(parallel_index->GetVecNum(), SizeT(element_size));
+        const float parallel_recall = recall(parallel_index);
+
+        EXPECT_GE(sequential_recall, 0.9);
+        EXPECT_GE(parallel_recall, sequential_recall - 0.03);
+    }
+
     template <typename Hnsw>
     void TestParallel() {
         int dim = 16;
@@ -285,6 +749,173 @@ public:
             t.join();
         }
     }
+
+    template <typename Hnsw>
+    void TestTruncated() {
+        int dim = 32;
+        int truncate_dim = 16;
+        int M = 8;
+        int ef_construction = 200;
+        int chunk_size = 128;
+        int max_chunk_n = 10;
+        int element_size = max_chunk_n * chunk_size;
+        int topk = 1;
+
+        std::mt19937 rng;
+        rng.seed(0);
+        std::uniform_real_distribution<float> distrib_real;
+
+        // most of the variance is in the first dimensions, like the embeddings of a matryoshka model
+        auto data = MakeUnique<float[]>(dim * element_size);
+        for (int i = 0; i < element_size; ++i) {
+            for (int j = 0; j < dim; ++j) {
+                data[i * dim + j] = distrib_real(rng) * (j < truncate_dim ? 1.0f : 0.1f);
+            }
+        }
+
+        // the rows of full dimension are inserted, the graph keeps their prefixes
+        auto hnsw_index = Hnsw::Make(chunk_size, max_chunk_n, truncate_dim, M, ef_construction);
+        auto iter = DenseVectorIter<float, LabelT>(data.get(), dim, element_size);
+        hnsw_index->InsertVecs(std::move(iter));
+        EXPECT_EQ(hnsw_index->dim(), SizeT(truncate_dim));
+
+        KnnSearchOption search_option{.ef_ = topk * kHnswTruncatedRerankFactor};
+        int correct = 0;
+        for (int i = 0; i < element_size; ++i) {
+            const float *query = data.get() + i * dim;
+            auto [result_n, d_ptr, l_ptr] = hnsw_index->KnnSearch(query, topk, search_option);
+            // rerank the candidates with the full vectors
+            LabelT best = std::numeric_limits<LabelT>::max();
+            float best_dist = std::numeric_limits<float>::max();
+            for (SizeT r = 0; r < result_n; ++r) {
+                const float *row = data.get() + l_ptr[r] * dim;
+                float dist = 0;
+                for (int j = 0; j < dim; ++j) {
+                    dist += (row[j] - query[j]) * (row[j] - query[j]);
+                }
+                if (dist < best_dist) {
+                    best_dist = dist;
+                    best = l_ptr[r];
+                }
+            }
+            if (best == (LabelT)i) {
+                ++correct;
+            }
+        }
+        float correct_rate = float(correct) / element_size;
+        EXPECT_GE(correct_rate, 0.95);
+    }
+
+    template <typename Hnsw>
+    void TestHamming() {
+        // 128 bits packed into 16 bytes
+        int dim = 16;
+        int M = 8;
+        int ef_construction = 200;
+        int chunk_size = 128;
+        int max_chunk_n = 10;
+        int element_size = max_chunk_n * chunk_size;
+
+        std::mt19937 rng;
+        rng.seed(0);
+        std::uniform_int_distribution<int> distrib_byte(0, 255);
+
+        auto data = MakeUnique<u8[]>(dim * element_size);
+        for (int i = 0; i < dim * element_size; ++i) {
+            data[i] = distrib_byte(rng);
+        }
+
+        auto hnsw_index = Hnsw::Make(chunk_size, max_chunk_n, dim, M, ef_construction);
+        auto iter = DenseVectorIter<u8, LabelT>(data.get(), dim, element_size);
+        hnsw_index->InsertVecs(std::move(iter));
+        hnsw_index->Check();
+
+        KnnSearchOption search_option{.ef_ = 10};
+        int correct = 0;
+        for (int i = 0; i < element_size; ++i) {
+            const u8 *query = data.get() + i * dim;
+            auto result = hnsw_index->KnnSearchSorted(query, 1, search_option);
+            if (result[0].second == (LabelT)i) {
+                EXPECT_EQ(result[0].first, 0);
+                ++correct;
+            }
+        }
+        float correct_rate = float(correct) / element_size;
+        EXPECT_GE(correct_rate, 0.95);
+    }
+
+    template <typename Hnsw>
+    void TestDistanceBound() {
+        int dim = 16;
+        int M = 8;
+        int ef_construction = 200;
+        int chunk_size = 128;
+        int max_chunk_n = 10;
+        int element_size = max_chunk_n * chunk_size;
+        int query_n = 100;
+        SizeT topk = 10;
+
+        std::mt19937 rng;
+        rng.seed(0);
+        std::uniform_real_distribution<float> distrib_real;
+
+        auto data = MakeUnique<float[]>(dim * element_size);
+        for (int i = 0; i < dim * element_size; ++i) {
+            data[i] = distrib_real(rng);
+        }
+        auto queries = MakeUnique<float[]>(dim * query_n);
+        for (int i = 0; i < dim * query_n; ++i) {
+            queries[i] = distrib_real(rng);
+        }
+
+        auto hnsw_index = Hnsw::Make(chunk_size, max_chunk_n, dim, M, ef_construction);
+        auto iter = DenseVectorIter<float, LabelT>(data.get(), dim, element_size);
+        hnsw_index->InsertVecs(std::move(iter));
+
+        int correct = 0;
+        for (int q = 0; q < query_n; ++q) {
+            const float *query = queries.get() + q * dim;
+            Vector<Pair<float, LabelT>> exact(element_size);
+            for (int i = 0; i < element_size; ++i) {
+                float dist = 0;
+                for (int j = 0; j < dim; ++j) {
+                    float diff = data[i * dim + j] - query[j];
+                    dist += diff * diff;
+                }
+                exact[i] = {dist, LabelT(i)};
+            }
+            std::partial_sort(exact.begin(), exact.begin() + topk, exact.end());
+
+            // the tightest bound another task can publish, the exact k-th distance
+            KnnSearchOption search_option{.ef_ = topk * 4};
+            search_option.distance_bound_ = exact[topk - 1].first;
+            auto bounded = hnsw_index->KnnSearchSorted(query, topk, search_option);
+            auto unbounded = hnsw_index->KnnSearchSorted(query, topk, KnnSearchOption{.ef_ = topk * 4});
+
+            // the bound only drops the results, the walk is the same
+            SizeT kept_n = 0;
+            for (const auto &[dist, label] : unbounded) {
+                if (dist <= search_option.distance_bound_) {
+                    ASSERT_LT(kept_n, bounded.size());
+                    EXPECT_EQ(bounded[kept_n].second, label);
+                    ++kept_n;
+                }
+            }
+            EXPECT_EQ(kept_n, bounded.size());
+
+            for (const auto &[dist, label] : bounded) {
+                EXPECT_LE(dist, search_option.distance_bound_);
+                for (SizeT r = 0; r < topk; ++r) {
+                    if (exact[r].second == label) {
+                        ++correct;
+                        break;
+                    }
+                }
+            }
+        }
+        float recall = float(correct) / (query_n * topk);
+        EXPECT_GE(recall, 0.9);
+    }
 };
 
 TEST_F(HnswAlgTest, test1) {
@@ -318,3 +949,88 @@ TEST_F(HnswAlgTest, test6) {
     using CompressedHnsw = KnnHnsw<LVQL2VecStoreType<float, int8_t>, LabelT>;
     TestCompress<Hnsw, CompressedHnsw>();
 }
+
+TEST_F(HnswAlgTest, test7) {
+    {
+        using Hnsw = KnnHnsw<PlainL2VecStoreType<float>, LabelT>;
+        using CompressedHnsw = KnnHnsw<PQL2VecStoreType<float>, LabelT>;
+        TestCompressPQ<Hnsw, CompressedHnsw>([](const float *v1, const float *v2, int dim) { return L2Distance<float>(v1, v2, dim); });
+    }
+    {
+        using Hnsw = KnnHnsw<PlainIPVecStoreType<float>, LabelT>;
+        using CompressedHnsw = KnnHnsw<PQIPVecStoreType<float>, LabelT>;
+        TestCompressPQ<Hnsw, CompressedHnsw>([](const float *v1, const float *v2, int dim) { return -IPDistance<float>(v1, v2, dim); });
+    }
+    {
+        using Hnsw = KnnHnsw<PlainCosVecStoreType<float>, LabelT>;
+        using CompressedHnsw = KnnHnsw<PQCosVecStoreType<float>, LabelT>;
+        TestCompressPQ<Hnsw, CompressedHnsw>([](const float *v1, const float *v2, int dim) { return -CosineDistance<float>(v1, v2, dim); });
+    }
+}
+
+TEST_F(HnswAlgTest, test8) {
+    using Hnsw = KnnHnsw<PlainL2VecStoreType<float>, LabelT>;
+    using CompressedHnsw = KnnHnsw<RaBitQL2VecStoreType<float>, LabelT>;
+    TestCompressRaBitQ<Hnsw, CompressedHnsw>();
+}
+
+TEST_F(HnswAlgTest, test9) {
+    using Hnsw = KnnHnsw<PlainL2VecStoreType<Float16T>, LabelT>;
+    TestSimple<Hnsw>();
+}
+
+TEST_F(HnswAlgTest, test10) {
+    using Hnsw = KnnHnsw<PlainL2VecStoreType<BFloat16T>, LabelT>;
+    TestSimple<Hnsw>();
+}
+
+TEST_F(HnswAlgTest, test11) {
+    using Hnsw = KnnHnsw<PlainL2VecStoreType<float>, LabelT>;
+    TestReorder<Hnsw>(HnswReorderType::kBFS);
+}
+
+TEST_F(HnswAlgTest, test12) {
+    using Hnsw = KnnHnsw<LVQL2VecStoreType<float, int8_t>, LabelT>;
+    TestReorder<Hnsw>(HnswReorderType::kRCM);
+}
+
+TEST_F(HnswAlgTest, test13) {
+    using Hnsw = KnnHnsw<PlainL2VecStoreType<float>, LabelT>;
+    TestBatch<Hnsw>();
+}
+
+TEST_F(HnswAlgTest, test14) {
+    using Hnsw = KnnHnsw<LVQL2VecStoreType<float, int8_t>, LabelT>;
+    TestBatch<Hnsw>();
+}
+
+TEST_F(HnswAlgTest, test15) {
+    using Hnsw = KnnHnsw<PlainL2VecStoreType<float>, LabelT>;
+    TestPatience<Hnsw>();
+}
+
+TEST_F(HnswAlgTest, test16) {
+    using Hnsw = KnnHnsw<PlainL2VecStoreType<float>, LabelT>;
+    TestTruncated<Hnsw>();
+}
+
+TEST_F(HnswAlgTest, test17) {
+    using Hnsw = KnnHnsw<PlainHammingVecStoreType<u8>, LabelT>;
+    TestHamming<Hnsw>();
+}
+
+TEST_F(HnswAlgTest, test18) {
+    using Hnsw = KnnHnsw<PlainL2VecStoreType<float>, LabelT>;
+    TestDistanceBound<Hnsw>();
+}
+
+TEST_F(HnswAlgTest, test19) {
+    using Hnsw = KnnHnsw<PlainL2VecStoreType<float>, LabelT>;
+    using CompressedHnsw = KnnHnsw<RaBitQL2VecStoreType<float>, LabelT>;
+    TestRaBitQRecall<Hnsw, CompressedHnsw>();
+}
+
+TEST_F(HnswAlgTest, test20) {
+    using Hnsw = KnnHnsw<PlainL2VecStoreType<float>, LabelT>;
+    TestParallelBuild<Hnsw>();
+}
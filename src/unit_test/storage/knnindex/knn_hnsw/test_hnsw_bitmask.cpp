@@ -24,6 +24,9 @@ import dist_func_ip;
 import hnsw_alg;
 import knn_filter;
 import hnsw_common;
+import hnsw_segment_group;
+import internal_types;
+import ivf_index_util_func;
 
 using namespace infinity;
 
@@ -142,4 +145,261 @@ TEST_F(HnswAlgBitmaskTest, test1) {
         EXPECT_NEAR(result[0].first, 0.2, error);
         EXPECT_NEAR(result[0].second, 3, error);
     }
-}
\ No newline at end of file
+}
+
+TEST_F(HnswAlgBitmaskTest, test_predicate_aware) {
+    int dim = 16;
+    int M = 8;
+    int ef_construction = 200;
+    int chunk_size = 128;
+    int max_chunk_n = 10;
+    int element_size = max_chunk_n * chunk_size;
+    int match_step = 20;
+    int topk = 5;
+
+    std::mt19937 rng;
+    rng.seed(0);
+    std::uniform_real_distribution<float> distrib_real;
+
+    auto data = MakeUnique<f32[]>(dim * element_size);
+    for (int i = 0; i < dim * element_size; ++i) {
+        data[i] = distrib_real(rng);
+    }
+
+    using LabelT = u64;
+    using Hnsw = KnnHnsw<PlainL2VecStoreType<f32>, LabelT>;
+    auto hnsw_index = Hnsw::Make(chunk_size, max_chunk_n, dim, M, ef_construction);
+    auto iter = DenseVectorIter<f32, LabelT>(data.get(), dim, element_size);
+    hnsw_index->InsertVecs(std::move(iter));
+
+    // only 1 / `match_step` of the rows pass the filter
+    auto p_bitmask = Bitmask::MakeSharedAllTrue(element_size);
+    for (int i = 0; i < element_size; ++i) {
+        if (i % match_step != 0) {
+            p_bitmask->SetFalse(i);
+        }
+    }
+    BitmaskFilter<LabelT> filter(*p_bitmask);
+
+    KnnSearchOption search_option{.ef_ = 50, .predicate_aware_ = true};
+    SizeT correct = 0;
+    SizeT total = 0;
+    for (int q = 1; q < element_size; q += 37) {
+        const f32 *query = data.get() + q * dim;
+        Vector<Pair<f32, LabelT>> expect;
+        for (int i = 0; i < element_size; i += match_step) {
+            f32 dist = 0;
+            for (int j = 0; j < dim; ++j) {
+                f32 diff = query[j] - data[i * dim + j];
+                dist += diff * diff;
+            }
+            expect.emplace_back(dist, i);
+        }
+        std::sort(expect.begin(), expect.end());
+
+        auto result = hnsw_index->KnnSearchSorted(query, topk, filter, search_option);
+        ASSERT_EQ(result.size(), SizeT(topk));
+        HashSet<LabelT> expect_labels;
+        for (int i = 0; i < topk; ++i) {
+            expect_labels.insert(expect[i].second);
+        }
+        for (const auto &[dist, label] : result) {
+            EXPECT_EQ(label % match_step, 0u);
+            correct += expect_labels.contains(label);
+        }
+        total += topk;
+    }
+    EXPECT_GE(correct, total * 9 / 10);
+}
+
+TEST_F(HnswAlgBitmaskTest, test_predicate_aware_fallback) {
+    int dim = 16;
+    int M = 8;
+    int ef_construction = 200;
+    int chunk_size = 128;
+    int max_chunk_n = 10;
+    int element_size = max_chunk_n * chunk_size;
+    // less than 1% of the rows pass the filter, they are too sparse to be reached through the 2 hop neighbors
+    int match_step = 150;
+    int topk = 5;
+
+    std::mt19937 rng;
+    rng.seed(0);
+    std::uniform_real_distribution<float> distrib_real;
+
+    auto data = MakeUnique<f32[]>(dim * element_size);
+    for (int i = 0; i < dim * element_size; ++i) {
+        data[i] = distrib_real(rng);
+    }
+
+    using LabelT = u64;
+    using Hnsw = KnnHnsw<PlainL2VecStoreType<f32>, LabelT>;
+    auto hnsw_index = Hnsw::Make(chunk_size, max_chunk_n, dim, M, ef_construction);
+    auto iter = DenseVectorIter<f32, LabelT>(data.get(), dim, element_size);
+    hnsw_index->InsertVecs(std::move(iter));
+
+    auto p_bitmask = Bitmask::MakeSharedAllTrue(element_size);
+    for (int i = 0; i < element_size; ++i) {
+        if (i % match_step != 0) {
+            p_bitmask->SetFalse(i);
+        }
+    }
+    BitmaskFilter<LabelT> filter(*p_bitmask);
+
+    KnnSearchOption search_option{.predicate_aware_ = true};
+    for (int q = 1; q < element_size; q += 37) {
+        const f32 *query = data.get() + q * dim;
+        auto [result_n, d_ptr, l_ptr] = hnsw_index->KnnSearch(query, topk, filter, search_option);
+        ASSERT_EQ(result_n, SizeT(topk));
+        for (SizeT i = 0; i < result_n; ++i) {
+            EXPECT_EQ(l_ptr[i] % match_step, 0u);
+        }
+    }
+}
+
+// the retry of a predicate aware search is bounded by the rows of its chunk which pass the filter, not of the whole segment
+TEST_F(HnswAlgBitmaskTest, test_filter_pass_count_of_chunk) {
+    constexpr u32 row_n = 3000;
+    constexpr u32 match_step = 7;
+    Bitmask all_true(row_n);
+    EXPECT_EQ(all_true.CountTrue(1000, 2000), 1000u);
+    EXPECT_EQ(all_true.CountTrue(2500, 4000), 500u);
+
+    Bitmask bitmask(row_n);
+    for (u32 i = 0; i < row_n; ++i) {
+        if (i % match_step != 0) {
+            bitmask.SetFalse(i);
+        }
+    }
+    const Vector<Pair<u32, u32>> ranges = {{0, 1}, {0, row_n}, {1, 7}, {1, 8}, {700, 1400}, {2999, 5000}, {5, 5}};
+    for (const auto &[start, end] : ranges) {
+        u32 expected = 0;
+        for (u32 i = start; i < std::min(end, row_n); ++i) {
+            expected += bitmask.IsTrue(i);
+        }
+        EXPECT_EQ(bitmask.CountTrue(start, end), expected) << start << " " << end;
+    }
+    EXPECT_EQ(bitmask.CountTrue(0, row_n), bitmask.CountTrue());
+}
+
+TEST_F(HnswAlgBitmaskTest, test_segment_group_filter) {
+    // labels of three segments in one group graph
+    Vector<HnswSegmentGroupPart> parts = {{.segment_id_ = 0, .base_offset_ = 0, .row_count_ = 100},
+                                          {.segment_id_ = 2, .base_offset_ = 100, .row_count_ = 200},
+                                          {.segment_id_ = 5, .base_offset_ = 300, .row_count_ = 70}};
+    HnswSegmentGroup group(nullptr, parts, 370);
+    EXPECT_EQ(group.GetPart(0).segment_id_, 0u);
+    EXPECT_EQ(group.GetPart(99).segment_id_, 0u);
+    EXPECT_EQ(group.GetPart(100).segment_id_, 2u);
+    EXPECT_EQ(group.GetPart(299).segment_id_, 2u);
+    EXPECT_EQ(group.GetPart(369).segment_id_, 5u);
+
+    // the first segment is all selected, the odd rows of the second one are selected, the last one is filtered out
+    auto p_bitmask = Bitmask::MakeSharedAllTrue(200);
+    for (u32 i = 0; i < 200; i += 2) {
+        p_bitmask->SetFalse(i);
+    }
+    BitmaskFilter<SegmentOffset> filter(group.row_count());
+    filter.SetRange(parts[0].base_offset_, parts[0].base_offset_ + parts[0].row_count_);
+    filter.Set(*p_bitmask, parts[1].base_offset_);
+    for (SegmentOffset label = 0; label < 370; ++label) {
+        bool expect = label < 100 || (label < 300 && (label - 100) % 2 == 1);
+        EXPECT_EQ(filter(label), expect);
+    }
+    EXPECT_FALSE(filter(370));
+}
+
+TEST_F(HnswAlgBitmaskTest, test_bitmask_filter) {
+    static_assert(FilterConcept<BitmaskFilter<u64>, u64>);
+    static_assert(PrefetchFilterConcept<BitmaskFilter<u64>, u64>);
+    static_assert(FilterConcept<AppendFilter, SegmentOffset>);
+    static_assert(!PrefetchFilterConcept<AppendFilter, SegmentOffset>);
+
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<u32> distrib(0, 3);
+    // the sizes around the word boundaries of the flattened bitmap
+    for (u32 count : {1u, 63u, 64u, 65u, 1000u}) {
+        auto all_true = Bitmask::MakeSharedAllTrue(count);
+        auto dense = Bitmask::MakeSharedAllTrue(count);
+        auto sparse = Bitmask::MakeSharedAllFalse(count);
+        for (u32 i = 0; i < count; ++i) {
+            if (distrib(rng) == 0) {
+                dense->SetFalse(i);
+            } else if (distrib(rng) == 0) {
+                sparse->SetTrue(i);
+            }
+        }
+        for (const auto &p_bitmask : {all_true, dense, sparse}) {
+            BitmaskFilter<SegmentOffset> filter(*p_bitmask);
+            EXPECT_EQ(filter.count(), count);
+            // the ivf scans check the same bits through a view
+            const IVFSearchFilter view{filter.words(), static_cast<SegmentOffset>(filter.count())};
+            for (SegmentOffset label = 0; label < count + 64; ++label) {
+                const bool expect = label < count && p_bitmask->IsTrue(label);
+                EXPECT_EQ(filter(label), expect) << "count " << count << " label " << label;
+                EXPECT_EQ(view(label), expect) << "count " << count << " label " << label;
+                filter.Prefetch(label);
+            }
+        }
+    }
+
+    // the ranges start and end inside, on and across the word boundaries
+    BitmaskFilter<SegmentOffset> filter(300);
+    Vector<bool> expect(300, false);
+    for (auto [begin, end] : Vector<Pair<u32, u32>>{{3, 7}, {60, 64}, {64, 128}, {130, 260}, {299, 300}, {10, 10}}) {
+        filter.SetRange(begin, end);
+        std::fill(expect.begin() + begin, expect.begin() + end, true);
+    }
+    for (SegmentOffset label = 0; label < 300; ++label) {
+        EXPECT_EQ(filter(label), expect[label]) << "label " << label;
+    }
+}
+
+TEST_F(HnswAlgBitmaskTest, test_append_filter) {
+    int dim = 16;
+    int M = 8;
+    int ef_construction = 200;
+    int chunk_size = 128;
+    int max_chunk_n = 10;
+    int element_size = max_chunk_n * chunk_size;
+    int visible_n = element_size / 3;
+    int topk = 10;
+
+    AppendFilter append_filter(visible_n);
+    EXPECT_TRUE(append_filter(0));
+    EXPECT_TRUE(append_filter(visible_n - 1));
+    EXPECT_FALSE(append_filter(visible_n));
+
+    std::mt19937 rng;
+    rng.seed(0);
+    std::uniform_real_distribution<float> distrib_real;
+
+    auto data = MakeUnique<f32[]>(dim * element_size);
+    for (int i = 0; i < dim * element_size; ++i) {
+        data[i] = distrib_real(rng);
+    }
+
+    using Hnsw = KnnHnsw<PlainL2VecStoreType<f32>, SegmentOffset>;
+    auto hnsw_index = Hnsw::Make(chunk_size, max_chunk_n, dim, M, ef_construction);
+    auto iter = DenseVectorIter<f32, SegmentOffset>(data.get(), dim, element_size);
+    hnsw_index->InsertVecs(std::move(iter));
+
+    // the rows appended after the snapshot are skipped, the results are the same as with the bitmap of the visible rows
+    auto p_bitmask = Bitmask::MakeSharedAllFalse(element_size);
+    p_bitmask->SetTrueRange(0, visible_n);
+    BitmaskFilter<SegmentOffset> bitmask_filter(*p_bitmask);
+
+    KnnSearchOption search_option{.ef_ = 100};
+    for (int q = 1; q < element_size; q += 37) {
+        const f32 *query = data.get() + q * dim;
+        auto append_result = hnsw_index->KnnSearchSorted(query, topk, append_filter, search_option);
+        auto bitmask_result = hnsw_index->KnnSearchSorted(query, topk, bitmask_filter, search_option);
+        ASSERT_EQ(append_result.size(), SizeT(topk));
+        ASSERT_EQ(bitmask_result.size(), append_result.size());
+        for (int i = 0; i < topk; ++i) {
+            EXPECT_LT(append_result[i].second, SegmentOffset(visible_n));
+            EXPECT_EQ(append_result[i].second, bitmask_result[i].second);
+            EXPECT_NEAR(append_result[i].first, bitmask_result[i].first, error);
+        }
+    }
+}
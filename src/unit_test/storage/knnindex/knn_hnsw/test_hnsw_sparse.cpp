@@ -125,3 +125,8 @@ TEST_F(HnswSparseTest, test1) {
     using Hnsw = KnnHnsw<SparseIPVecStoreType<float, IdxT>, LabelT>;
     TestSimple<Hnsw>();
 }
+
+TEST_F(HnswSparseTest, test_compressed) {
+    using Hnsw = KnnHnsw<CompressedSparseIPVecStoreType<float, IdxT>, LabelT>;
+    TestSimple<Hnsw>();
+}
@@ -0,0 +1,72 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <latch>
+import base_test;
+
+import stl;
+import knn_query_coalescer;
+
+using namespace infinity;
+
+class KnnQueryCoalescerTest : public BaseTest {};
+
+TEST_F(KnnQueryCoalescerTest, fan_out) {
+    constexpr i32 thread_n = 16;
+    KnnQueryCoalescer<i32, i32, i32> coalescer;
+    atomic_u64 batch_n = 0;
+    atomic_u64 query_n = 0;
+    Vector<i32> results(thread_n, -1);
+    // all the queries are submitted together, well within the window of the first one
+    std::latch start(thread_n);
+    Vector<Thread> threads;
+    for (i32 i = 0; i < thread_n; ++i) {
+        threads.emplace_back([&, i] {
+            // two keys, the queries of different keys are never in one batch
+            const i32 key = i % 2;
+            start.arrive_and_wait();
+            results[i] = coalescer.Submit(key, i, kKnnQueryCoalesceMaxWindow, [&](const Vector<i32> &queries) {
+                ++batch_n;
+                query_n += queries.size();
+                Vector<i32> batch_results;
+                for (i32 query : queries) {
+                    EXPECT_EQ(query % 2, key);
+                    batch_results.push_back(query * 10);
+                }
+                return batch_results;
+            });
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(query_n, u64(thread_n));
+    // some queries shared a batch
+    EXPECT_GE(batch_n, 2u);
+    EXPECT_LT(batch_n, u64(thread_n));
+    // every thread gets the result of its own query, not of another one in its batch
+    for (i32 i = 0; i < thread_n; ++i) {
+        EXPECT_EQ(results[i], i * 10);
+    }
+}
+
+TEST_F(KnnQueryCoalescerTest, exception) {
+    KnnQueryCoalescer<i32, i32, i32> coalescer;
+    EXPECT_THROW(coalescer.Submit(0, 1, std::chrono::microseconds(0), [](const Vector<i32> &) -> Vector<i32> { throw std::runtime_error("fail"); }),
+                 std::runtime_error);
+    // the failed batch is closed
+    EXPECT_EQ(coalescer.Submit(0, 1, std::chrono::microseconds(0), [](const Vector<i32> &queries) { return queries; }), 1);
+}
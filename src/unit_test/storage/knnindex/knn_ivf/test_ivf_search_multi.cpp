@@ -0,0 +1,125 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include <random>
+import base_test;
+
+import stl;
+import internal_types;
+import logical_type;
+import data_type;
+import knn_expr;
+import knn_scan_data;
+import index_base;
+import index_ivf;
+import ivf_index_storage;
+import ivf_index_util_func;
+
+using namespace infinity;
+
+// The batched search of several queries scans every probed part once for all the queries which probe it, every query has to get
+// the same candidates with the same distances as when it is searched alone.
+class IVFSearchMultiTest : public BaseTest {
+protected:
+    static constexpr u32 dim = 32;
+    static constexpr u32 embedding_num = 4096;
+    static constexpr u32 query_count = 7;
+    static constexpr u32 nprobe = 4;
+
+    void SetUp() override {
+        BaseTest::SetUp();
+        std::mt19937 gen(0);
+        std::uniform_real_distribution<f32> dist(-1.0f, 1.0f);
+        data_.resize(embedding_num * dim);
+        for (auto &x : data_) {
+            x = dist(gen);
+        }
+        queries_.resize(query_count * dim);
+        for (auto &x : queries_) {
+            x = dist(gen);
+        }
+    }
+
+    void CheckMultiEqualsSingle(const MetricType metric, const KnnDistanceType dist_type, const IndexIVFStorageOption &storage_option) {
+        const IndexIVFOption ivf_option{.metric_ = metric, .centroid_option_ = {}, .storage_option_ = storage_option};
+        IVF_Index_Storage storage(ivf_option, LogicalType::kEmbedding, EmbeddingDataType::kElemFloat, dim);
+        storage.Train(embedding_num, data_.data(), 32);
+        storage.AddEmbeddingBatch(0, data_.data(), embedding_num);
+
+        const KnnDistance1<f32, f32> knn_distance(dist_type);
+        const IVFSearchFilter filter{nullptr, embedding_num};
+        Vector<Vector<Pair<SegmentOffset, f32>>> multi_results(query_count);
+        storage.SearchIndexMulti(&knn_distance,
+                                 queries_.data(),
+                                 EmbeddingDataType::kElemFloat,
+                                 query_count,
+                                 nprobe,
+                                 filter,
+                                 [&](const u32 query_id, const f32 d, const SegmentOffset i) { multi_results[query_id].emplace_back(i, d); });
+        for (u32 query_id = 0; query_id < query_count; ++query_id) {
+            Vector<Pair<SegmentOffset, f32>> single_result;
+            storage.SearchIndex(&knn_distance,
+                                queries_.data() + query_id * dim,
+                                EmbeddingDataType::kElemFloat,
+                                nprobe,
+                                filter,
+                                [&](const f32 d, const SegmentOffset i) { single_result.emplace_back(i, d); });
+            auto &multi_result = multi_results[query_id];
+            ASSERT_FALSE(single_result.empty());
+            ASSERT_EQ(multi_result.size(), single_result.size()) << "query " << query_id;
+            std::sort(single_result.begin(), single_result.end());
+            std::sort(multi_result.begin(), multi_result.end());
+            for (SizeT i = 0; i < single_result.size(); ++i) {
+                EXPECT_EQ(multi_result[i].first, single_result[i].first);
+                EXPECT_NEAR(multi_result[i].second, single_result[i].second, 1e-4);
+            }
+        }
+    }
+
+    Vector<f32> data_;
+    Vector<f32> queries_;
+};
+
+TEST_F(IVFSearchMultiTest, plain) {
+    IndexIVFStorageOption storage_option;
+    storage_option.type_ = IndexIVFStorageOption::Type::kPlain;
+    storage_option.plain_storage_data_type_ = EmbeddingDataType::kElemFloat;
+    CheckMultiEqualsSingle(MetricType::kMetricL2, KnnDistanceType::kL2, storage_option);
+    CheckMultiEqualsSingle(MetricType::kMetricInnerProduct, KnnDistanceType::kInnerProduct, storage_option);
+}
+
+TEST_F(IVFSearchMultiTest, scalar_quantization) {
+    IndexIVFStorageOption storage_option;
+    storage_option.type_ = IndexIVFStorageOption::Type::kScalarQuantization;
+    storage_option.scalar_quantization_bits_ = 8;
+    CheckMultiEqualsSingle(MetricType::kMetricL2, KnnDistanceType::kL2, storage_option);
+    CheckMultiEqualsSingle(MetricType::kMetricInnerProduct, KnnDistanceType::kInnerProduct, storage_option);
+}
+
+TEST_F(IVFSearchMultiTest, product_quantization) {
+    IndexIVFStorageOption storage_option;
+    storage_option.type_ = IndexIVFStorageOption::Type::kProductQuantization;
+    storage_option.product_quantization_subspace_num_ = 8;
+    storage_option.product_quantization_subspace_bits_ = 4;
+    CheckMultiEqualsSingle(MetricType::kMetricL2, KnnDistanceType::kL2, storage_option);
+    CheckMultiEqualsSingle(MetricType::kMetricInnerProduct, KnnDistanceType::kInnerProduct, storage_option);
+}
+
+TEST_F(IVFSearchMultiTest, rabitq) {
+    IndexIVFStorageOption storage_option;
+    storage_option.type_ = IndexIVFStorageOption::Type::kRaBitQ;
+    CheckMultiEqualsSingle(MetricType::kMetricL2, KnnDistanceType::kL2, storage_option);
+    CheckMultiEqualsSingle(MetricType::kMetricInnerProduct, KnnDistanceType::kInnerProduct, storage_option);
+}
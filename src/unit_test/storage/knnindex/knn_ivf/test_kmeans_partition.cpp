@@ -0,0 +1,102 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include <random>
+import base_test;
+
+import stl;
+import index_base;
+import kmeans_partition;
+import vector_distance;
+
+using namespace infinity;
+
+class KMeansPartitionTest : public BaseTest {
+protected:
+    static constexpr u32 dim = 16;
+    static constexpr u32 cluster_num = 8;
+    static constexpr u32 vector_num = 64 * 256;
+
+    void SetUp() override {
+        BaseTest::SetUp();
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<f32> center_dist(-10.0f, 10.0f);
+        std::normal_distribution<f32> noise(0.0f, 0.1f);
+        centers_.resize(cluster_num * dim);
+        for (auto &x : centers_) {
+            x = center_dist(gen);
+        }
+        vectors_.resize(vector_num * dim);
+        for (u32 i = 0; i < vector_num; ++i) {
+            const f32 *center = centers_.data() + (i % cluster_num) * dim;
+            for (u32 j = 0; j < dim; ++j) {
+                vectors_[i * dim + j] = center[j] + noise(gen);
+            }
+        }
+    }
+
+    // every cluster center has a centroid close to it
+    void CheckCentroids(const Vector<f32> &centroids, const u32 centroid_num) {
+        ASSERT_EQ(centroids.size(), centroid_num * dim);
+        u32 found = 0;
+        for (u32 c = 0; c < cluster_num; ++c) {
+            f32 min_distance = std::numeric_limits<f32>::max();
+            for (u32 i = 0; i < centroid_num; ++i) {
+                min_distance = std::min(min_distance, L2Distance<f32>(centers_.data() + c * dim, centroids.data() + i * dim, dim));
+            }
+            found += min_distance < 1.0f;
+        }
+        EXPECT_GE(found, cluster_num - 1);
+    }
+
+    Vector<f32> centers_;
+    Vector<f32> vectors_;
+};
+
+TEST_F(KMeansPartitionTest, full_batch) {
+    Vector<f32> centroids;
+    const auto centroid_num =
+        GetKMeansCentroids(MetricType::kMetricL2, dim, vector_num, vectors_.data(), centroids, cluster_num, 20, KMeansOption{.thread_num_ = 4});
+    EXPECT_EQ(centroid_num, cluster_num);
+    CheckCentroids(centroids, centroid_num);
+}
+
+TEST_F(KMeansPartitionTest, mini_batch) {
+    Vector<f32> centroids;
+    const auto centroid_num = GetKMeansCentroids(MetricType::kMetricL2,
+                                                 dim,
+                                                 vector_num,
+                                                 vectors_.data(),
+                                                 centroids,
+                                                 cluster_num,
+                                                 20,
+                                                 KMeansOption{.thread_num_ = 4, .mini_batch_size_ = 256});
+    EXPECT_EQ(centroid_num, cluster_num);
+    CheckCentroids(centroids, centroid_num);
+}
+
+TEST_F(KMeansPartitionTest, kmeans_plus_plus) {
+    Vector<f32> centroids;
+    const auto centroid_num = GetKMeansCentroids(MetricType::kMetricL2,
+                                                 dim,
+                                                 vector_num,
+                                                 vectors_.data(),
+                                                 centroids,
+                                                 cluster_num,
+                                                 20,
+                                                 KMeansOption{.kmeans_plus_plus_ = true});
+    EXPECT_EQ(centroid_num, cluster_num);
+    CheckCentroids(centroids, centroid_num);
+}
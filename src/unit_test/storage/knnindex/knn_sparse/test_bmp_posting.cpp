@@ -0,0 +1,91 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include <random>
+
+import base_test;
+import stl;
+import bm_posting;
+import bmp_util;
+
+using namespace infinity;
+
+class BMPPostingTest : public BaseTest {
+protected:
+    static constexpr BMPBlockID block_num = 1000;
+
+    template <typename DataType, BMPCompressType CompressType>
+    void TestFunc() {
+        using Postings = BlockPostings<DataType, CompressType>;
+
+        // the maximum grows with the blocks, every block is added with a new largest score
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<DataType> distrib(0.0, 1.0);
+        Vector<DataType> exact(block_num, 0.0);
+        Postings postings;
+        postings.kth_ = 1;
+        postings.kth_score_ = 0.0;
+        for (BMPBlockID block_id = 0; block_id < block_num; block_id += 2) {
+            exact[block_id] = distrib(rng) * (block_id + 1);
+            postings.data_.AddBlock(block_id, exact[block_id]);
+        }
+        const DataType max_score = *std::max_element(exact.begin(), exact.end());
+        const DataType query_score = 2.0;
+
+        auto calculate = [&](const Postings &p) {
+            Vector<DataType> upper_bounds(block_num, 0.0);
+            p.data_.Calculate(upper_bounds, query_score);
+            return upper_bounds;
+        };
+
+        // the exact scores are used before the postings are finalized
+        {
+            const auto upper_bounds = calculate(postings);
+            for (BMPBlockID block_id = 0; block_id < block_num; ++block_id) {
+                EXPECT_EQ(upper_bounds[block_id], exact[block_id] * query_score) << "block " << block_id;
+            }
+        }
+
+        postings.data_.Finalize();
+        const auto upper_bounds = calculate(postings);
+        for (BMPBlockID block_id = 0; block_id < block_num; ++block_id) {
+            const DataType exact_bound = exact[block_id] * query_score;
+            EXPECT_GE(upper_bounds[block_id], exact_bound * (1 - 1e-5)) << "block " << block_id;
+            EXPECT_LE(upper_bounds[block_id], exact_bound + max_score * query_score / 255 * 1.01) << "block " << block_id;
+        }
+
+        // the serialized scores are the exact ones, the bounds stay the same over save and load cycles
+        Postings current = std::move(postings);
+        for (int cycle = 0; cycle < 3; ++cycle) {
+            Vector<char> buf(current.GetSizeInBytes());
+            char *p = buf.data();
+            current.WriteAdv(p);
+            ASSERT_EQ(p, buf.data() + buf.size());
+
+            const char *p_r = buf.data();
+            Postings loaded = Postings::ReadAdv(p_r);
+            ASSERT_EQ(p_r, buf.data() + buf.size());
+            EXPECT_EQ(calculate(loaded), upper_bounds) << "cycle " << cycle;
+            current = std::move(loaded);
+        }
+    }
+};
+
+TEST_F(BMPPostingTest, stable_bounds) {
+    TestFunc<f32, BMPCompressType::kRaw>();
+    TestFunc<f32, BMPCompressType::kCompressed>();
+    TestFunc<f64, BMPCompressType::kRaw>();
+    TestFunc<f64, BMPCompressType::kCompressed>();
+}
@@ -0,0 +1,78 @@
+// Copyright(C) 2023 InfiniFlow, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+import base_test;
+
+import stl;
+import sparse_util;
+import sparse_vec_codec;
+import sparse_test_util;
+
+using namespace infinity;
+
+class SparseVecCodecTest : public BaseTest {
+protected:
+    using Codec = SparseVecCodec<f32, i32>;
+
+    static f32 PlainIP(const SparseVecRef<f32, i32> &vec1, const SparseVecRef<f32, i32> &vec2) {
+        f32 res = 0;
+        i32 i = 0, j = 0;
+        while (i < vec1.nnz_ && j < vec2.nnz_) {
+            if (vec1.indices_[i] == vec2.indices_[j]) {
+                res += vec1.data_[i++] * vec2.data_[j++];
+            } else if (vec1.indices_[i] < vec2.indices_[j]) {
+                ++i;
+            } else {
+                ++j;
+            }
+        }
+        return res;
+    }
+};
+
+TEST_F(SparseVecCodecTest, round_trip) {
+    // the wide dimension gives multi byte deltas
+    u32 nrow = 200;
+    u32 ncol = 1 << 24;
+    f32 sparsity = 1e-5;
+
+    const SparseMatrix dataset = SparseTestUtil<f32, i32>::GenerateDataset(nrow, ncol, sparsity);
+    Vector<UniquePtr<char[]>> encoded(nrow);
+    for (u32 row_id = 0; row_id < nrow; ++row_id) {
+        SparseVecRef<f32, i32> vec = dataset.at(row_id);
+        encoded[row_id] = MakeUniqueForOverwrite<char[]>(Codec::EncodedSize(vec));
+        Codec::Encode(vec, encoded[row_id].get());
+
+        CompressedSparseVecRef<f32> compressed = Codec::View(encoded[row_id].get());
+        ASSERT_EQ(compressed.nnz_, vec.nnz_);
+        Vector<i32> indices(vec.nnz_);
+        Vector<f32> data(vec.nnz_);
+        Codec::Decode(compressed, indices.data(), data.data());
+        for (i32 i = 0; i < vec.nnz_; ++i) {
+            EXPECT_EQ(indices[i], vec.indices_[i]);
+            EXPECT_NEAR(data[i], vec.data_[i], compressed.scale_ / 2 + 1e-6);
+        }
+    }
+
+    for (u32 i = 0; i + 1 < nrow; ++i) {
+        SparseVecRef<f32, i32> vec1 = dataset.at(i);
+        SparseVecRef<f32, i32> vec2 = dataset.at(i + 1);
+        f32 expected = PlainIP(vec1, vec2);
+        f32 res = CompressedSparseIP(Codec::View(encoded[i].get()), Codec::View(encoded[i + 1].get()));
+        EXPECT_NEAR(res, expected, 0.02 * std::max(1.0f, std::abs(expected)));
+        f32 norm = PlainIP(vec1, vec1);
+        EXPECT_NEAR(CompressedSparseIP(Codec::View(encoded[i].get()), Codec::View(encoded[i].get())), norm, 0.02 * norm + 1e-6);
+    }
+}
@@ -37,6 +37,10 @@ import statement_common;
 import data_type;
 import persistence_manager;
 import embedding_info;
+import index_hnsw;
+import create_index_info;
+import serialize;
+import crc;
 
 using namespace infinity;
 
@@ -292,6 +296,61 @@ TEST_F(WalEntryTest, ReadWrite) {
     infinity::InfinityContext::instance().UnInit();
 }
 
+// an entry written before pq_subspace_num and truncate_dim were in the record of an hnsw index
+TEST_F(WalEntryTest, ReadOldHnswIndex) {
+    Vector<char> buf(1024, char(0));
+    char *const buf_beg = buf.data();
+    char *ptr = buf_beg + sizeof(WalEntryHeader);
+    WriteBufAdv(ptr, static_cast<i32>(2));
+    char *const create_index_beg = ptr;
+    WriteBufAdv(ptr, WalCommandType::CREATE_INDEX);
+    WriteBufAdv(ptr, String("db1"));
+    WriteBufAdv(ptr, String("tbl1"));
+    WriteBufAdv(ptr, String("CCC_idx1"));
+    WriteBufAdv(ptr, IndexType::kHnsw);
+    WriteBufAdv(ptr, String("idx1"));
+    WriteBufAdv(ptr, String("test comment"));
+    WriteBufAdv(ptr, String("idx1_tbl1"));
+    WriteBufAdv(ptr, static_cast<i32>(1));
+    WriteBufAdv(ptr, String("col1"));
+    WriteBufAdv(ptr, MetricType::kMetricL2);
+    WriteBufAdv(ptr, HnswEncodeType::kLVQ);
+    WriteBufAdv(ptr, SizeT(16));
+    WriteBufAdv(ptr, SizeT(200));
+    WriteBufAdv(ptr, SizeT(8192));
+    const i32 create_index_size = ptr - create_index_beg;
+    WalCmdDropIndex("db1", "tbl1", "idx1").WriteAdv(ptr);
+    const i32 size = ptr - buf_beg + sizeof(i32);
+    WriteBufAdv(ptr, size);
+    auto *header = reinterpret_cast<WalEntryHeader *>(buf_beg);
+    header->size_ = size;
+    header->checksum_ = CRC32IEEE::makeCRC(reinterpret_cast<const unsigned char *>(buf_beg), size);
+
+    const char *ptr_r = buf_beg;
+    SharedPtr<WalEntry> entry = WalEntry::ReadAdv(ptr_r, size);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(ptr_r - buf_beg, size);
+    ASSERT_EQ(entry->cmds_.size(), 2u);
+
+    const auto *create_index = dynamic_cast<const WalCmdCreateIndex *>(entry->cmds_[0].get());
+    ASSERT_NE(create_index, nullptr);
+    const auto *index_hnsw = dynamic_cast<const IndexHnsw *>(create_index->index_base_.get());
+    ASSERT_NE(index_hnsw, nullptr);
+    EXPECT_EQ(index_hnsw->metric_type_, MetricType::kMetricL2);
+    EXPECT_EQ(index_hnsw->encode_type_, HnswEncodeType::kLVQ);
+    EXPECT_EQ(index_hnsw->M_, 16u);
+    EXPECT_EQ(index_hnsw->ef_construction_, 200u);
+    EXPECT_EQ(index_hnsw->block_size_, 8192u);
+    EXPECT_EQ(index_hnsw->pq_subspace_num_, 0u);
+    EXPECT_EQ(index_hnsw->truncate_dim_, 0u);
+    // the index is written in the same layout again
+    EXPECT_EQ(create_index->GetSizeInBytes(), create_index_size);
+
+    const auto *drop_index = dynamic_cast<const WalCmdDropIndex *>(entry->cmds_[1].get());
+    ASSERT_NE(drop_index, nullptr);
+    EXPECT_EQ(drop_index->index_name_, "idx1");
+}
+
 TEST_F(WalEntryTest, ReadWriteVFS) {
     RemoveDbDirs();
     SharedPtr<WalEntry> entry = MakeShared<WalEntry>();